@@ -0,0 +1,166 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+                 
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+                 
+CustusX is released under a BSD 3-Clause license.
+                 
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxOpenIGTLinkBenchmark.h"
+
+#include <QTcpSocket>
+#include <vtkImageData.h>
+#include "cxVolumeHelpers.h"
+#include "cxGrabberSenderMultiClient.h"
+#include "cxDirectlyLinkedSender.h"
+#include "cxIGTLinkClientStreamer.h"
+
+namespace cx
+{
+
+BenchmarkTimes::BenchmarkTimes(int frames) :
+	mSent(frames, -1),
+	mReceived(frames, -1)
+{
+	mClock.start();
+}
+
+qint64 BenchmarkTimes::now() const
+{
+	return mClock.nsecsElapsed();
+}
+
+void BenchmarkTimes::setSent(int frame)
+{
+	QMutexLocker lock(&mMutex);
+	mSent[frame] = this->now();
+}
+
+void BenchmarkTimes::setReceived(int frame)
+{
+	QMutexLocker lock(&mMutex);
+	mReceived[frame] = this->now();
+}
+
+int BenchmarkTimes::getFrameCount() const
+{
+	return int(mSent.size());
+}
+
+std::vector<qint64> BenchmarkTimes::getSent() const
+{
+	QMutexLocker lock(&mMutex);
+	return mSent;
+}
+
+std::vector<qint64> BenchmarkTimes::getReceived() const
+{
+	QMutexLocker lock(&mMutex);
+	return mReceived;
+}
+
+///--------------------------------------------------------
+///--------------------------------------------------------
+///--------------------------------------------------------
+
+BenchmarkServer::BenchmarkServer(BenchmarkTimes* times, Eigen::Array3i dim, int components, int interval) :
+	mTimes(times),
+	mSender(new GrabberSenderMultiClient()),
+	mNextFrame(0)
+{
+	vtkImageDataPtr data = generateVtkImageData(dim, Vector3D(0.1, 0.1, 1), 0, components);
+	unsigned char* ptr = static_cast<unsigned char*>(data->GetScalarPointer());
+	for (vtkIdType i=0; i<vtkIdType(dim.prod())*components; ++i)
+		ptr[i] = i % 251;
+	mImage.reset(new Image("f0", data));
+
+	mTimer = new QTimer(this);
+	mTimer->setInterval(interval);
+	connect(mTimer, &QTimer::timeout, this, &BenchmarkServer::sendSlot);
+	connect(this, &QTcpServer::newConnection, this, &BenchmarkServer::newConnectionSlot);
+}
+
+int BenchmarkServer::getDroppedCount() const
+{
+	std::vector<GrabberSenderMultiClient::ClientStatistics> statistics = mSender->getStatistics();
+	return statistics.empty() ? 0 : statistics.front().packagesDropped;
+}
+
+void BenchmarkServer::newConnectionSlot()
+{
+	QTcpSocket* socket = this->nextPendingConnection();
+	mSender->addClient(socket);
+	mTimer->start();
+}
+
+void BenchmarkServer::sendSlot()
+{
+	if (mNextFrame >= mTimes->getFrameCount())
+	{
+		mTimer->stop();
+		return;
+	}
+
+	// the frame number is sent as device name
+	mImage->setName(QString("f%1").arg(mNextFrame));
+	mImage->setAcquisitionTime(QDateTime::currentDateTime());
+	PackagePtr package(new Package());
+	package->mImage = mImage;
+
+	mTimes->setSent(mNextFrame);
+	mSender->send(package);
+	++mNextFrame;
+}
+
+///--------------------------------------------------------
+///--------------------------------------------------------
+///--------------------------------------------------------
+
+BenchmarkClient::BenchmarkClient(BenchmarkTimes* times, int port) :
+	mTimes(times),
+	mPort(port),
+	mCreatedMessages(0),
+	mRecycledMessages(0),
+	mSharedMessages(0)
+{
+}
+
+void BenchmarkClient::run()
+{
+	IGTLinkClientStreamerPtr streamer(new IGTLinkClientStreamer());
+	mReceiver.reset(new DirectlyLinkedSender());
+	connect(mReceiver.get(), &DirectlyLinkedSender::newImage, this, &BenchmarkClient::newImageSlot, Qt::DirectConnection);
+
+	streamer->setAddress("127.0.0.1", mPort);
+	streamer->startStreaming(mReceiver);
+	if (streamer->isStreaming())
+		this->exec();
+	streamer->stopStreaming();
+
+	IGTLinkImageMessagePoolPtr pool = streamer->getImagePool();
+	mCreatedMessages = pool->getCreatedCount();
+	mRecycledMessages = pool->getRecycledCount();
+	mSharedMessages = pool->getLentCount();
+	mReceiver.reset();
+}
+
+void BenchmarkClient::newImageSlot()
+{
+	ImagePtr image = mReceiver->popImage();
+	if (!image)
+		return;
+
+	bool ok = false;
+	int frame = image->getUid().mid(1).toInt(&ok);
+	if (!ok || frame<0 || frame>=mTimes->getFrameCount())
+		return;
+	mTimes->setReceived(frame);
+
+	if (frame == mTimes->getFrameCount()-1)
+		this->exit();
+}
+
+} // namespace cx
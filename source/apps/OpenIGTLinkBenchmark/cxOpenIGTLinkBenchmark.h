@@ -0,0 +1,100 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+                 
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+                 
+CustusX is released under a BSD 3-Clause license.
+                 
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXOPENIGTLINKBENCHMARK_H
+#define CXOPENIGTLINKBENCHMARK_H
+
+#include <vector>
+#include <QThread>
+#include <QTcpServer>
+#include <QTimer>
+#include <QMutex>
+#include <QElapsedTimer>
+#include "cxImage.h"
+#include "cxVector3D.h"
+
+namespace cx
+{
+typedef boost::shared_ptr<class GrabberSenderMultiClient> GrabberSenderMultiClientPtr;
+typedef boost::shared_ptr<class DirectlyLinkedSender> DirectlyLinkedSenderPtr;
+typedef boost::shared_ptr<class IGTLinkClientStreamer> IGTLinkClientStreamerPtr;
+
+/** Send and receive times for each frame, in ns since start.
+ *  Negative if not sent/received.
+ */
+class BenchmarkTimes
+{
+public:
+	explicit BenchmarkTimes(int frames);
+	qint64 now() const;
+	void setSent(int frame);
+	void setReceived(int frame);
+	int getFrameCount() const;
+	std::vector<qint64> getSent() const;
+	std::vector<qint64> getReceived() const;
+
+private:
+	QElapsedTimer mClock;
+	mutable QMutex mMutex;
+	std::vector<qint64> mSent;
+	std::vector<qint64> mReceived;
+};
+
+/** Stream generated frames to the connected clients.
+ */
+class BenchmarkServer : public QTcpServer
+{
+	Q_OBJECT
+public:
+	BenchmarkServer(BenchmarkTimes* times, Eigen::Array3i dim, int components, int interval);
+	int getDroppedCount() const;
+
+private slots:
+	void newConnectionSlot();
+	void sendSlot();
+
+private:
+	BenchmarkTimes* mTimes;
+	GrabberSenderMultiClientPtr mSender;
+	ImagePtr mImage;
+	QTimer* mTimer;
+	int mNextFrame;
+};
+
+/** Receive frames using IGTLinkClientStreamer in a separate thread,
+ *  as is done in the video service.
+ */
+class BenchmarkClient : public QThread
+{
+	Q_OBJECT
+public:
+	BenchmarkClient(BenchmarkTimes* times, int port);
+	unsigned getCreatedMessageCount() const { return mCreatedMessages; }
+	unsigned getRecycledMessageCount() const { return mRecycledMessages; }
+	unsigned getSharedMessageCount() const { return mSharedMessages; }
+
+protected:
+	virtual void run();
+
+private slots:
+	void newImageSlot();
+
+private:
+	BenchmarkTimes* mTimes;
+	int mPort;
+	DirectlyLinkedSenderPtr mReceiver;
+	unsigned mCreatedMessages;
+	unsigned mRecycledMessages;
+	unsigned mSharedMessages;
+};
+
+} // namespace cx
+
+#endif // CXOPENIGTLINKBENCHMARK_H
@@ -0,0 +1,109 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+                 
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+                 
+CustusX is released under a BSD 3-Clause license.
+                 
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include <iostream>
+#include <algorithm>
+#include <QCoreApplication>
+#include <QTimer>
+#include <QHostAddress>
+#include "cxOpenIGTLinkBenchmark.h"
+#include "cxCommandlineImageStreamerFactory.h"
+#include "cxStringHelpers.h"
+#include "cxReporter.h"
+
+/** Measure frame rate and latency of the OpenIGTLink image stream,
+ *  sending from a GrabberSenderMultiClient to an IGTLinkClientStreamer
+ *  over loopback.
+ */
+int main(int argc, char* argv[])
+{
+	QCoreApplication app(argc, argv);
+	app.setOrganizationName("SINTEF");
+	app.setOrganizationDomain("www.sintef.no");
+	app.setApplicationName("OpenIGTLinkBenchmark");
+
+	cx::StringMap args = cx::extractCommandlineOptions(app.arguments());
+	if (args.count("help") || args.count("h"))
+	{
+		std::cout << "Usage: " << app.applicationName().toStdString() << " (--arg <argval>)*" << std::endl;
+		std::cout << "    --port       : Tcp/IP port # (default=18444)" << std::endl;
+		std::cout << "    --frames     : Number of frames to send (default=600)" << std::endl;
+		std::cout << "    --width      : Frame width (default=1920)" << std::endl;
+		std::cout << "    --height     : Frame height (default=1080)" << std::endl;
+		std::cout << "    --components : Components per pixel (default=4)" << std::endl;
+		std::cout << "    --interval   : ms between frames, 0 is as fast as possible (default=16)" << std::endl;
+		return 0;
+	}
+	cx::Reporter::initialize();
+
+	int port = cx::convertStringWithDefault(args["port"], 18444);
+	int frames = std::max(1, cx::convertStringWithDefault(args["frames"], 600));
+	Eigen::Array3i dim(cx::convertStringWithDefault(args["width"], 1920),
+					   cx::convertStringWithDefault(args["height"], 1080),
+					   1);
+	int components = cx::convertStringWithDefault(args["components"], 4);
+	int interval = cx::convertStringWithDefault(args["interval"], 16);
+
+	cx::BenchmarkTimes times(frames);
+	cx::BenchmarkServer server(&times, dim, components, interval);
+	if (!server.listen(QHostAddress::LocalHost, port))
+	{
+		std::cout << "Server failed to start. Error: " << server.errorString().toStdString() << std::endl;
+		return 1;
+	}
+
+	cx::BenchmarkClient client(&times, port);
+	QObject::connect(&client, &QThread::finished, &app, &QCoreApplication::quit);
+	QTimer::singleShot(frames*std::max(interval, 100) + 30000, &app, &QCoreApplication::quit); // timeout
+	client.start();
+	app.exec();
+	client.exit();
+	client.wait();
+
+	std::vector<qint64> sent = times.getSent();
+	std::vector<qint64> received = times.getReceived();
+	std::vector<double> latency; // ms
+	qint64 first = -1;
+	qint64 last = -1;
+	for (unsigned i=0; i<received.size(); ++i)
+	{
+		if (received[i]<0 || sent[i]<0)
+			continue;
+		latency.push_back((received[i]-sent[i])/1.0E6);
+		if (first<0)
+			first = received[i];
+		last = received[i];
+	}
+
+	double megaBytes = double(dim.prod())*components/1.0E6;
+	std::cout << "Frames: " << frames << " of " << dim[0] << "x" << dim[1] << "x" << components
+			  << " (" << megaBytes << " MB)" << std::endl;
+	std::cout << "Received: " << latency.size() << ", dropped by server: " << server.getDroppedCount() << std::endl;
+	if (latency.size() > 1)
+	{
+		double fps = (latency.size()-1)/((last-first)/1.0E9);
+		std::sort(latency.begin(), latency.end());
+		double sum = 0;
+		for (unsigned i=0; i<latency.size(); ++i)
+			sum += latency[i];
+		std::cout << "Throughput: " << fps << " frames/s, " << fps*megaBytes << " MB/s" << std::endl;
+		std::cout << "Latency (ms): mean=" << sum/latency.size()
+				  << ", min=" << latency.front()
+				  << ", median=" << latency[latency.size()/2]
+				  << ", max=" << latency.back() << std::endl;
+	}
+	std::cout << "Receive buffers: " << client.getCreatedMessageCount() << " created, "
+			  << client.getRecycledMessageCount() << " recycled, "
+			  << client.getSharedMessageCount() << " used without copy" << std::endl;
+
+	cx::Reporter::shutdown();
+	return 0;
+}
@@ -16,6 +16,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <QMouseEvent>
 #include <QLabel>
 #include "cxTrackingService.h"
+#include "cxToolPositionHistory.h"
 #include "cxHelperWidgets.h"
 #include "cxTime.h"
 #include "cxLogger.h"
@@ -172,18 +173,18 @@ QColor PlaybackWidget::generateRandomToolColor() const
 std::vector<TimelineEvent> PlaybackWidget::convertHistoryToEvents(ToolPtr tool)
 {
 	std::vector<TimelineEvent> retval;
-	TimedTransformMapPtr history = tool->getPositionHistory();
+	ToolPositionHistoryPtr history = tool->getPositionHistory();
 	if (!history || history->empty())
 		return retval;
 	double timeout = 200;
-	TimelineEvent currentEvent(tool->getName() + " visible", history->begin()->first);
+	TimelineEvent currentEvent(tool->getName() + " visible", history->getFirstTimestamp());
 	currentEvent.mGroup = "tool";
 	currentEvent.mColor = this->generateRandomToolColor(); // QColor::fromHsv(110, 255, 192);
 //	std::cout << "first event start: " << currentEvent.mDescription << " " << currentEvent.mStartTime << " " << history->size() << std::endl;
 
-	for(TimedTransformMap::iterator iter=history->begin(); iter!=history->end(); ++iter)
+	for(ToolPositionHistory::const_iterator iter=history->begin(); iter!=history->end(); ++iter)
 	{
-		double current = iter->first;
+		double current = iter.time();
 
 		if (current - currentEvent.mEndTime > timeout)
 		{
@@ -378,6 +378,8 @@ VideoTab::VideoTab(QWidget *parent) :
 	m24bitRadioButton = NULL;
 	m8bitRadioButton = NULL;
 	mCompressCheckBox = NULL;
+	mLiveReconstructionCheckBox = NULL;
+	mFrameContainerCheckBox = NULL;
 
 }
 
@@ -405,10 +407,20 @@ void VideoTab::init()
 	mCompressCheckBox->setChecked(settings()->value("Ultrasound/CompressAcquisition", true).toBool());
 	mCompressCheckBox->setToolTip("Store the US Acquisition data as compressed MHD");
 
+	mFrameContainerCheckBox = new QCheckBox("Save acquisition as single file");
+	mFrameContainerCheckBox->setChecked(settings()->value("Ultrasound/FrameContainerFormat").toBool());
+	mFrameContainerCheckBox->setToolTip("Store all US frames in one .cxframes file instead of one MHD file per frame");
+
+	mLiveReconstructionCheckBox = new QCheckBox("Live reconstruction preview");
+	mLiveReconstructionCheckBox->setChecked(settings()->value("Ultrasound/LiveReconstruction").toBool());
+	mLiveReconstructionCheckBox->setToolTip("Show a coarse 3D volume growing while US is acquired. The ordinary reconstruction is still run afterwards.");
+
   toplayout->addSpacing(5);
   toplayout->addWidget(m24bitRadioButton);
   toplayout->addWidget(m8bitRadioButton);
   toplayout->addWidget(mCompressCheckBox);
+  toplayout->addWidget(mFrameContainerCheckBox);
+  toplayout->addWidget(mLiveReconstructionCheckBox);
 
   mTopLayout->addLayout(toplayout);
 
@@ -419,6 +431,8 @@ void VideoTab::saveParametersSlot()
   settings()->setValue("Ultrasound/acquisitionName", mAcquisitionNameLineEdit->text());
   settings()->setValue("Ultrasound/8bitAcquisitionData", m8bitRadioButton->isChecked());
   settings()->setValue("Ultrasound/CompressAcquisition", mCompressCheckBox->isChecked());
+  settings()->setValue("Ultrasound/FrameContainerFormat", mFrameContainerCheckBox->isChecked());
+  settings()->setValue("Ultrasound/LiveReconstruction", mLiveReconstructionCheckBox->isChecked());
 }
 
 //==============================================================================
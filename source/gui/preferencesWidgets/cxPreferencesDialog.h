@@ -158,6 +158,8 @@ protected:
   QRadioButton* m24bitRadioButton;
   QRadioButton* m8bitRadioButton;
   QCheckBox* mCompressCheckBox;
+  QCheckBox* mFrameContainerCheckBox;
+  QCheckBox* mLiveReconstructionCheckBox;
 };
 
 /**
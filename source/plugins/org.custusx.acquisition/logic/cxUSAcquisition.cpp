@@ -25,6 +25,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxAcquisitionService.h"
 #include "cxUsReconstructionService.h"
 #include "cxVisServices.h"
+#include "cxUSLiveReconstruction.h"
 
 
 namespace cx
@@ -49,6 +50,8 @@ USAcquisition::USAcquisition(AcquisitionPtr base, QObject* parent) :
 	connect(mBase.get(), SIGNAL(started()), this, SLOT(recordStarted()));
 	connect(mBase.get(), SIGNAL(acquisitionStopped()), this, SLOT(recordStopped()), Qt::QueuedConnection);
 	connect(mBase.get(), SIGNAL(cancelled()), this, SLOT(recordCancelled()));
+	if (this->getReconstructer())
+		connect(this->getReconstructer().get(), &UsReconstructionService::reconstructFinished, this, &USAcquisition::reconstructFinishedSlot);
 
 	this->checkIfReadySlot();
 }
@@ -155,11 +158,29 @@ void USAcquisition::recordStarted()
 
 	ToolPtr tool = this->getServices()->tracking()->getFirstProbe();
 	mCore->setWriteColor(this->getWriteColor());
+	mCore->setUseFrameContainer(settings()->value("Ultrasound/FrameContainerFormat").toBool());
 	mCore->startRecord(mBase->getLatestSession(),
 										 tool,
 										 this->getServices()->tracking()->getReferenceTool(),
 										 this->getRecordingVideoSources(tool),
 										 this->getServices()->file());
+
+	this->startLiveReconstruction(tool);
+}
+
+void USAcquisition::startLiveReconstruction(ToolPtr tool)
+{
+	if (!settings()->value("Ultrasound/LiveReconstruction").toBool())
+	{
+		mLiveReconstruction.reset();
+		return;
+	}
+
+	if (!mLiveReconstruction)
+		mLiveReconstruction.reset(new USLiveReconstruction(this->getServices()->patient()));
+	mLiveReconstruction->setPublishInterval(settings()->value("Ultrasound/LiveReconstructionInterval").toInt());
+	mLiveReconstruction->setSpacing(settings()->value("Ultrasound/LiveReconstructionSpacing").toDouble());
+	mLiveReconstruction->start(this->getServices()->video()->getActiveVideoSource(), tool);
 }
 
 void USAcquisition::recordStopped()
@@ -168,6 +189,8 @@ void USAcquisition::recordStopped()
 		return;
 
 	mCore->stopRecord();
+	if (mLiveReconstruction)
+		mLiveReconstruction->stop(); // keep the preview until it is replaced
 
 	this->sendAcquisitionDataToReconstructer();
 
@@ -184,6 +207,20 @@ void USAcquisition::recordStopped()
 void USAcquisition::recordCancelled()
 {
 	mCore->cancelRecord();
+	if (mLiveReconstruction)
+	{
+		mLiveReconstruction->stop();
+		mLiveReconstruction->removePreview();
+	}
+}
+
+/** The reconstruction of the last recording has been added to the patient:
+ *  Remove the preview, unless a new recording has started.
+ */
+void USAcquisition::reconstructFinishedSlot()
+{
+	if (mLiveReconstruction && !mLiveReconstruction->isRunning())
+		mLiveReconstruction->removePreview();
 }
 
 void USAcquisition::sendAcquisitionDataToReconstructer()
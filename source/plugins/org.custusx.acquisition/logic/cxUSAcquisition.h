@@ -26,6 +26,7 @@ namespace cx
 typedef boost::shared_ptr<class UsReconstructionFileMaker> UsReconstructionFileMakerPtr;
 typedef boost::shared_ptr<class SavingVideoRecorder> SavingVideoRecorderPtr;
 typedef boost::shared_ptr<class USSavingRecorder> USSavingRecorderPtr;
+typedef boost::shared_ptr<class USLiveReconstruction> USLiveReconstructionPtr;
 typedef boost::shared_ptr<class Acquisition> AcquisitionPtr;
 typedef boost::shared_ptr<class UsReconstructionService> UsReconstructionServicePtr;
 typedef boost::shared_ptr<class VisServices> VisServicesPtr;
@@ -51,6 +52,12 @@ typedef boost::shared_ptr<class VisServices> VisServicesPtr;
  * the reconstructer and saved to disk. saveDataCompleted() is
  * emitted after a successful save of each video stream.
  *
+ * If the setting Ultrasound/LiveReconstruction is on, a coarse
+ * preview volume is reconstructed while recording, see USLiveReconstruction.
+ * The preview stays in the patient after recording stops, until the
+ * reconstruction of the acquisition finishes or the next recording
+ * starts. A cancelled recording removes the preview.
+ *
  *  \date May 12, 2011
  *  \author christiana
  */
@@ -78,18 +85,21 @@ private slots:
 	void recordStarted();
 	void recordStopped();
 	void recordCancelled();
+	void reconstructFinishedSlot();
 
 private:
 	std::vector<VideoSourcePtr> getRecordingVideoSources(ToolPtr tool);
 	bool getWriteColor();
 	void sendAcquisitionDataToReconstructer();
 	void setReady(bool val, QString text);
+	void startLiveReconstruction(ToolPtr tool);
 
 	VisServicesPtr getServices();
 	UsReconstructionServicePtr getReconstructer();
 
 	AcquisitionPtr mBase;
 	USSavingRecorderPtr mCore;
+	USLiveReconstructionPtr mLiveReconstruction; ///< optional preview during recording
 	bool mReady;
 	QString mInfoText;
 };
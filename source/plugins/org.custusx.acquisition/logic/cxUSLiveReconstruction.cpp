@@ -0,0 +1,476 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#include "cxUSLiveReconstruction.h"
+
+#include <iterator>
+#include <limits>
+#include <QTimer>
+#include <QThread>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <vtkImageData.h>
+
+#include "cxLogger.h"
+#include "cxImage.h"
+#include "cxTool.h"
+#include "cxProbeSector.h"
+#include "cxVideoSource.h"
+#include "cxPatientModelService.h"
+#include "cxRegistrationTransform.h"
+#include "cxVolumeHelpers.h"
+#include "cxUSReconstructInputDataAlgoritms.h"
+
+namespace cx
+{
+
+namespace
+{
+const double gGrowMargin = 20; ///< mm added on each side when the volume grows
+const unsigned gMaxQueuedFrames = 100; ///< frames waiting for the worker thread
+const unsigned gMaxPendingFrames = 100; ///< frames waiting for a position
+
+/** Thread running a function, used instead of the global thread pool
+ *  for loops lasting as long as a recording.
+ */
+class FunctionThread : public QThread
+{
+public:
+	FunctionThread(boost::function<void ()> function) : mFunction(function) {}
+protected:
+	virtual void run() { mFunction(); }
+private:
+	boost::function<void ()> mFunction;
+};
+}
+
+///--------------------------------------------------------
+///--------------------------------------------------------
+///--------------------------------------------------------
+
+ProgressiveUSVolume::ProgressiveUSVolume(double spacing, double maxVolumeSize) :
+	mSpacing(spacing),
+	mMaxVolumeSize(maxVolumeSize),
+	m_prMdd(Transform3D::Identity()),
+	mOrigin_dd(Eigen::Array3d::Zero()),
+	mFrameCount(0)
+{
+}
+
+void ProgressiveUSVolume::setMask(vtkImageDataPtr mask)
+{
+	QMutexLocker locker(&mMutex);
+	mMask = mask;
+}
+
+int ProgressiveUSVolume::getFrameCount() const
+{
+	QMutexLocker locker(&mMutex);
+	return mFrameCount;
+}
+
+bool ProgressiveUSVolume::insert(vtkImageDataPtr frame, Transform3D prMu)
+{
+	if (!frame || frame->GetScalarType()!=VTK_UNSIGNED_CHAR || frame->GetNumberOfScalarComponents()!=1)
+		return false;
+
+	QMutexLocker locker(&mMutex);
+
+	Eigen::Array3i frameDims(frame->GetDimensions());
+	Vector3D frameSpacing(frame->GetSpacing());
+	unsigned char* framePtr = static_cast<unsigned char*>(frame->GetScalarPointer());
+	unsigned char* maskPtr = NULL;
+	if (mMask && (Eigen::Array3i(mMask->GetDimensions())==frameDims).all())
+		maskPtr = static_cast<unsigned char*>(mMask->GetScalarPointer());
+
+	if (!mVolume)
+		m_prMdd = prMu;
+	Transform3D ddMu = m_prMdd.inv() * prMu;
+
+	// bounding box of the frame in dd space
+	Eigen::Array3d lower = Eigen::Array3d::Constant(std::numeric_limits<double>::max());
+	Eigen::Array3d upper = Eigen::Array3d::Constant(-std::numeric_limits<double>::max());
+	for (int i=0; i<4; ++i)
+	{
+		Vector3D corner_u((i%2) * (frameDims[0]-1) * frameSpacing[0],
+						  (i/2) * (frameDims[1]-1) * frameSpacing[1],
+						  0);
+		Eigen::Array3d corner_dd = ddMu.coord(corner_u).array();
+		lower = lower.min(corner_dd);
+		upper = upper.max(corner_dd);
+	}
+
+	if (!this->growToInclude(lower, upper))
+		return false;
+
+	// pixel to voxel index, incremented along the frame axes
+	Eigen::Array3i dims(mVolume->GetDimensions());
+	unsigned char* volumePtr = static_cast<unsigned char*>(mVolume->GetScalarPointer());
+	Transform3D vMu = createTransformScale(Vector3D::Constant(1.0/mSpacing))
+			* createTransformTranslate(-Vector3D(mOrigin_dd.matrix()))
+			* ddMu;
+	Vector3D origin_v = vMu.coord(Vector3D::Zero());
+	Vector3D ex_v = vMu.vector(Vector3D(frameSpacing[0], 0, 0));
+	Vector3D ey_v = vMu.vector(Vector3D(0, frameSpacing[1], 0));
+
+	for (int y=0; y<frameDims[1]; ++y)
+	{
+		Vector3D row_v = origin_v + y*ey_v;
+		for (int x=0; x<frameDims[0]; ++x)
+		{
+			int pixel = x + y*frameDims[0];
+			if (maskPtr && !maskPtr[pixel])
+				continue;
+			Vector3D p_v = row_v + x*ex_v;
+			int vx = static_cast<int>(p_v[0]+0.5);
+			int vy = static_cast<int>(p_v[1]+0.5);
+			int vz = static_cast<int>(p_v[2]+0.5);
+			if (vx<0 || vy<0 || vz<0 || vx>=dims[0] || vy>=dims[1] || vz>=dims[2])
+				continue;
+			// zero is reserved for voxels not hit by any pixel
+			volumePtr[vx + vy*dims[0] + vz*dims[0]*dims[1]] = std::max<unsigned char>(framePtr[pixel], 1);
+		}
+	}
+
+	++mFrameCount;
+	return true;
+}
+
+/** Grow the volume to include the dd space box [lower,upper].
+ *  The old contents are kept on the same voxel grid.
+ */
+bool ProgressiveUSVolume::growToInclude(Eigen::Array3d lower, Eigen::Array3d upper)
+{
+	Eigen::Array3d origin;
+	Eigen::Array3i dims;
+	Eigen::Array3i shift = Eigen::Array3i::Zero();
+
+	if (!mVolume)
+	{
+		origin = lower - gGrowMargin;
+		dims = ((upper - origin + gGrowMargin)/mSpacing).ceil().cast<int>() + 1;
+	}
+	else
+	{
+		Eigen::Array3i oldDims(mVolume->GetDimensions());
+		Eigen::Array3d oldUpper = mOrigin_dd + (oldDims-1).cast<double>()*mSpacing;
+		if ((lower >= mOrigin_dd).all() && (upper <= oldUpper).all())
+			return true;
+
+		Eigen::Array3d newLower = mOrigin_dd.min(lower - gGrowMargin);
+		Eigen::Array3d newUpper = oldUpper.max(upper + gGrowMargin);
+		shift = ((mOrigin_dd - newLower)/mSpacing).ceil().cast<int>();
+		origin = mOrigin_dd - shift.cast<double>()*mSpacing;
+		dims = ((newUpper - origin)/mSpacing).ceil().cast<int>() + 1;
+	}
+
+	if (dims.cast<double>().prod() > mMaxVolumeSize)
+		return false;
+
+	vtkImageDataPtr volume = generateVtkImageData(dims, Vector3D::Constant(mSpacing), 0);
+	if (mVolume)
+	{
+		Eigen::Array3i oldDims(mVolume->GetDimensions());
+		unsigned char* oldPtr = static_cast<unsigned char*>(mVolume->GetScalarPointer());
+		unsigned char* newPtr = static_cast<unsigned char*>(volume->GetScalarPointer());
+		for (int z=0; z<oldDims[2]; ++z)
+		{
+			for (int y=0; y<oldDims[1]; ++y)
+			{
+				unsigned char* src = oldPtr + y*oldDims[0] + z*oldDims[0]*oldDims[1];
+				unsigned char* dst = newPtr + shift[0] + (y+shift[1])*dims[0] + (z+shift[2])*dims[0]*dims[1];
+				std::copy(src, src+oldDims[0], dst);
+			}
+		}
+	}
+
+	mVolume = volume;
+	mOrigin_dd = origin;
+	return true;
+}
+
+vtkImageDataPtr ProgressiveUSVolume::getVolumeCopy(Transform3D* prMd) const
+{
+	QMutexLocker locker(&mMutex);
+	if (!mVolume)
+		return vtkImageDataPtr();
+
+	vtkImageDataPtr copy = vtkImageDataPtr::New();
+	copy->DeepCopy(mVolume);
+	if (prMd)
+		*prMd = m_prMdd * createTransformTranslate(Vector3D(mOrigin_dd.matrix()));
+	return copy;
+}
+
+///--------------------------------------------------------
+///--------------------------------------------------------
+///--------------------------------------------------------
+
+USLiveReconstruction::USLiveReconstruction(PatientModelServicePtr patientModelService) :
+	mPatientModelService(patientModelService),
+	mPublishInterval(1000),
+	mSpacing(0.5),
+	mMaxVolumeSize(256*256*256),
+	mMaxTimeDiff(250),
+	mStopWorker(false),
+	mDroppedFrames(0),
+	mRejectedFrames(0),
+	mPublishedFrameCount(0)
+{
+	mPublishTimer = new QTimer(this);
+	connect(mPublishTimer, &QTimer::timeout, this, &USLiveReconstruction::publishSlot);
+}
+
+USLiveReconstruction::~USLiveReconstruction()
+{
+	this->stop();
+}
+
+void USLiveReconstruction::setPublishInterval(int ms)
+{
+	mPublishInterval = ms;
+}
+
+void USLiveReconstruction::setSpacing(double mm)
+{
+	mSpacing = mm;
+}
+
+void USLiveReconstruction::setMaxVolumeSize(double voxels)
+{
+	mMaxVolumeSize = voxels;
+}
+
+void USLiveReconstruction::start(VideoSourcePtr source, ToolPtr tool)
+{
+	this->stop();
+	this->removePreview();
+	if (!source || !tool)
+		return;
+
+	mSource = source;
+	mTool = tool;
+
+	ProbeSector sector;
+	if (tool->getProbe())
+		sector.setData(tool->getProbe()->getProbeDefinition());
+	m_tMu = sector.get_tMu() * sector.get_uMv();
+
+	mVolume.reset(new ProgressiveUSVolume(mSpacing, mMaxVolumeSize));
+	if (tool->getProbe())
+		mVolume->setMask(sector.getMask());
+
+	mPendingFrames.clear();
+	mPositions.clear();
+	mJobs.clear();
+	mStopWorker = false;
+	mDroppedFrames = 0;
+	mRejectedFrames = 0;
+	mPublishedFrameCount = 0;
+
+	connect(mSource.get(), &VideoSource::newFrame, this, &USLiveReconstruction::newFrameSlot);
+	connect(mTool.get(), &Tool::toolTransformAndTimestamp, this, &USLiveReconstruction::toolTransformAndTimestampSlot);
+
+	mWorker.reset(new FunctionThread(boost::bind(&USLiveReconstruction::workerLoop, this)));
+	mWorker->start();
+	mPublishTimer->start(mPublishInterval);
+}
+
+void USLiveReconstruction::stop()
+{
+	if (!this->isRunning())
+		return;
+
+	disconnect(mSource.get(), &VideoSource::newFrame, this, &USLiveReconstruction::newFrameSlot);
+	disconnect(mTool.get(), &Tool::toolTransformAndTimestamp, this, &USLiveReconstruction::toolTransformAndTimestampSlot);
+	mPublishTimer->stop();
+
+	// frames still lacking a position after this are lost
+	this->processPendingFrames();
+	mDroppedFrames += mPendingFrames.size();
+	mPendingFrames.clear();
+	mPositions.clear();
+
+	{
+		QMutexLocker locker(&mJobMutex);
+		mStopWorker = true;
+		mJobAdded.wakeAll();
+	}
+	mWorker->wait();
+	mWorker.reset();
+
+	this->publishSlot();
+	int dropped = this->getDroppedFrameCount();
+	if (dropped)
+		reportDebug(QString("Live reconstruction dropped %1 of %2 frames")
+					.arg(dropped)
+					.arg(dropped + mVolume->getFrameCount()));
+
+	mSource.reset();
+	mTool.reset();
+}
+
+int USLiveReconstruction::getDroppedFrameCount() const
+{
+	return mDroppedFrames + mRejectedFrames;
+}
+
+void USLiveReconstruction::removePreview()
+{
+	if (mPreview)
+		mPatientModelService->removeData(mPreview->getUid());
+	mPreview.reset();
+}
+
+void USLiveReconstruction::newFrameSlot()
+{
+	Job job;
+	job.frame = this->convertTo8bitGrayCopy(mSource->getVtkImageData());
+	if (!job.frame)
+		return;
+	job.time = mSource->getAdvancedTimeInfo().getAcquisitionTime();
+
+	mPendingFrames.push_back(job);
+	if (mPendingFrames.size() > gMaxPendingFrames)
+	{
+		mPendingFrames.pop_front();
+		++mDroppedFrames;
+	}
+	this->processPendingFrames();
+}
+
+void USLiveReconstruction::toolTransformAndTimestampSlot(Transform3D prMt, double timestamp)
+{
+	mPositions[timestamp] = prMt;
+	this->processPendingFrames();
+}
+
+/** Send frames with a position on both sides in time to the worker,
+ *  using the same interpolation as the offline reconstruction.
+ */
+void USLiveReconstruction::processPendingFrames()
+{
+	while (!mPendingFrames.empty())
+	{
+		Job job = mPendingFrames.front();
+		TimedTransformMap::iterator next = mPositions.lower_bound(job.time);
+		if (next==mPositions.end())
+			break; // wait for more positions
+
+		bool valid = (next->first - job.time) <= mMaxTimeDiff;
+		Transform3D prMt = next->second;
+		if (next!=mPositions.begin())
+		{
+			TimedTransformMap::iterator prev = std::prev(next);
+			valid = valid && (job.time - prev->first) <= mMaxTimeDiff;
+			double t = 0;
+			if (!similar(next->first, prev->first))
+				t = (job.time - prev->first)/(next->first - prev->first);
+			prMt = USReconstructInputDataAlgorithm::slerpInterpolate(prev->second, next->second, t);
+		}
+		mPendingFrames.pop_front();
+
+		if (!valid)
+		{
+			++mDroppedFrames;
+			continue;
+		}
+		job.prMu = prMt * m_tMu;
+		this->addJob(job);
+	}
+
+	// keep only the positions needed to interpolate the remaining frames
+	if (mPositions.empty())
+		return;
+	double oldest = mPendingFrames.empty() ? mPositions.rbegin()->first : mPendingFrames.front().time;
+	TimedTransformMap::iterator keep = mPositions.lower_bound(oldest);
+	if (keep!=mPositions.begin())
+		--keep;
+	mPositions.erase(mPositions.begin(), keep);
+}
+
+void USLiveReconstruction::addJob(Job job)
+{
+	QMutexLocker locker(&mJobMutex);
+	if (mJobs.size() >= gMaxQueuedFrames)
+	{
+		mJobs.pop_front();
+		++mDroppedFrames;
+	}
+	mJobs.push_back(job);
+	mJobAdded.wakeOne();
+}
+
+void USLiveReconstruction::workerLoop()
+{
+	while (true)
+	{
+		Job job;
+		{
+			QMutexLocker locker(&mJobMutex);
+			while (mJobs.empty() && !mStopWorker)
+				mJobAdded.wait(&mJobMutex);
+			if (mJobs.empty())
+				return;
+			job = mJobs.front();
+			mJobs.pop_front();
+		}
+
+		if (!mVolume->insert(job.frame, job.prMu))
+			++mRejectedFrames;
+	}
+}
+
+vtkImageDataPtr USLiveReconstruction::convertTo8bitGrayCopy(vtkImageDataPtr input)
+{
+	if (!input)
+		return vtkImageDataPtr();
+
+	vtkImageDataPtr gray = input;
+	if (input->GetNumberOfScalarComponents()>1)
+		gray = convertImageDataToGrayScale(input);
+	if (gray->GetScalarType()!=VTK_UNSIGNED_CHAR)
+		return vtkImageDataPtr();
+
+	vtkImageDataPtr copy = vtkImageDataPtr::New();
+	copy->DeepCopy(gray);
+	return copy;
+}
+
+void USLiveReconstruction::publishSlot()
+{
+	if (!mVolume)
+		return;
+	int frameCount = mVolume->getFrameCount();
+	if (frameCount==mPublishedFrameCount)
+		return;
+
+	Transform3D prMd;
+	vtkImageDataPtr volume = mVolume->getVolumeCopy(&prMd);
+	if (!volume)
+		return;
+	mPublishedFrameCount = frameCount;
+
+	bool created = !mPreview;
+	if (created)
+	{
+		mPreview = mPatientModelService->createSpecificData<Image>("US_live_%1", "US live %1");
+		mPreview->setModality("US");
+		mPreview->setImageType("B-Mode");
+	}
+	mPreview->setVtkImageData(volume, created);
+	mPreview->get_rMd_History()->setRegistration(mPatientModelService->get_rMpr() * prMd);
+	if (created)
+		mPatientModelService->insertData(mPreview);
+
+	emit previewUpdated();
+}
+
+} // namespace cx
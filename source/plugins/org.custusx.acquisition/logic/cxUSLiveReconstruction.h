@@ -0,0 +1,171 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXUSLIVERECONSTRUCTION_H
+#define CXUSLIVERECONSTRUCTION_H
+
+#include "org_custusx_acquisition_Export.h"
+
+#include <deque>
+#include <map>
+#include <QObject>
+#include <QMutex>
+#include <QWaitCondition>
+#include "cxForwardDeclarations.h"
+#include "cxTransform3D.h"
+
+class QTimer;
+class QThread;
+
+namespace cx
+{
+typedef std::map<double, Transform3D> TimedTransformMap;
+typedef boost::shared_ptr<class ProgressiveUSVolume> ProgressiveUSVolumePtr;
+typedef boost::shared_ptr<class USLiveReconstruction> USLiveReconstructionPtr;
+
+/**
+ * \file
+ * \addtogroup org_custusx_acquisition
+ * @{
+ */
+
+/**
+ * \brief Volume that US frames are splatted into one at a time.
+ *
+ * Pixel nearest neighbour without hole filling: Each pixel inside the
+ * mask is written to the nearest voxel. The first frame defines the
+ * orientation of the volume. The volume grows when a frame falls outside
+ * of it, up to a max size.
+ *
+ * Thread-safe: insert() can be called from a worker thread while the
+ * volume is read from another.
+ *
+ *  \date 2026-10-18
+ */
+class org_custusx_acquisition_EXPORT ProgressiveUSVolume
+{
+public:
+	/**
+	 * \param spacing Voxel spacing in mm.
+	 * \param maxVolumeSize Max number of voxels in the volume.
+	 */
+	ProgressiveUSVolume(double spacing, double maxVolumeSize);
+	void setMask(vtkImageDataPtr mask); ///< optional mask with the frame dimensions, zero for pixels to ignore
+	/**
+	 * Splat an 8 bit frame with position prMu into the volume.
+	 * Return false if the frame is ignored, because the volume would exceed the max size.
+	 */
+	bool insert(vtkImageDataPtr frame, Transform3D prMu);
+	/**
+	 * Return a copy of the current volume, zero if no frames are inserted.
+	 * The position of the copy is returned in prMd.
+	 */
+	vtkImageDataPtr getVolumeCopy(Transform3D* prMd) const;
+	int getFrameCount() const;
+
+private:
+	bool growToInclude(Eigen::Array3d lower, Eigen::Array3d upper);
+
+	mutable QMutex mMutex;
+	double mSpacing;
+	double mMaxVolumeSize;
+	vtkImageDataPtr mMask;
+	Transform3D m_prMdd; ///< orientation of volume, given by the first frame
+	Eigen::Array3d mOrigin_dd; ///< position of voxel (0,0,0) in dd space
+	vtkImageDataPtr mVolume;
+	int mFrameCount;
+};
+
+/**
+ * \brief Progressive 3D reconstruction during US acquisition.
+ *
+ * Frames from a video source are paired with probe positions interpolated
+ * from the tool position stream, and splatted into a ProgressiveUSVolume on a
+ * dedicated worker thread. The volume is published to the patient model as a preview
+ * Image at a fixed interval.
+ *
+ * The preview is a low latency estimate only: The offline reconstruction
+ * of the saved acquisition remains the authoritative result.
+ *
+ *  \date 2026-10-18
+ */
+class org_custusx_acquisition_EXPORT USLiveReconstruction : public QObject
+{
+	Q_OBJECT
+public:
+	USLiveReconstruction(PatientModelServicePtr patientModelService);
+	virtual ~USLiveReconstruction();
+
+	void setPublishInterval(int ms);
+	void setSpacing(double mm);
+	void setMaxVolumeSize(double voxels);
+
+	void start(VideoSourcePtr source, ToolPtr tool);
+	void stop(); ///< process remaining frames and publish the final preview
+	int getDroppedFrameCount() const; ///< frames lost in the last run, including frames rejected by the volume. Valid when not running.
+	bool isRunning() const { return mSource ? true : false; }
+	ImagePtr getPreview() { return mPreview; }
+	void removePreview(); ///< remove the preview from the patient model
+
+signals:
+	void previewUpdated();
+
+private slots:
+	void newFrameSlot();
+	void toolTransformAndTimestampSlot(Transform3D prMt, double timestamp);
+	void publishSlot();
+
+private:
+	struct Job
+	{
+		vtkImageDataPtr frame;
+		double time;
+		Transform3D prMu;
+	};
+	void processPendingFrames();
+	void addJob(Job job);
+	void workerLoop();
+	vtkImageDataPtr convertTo8bitGrayCopy(vtkImageDataPtr input);
+
+	PatientModelServicePtr mPatientModelService;
+	int mPublishInterval;
+	double mSpacing;
+	double mMaxVolumeSize;
+	double mMaxTimeDiff;
+
+	VideoSourcePtr mSource;
+	ToolPtr mTool;
+	Transform3D m_tMu;
+
+	// main thread: frames waiting for positions
+	std::deque<Job> mPendingFrames;
+	TimedTransformMap mPositions;
+
+	// worker thread: frames ready for splatting
+	QMutex mJobMutex;
+	QWaitCondition mJobAdded;
+	std::deque<Job> mJobs;
+	bool mStopWorker;
+	int mDroppedFrames;
+	int mRejectedFrames; ///< frames ignored by the volume, written by the worker thread only
+	boost::shared_ptr<QThread> mWorker;
+
+	ProgressiveUSVolumePtr mVolume;
+	QTimer* mPublishTimer;
+	int mPublishedFrameCount;
+	ImagePtr mPreview;
+};
+
+/**
+* @}
+*/
+}
+
+#endif // CXUSLIVERECONSTRUCTION_H
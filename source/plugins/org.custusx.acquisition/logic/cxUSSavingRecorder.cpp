@@ -32,7 +32,7 @@ namespace cx
 {
 
 
-USSavingRecorder::USSavingRecorder() : mDoWriteColor(true), m_rMpr(Transform3D::Identity())
+USSavingRecorder::USSavingRecorder() : mDoWriteColor(true), mUseFrameContainer(false), m_rMpr(Transform3D::Identity())
 {
 
 }
@@ -51,6 +51,11 @@ void USSavingRecorder::setWriteColor(bool on)
 	mDoWriteColor = on;
 }
 
+void USSavingRecorder::setUseFrameContainer(bool on)
+{
+	mUseFrameContainer = on;
+}
+
 void USSavingRecorder::set_rMpr(Transform3D rMpr)
 {
 	m_rMpr = rMpr;
@@ -76,7 +81,8 @@ void USSavingRecorder::startRecord(RecordSessionPtr session, ToolPtr tool, ToolP
 								 QString("%1_%2").arg(session->getDescription()).arg(video[i]->getUid()),
 								 false, // no compression when saving to cache
 								 mDoWriteColor,
-								filemanager
+								filemanager,
+								mUseFrameContainer
 								));
 		videoRecorder->startRecord();
 		mVideoRecorder.push_back(videoRecorder);
@@ -122,14 +128,14 @@ USReconstructInputData USSavingRecorder::getDataForStream(unsigned videoRecorder
 		return USReconstructInputData();
 
 	SavingVideoRecorderPtr videoRecorder = mVideoRecorder[videoRecorderIndex];
-	videoRecorder->completeSave(); // just in case - should have been done earlier.
+	videoRecorder->completeSave(); // done in stopRecord(), but required before getImageData()
 	TimedTransformMap trackerRecordedData = RecordSession::getToolHistory_prMt(mRecordingTool, mSession, true);
 	std::map<double, cx::ToolPositionMetadata> trackerMetadata = RecordSession::getToolHistory_metadata(mRecordingTool, mSession, true);
 	std::map<double, cx::ToolPositionMetadata> referenceTrackerMetadata = RecordSession::getToolHistory_metadata(mReference, mSession, true);
 	std::cout << "----------- "
 				 "trackerMetadata : " << trackerMetadata.size() << std::endl;
 
-	CachedImageDataContainerPtr imageData = videoRecorder->getImageData();
+	ImageDataContainerPtr imageData = videoRecorder->getImageData();
 	std::vector<TimeInfo> imageTimestamps = videoRecorder->getTimestamps();
 	QString streamSessionName = mSession->getDescription()+"_"+videoRecorder->getSource()->getUid();
 
@@ -181,6 +187,7 @@ void USSavingRecorder::saveStreamSession(USReconstructInputData reconstructData,
 	UsReconstructionFileMakerPtr fileMaker;
 	fileMaker.reset(new UsReconstructionFileMaker(streamSessionName));
 	fileMaker->setReconstructData(reconstructData);
+	fileMaker->setUseFrameContainer(mUseFrameContainer);
 
 	// now start saving of data to the patient folder, compressed version:
 	QFuture<QString> fileMakerFuture =
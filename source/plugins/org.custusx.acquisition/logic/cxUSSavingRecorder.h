@@ -67,6 +67,7 @@ public:
 	void cancelRecord();
 
 	void setWriteColor(bool on);
+	void setUseFrameContainer(bool on); ///< save frames in one .cxframes file instead of one mhd file per frame
 	void set_rMpr(Transform3D rMpr);
 	/**
 	  * Retrieve an in-memory data set for the given stream uid.
@@ -98,6 +99,7 @@ private:
 	ToolPtr mRecordingTool;
 	ToolPtr mReference;
 	bool mDoWriteColor;
+	bool mUseFrameContainer;
 	Transform3D m_rMpr;
 };
 typedef boost::shared_ptr<USSavingRecorder> USSavingRecorderPtr;
@@ -0,0 +1,112 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <QDomDocument>
+#include "cxRecordSession.h"
+#include "cxDummyTool.h"
+#include "cxToolPositionHistory.h"
+#include "cxPositionLogFile.h"
+#include "cxDataLocations.h"
+
+namespace cxtest
+{
+
+namespace
+{
+QString getPositionLogFilename()
+{
+	QString path = cx::DataLocations::getTestDataPath() + "/temp/RecordSession";
+	QDir().mkpath(path);
+	QString filename = path + "/toolpositions." + cx::PositionLogReader::getSuffix();
+	QFile::remove(filename);
+	return filename;
+}
+
+cx::TimedTransformMap createPositions(double startTime, int count)
+{
+	cx::TimedTransformMap retval;
+	for (int i=0; i<count; ++i)
+		retval[startTime + 25*i] = cx::createTransformTranslate(cx::Vector3D(i, 2*i, 10)) * cx::createTransformRotateZ(0.01*i);
+	return retval;
+}
+
+/** Session as stored in the patient file, with one interval.
+ */
+cx::RecordSessionPtr createSession(double startTime, double stopTime)
+{
+	QDomDocument doc;
+	QDomElement node = doc.createElement("recordSession");
+	doc.appendChild(node);
+	node.setAttribute("uid", "1_20261018T100000");
+
+	QDomElement start = doc.createElement("start");
+	start.appendChild(doc.createTextNode(QString::number(startTime, 'f', 0)));
+	node.appendChild(start);
+	QDomElement stop = doc.createElement("stop");
+	stop.appendChild(doc.createTextNode(QString::number(stopTime, 'f', 0)));
+	node.appendChild(stop);
+	QDomElement description = doc.createElement("description");
+	description.appendChild(doc.createTextNode("Acquisition_1_20261018T100000"));
+	node.appendChild(description);
+
+	cx::RecordSessionPtr retval(new cx::RecordSession());
+	retval->parseXml(node);
+	return retval;
+}
+} // namespace
+
+TEST_CASE("RecordSession: Tool history of a reloaded session is read from the position log", "[unit][modules][Acquisition]")
+{
+	double startTime = 1760000000000;
+	cx::TimedTransformMap positions = createPositions(startTime, 400);
+
+	// recorded in an earlier run of the application
+	QString filename = getPositionLogFilename();
+	{
+		cx::PositionLogWriter writer(filename);
+		REQUIRE(writer.isValid());
+		writer.write("tool", positions);
+	}
+
+	// reloaded: the tool history is empty, and the log is the source of older positions
+	cx::DummyToolPtr tool(new cx::DummyTool("tool"));
+	REQUIRE(tool->getPositionHistory()->empty());
+	cx::PositionLogReaderPtr log(new cx::PositionLogReader(filename));
+	REQUIRE(log->isValid());
+	tool->getPositionHistory()->setSource([log](double start, double stop)
+	{
+		return log->getSessionHistory("tool", start, stop);
+	});
+
+	cx::RecordSessionPtr session = createSession(startTime + 1000, startTime + 5000);
+	cx::TimedTransformMap history = cx::RecordSession::getToolHistory_prMt(tool, session, true);
+
+	cx::TimedTransformMap::iterator begin = positions.lower_bound(startTime + 1000);
+	cx::TimedTransformMap::iterator end = positions.upper_bound(startTime + 5000);
+	REQUIRE(history.size() == size_t(std::distance(begin, end)));
+	REQUIRE(history.size() == 161);
+	for (cx::TimedTransformMap::iterator iter=history.begin(); iter!=history.end(); ++iter, ++begin)
+	{
+		CHECK(iter->first == begin->first);
+		CHECK(cx::similar(iter->second, begin->second, 1.0E-3));
+	}
+
+	// the tool history holds the log open
+	tool.reset();
+	log.reset();
+	QFile::remove(filename);
+}
+
+} // namespace cxtest
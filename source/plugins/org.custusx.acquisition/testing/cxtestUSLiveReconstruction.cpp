@@ -0,0 +1,91 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+#include <algorithm>
+#include <vtkImageData.h>
+#include "cxUSLiveReconstruction.h"
+#include "cxVolumeHelpers.h"
+
+namespace cxtest
+{
+
+namespace
+{
+vtkImageDataPtr createFrame(unsigned char value)
+{
+	return cx::generateVtkImageData(Eigen::Array3i(20, 10, 1), cx::Vector3D(1, 1, 1), value);
+}
+
+int countVoxelsWithValue(vtkImageDataPtr volume, unsigned char value)
+{
+	unsigned char* ptr = static_cast<unsigned char*>(volume->GetScalarPointer());
+	int size = volume->GetNumberOfPoints();
+	return std::count(ptr, ptr+size, value);
+}
+} // namespace
+
+TEST_CASE("ProgressiveUSVolume: Empty volume returns no data", "[unit][modules][Acquisition]")
+{
+	cx::ProgressiveUSVolume volume(1, 1E6);
+	cx::Transform3D prMd;
+	CHECK(!volume.getVolumeCopy(&prMd));
+	CHECK(volume.getFrameCount()==0);
+}
+
+TEST_CASE("ProgressiveUSVolume: Frames are splatted into a growing volume", "[unit][modules][Acquisition]")
+{
+	cx::ProgressiveUSVolume volume(1, 1E7);
+
+	REQUIRE(volume.insert(createFrame(100), cx::Transform3D::Identity()));
+	cx::Transform3D prMd;
+	vtkImageDataPtr first = volume.getVolumeCopy(&prMd);
+	REQUIRE(first);
+	CHECK(countVoxelsWithValue(first, 100)==200);
+	// pixel (0,0) of the first frame is at the origin of pr
+	Eigen::Array3i pixel_d = (prMd.inv().coord(cx::Vector3D::Zero()).array()+0.5).cast<int>();
+	unsigned char* ptr = static_cast<unsigned char*>(first->GetScalarPointer(pixel_d[0], pixel_d[1], pixel_d[2]));
+	CHECK(*ptr==100);
+
+	// a frame far away forces the volume to grow, keeping the old content
+	cx::Transform3D prMu = cx::createTransformTranslate(cx::Vector3D(0, 0, 50));
+	REQUIRE(volume.insert(createFrame(200), prMu));
+	vtkImageDataPtr grown = volume.getVolumeCopy(&prMd);
+	CHECK(Eigen::Array3i(grown->GetDimensions())[2] > Eigen::Array3i(first->GetDimensions())[2]);
+	CHECK(countVoxelsWithValue(grown, 100)==200);
+	CHECK(countVoxelsWithValue(grown, 200)==200);
+	CHECK(volume.getFrameCount()==2);
+}
+
+TEST_CASE("ProgressiveUSVolume: Frames exceeding the max size are ignored", "[unit][modules][Acquisition]")
+{
+	cx::ProgressiveUSVolume volume(1, 2E5);
+
+	REQUIRE(volume.insert(createFrame(100), cx::Transform3D::Identity()));
+	cx::Transform3D prMu = cx::createTransformTranslate(cx::Vector3D(0, 0, 1000));
+	CHECK(!volume.insert(createFrame(200), prMu));
+	CHECK(volume.getFrameCount()==1);
+}
+
+TEST_CASE("ProgressiveUSVolume: Masked pixels are ignored", "[unit][modules][Acquisition]")
+{
+	cx::ProgressiveUSVolume volume(1, 1E6);
+	vtkImageDataPtr mask = createFrame(0);
+	unsigned char* maskPtr = static_cast<unsigned char*>(mask->GetScalarPointer());
+	std::fill(maskPtr, maskPtr+50, 1);
+	volume.setMask(mask);
+
+	REQUIRE(volume.insert(createFrame(100), cx::Transform3D::Identity()));
+	cx::Transform3D prMd;
+	CHECK(countVoxelsWithValue(volume.getVolumeCopy(&prMd), 100)==50);
+}
+
+} // namespace cxtest
@@ -0,0 +1,84 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <iostream>
+#include <QDir>
+#include <QElapsedTimer>
+#include "cxtestUSSavingRecorderFixture.h"
+#include "cxSavingVideoRecorder.h"
+#include "cxVolumeHelpers.h"
+#include "cxFileHelpers.h"
+#include "cxReporter.h"
+
+namespace cxtest
+{
+
+namespace
+{
+/** Feed a synthetic color 1080p stream to a save thread at the given rate,
+ *  and report the sustained write rate and the number of dropped frames.
+ */
+void recordSynthetic1080pStream(bool useFrameContainer, double fps, int seconds)
+{
+	cx::Reporter::initialize();
+	QString folder = USSavingRecorderFixture::getDataPath() + "/VideoRecorderSaveThread";
+	QDir().mkpath(folder);
+
+	vtkImageDataPtr frame = cx::generateVtkImageData(Eigen::Array3i(1920, 1080, 1), cx::Vector3D(0.1, 0.1, 1), 100, 3);
+	cx::VideoRecorderSaveThread thread(NULL, folder, "stream", false, true, useFrameContainer);
+	thread.start();
+
+	int count = fps*seconds;
+	QElapsedTimer timer;
+	timer.start();
+	for (int i=0; i<count; ++i)
+	{
+		thread.addData(cx::TimeInfo(timer.elapsed()), frame);
+		qint64 next = (i+1)*1000/fps;
+		while (timer.elapsed() < next)
+			QThread::msleep(1);
+	}
+	qint64 recordTime = timer.elapsed();
+	thread.stop();
+	thread.wait();
+	qint64 totalTime = timer.elapsed();
+
+	int written = thread.getWrittenFrames();
+	int dropped = thread.getDroppedFrames();
+	std::cout << QString("VideoRecorderSaveThread %1, 1080p at %2 fps: wrote %3 frames in %4 s (%5 fps sustained), dropped %6, flush after stop %7 ms")
+				 .arg(useFrameContainer ? "frame container" : "mhd files")
+				 .arg(fps)
+				 .arg(written)
+				 .arg(totalTime/1000.0, 0, 'f', 2)
+				 .arg(written*1000.0/totalTime, 0, 'f', 1)
+				 .arg(dropped)
+				 .arg(totalTime-recordTime)
+				 .toStdString() << std::endl;
+
+	CHECK(written + dropped == count);
+	cx::removeNonemptyDirRecursively(folder);
+	cx::Reporter::shutdown();
+}
+} // namespace
+
+TEST_CASE("VideoRecorderSaveThread: Benchmark 1080p stream to mhd files", "[speed][integration][modules][Acquisition]")
+{
+	recordSynthetic1080pStream(false, 60, 5);
+}
+
+TEST_CASE("VideoRecorderSaveThread: Benchmark 1080p stream to frame container", "[speed][integration][modules][Acquisition]")
+{
+	recordSynthetic1080pStream(true, 60, 5);
+}
+
+} // namespace cxtest
@@ -136,8 +136,9 @@ void TemporalCalibrationWidget::calibrateSlot()
   double shift = mAlgorithm->calibrate(&success);
   if (success)
   {
-	  reportSuccess(QString("Completed temporal calibration, found shift %1 ms").arg(shift,0,'f',0));
-	  mResult->setText(QString("Shift = %1 ms").arg(shift, 0, 'f', 0));
+	  double confidence = mAlgorithm->getConfidence();
+	  reportSuccess(QString("Completed temporal calibration, found shift %1 ms, confidence %2").arg(shift,0,'f',1).arg(confidence,0,'f',2));
+	  mResult->setText(QString("Shift = %1 ms, confidence = %2").arg(shift, 0, 'f', 1).arg(confidence, 0, 'f', 2));
   }
   else
   {
@@ -0,0 +1,154 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+                 
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+                 
+CustusX is released under a BSD 3-Clause license.
+                 
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxSignalCorrelation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+namespace cx
+{
+
+namespace
+{
+typedef std::complex<double> Complex;
+
+/** In-place iterative radix-2 FFT. data.size() must be a power of two.
+ */
+void fft(std::vector<Complex>& data, bool inverse)
+{
+	size_t n = data.size();
+
+	for (size_t i=1, j=0; i<n; ++i)
+	{
+		size_t bit = n >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+		if (i < j)
+			std::swap(data[i], data[j]);
+	}
+
+	for (size_t length=2; length<=n; length <<= 1)
+	{
+		double angle = 2*M_PI/length * (inverse ? 1 : -1);
+		Complex step(cos(angle), sin(angle));
+		for (size_t i=0; i<n; i+=length)
+		{
+			Complex w(1);
+			for (size_t j=0; j<length/2; ++j)
+			{
+				Complex u = data[i+j];
+				Complex v = data[i+j+length/2] * w;
+				data[i+j] = u + v;
+				data[i+j+length/2] = u - v;
+				w *= step;
+			}
+		}
+	}
+
+	if (inverse)
+		for (size_t i=0; i<n; ++i)
+			data[i] /= double(n);
+}
+
+std::vector<Complex> padded(const std::vector<double>& x, size_t size)
+{
+	std::vector<Complex> retval(size, Complex(0));
+	std::copy(x.begin(), x.end(), retval.begin());
+	return retval;
+}
+
+} // namespace
+
+std::vector<double> computeLaggedProducts(const std::vector<double>& x, const std::vector<double>& y, int minLag, int maxLag)
+{
+	std::vector<double> retval(std::max(maxLag-minLag+1, 0), 0);
+	if (x.empty() || y.empty())
+		return retval;
+
+	size_t size = 1;
+	while (size < x.size()+y.size())
+		size <<= 1;
+
+	std::vector<Complex> X = padded(x, size);
+	std::vector<Complex> Y = padded(y, size);
+	fft(X, false);
+	fft(Y, false);
+	for (size_t i=0; i<size; ++i)
+		X[i] = std::conj(X[i]) * Y[i];
+	fft(X, true);
+
+	// lags outside the series have no overlap and are left at zero
+	for (int lag=std::max<int>(minLag, 1-int(x.size())); lag<=std::min<int>(maxLag, int(y.size())-1); ++lag)
+	{
+		size_t index = (lag<0) ? size+lag : lag;
+		retval[lag-minLag] = X[index].real();
+	}
+	return retval;
+}
+
+std::vector<double> correlateFFT(const std::vector<double>& x, const std::vector<double>& y, int maxdelay)
+{
+	std::vector<double> retval(2*maxdelay, 0);
+	size_t n = std::min(x.size(), y.size());
+	if (n==0)
+		return retval;
+
+	double mx = 0;
+	double my = 0;
+	for (size_t i=0; i<n; ++i)
+	{
+		mx += x[i];
+		my += y[i];
+	}
+	mx /= n;
+	my /= n;
+
+	std::vector<double> centeredX(n);
+	std::vector<double> centeredY(n);
+	double sx = 0;
+	double sy = 0;
+	for (size_t i=0; i<n; ++i)
+	{
+		centeredX[i] = x[i] - mx;
+		centeredY[i] = y[i] - my;
+		sx += centeredX[i] * centeredX[i];
+		sy += centeredY[i] * centeredY[i];
+	}
+	double denom = sqrt(sx * sy);
+	if (denom==0)
+		return retval; // constant signal: no correlation
+
+	retval = computeLaggedProducts(centeredX, centeredY, -maxdelay, maxdelay-1);
+	for (size_t i=0; i<retval.size(); ++i)
+		retval[i] /= denom;
+	return retval;
+}
+
+double findParabolicPeak(const std::vector<double>& values, int index)
+{
+	if (index<=0 || index+1>=int(values.size()))
+		return index;
+
+	double a = values[index-1];
+	double b = values[index];
+	double c = values[index+1];
+	double denom = a - 2*b + c;
+	if (denom==0)
+		return index;
+
+	double delta = 0.5 * (a - c) / denom;
+	return index + std::max(-0.5, std::min(0.5, delta));
+}
+
+}//namespace cx
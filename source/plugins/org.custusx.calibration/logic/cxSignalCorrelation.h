@@ -0,0 +1,56 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+                 
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+                 
+CustusX is released under a BSD 3-Clause license.
+                 
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXSIGNALCORRELATION_H_
+#define CXSIGNALCORRELATION_H_
+
+#include "org_custusx_calibration_Export.h"
+
+#include <vector>
+
+namespace cx
+{
+/**
+ * \file
+ * \addtogroup org_custusx_calibration
+ * @{
+ */
+
+/**Compute the products sum_i x[i]*y[i+lag] for all lags in [minLag, maxLag],
+ * using only the overlapping part of the series.
+ *
+ * Computed using FFT in O(n log n), with zero padding to avoid wraparound.
+ * The result has size maxLag-minLag+1, lag zero is found at retval[-minLag].
+ */
+org_custusx_calibration_EXPORT std::vector<double> computeLaggedProducts(const std::vector<double>& x, const std::vector<double>& y, int minLag, int maxLag);
+
+/**Normalized cross correlation between the series x and y, using the
+ * first n=min(x.size(), y.size()) samples of each.
+ *
+ * The result has size 2*maxdelay, zero shift is found at retval[maxdelay].
+ * Equal to a direct computation of the correlation coefficient for each
+ * delay, but runs in O(n log n).
+ */
+org_custusx_calibration_EXPORT std::vector<double> correlateFFT(const std::vector<double>& x, const std::vector<double>& y, int maxdelay);
+
+/**Fit a parabola to values[index-1..index+1], and return the position
+ * of its extremum, i.e. index refined to sub-sample resolution.
+ * Return index unchanged at the ends of the series or when the three
+ * values are collinear.
+ */
+org_custusx_calibration_EXPORT double findParabolicPeak(const std::vector<double>& values, int index);
+
+/**
+ * @}
+ */
+}
+
+#endif /* CXSIGNALCORRELATION_H_ */
@@ -29,10 +29,10 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxUsReconstructionFileReader.h"
 #include "cxLogger.h"
 #include "cxTime.h"
-#include <vtkImageMask.h>
 #include "cxFileManagerServiceProxy.h"
+#include "cxSignalCorrelation.h"
+#include <QtConcurrentMap>
 
-typedef vtkSmartPointer<vtkImageMask> vtkImageMaskPtr;
 typedef vtkSmartPointer<vtkImageCorrelation> vtkImageCorrelationPtr;
 
 namespace cx
@@ -42,67 +42,41 @@ typedef unsigned char uchar; // for removing eclipse warnings
 
 
 
-/**
- * Found this on
- * http://paulbourke.net/miscellaneous/correlate/
- * Slightly modified.
- *
- * x: first input series, size n
- * y: second input series, size n
- * corr: correlation result, size maxdelay*2 (zero shif is found at corr[maxdelay]
+namespace
+{
+/**extract the y-line with x-index line_index_x from frame ( frame[line_index_x, y_varying] ),
+ * setting pixels outside the mask to zero.
+ * Reads directly from memory, thus can be called for different frames in parallel.
  */
-void correlate(double* x, double* y, double* corr, int maxdelay, int n)
+std::vector<double> extractLine_y(const uchar* frame, const uchar* mask, int dimX, int dimY, int line_index_x)
 {
-  int i, j;
-  double mx, my, sx, sy, sxy, denom, r;
-  int delay;
-
-  /* Calculate the mean of the two series x[], y[] */
-  mx = 0;
-  my = 0;
-  for (i = 0; i < n; i++)
-  {
-    mx += x[i];
-    my += y[i];
-  }
-  mx /= n;
-  my /= n;
-
-  /* Calculate the denominator */
-  sx = 0;
-  sy = 0;
-  for (i = 0; i < n; i++)
-  {
-    sx += (x[i] - mx) * (x[i] - mx);
-    sy += (y[i] - my) * (y[i] - my);
-  }
-  denom = sqrt(sx * sy);
-
-  /* Calculate the correlation series */
-  for (delay = -maxdelay; delay < maxdelay; delay++)
+  std::vector<double> retval(dimY, 0);
+  for (int y=0; y<dimY; ++y)
   {
-    sxy = 0;
-    for (i = 0; i < n; i++)
-    {
-      j = i + delay;
-      if (j < 0 || j >= n)
-        continue;
-      else
-        sxy += (x[i] - mx) * (y[j] - my);
-    }
-    r = sxy / denom;
-    corr[delay+maxdelay] = r;//(sxy/denom+1) * 128;
-
-    /* r is the correlation coefficient at "delay" */
-
+    int index = y*dimX + line_index_x;
+    if (!mask || mask[index])
+      retval[y] = frame[index];
   }
-
+  return retval;
 }
+} // namespace
 
 TemporalCalibration::TemporalCalibration()
 {
 	mAddRawToDebug = false;
 	mMask = vtkImageDataPtr();
+	mConfidence = 0;
+	mGridShift = 0;
+}
+
+double TemporalCalibration::getConfidence() const
+{
+	return mConfidence;
+}
+
+double TemporalCalibration::getGridShift() const
+{
+	return mGridShift;
 }
 
 void TemporalCalibration::selectData(QString filename, FileManagerServicePtr filemanager)
@@ -169,6 +143,8 @@ double TemporalCalibration::calibrate(bool* success)
 {
   mDebugStream.str("");
   mDebugStream.clear();
+  mConfidence = 0;
+  mGridShift = 0;
 
   if (!mFileData.mUsRaw)
   {
@@ -189,7 +165,7 @@ double TemporalCalibration::calibrate(bool* success)
 
   std::vector<double> frameMovement = this->computeProbeMovement();
 
-  if (!this->checkFrameMovementQuality(frameMovement))
+  if (frameMovement.empty() || !this->checkFrameMovementQuality(frameMovement))
   {
 	  reportError("Failed to detect movement in images. Make sure that the first image is clear and visible.");
 	  *success = false;
@@ -209,11 +185,14 @@ double TemporalCalibration::calibrate(bool* success)
   double shift = this->findLSShift(frameMovementRegular, trackingMovementRegular, resolution);
 
   double totalShift = offset + shift;
+  mGridShift += offset;
 
   mDebugStream << "=======================================" << std::endl;
   mDebugStream << "Performed temporal calibration:" << std::endl;
   mDebugStream << "offset = " << offset << ", shift = " << shift << std::endl;
   mDebugStream << "Total temporal shift tf-tt = " << offset+shift << " ms" << std::endl;
+  mDebugStream << "Total temporal shift on sample grid = " << mGridShift << " ms" << std::endl;
+  mDebugStream << "Confidence = " << mConfidence << std::endl;
   mDebugStream << "=======================================" << std::endl;
 
   double startTime = mFileData.mPositions.front().mTime;
@@ -241,27 +220,70 @@ bool TemporalCalibration::checkFrameMovementQuality(std::vector<double> pos)
 	return error < 0.2;
 }
 
-/** shift tracking data with the input shift, then compute RMS value of function
+/** shift tracking data with each shift in [-W,W), then compute RMS value of the
+ *  difference function. Zero shift is found at retval[W].
  *
+ *  The sum of squares is expanded as sum(f^2) + sum(t^2) - 2*sum(f*t), where
+ *  the squares are found from cumulative sums and the products using FFT.
  */
-double TemporalCalibration::findLeastSquares(std::vector<double> frames, std::vector<double> tracking, int shift) const
+std::vector<double> TemporalCalibration::findLeastSquares(std::vector<double> frames, std::vector<double> tracking, int W) const
 {
-	size_t r0 = 0;
-	size_t r1 = frames.size();
+	std::vector<double> products = computeLaggedProducts(frames, tracking, -W, W-1);
+
+	std::vector<double> framesSq(frames.size()+1, 0);
+	for (unsigned i=0; i<frames.size(); ++i)
+		framesSq[i+1] = framesSq[i] + frames[i]*frames[i];
+	std::vector<double> trackingSq(tracking.size()+1, 0);
+	for (unsigned i=0; i<tracking.size(); ++i)
+		trackingSq[i+1] = trackingSq[i] + tracking[i]*tracking[i];
+
+	std::vector<double> retval(2*W, 0);
+	for (int shift=-W; shift<W; ++shift)
+	{
+		int r0 = std::max<int>(0, -shift);
+		int r1 = std::min<int>(frames.size(), tracking.size() - shift);
+		if (r1<=r0)
+			continue;
+
+		double value = (framesSq[r1]-framesSq[r0]) + (trackingSq[r1+shift]-trackingSq[r0+shift]) - 2*products[shift+W];
+		value = std::max(value, 0.0); // remove roundoff
+		retval[shift+W] = sqrt(value/(r1-r0));
+	}
+	return retval;
+}
 
-	r0 = std::max<int>(r0, - shift);
-	r1 = std::min<int>(r1, tracking.size() - shift);
+/** shift tracking data with the input shift, then compute the correlation
+ *  coefficient between frames and tracking over the overlap.
+ */
+double TemporalCalibration::findCorrelationCoefficient(std::vector<double> frames, std::vector<double> tracking, int shift) const
+{
+	int r0 = std::max<int>(0, -shift);
+	int r1 = std::min<int>(frames.size(), tracking.size() - shift);
+	if (r1<=r0)
+		return 0;
 
-	double value = 0;
+	double mf = 0;
+	double mt = 0;
+	for (int i=r0; i<r1; ++i)
+	{
+		mf += frames[i];
+		mt += tracking[i+shift];
+	}
+	mf /= (r1-r0);
+	mt /= (r1-r0);
 
+	double sf = 0;
+	double st = 0;
+	double sft = 0;
 	for (int i=r0; i<r1; ++i)
 	{
-		double core = pow(frames[i] - tracking[i+shift], 2.0);
-		value += core;
+		sf += (frames[i]-mf) * (frames[i]-mf);
+		st += (tracking[i+shift]-mt) * (tracking[i+shift]-mt);
+		sft += (frames[i]-mf) * (tracking[i+shift]-mt);
 	}
-	value /= (r1-r0);
-	value = sqrt(value);
-	return value;
+	if (similar(sf*st, 0))
+		return 0;
+	return sft / sqrt(sf*st);
 }
 
 /** Find the correlation shift between the regularly spaces series frames and tracking,
@@ -274,17 +296,14 @@ double TemporalCalibration::findLSShift(std::vector<double> frames, std::vector<
 	double maxShift = 1000;
 	size_t N = std::min(tracking.size(), frames.size());
   N = std::min<int>(N, 2*maxShift/resolution); // constrain search to 1 second in each direction
-  std::vector<double> result(N, 0);
   int W = N/2;
-
-  for (int i=-W; i<W; ++i)
-  {
-  	double rms = this->findLeastSquares(frames, tracking, i);
-  	result[i+W] = rms;
-  }
+  std::vector<double> result = this->findLeastSquares(frames, tracking, W);
 
   int top = std::distance(result.begin(), std::min_element(result.begin(), result.end()));
-  double shift = (W-top) * resolution; // convert to shift in ms.
+  double subTop = findParabolicPeak(result, top);
+  double shift = (W-subTop) * resolution; // convert to shift in ms.
+  mGridShift = (W-top) * resolution;
+  mConfidence = this->findCorrelationCoefficient(frames, tracking, top-W);
 
   mDebugStream << "=======================================" << std::endl;
   mDebugStream << "tracking vs frames fit using least squares:" << std::endl;
@@ -302,7 +321,8 @@ double TemporalCalibration::findLSShift(std::vector<double> frames, std::vector<
   }
 
   mDebugStream << std::endl;
-  mDebugStream << "minimal index: " << top << ", = shift in ms: " << shift << std::endl;
+  mDebugStream << "minimal index: " << top << ", refined: " << subTop << ", = shift in ms: " << shift << std::endl;
+  mDebugStream << "correlation coefficient at minimum: " << mConfidence << std::endl;
   mDebugStream << "=======================================" << std::endl;
 
   return shift; // shift frames-tracking: frame = tracking + shift
@@ -316,12 +336,10 @@ double TemporalCalibration::findLSShift(std::vector<double> frames, std::vector<
 double TemporalCalibration::findCorrelationShift(std::vector<double> frames, std::vector<double> tracking, double resolution) const
 {
 	size_t N = std::min(tracking.size(), frames.size());
-  std::vector<double> result(N, 0);
-
-  correlate(&*frames.begin(), &*tracking.begin(), &*result.begin(), N / 2, N);
+  std::vector<double> result = correlateFFT(frames, tracking, N/2);
 
   int top = std::distance(result.begin(), std::max_element(result.begin(), result.end()));
-  double shift = (N/2-top) * resolution; // convert to shift in ms.
+  double shift = (N/2-findParabolicPeak(result, top)) * resolution; // convert to shift in ms.
 
   mDebugStream << "=======================================" << std::endl;
   mDebugStream << "tracking vs frames correlation:" << std::endl;
@@ -329,7 +347,7 @@ double TemporalCalibration::findCorrelationShift(std::vector<double> frames, std
   mDebugStream << "#frames=" << frames.size() << ", #tracks=" << tracking.size() << std::endl;
   mDebugStream << std::endl;
   mDebugStream << "Frame pos" << "\t" << "Track pos" << "\t" << "correlation" << std::endl;
-  for (int x = 0; x < N; ++x)
+  for (unsigned x = 0; x < result.size(); ++x)
   {
     mDebugStream << frames[x] << "\t" << tracking[x] << "\t" << result[x] << std::endl;
   }
@@ -426,22 +444,61 @@ std::vector<double> TemporalCalibration::computeTrackingMovement()
 
 /** Calculate offset values from the first frame for all frames.
  *
+ *  The correlation with the first frame is independent for each frame, and is
+ *  computed in parallel. The peak search is seeded by the previous frame, and
+ *  is done afterwards.
  */
 std::vector<double> TemporalCalibration::computeProbeMovement()
 {
   int N_frames = mFileData.mUsRaw->getDimensions()[2];
+  int dimX = mFileData.mUsRaw->getDimensions()[0];
+  int dimY = mFileData.mUsRaw->getDimensions()[1];
+  int line_index_x = mFileData.mProbeDefinition.mData.getOrigin_p()[0];
 
   std::vector<double> retval;
 
+  if (int(mProcessedFrames.size()) < N_frames || line_index_x < 0 || line_index_x >= dimX)
+  {
+    reportError("Temporal calib: Invalid frame data or probe origin.");
+    return retval;
+  }
+
+	mMask = mFileData.getMask();
+	const uchar* mask = NULL;
+	if (mMask && mMask->GetScalarType()==VTK_UNSIGNED_CHAR
+			&& mMask->GetDimensions()[0]==dimX && mMask->GetDimensions()[1]==dimY)
+		mask = static_cast<const uchar*>(mMask->GetScalarPointer());
+
+  // collect frame pointers up front: no VTK calls inside the parallel section
+  std::vector<const uchar*> frames(N_frames);
+  for (int i=0; i<N_frames; ++i)
+  {
+    if (mProcessedFrames[i]->GetScalarType()!=VTK_UNSIGNED_CHAR)
+    {
+      reportError("Temporal calib: Only 8 bit frames are supported.");
+      return retval;
+    }
+    frames[i] = static_cast<const uchar*>(mProcessedFrames[i]->GetScalarPointer());
+  }
+
+  std::vector<double> reference = extractLine_y(frames[0], mask, dimX, dimY, line_index_x);
+  std::vector<std::vector<double> > correlations(N_frames);
+  std::vector<int> indices(N_frames);
+  for (int i=0; i<N_frames; ++i)
+    indices[i] = i;
+
+  QtConcurrent::blockingMap(indices, [&](int& i)
+  {
+    std::vector<double> line = extractLine_y(frames[i], mask, dimX, dimY, line_index_x);
+    correlations[i] = correlateFFT(reference, line, dimY); // allocate space on both sides of zero
+  });
+
   double maxSingleStep = 5; // assume max 5mm movement per frame
-//	double currentMaxShift;
   double lastVal = 0;
 
-	mMask = mFileData.getMask();
   for (int i=0; i<N_frames; ++i)
   {
-    double val = this->findCorrelation(mFileData.mUsRaw, 0, i, maxSingleStep, lastVal);
-//    currentMaxShift =  fabs(val) + maxSingleStep;
+    double val = this->findCorrelation(correlations[i], maxSingleStep, lastVal);
     lastVal = val;
     retval.push_back(val);
   }
@@ -463,25 +520,15 @@ std::vector<double> TemporalCalibration::computeProbeMovement()
   return retval;
 }
 
-double TemporalCalibration::findCorrelation(USFrameDataPtr data, int frame_a, int frame_b, double maxShift, double lastVal)
+/** Find the downwards movement in mm from the correlation between two lines,
+ *  looking for a maximum within maxShift of the last found movement.
+ */
+double TemporalCalibration::findCorrelation(const std::vector<double>& correlation, double maxShift, double lastVal) const
 {
 	int maxShift_pix = maxShift / mFileData.mUsRaw->getSpacing()[1];
 	int lastVal_pix = lastVal / mFileData.mUsRaw->getSpacing()[1];
 
-	int line_index_x = mFileData.mProbeDefinition.mData.getOrigin_p()[0];
-
-  int dimY = mFileData.mUsRaw->getDimensions()[1];
-
-	vtkImageDataPtr line1 = this->extractLine_y(mFileData.mUsRaw, line_index_x, frame_a);
-	vtkImageDataPtr line2 = this->extractLine_y(mFileData.mUsRaw, line_index_x, frame_b);
-
-  int N = 2*dimY; //result vector allocate space on both sides of zero
-  std::vector<double> result(N, 0);
-  double* line_a = static_cast<double*>(line1->GetScalarPointer());
-  double* line_b = static_cast<double*>(line2->GetScalarPointer());
-  double* line_c = &*result.begin();
-
-  correlate(line_a, line_b, line_c, N/2, dimY);
+  int N = correlation.size();
 
   // use the last found hit as a seed for looking for a local maximum
   int lastTop = N/2 - lastVal_pix;
@@ -490,49 +537,13 @@ double TemporalCalibration::findCorrelation(USFrameDataPtr data, int frame_a, in
   range.second = std::min(N, range.second);
 
   // look for a max in the vicinity of the last hit
-  int top = std::distance(result.begin(), std::max_element(result.begin()+range.first, result.begin()+range.second));
+  int top = std::distance(correlation.begin(), std::max_element(correlation.begin()+range.first, correlation.begin()+range.second));
 
   double hit = (N/2-top) * mFileData.mUsRaw->getSpacing()[1]; // convert to downwards movement in mm.
 
   return hit;
 }
 
-/**extract the y-line with x-index line_index_x from frame ( data[line_index_x, y_varying, frame] )
- *
- */
-vtkImageDataPtr TemporalCalibration::extractLine_y(USFrameDataPtr data, int line_index_x, int frame)
-{
-  int dimX = data->getDimensions()[0];
-  int dimY = data->getDimensions()[1];
-
-  vtkImageDataPtr retval = generateVtkImageDataDouble(Eigen::Array3i(dimY, 1, 1), Vector3D(1,1,1), 1);
-
-  vtkImageDataPtr base = mProcessedFrames[frame];
-
-  // run the base frame through the mask. Result is source.
-  vtkImageMaskPtr maskFilter = vtkImageMaskPtr::New();
-	maskFilter->SetMaskInputData(mMask);
-  maskFilter->SetImageInputData(base);
-  maskFilter->SetMaskedOutputValue(0.0);
-  maskFilter->Update();
-  uchar* source = static_cast<uchar*>(maskFilter->GetOutput()->GetScalarPointer());
-
-  double* dest = static_cast<double*>(retval->GetScalarPointer());
-
-  for (int y=0; y<dimY; ++y)
-  {
-    dest[y] = source[y*dimX + line_index_x];
-  }
-
-  return retval;
-}
-
-
-
-
-
-
-
 }//namespace cx
 
 
@@ -36,6 +36,13 @@ typedef std::map<double,double> TimeSeriesType;
  * the tracking data and from the us images, and use
  * correlation to find the shift between them.
  *
+ * The probe movement is found by correlating a scan line
+ * from each frame with the same line in the first frame.
+ * Lines are read directly from the frame memory, and all
+ * frames are correlated in parallel. All correlations are
+ * computed using FFT, and the final shift is refined to
+ * sub-sample resolution using a parabolic fit.
+ *
  * The shift sign is given from:
  *   frames = tracking + shift
  *
@@ -47,15 +54,17 @@ public:
   void selectData(QString filename, FileManagerServicePtr filemanager);
   void setDebugFolder(QString path);
   double calibrate(bool* success);
+  double getConfidence() const; ///< correlation coefficient [-1,1] between the shifted frame and tracking movement from the last calibrate()
+  double getGridShift() const; ///< shift from the last calibrate() before sub-sample refinement, i.e. a multiple of the resolution from the first frame/position offset
 
 private:
-	vtkImageDataPtr extractLine_y(USFrameDataPtr data, int line_index_x, int frame);
-  double findCorrelation(USFrameDataPtr data, int frame_a, int frame_b, double maxShift, double lastVal);
+  double findCorrelation(const std::vector<double>& correlation, double maxShift, double lastVal) const;
   std::vector<double> computeProbeMovement();
   std::vector<double> resample(std::vector<double> shift, std::vector<TimedPosition> time, double resolution);
   std::vector<double> computeTrackingMovement();
   double findCorrelationShift(std::vector<double> frames, std::vector<double> tracking, double resolution) const;
-  double findLeastSquares(std::vector<double> frames, std::vector<double> tracking, int shift) const;
+  std::vector<double> findLeastSquares(std::vector<double> frames, std::vector<double> tracking, int W) const;
+  double findCorrelationCoefficient(std::vector<double> frames, std::vector<double> tracking, int shift) const;
   double findLSShift(std::vector<double> frames, std::vector<double> tracking, double resolution) const;
   bool checkFrameMovementQuality(std::vector<double> pos);
   void writePositions(QString title, std::vector<double> pos, std::vector<TimedPosition> time, double shift);
@@ -69,6 +78,8 @@ private:
   mutable std::stringstream mDebugStream;
   bool mAddRawToDebug;
   vtkImageDataPtr mMask;
+  mutable double mConfidence;
+  mutable double mGridShift;
 
 };
 
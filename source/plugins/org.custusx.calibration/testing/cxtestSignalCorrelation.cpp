@@ -0,0 +1,123 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+                 
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+                 
+CustusX is released under a BSD 3-Clause license.
+                 
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include "cxSignalCorrelation.h"
+#include "cxVector3D.h"
+
+namespace
+{
+std::vector<double> createSignal(int n, double shift)
+{
+	std::vector<double> retval(n);
+	for (int i=0; i<n; ++i)
+	{
+		double t = i - shift;
+		retval[i] = sin(t/7.0) + 0.5*cos(t/3.0) + exp(-(t-n/2)*(t-n/2)/50.0);
+	}
+	return retval;
+}
+
+std::vector<double> createPulse(int n, double center)
+{
+	std::vector<double> retval(n);
+	for (int i=0; i<n; ++i)
+		retval[i] = exp(-(i-center)*(i-center)/(2*8.0*8.0));
+	return retval;
+}
+
+/** Direct O(n*maxdelay) computation of the correlation coefficient for each delay.
+ */
+std::vector<double> correlateDirect(const std::vector<double>& x, const std::vector<double>& y, int maxdelay)
+{
+	int n = x.size();
+	double mx = 0, my = 0;
+	for (int i=0; i<n; ++i)
+	{
+		mx += x[i];
+		my += y[i];
+	}
+	mx /= n;
+	my /= n;
+
+	double sx = 0, sy = 0;
+	for (int i=0; i<n; ++i)
+	{
+		sx += (x[i]-mx)*(x[i]-mx);
+		sy += (y[i]-my)*(y[i]-my);
+	}
+
+	std::vector<double> retval(2*maxdelay, 0);
+	for (int delay=-maxdelay; delay<maxdelay; ++delay)
+	{
+		double sxy = 0;
+		for (int i=0; i<n; ++i)
+			if (i+delay>=0 && i+delay<n)
+				sxy += (x[i]-mx)*(y[i+delay]-my);
+		retval[delay+maxdelay] = sxy/sqrt(sx*sy);
+	}
+	return retval;
+}
+} // namespace
+
+TEST_CASE("SignalCorrelation: FFT correlation equals direct correlation", "[unit][modules][calibration]")
+{
+	std::vector<double> x = createSignal(100, 0);
+	std::vector<double> y = createSignal(100, 13);
+
+	std::vector<double> expected = correlateDirect(x, y, 100);
+	std::vector<double> result = cx::correlateFFT(x, y, 100);
+
+	REQUIRE(result.size()==expected.size());
+	for (unsigned i=0; i<result.size(); ++i)
+		CHECK(cx::similar(result[i], expected[i], 1.0E-9));
+}
+
+TEST_CASE("SignalCorrelation: Lagged products of series with different sizes", "[unit][modules][calibration]")
+{
+	std::vector<double> x = createSignal(37, 0);
+	std::vector<double> y = createSignal(64, 5);
+
+	std::vector<double> result = cx::computeLaggedProducts(x, y, -50, 70);
+	REQUIRE(result.size()==121);
+	for (int lag=-50; lag<=70; ++lag)
+	{
+		double expected = 0;
+		for (int i=0; i<int(x.size()); ++i)
+			if (i+lag>=0 && i+lag<int(y.size()))
+				expected += x[i]*y[i+lag];
+		CHECK(cx::similar(result[lag+50], expected, 1.0E-9));
+	}
+}
+
+TEST_CASE("SignalCorrelation: Parabolic peak fit finds sub-sample shift", "[unit][modules][calibration]")
+{
+	std::vector<double> values(10);
+	for (int i=0; i<10; ++i)
+		values[i] = -(i-4.3)*(i-4.3);
+	CHECK(cx::similar(cx::findParabolicPeak(values, 4), 4.3, 1.0E-9));
+	CHECK(cx::findParabolicPeak(values, 0)==0);
+	CHECK(cx::findParabolicPeak(values, 9)==9);
+
+	int maxdelay = 50;
+	std::vector<double> x = createPulse(200, 90);
+	std::vector<double> y = createPulse(200, 100.4);
+	std::vector<double> corr = cx::correlateFFT(x, y, maxdelay);
+	int top = std::distance(corr.begin(), std::max_element(corr.begin(), corr.end()));
+	CHECK(top==maxdelay+10);
+	double refined = cx::findParabolicPeak(corr, top)-maxdelay;
+	CHECK(fabs(refined-10.4) < fabs(top-maxdelay-10.4));
+	CHECK(cx::similar(refined, 10.4, 0.15)); // the finite overlap biases the correlation peak slightly
+
+}
@@ -28,9 +28,13 @@ TEST_CASE("TemporalCalibration reproduces old results on a test data set", "[uni
   double shift = calibrator.calibrate(&success);
 
   double testValue = 115; // shift found on data set during first tests.
+  double resolution = 5; // ms, the sub-sample peak fit moves the shift at most half of this from the sample grid
 
   CHECK( success );
+  CHECK( cx::similar(calibrator.getGridShift(), testValue, 1));
+  CHECK( fabs(shift - calibrator.getGridShift()) <= resolution/2 );
   CHECK( cx::similar(shift, testValue, 1));
+  CHECK( calibrator.getConfidence() > 0 );
 	cx::LogicManager::shutdown();
 }
 
@@ -116,34 +116,9 @@ std::vector<DataPtr> MetaImageReader::read(const QString &filename)
 	std::vector<DataPtr> retval;
 
 	ImagePtr image = boost::dynamic_pointer_cast<Image>(this->createData(Image::getTypeName(), filename));
-
-	CustomMetaImagePtr customReader = CustomMetaImage::create(filename);
-	Transform3D rMd = customReader->readTransform();
-
-	vtkImageDataPtr raw = this->loadVtkImageData(filename);
-	if(!raw)
+	if (!this->readInto(image, filename))
 		return retval;
 
-	image->setVtkImageData(raw);
-//	ImagePtr image(new Image(uid, raw));
-
-	//  RegistrationTransform regTrans(rMd, QFileInfo(filename).lastModified(), "From MHD file");
-	//  image->get_rMd_History()->addRegistration(regTrans);
-	image->get_rMd_History()->setRegistration(rMd);
-	image->setModality(customReader->readModality());
-	image->setImageType(customReader->readImageType());
-
-	bool ok1 = true;
-	bool ok2 = true;
-	double level = customReader->readKey("WindowLevel").toDouble(&ok1);
-	double window = customReader->readKey("WindowWidth").toDouble(&ok2);
-
-	if (ok1 && ok2)
-	{
-		image->setInitialWindowLevel(window, level);
-		image->resetTransferFunctions();
-	}
-
 	retval.push_back(image);
 	return retval;
 
@@ -175,6 +150,7 @@ void MetaImageReader::write(DataPtr data, const QString& filename)
 	customReader->setKey("WindowLevel", qstring_cast(image->getInitialWindowLevel()));
 	customReader->setKey("WindowWidth", qstring_cast(image->getInitialWindowWidth()));
 	customReader->setKey("Creator", QString("CustusX_%1").arg(CustusX_VERSION_STRING));
+	customReader->write();
 }
 
 }
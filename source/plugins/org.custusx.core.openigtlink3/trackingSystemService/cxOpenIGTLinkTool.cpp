@@ -162,7 +162,7 @@ void OpenIGTLinkTool::toolTransformAndTimestampSlot(Transform3D prMs, double tim
         prMt_filtered = mTrackingPositionFilter->getFilteredPosition();
     }
 
-    (*mPositionHistory)[mTimestamp] = prMt; // store original in history
+    mPositionHistory->insert(mTimestamp, prMt); // store original in history
     m_prMt = prMt_filtered;
     emit toolTransformAndTimestamp(m_prMt, mTimestamp);
 }
@@ -201,13 +201,14 @@ void OpenIGTLinkTool::calculateTpsSlot()
         return;
     }
 
-    TimedTransformMap::reverse_iterator rit = mPositionHistory->rbegin();
-    double lastTransform = rit->first;
+    ToolPositionHistory::const_iterator rit = mPositionHistory->end();
+    --rit;
+    double lastTransform = rit.time();
 		for (size_t i = 0; i < numberOfTransformsToCheck-1; ++i)
     {
-        ++rit;
+        --rit;
     }
-    double firstTransform = rit->first;
+    double firstTransform = rit.time();
     double secondsPassed = (lastTransform - firstTransform) / 1000;
 
     if (!similar(secondsPassed, 0))
@@ -18,6 +18,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <QFile>
 #include <QTextStream>
 #include <QDir>
+#include <algorithm>
 
 #include "cxTransform3D.h"
 #include "cxRegistrationTransform.h"
@@ -40,6 +41,9 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxDefinitionStrings.h"
 #include "cxActiveData.h"
 #include "cxFileManagerService.h"
+#include "cxImage.h"
+#include "cxTime.h"
+#include "cxParallelDataLoader.h"
 
 
 namespace cx
@@ -63,6 +67,12 @@ DataManagerImpl::DataManagerImpl(ActiveDataPtr activeData) :
 	connect(settings(), SIGNAL(valueChangedFor(QString)), this, SLOT(settingsChangedSlot(QString)));
 	this->readClinicalView();
 
+	if (mActiveData)
+		connect(mActiveData.get(), &ActiveData::activeImageChanged, this, &DataManagerImpl::activeImageChangedSlot);
+	mPurgeVoxelDataTimer = new QTimer(this);
+	connect(mPurgeVoxelDataTimer, &QTimer::timeout, this, &DataManagerImpl::purgeVoxelDataSlot);
+	mPurgeVoxelDataTimer->start(10000);
+
 	this->clear();
 }
 
@@ -254,6 +264,12 @@ void DataManagerImpl::loadData(DataPtr data)
 			reportError(QString("Overwriting Data with uid=%1 with new object into PasM").arg(data->getUid()));
 //		this->verifyParentFrame(data);
 		mData[data->getUid()] = data;
+
+		// histogram and range are needed by the transfer function widgets: compute in advance
+		ImagePtr image = boost::dynamic_pointer_cast<Image>(data);
+		if (image)
+			image->requestStatistics();
+
 		emit dataAddedOrRemoved();
 	}
 }
@@ -364,15 +380,42 @@ void DataManagerImpl::parseXml(QDomNode& dataManagerNode, QString rootPath)
 	// All images must be created from the DataManager, so the image nodes are parsed here
 	std::map<DataPtr, QDomNode> datanodes;
 
+	// create all data first, then read the files in parallel
+	ParallelDataLoader loader(mFileManagerService,
+							  settings()->value("Data/loadConcurrency").toInt(),
+							  settings()->value("Data/lazyImageLoading").toBool());
+	std::vector<std::pair<DataPtr, QDomElement> > created;
+	std::set<QString> createdUids;
+
 	QDomNode child = dataManagerNode.firstChild();
 	for (; !child.isNull(); child = child.nextSibling())
 	{
-		if (child.nodeName() == "data")
+		if (child.nodeName() != "data")
+			continue;
+		QDomElement node = child.toElement();
+		QString uid = node.attribute("uid");
+		if (mData.count(uid)) // dont load same image twice
 		{
-			DataPtr data = this->loadData(child.toElement(), rootPath);
-			if (data)
-				datanodes[data] = child.toElement();
+			datanodes[mData[uid]] = node;
+			continue;
 		}
+		if (createdUids.count(uid))
+			continue;
+		DataPtr data = this->createData(node, rootPath, &loader);
+		if (!data)
+			continue;
+		created.push_back(std::make_pair(data, node));
+		createdUids.insert(uid);
+	}
+
+	loader.load();
+
+	for (unsigned i = 0; i < created.size(); ++i)
+	{
+		if (!loader.isLoaded(created[i].first))
+			continue;
+		this->addLoadedData(created[i].second, rootPath, created[i].first);
+		datanodes[created[i].first] = created[i].second;
 	}
 
 	// parse xml data separately: we want to first load all data
@@ -411,31 +454,35 @@ void DataManagerImpl::parseXml(QDomNode& dataManagerNode, QString rootPath)
 	}
 }
 
-DataPtr DataManagerImpl::loadData(QDomElement node, QString rootPath)
+/** Create the data object described by node, and queue its file for reading.
+ */
+DataPtr DataManagerImpl::createData(QDomElement node, QString rootPath, ParallelDataLoader* loader)
 {
-	QString uid = node.toElement().attribute("uid");
-	QString name = node.toElement().attribute("name");
-	QString type = node.toElement().attribute("type");
+	QString uid = node.attribute("uid");
+	QString name = node.attribute("name");
+	QString type = node.attribute("type");
 
 	QDir relativePath = this->findRelativePath(node, rootPath);
 	QString absolutePath = this->findAbsolutePath(relativePath, rootPath);
 
-	if (mData.count(uid)) // dont load same image twice
-		return mData[uid];
-
 	DataPtr data = mDataFactory->create(type, uid, name);
 	if (!data)
 	{
 		reportWarning(QString("Unknown type: %1 for file %2").arg(type).arg(absolutePath));
 		return DataPtr();
 	}
-	bool loaded = data->load(absolutePath, mFileManagerService);
+	loader->add(data, absolutePath);
+	return data;
+}
 
-	if (!loaded)
-	{
-		reportWarning("Unknown file: " + absolutePath);
-		return DataPtr();
-	}
+/** Add data read by createData() to the manager.
+ */
+void DataManagerImpl::addLoadedData(QDomElement node, QString rootPath, DataPtr data)
+{
+	QString name = node.attribute("name");
+
+	QDir relativePath = this->findRelativePath(node, rootPath);
+	QString absolutePath = this->findAbsolutePath(relativePath, rootPath);
 
 	if (!name.isEmpty())
 		data->setName(name);
@@ -450,8 +497,63 @@ DataPtr DataManagerImpl::loadData(QDomElement node, QString rootPath)
 		reportWarning(QString("Detected old data format, converting from %1 to %2").arg(absolutePath).arg(newPath));
 		data->save(rootPath, mFileManagerService);
 	}
+}
 
-	return data;
+/** Start reading the voxel data of an image that is about to be shown.
+ */
+void DataManagerImpl::activeImageChangedSlot(const QString& uid)
+{
+	ImagePtr image = this->getImage(uid);
+	if (image)
+		image->requestVoxelData();
+}
+
+namespace
+{
+bool accessedBefore(ImagePtr a, ImagePtr b)
+{
+	return a->getLastVoxelDataAccessTime() < b->getLastVoxelDataAccessTime();
+}
+}
+
+/** Release lazily read voxel data, least recently used first: Images
+ *  not accessed for a while are released, and more are released while
+ *  the total exceeds the memory limit. Images in use are kept.
+ */
+void DataManagerImpl::purgeVoxelDataSlot()
+{
+	if (!settings()->value("Data/lazyImageLoading").toBool())
+		return;
+	double maxAge = settings()->value("Data/lazyImagePurgeAge").toDouble() * 1000;
+	double memoryLimit = settings()->value("Data/lazyImageMemoryLimit").toDouble() * 1024;
+
+	std::vector<ImagePtr> loaded;
+	double memory = 0;
+	std::map<QString, ImagePtr> images = this->getImages();
+	for (std::map<QString, ImagePtr>::iterator iter = images.begin(); iter != images.end(); ++iter)
+	{
+		unsigned long size = iter->second->getLazyVoxelDataMemorySize();
+		if (size == 0)
+			continue;
+		loaded.push_back(iter->second);
+		memory += size;
+	}
+	std::sort(loaded.begin(), loaded.end(), accessedBefore);
+
+	double now = getMilliSecondsSinceEpoch();
+	for (unsigned i = 0; i < loaded.size(); ++i)
+	{
+		bool old = (maxAge > 0) && (now - loaded[i]->getLastVoxelDataAccessTime() > maxAge);
+		bool overLimit = (memoryLimit > 0) && (memory > memoryLimit);
+		if (!old && !overLimit)
+			break;
+		unsigned long size = loaded[i]->getLazyVoxelDataMemorySize();
+		if (loaded[i]->purgeVoxelData())
+		{
+			memory -= size;
+			CX_LOG_DEBUG() << QString("Released voxel data for %1 (%2 MB)").arg(loaded[i]->getUid()).arg(size/1024);
+		}
+	}
 }
 
 QDir DataManagerImpl::findRelativePath(QDomElement node, QString rootPath)
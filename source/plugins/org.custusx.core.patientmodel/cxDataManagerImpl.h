@@ -29,12 +29,14 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxPatientModelService.h"
 
 class QDomElement;
+class QTimer;
 
 namespace cx
 {
 
 typedef boost::shared_ptr<class DataManager> DataServicePtr;
 typedef boost::shared_ptr<class DataManagerImpl> DataManagerImplPtr;
+class ParallelDataLoader;
 
 /** Default implementation of DataManager.
  *
@@ -112,7 +114,8 @@ protected:
 	CLINICAL_VIEW mClinicalApplication;
 	void deleteFiles(DataPtr data, QString basePath);
 
-	DataPtr loadData(QDomElement node, QString rootPath);
+	DataPtr createData(QDomElement node, QString rootPath, ParallelDataLoader* loader);
+	void addLoadedData(QDomElement node, QString rootPath, DataPtr data);
 	int findUniqueUidNumber(QString uidBase) const;
 
 	void readClinicalView();
@@ -131,8 +134,11 @@ private:
 	QDir findRelativePath(QDomElement node, QString rootPath);
 	QString findPath(QDomElement node);
 	QString findAbsolutePath(QDir relativePath, QString rootPath);
+	QTimer* mPurgeVoxelDataTimer;
 private slots:
 	void settingsChangedSlot(QString key);
+	void activeImageChangedSlot(const QString& uid);
+	void purgeVoxelDataSlot();
 };
 
 } // namespace cx
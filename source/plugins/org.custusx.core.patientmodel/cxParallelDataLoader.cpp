@@ -0,0 +1,139 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxParallelDataLoader.h"
+
+#include <algorithm>
+#include <QFileInfo>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QtConcurrentRun>
+#include <vtkPolyData.h>
+
+#include "cxImage.h"
+#include "cxMesh.h"
+#include "cxFileManagerService.h"
+#include "cxLogger.h"
+
+namespace cx
+{
+
+ParallelDataLoader::ParallelDataLoader(FileManagerServicePtr filemanager, int maxThreadCount, bool lazyImages) :
+	mFileManager(filemanager),
+	mMaxThreadCount(std::max(maxThreadCount, 1)),
+	mLazyImages(lazyImages),
+	mReadCount(0),
+	mFinishedReadCount(0)
+{
+}
+
+void ParallelDataLoader::add(DataPtr data, QString path)
+{
+	mJobs.push_back(Job(data, path));
+}
+
+void ParallelDataLoader::load()
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	std::vector<Job*> reads;
+	for (unsigned i = 0; i < mJobs.size(); ++i)
+		if (this->prepare(&mJobs[i]))
+			reads.push_back(&mJobs[i]);
+	mReadCount = reads.size();
+	mFinishedReadCount = 0;
+
+	QThreadPool pool;
+	pool.setMaxThreadCount(mMaxThreadCount);
+	std::vector<QFuture<void> > futures;
+	for (unsigned i = 0; i < reads.size(); ++i)
+	{
+		Job* job = reads[i];
+		futures.push_back(QtConcurrent::run(&pool, [this, job]() { this->read(job); }));
+	}
+	for (unsigned i = 0; i < futures.size(); ++i)
+		futures[i].waitForFinished();
+
+	for (unsigned i = 0; i < mJobs.size(); ++i)
+		this->finish(&mJobs[i]);
+
+	report(QString("Loaded %1 data in %2 s, %3 files read using %4 threads")
+		   .arg(mJobs.size())
+		   .arg(timer.elapsed()/1000.0, 0, 'f', 1)
+		   .arg(mReadCount)
+		   .arg(std::min(mMaxThreadCount, std::max(mReadCount, 1))));
+}
+
+bool ParallelDataLoader::isLoaded(DataPtr data) const
+{
+	for (unsigned i = 0; i < mJobs.size(); ++i)
+		if (mJobs[i].mData == data)
+			return mJobs[i].mLoaded;
+	return false;
+}
+
+/** Do the parts of loading that must happen in the calling thread.
+ *  Return true if the job has a file left for a worker to read.
+ */
+bool ParallelDataLoader::prepare(Job* job)
+{
+	ImagePtr image = boost::dynamic_pointer_cast<Image>(job->mData);
+	if (image && image->loadHeader(job->mPath, mFileManager))
+	{
+		job->mLoaded = mLazyImages;
+		return !mLazyImages;
+	}
+	if (boost::dynamic_pointer_cast<Mesh>(job->mData))
+		return true;
+
+	job->mLoaded = job->mData->load(job->mPath, mFileManager);
+	return false;
+}
+
+/** Read the file in a worker thread. Must not modify anything but the job.
+ */
+void ParallelDataLoader::read(Job* job)
+{
+	ImagePtr image = boost::dynamic_pointer_cast<Image>(job->mData);
+	if (image)
+	{
+		// thread safe, see Image::loadVoxelData()
+		image->getBaseVtkImageData();
+		job->mLoaded = image->isVoxelDataLoaded();
+	}
+	else
+	{
+		job->mPolyData = mFileManager->loadVtkPolyData(job->mPath);
+		job->mLoaded = job->mPolyData!=0;
+	}
+
+	int count = mFinishedReadCount.fetchAndAddOrdered(1) + 1;
+	report(QString("Loaded data %1 of %2: %3").arg(count).arg(mReadCount).arg(QFileInfo(job->mPath).fileName()));
+}
+
+void ParallelDataLoader::finish(Job* job)
+{
+	MeshPtr mesh = boost::dynamic_pointer_cast<Mesh>(job->mData);
+	if (mesh && job->mPolyData)
+	{
+		// same as Mesh::load()
+		mesh->setVtkPolyData(job->mPolyData);
+		mesh->setName(QFileInfo(job->mPath).baseName());
+		mesh->setFilename(job->mPath);
+		job->mPolyData = vtkPolyDataPtr();
+	}
+
+	if (!job->mLoaded)
+		reportWarning("Unknown file: " + job->mPath);
+}
+
+} // namespace cx
@@ -0,0 +1,71 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXPARALLELDATALOADER_H_
+#define CXPARALLELDATALOADER_H_
+
+#include "org_custusx_core_patientmodel_Export.h"
+
+#include <vector>
+#include <QString>
+#include <QAtomicInt>
+#include "cxForwardDeclarations.h"
+#include "vtkForwardDeclarations.h"
+
+namespace cx
+{
+
+/** \brief Read the files of several data objects in parallel.
+ *
+ * Used when opening a patient. The voxel data of images and the
+ * polydata of meshes are read by a pool of worker threads, limited
+ * to maxThreadCount concurrent reads. Everything else, i.e. image
+ * headers, other data types and all modifications of the data
+ * objects, is done in the calling thread. load() returns when all
+ * files are read.
+ *
+ * In lazy mode, only the image headers are read, see Image::loadHeader().
+ *
+ * \ingroup org_custusx_core_patientmodel
+ * \date 2026-10-18
+ */
+class org_custusx_core_patientmodel_EXPORT ParallelDataLoader
+{
+public:
+	ParallelDataLoader(FileManagerServicePtr filemanager, int maxThreadCount, bool lazyImages);
+	void add(DataPtr data, QString path);
+	void load();
+	bool isLoaded(DataPtr data) const; ///< valid after load()
+
+private:
+	struct Job
+	{
+		Job(DataPtr data, QString path) : mData(data), mPath(path), mLoaded(false) {}
+		DataPtr mData;
+		QString mPath;
+		vtkPolyDataPtr mPolyData; ///< read by a worker, meshes only
+		bool mLoaded;
+	};
+	bool prepare(Job* job);
+	void read(Job* job);
+	void finish(Job* job);
+
+	FileManagerServicePtr mFileManager;
+	int mMaxThreadCount;
+	bool mLazyImages;
+	std::vector<Job> mJobs;
+	int mReadCount;
+	QAtomicInt mFinishedReadCount;
+};
+
+} // namespace cx
+
+#endif /* CXPARALLELDATALOADER_H_ */
@@ -96,6 +96,7 @@ void PatientData::onSessionSave(QDomElement &node)
 		{
 			CustomMetaImagePtr customReader = CustomMetaImage::create(mSession->getRootFolder() + "/" + iter->second->getFilename());
 			customReader->setTransform(iter->second->get_rMd());
+			customReader->write();
 		}
 	}
 
@@ -177,7 +177,7 @@ void ToolUsingIGSTK::toolTransformAndTimestampSlot(Transform3D matrix, double ti
 
 	// Store positions in history, but only if visible - the history has no concept of visibility
 	if (this->getVisible())
-		(*mPositionHistory)[timestamp] = matrix;
+		mPositionHistory->insert(timestamp, matrix);
 	m_prMt = prMt_filtered;
 	emit toolTransformAndTimestamp(m_prMt, timestamp);
 
@@ -195,11 +195,12 @@ void ToolUsingIGSTK::calculateTpsSlot()
 		return;
 	}
 
-	TimedTransformMap::reverse_iterator it = mPositionHistory->rbegin();
-	double lastTransform = it->first;
-	for (size_t i = 0; i < numberOfTransformsToCheck; ++i)
-		++it;
-	double firstTransform = it->first;
+	ToolPositionHistory::const_iterator it = mPositionHistory->end();
+	--it;
+	double lastTransform = it.time();
+	for (size_t i = 0; i < numberOfTransformsToCheck-1; ++i)
+		--it;
+	double firstTransform = it.time();
 	double secondsPassed = (lastTransform - firstTransform) / 1000;
 
 	if (!similar(secondsPassed, 0))
@@ -26,7 +26,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxRegistrationTransform.h"
 #include "cxLogger.h"
 #include "cxTypeConversions.h"
-#include "cxPositionStorageFile.h"
+#include "cxPositionLogFile.h"
 #include "cxTime.h"
 #include "cxEnumConverter.h"
 #include "cxDummyTool.h"
@@ -73,6 +73,7 @@ TrackingImplService::~TrackingImplService()
 {
 	while (!mTrackingSystems.empty())
 		this->unInstallTrackingSystem(mTrackingSystems.back());
+	this->setPositionLogAsSource(false);
 }
 
 
@@ -109,6 +110,7 @@ void TrackingImplService::setPlaybackMode(PlaybackTimePtr controller)
 	// uninstall tracking systems, playback on
 	if (controller)
 	{
+		this->loadFullPositionHistory();
 		mPlaybackSystem.reset(new TrackingSystemPlaybackService(controller, mTrackingSystems, mManualTool));
 		std::vector<TrackingSystemServicePtr> old = mPlaybackSystem->getBase();
 		for (unsigned i=0; i<old.size(); ++i)
@@ -223,12 +225,14 @@ void TrackingImplService::onTrackingSystemModified(TrackingSystemService* servic
 
 void TrackingImplService::rebuildCachedTools()
 {
+    this->setPositionLogAsSource(false);
     mTools.clear();
     for (unsigned i=0; i<mTrackingSystems.size(); ++i)
     {
         this->addToolsFrom(mTrackingSystems[i]);
     }
     mTools[mManualTool->getUid()] = mManualTool;
+    this->setPositionLogAsSource(true);
     this->imbueManualToolWithRealProperties();
     this->loadPositionHistory(); // the tools are always reconfigured after a setloggingfolder
 	this->resetTrackingPositionFilters();
@@ -289,6 +293,7 @@ SessionToolHistoryMap TrackingImplService::getSessionHistory(double startTime, d
 	ToolMap::iterator it = tools.begin();
 	for (; it != tools.end(); ++it)
 	{
+		// includes positions from the log, see setPositionLogAsSource()
 		TimedTransformMap toolMap = it->second->getSessionHistory(startTime, stopTime);
 		if (toolMap.empty())
 			continue;
@@ -351,30 +356,90 @@ ToolPtr TrackingImplService::getReferenceTool() const
 	return mReferenceTool;
 }
 
+QString TrackingImplService::getPositionLogFilename()
+{
+	return this->getLoggingFolder() + "/toolpositions." + PositionLogReader::getSuffix();
+}
+
+PositionLogReaderPtr TrackingImplService::getPositionLog()
+{
+	if (!mPositionLog && QFileInfo(this->getPositionLogFilename()).exists())
+	{
+		mPositionLog.reset(new PositionLogReader(this->getPositionLogFilename()));
+		if (!mPositionLog->isValid())
+			mPositionLog.reset();
+	}
+	return mPositionLog;
+}
+
+TimedTransformMap TrackingImplService::getLoggedSessionHistory(QString toolUid, double startTime, double stopTime)
+{
+	PositionLogReaderPtr log = this->getPositionLog();
+	if (!log)
+		return TimedTransformMap();
+	return log->getSessionHistory(toolUid, startTime, stopTime);
+}
+
+/** Let the tool histories read positions from the position log,
+ *  thus positions from earlier sessions and positions removed by
+ *  downsampling are found by Tool::getSessionHistory().
+ */
+void TrackingImplService::setPositionLogAsSource(bool on)
+{
+	for (ToolMap::iterator it = mTools.begin(); it != mTools.end(); ++it)
+	{
+		ToolPositionHistoryPtr data = it->second->getPositionHistory();
+		if (!data)
+			continue;
+		if (on)
+			data->setSource(boost::bind(&TrackingImplService::getLoggedSessionHistory, this, it->first, _1, _2));
+		else
+			data->setSource(ToolPositionHistory::Source());
+	}
+}
+
 void TrackingImplService::savePositionHistory()
 {
-	QString filename = this->getLoggingFolder() + "/toolpositions.snwpos";
+	mPositionLog.reset(); // reopen after writing
+
+	// sessions from older versions: continue from the legacy position file
+	QString legacyFilename = this->getLoggingFolder() + "/toolpositions.snwpos";
+	if (QFileInfo(legacyFilename).exists() && !QFileInfo(this->getPositionLogFilename()).exists())
+		convertPositionStorageToPositionLog(legacyFilename, this->getPositionLogFilename());
 
-	PositionStorageWriter writer(filename);
+	PositionLogWriter writer(this->getPositionLogFilename());
+
+	// positions in the log can be thinned out in memory, keeping the last minute at full resolution
+	double downsampleInterval = settings()->value("TrackingPositionHistory/downsampleInterval", 0).toDouble();
+	double downsampleBefore = std::min(mLastLoadPositionHistory, getMilliSecondsSinceEpoch() - 60*1000);
 
 	ToolMap::iterator it = mTools.begin();
 	for (; it != mTools.end(); ++it)
 	{
 		ToolPtr current = it->second;
-		TimedTransformMapPtr data = current->getPositionHistory();
+		ToolPositionHistoryPtr data = current->getPositionHistory();
 
 		if (!data)
 			continue;
 
-		// save only data acquired after mLastLoadPositionHistory:
-		TimedTransformMap::iterator iter = data->lower_bound(mLastLoadPositionHistory);
-		for (; iter != data->end(); ++iter)
-			writer.write(iter->second, (iter->first), current->getUid());
+		// save only data acquired after mLastLoadPositionHistory, taken from memory only:
+		TimedTransformMap unsaved;
+		ToolPositionHistory::Range range = data->getRange(mLastLoadPositionHistory, data->getLastTimestamp());
+		for (ToolPositionHistory::const_iterator iter=range.begin(); iter!=range.end(); ++iter)
+			unsaved.insert(unsaved.end(), std::make_pair(iter.time(), iter.transform()));
+		writer.write(current->getUid(), unsaved);
+
+		if (writer.isValid() && !mPlaybackSystem) // playback uses the full history
+			data->downsample(downsampleBefore, downsampleInterval);
 	}
 
 	mLastLoadPositionHistory = getMilliSecondsSinceEpoch();
 }
 
+/** Open the position log of the session. The positions are not loaded into the
+ *  tools, they are read from the log on request, see getSessionHistory()
+ *  and loadFullPositionHistory().
+ */
 void TrackingImplService::loadPositionHistory()
 {
 	if (this->getState()==Tool::tsNONE)
@@ -382,34 +447,15 @@ void TrackingImplService::loadPositionHistory()
 	// save all position data acquired so far, in case of multiple calls.
 	this->savePositionHistory();
 
-	QString filename = this->getLoggingFolder()+ "/toolpositions.snwpos";
-
-	PositionStorageReader reader(filename);
-
-	Transform3D matrix = Transform3D::Identity();
-	double timestamp;
-	QString toolUid;
+	PositionLogReaderPtr log = this->getPositionLog();
+	if (!log)
+		return;
 
 	QStringList missingTools;
-
-	while (!reader.atEnd())
-	{
-		if (!reader.read(&matrix, &timestamp, &toolUid))
-			break;
-
-		ToolPtr current = this->getTool(toolUid);
-		if (current)
-		{
-			(*current->getPositionHistory())[timestamp] = matrix;
-		}
-		else
-		{
-			missingTools << toolUid;
-		}
-	}
-
-	missingTools.removeDuplicates();
-	missingTools.removeAll("");
+	QStringList uids = log->getToolUids();
+	for (int i=0; i<uids.size(); ++i)
+		if (!this->getTool(uids[i]))
+			missingTools << uids[i];
 
 	if (!missingTools.empty())
 	{
@@ -417,8 +463,25 @@ void TrackingImplService::loadPositionHistory()
 							  "are not present in the configuration:"
 							  "\n  \t%1").arg(missingTools.join("\n  \t")));
 	}
+}
 
-	mLastLoadPositionHistory = getMilliSecondsSinceEpoch();
+/** Fill the tools with all positions in the position log.
+ *  Required by playback, which works on the full tool histories.
+ */
+void TrackingImplService::loadFullPositionHistory()
+{
+	PositionLogReaderPtr log = this->getPositionLog();
+	if (!log)
+		return;
+
+	ToolMap::iterator it = mTools.begin();
+	for (; it != mTools.end(); ++it)
+	{
+		ToolPositionHistoryPtr data = it->second->getPositionHistory();
+		if (!data)
+			continue;
+		data->merge(log->getPositionHistory(it->first));
+	}
 }
 
 //void TrackingImplService::setLoggingFolder(QString loggingFolder)
@@ -559,6 +622,7 @@ QString TrackingImplService::getLoggingFolder()
 
 void TrackingImplService::onSessionChanged()
 {
+	mPositionLog.reset();
 	QString loggingFolder = this->getLoggingFolder();
 
 	for (unsigned i=0; i<mTrackingSystems.size(); ++i)
@@ -567,6 +631,7 @@ void TrackingImplService::onSessionChanged()
 
 void TrackingImplService::onSessionCleared()
 {
+	mPositionLog.reset();
 	mManualTool->set_prMt(Transform3D::Identity());
 }
 
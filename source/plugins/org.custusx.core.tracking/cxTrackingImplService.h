@@ -36,6 +36,7 @@ typedef boost::shared_ptr<class PlaybackTime> PlaybackTimePtr;
 typedef boost::shared_ptr<class TrackingSystemService> TrackingSystemServicePtr;
 typedef boost::shared_ptr<class TrackingSystemPlaybackService> TrackingSystemPlaybackServicePtr;
 typedef boost::shared_ptr<class SessionStorageService> SessionStorageServicePtr;
+typedef boost::shared_ptr<class PositionLogReader> PositionLogReaderPtr;
 
 /**
  * \brief Interface towards the navigation system.
@@ -134,6 +135,11 @@ private:
 	void parseXml(QDomNode& dataNode); ///< read internal state from node
 	virtual void savePositionHistory();
 	virtual void loadPositionHistory();
+	void loadFullPositionHistory();
+	QString getPositionLogFilename();
+	PositionLogReaderPtr getPositionLog();
+	TimedTransformMap getLoggedSessionHistory(QString toolUid, double startTime, double stopTime);
+	void setPositionLogAsSource(bool on);
 
 	QString getLoggingFolder();
 
@@ -143,6 +149,7 @@ private:
 	ManualToolAdapterPtr mManualTool; ///< a mouse-controllable virtual tool that is available even when not tracking.
 
 	double mLastLoadPositionHistory;
+	PositionLogReaderPtr mPositionLog; ///< positions saved to the session, opened on demand
 
 	std::vector<TrackingSystemServicePtr> mTrackingSystems;
 	TrackingSystemPlaybackServicePtr mPlaybackSystem;
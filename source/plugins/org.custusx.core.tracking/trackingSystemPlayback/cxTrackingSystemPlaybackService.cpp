@@ -59,11 +59,11 @@ void TrackingSystemPlaybackService::start()
 		connect(current.get(), &Tool::toolTransformAndTimestamp, this, &TrackingSystemPlaybackService::onToolPositionChanged);
 		mTools.push_back(current);
 
-		TimedTransformMapPtr history = original[i]->getPositionHistory();
+		ToolPositionHistoryPtr history = original[i]->getPositionHistory();
 		if (!history->empty())
 		{
-			timeRange.first = std::min(timeRange.first, history->begin()->first);
-			timeRange.second = std::max(timeRange.second, history->rbegin()->first);
+			timeRange.first = std::min(timeRange.first, history->getFirstTimestamp());
+			timeRange.second = std::max(timeRange.second, history->getLastTimestamp());
 		}
 	}
 
@@ -36,7 +36,8 @@ namespace cx
 IGTLinkClientStreamer::IGTLinkClientStreamer() :
 	mHeadingReceived(false),
 	mAddress(""),
-	mPort(0)
+	mPort(0),
+	mImagePool(IGTLinkImageMessagePool::create())
 {
 }
 
@@ -283,19 +284,16 @@ void write_time_info(igtl::ImageMessage::Pointer imgMsg)
 
 bool IGTLinkClientStreamer::ReceiveImage(QTcpSocket* socket, igtl::MessageHeader::Pointer& header)
 {
-	// Create a message buffer to receive transform data
-	igtl::ImageMessage::Pointer imgMsg = igtl::ImageMessage::New();
-	imgMsg->SetMessageHeader(header);
-	imgMsg->AllocatePack();
-
-	// Receive transform data from the socket
 	// ignore if not enough data (yet)
-	if (socket->bytesAvailable() < imgMsg->GetPackBodySize())
+	if (socket->bytesAvailable() < header->GetBodySizeToRead())
 	{
 		//std::cout << "Incomplete body received, ignoring. " << std::endl;
 		return false;
 	}
 
+	// Get a recycled message buffer to receive image data
+	igtl::ImageMessage::Pointer imgMsg = mImagePool->getMessage(header);
+
 	socket->read(reinterpret_cast<char*>(imgMsg->GetPackBodyPointer()), imgMsg->GetPackBodySize());
 	// Deserialize the transform data
 	// If you want to do a CRC check, call Unpack(1).
@@ -311,6 +309,7 @@ bool IGTLinkClientStreamer::ReceiveImage(QTcpSocket* socket, igtl::MessageHeader
 	}
 
 	std::cout << "body crc failed!" << std::endl;
+	mImagePool->release(imgMsg);
 	return true;
 }
 
@@ -334,7 +333,7 @@ void IGTLinkClientStreamer::addToQueue(igtl::ImageMessage::Pointer msg)
     }
     else
     {
-        package->mImage = imageconverter.decode(msg);
+        package->mImage = imageconverter.decode(msg, mImagePool);
     }
 
 	// if us status not sent, do it here
@@ -17,6 +17,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxIGTLinkImageMessage.h"
 #include "cxIGTLinkUSStatusMessage.h"
 #include "cxStreamedTimestampSynchronizer.h"
+#include "cxIGTLinkImageMessagePool.h"
 
 class QTcpSocket;
 
@@ -27,6 +28,10 @@ namespace cx
  * Streamer that listens to an IGTLink connection, then
  * streams the incoming data.
  *
+ * Image messages are taken from a pool of recycled messages, and the
+ * socket is read directly into the buffer that backs the resulting image
+ * when no conversion is needed.
+ *
  * \addtogroup org_custusx_core_video
  * \author Christian Askeland, SINTEF
  * \date 2014-11-20
@@ -44,6 +49,7 @@ public:
 	virtual void startStreaming(SenderPtr sender);
 	virtual void stopStreaming();
 	virtual bool isStreaming();
+	IGTLinkImageMessagePoolPtr getImagePool() const { return mImagePool; }
 
 
 private slots:
@@ -75,6 +81,7 @@ private:
     boost::shared_ptr<QTcpSocket> mSocket;
 	igtl::MessageHeader::Pointer mHeaderMsg;
 	IGTLinkUSStatusMessage::Pointer mUnsentUSStatusMessage; ///< received message, will be added to queue when next image arrives
+	IGTLinkImageMessagePoolPtr mImagePool;
 
 
 };
@@ -13,16 +13,22 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #define CXDICOMCONVERTER_H_
 
 #include "cxImage.h"
+#include "cxDicomImageReader.h"
 #include "org_custusx_dicom_Export.h"
 class ctkDICOMDatabase;
 
 namespace cx
 {
-typedef boost::shared_ptr<class DicomImageReader> DicomImageReaderPtr;
 
 /**
  * Import dicom series into cx Image.
  *
+ * The headers of all files are read first, and used to sort the
+ * slices and validate the grid. The output volume is then allocated
+ * once, and the slices are decoded in parallel directly into it.
+ * Series that do not fit this scheme (e.g. slices of different size)
+ * are imported by converting each slice to an image and merging them.
+ *
  * \ingroup org_custusx_dicom
  *
  * \date 2014-04-04
@@ -36,17 +42,35 @@ public:
 
 	void setDicomDatabase(ctkDICOMDatabase* database);
 	ImagePtr convertToImage(QString seriesUid);
+	ImagePtr convertFilesToImage(QStringList files);
+	ImagePtr convertFilesToImageBySlices(QStringList files); ///< old import path, one image per slice
 
 private:
+	struct SliceHeader
+	{
+		QString mFilename;
+		DicomImageReaderPtr mReader;
+		Vector3D mPosition;
+		Eigen::Array3i mDim;
+		int mComponents;
+	};
+	typedef std::map<double, SliceHeader> SortedSliceHeaders;
+
 	QString generateUid(DicomImageReaderPtr reader);
 	QString generateName(DicomImageReaderPtr reader);
 	std::map<double, ImagePtr> sortImagesAlongDirection(std::vector<ImagePtr> images, Vector3D  e_sort);
 	ImagePtr mergeSlices(std::map<double, ImagePtr> sorted) const;
 	double getMeanSliceDistance(std::map<double, ImagePtr> sorted) const;
-	bool slicesFormRegularGrid(std::map<double, ImagePtr> sorted, Vector3D e_sort) const;
+	double getMeanSliceDistance(double firstDistance, double lastDistance, unsigned long numberOfSlices) const;
+	bool slicesFormRegularGrid(std::vector<Vector3D> positions, Vector3D e_sort) const;
 	// ignoreLocalizerImages is a tag to ignore special images. For now only localizer images are ignored
+	DicomImageReaderPtr readHeader(QString filename, bool ignoreLocalizerImages);
 	ImagePtr createCxImageFromDicomFile(QString filename, bool ignoreLocalizerImages);
 	std::vector<ImagePtr> createImages(QStringList files);
+	std::vector<SliceHeader> readSliceHeaders(QStringList files);
+	SortedSliceHeaders sortSlicesAlongDirection(const std::vector<SliceHeader>& slices, Vector3D e_sort) const;
+	bool slicesHaveEqualFormat(const SortedSliceHeaders& sorted) const;
+	ImagePtr readSlicesIntoVolume(const SortedSliceHeaders& sorted);
     QString convertToValidName(QString text) const;
 
 	ctkDICOMDatabase* mDatabase;
@@ -232,6 +232,79 @@ vtkImageDataPtr DicomImageReader::createVtkImageData()
 	return data;
 }
 
+namespace
+{
+template<class T>
+void castToShort(const void* source, short* target, unsigned long numberOfValues)
+{
+	const T* values = static_cast<const T*>(source);
+	for (unsigned long i=0; i<numberOfValues; ++i)
+		target[i] = static_cast<short>(values[i]);
+}
+} // namespace
+
+bool DicomImageReader::readPixelDataAsShort(short* target, unsigned long numberOfValues) const
+{
+	DicomImage dicomImage(mFilename.toLatin1().data());
+	const DiPixel *pixels = dicomImage.getInterData();
+	if (!pixels)
+	{
+		this->error("Found no pixel data");
+		return false;
+	}
+
+	if (pixels->getCount()*pixels->getPlanes() != numberOfValues)
+	{
+		this->error("Mismatch in pixel counts");
+		return false;
+	}
+
+	const void* data = pixels->getData();
+	switch (pixels->getRepresentation())
+	{
+	case EPR_Uint8:
+		castToShort<Uint8>(data, target, numberOfValues);
+		break;
+	case EPR_Uint16:
+		castToShort<Uint16>(data, target, numberOfValues);
+		break;
+	case EPR_Uint32:
+		castToShort<Uint32>(data, target, numberOfValues);
+		break;
+	case EPR_Sint8:
+		castToShort<Sint8>(data, target, numberOfValues);
+		break;
+	case EPR_Sint16:
+		castToShort<Sint16>(data, target, numberOfValues);
+		break;
+	case EPR_Sint32:
+		castToShort<Sint32>(data, target, numberOfValues);
+		break;
+	default:
+		this->error("Unsupported pixel representation");
+		return false;
+	}
+	return true;
+}
+
+Eigen::Array3i DicomImageReader::getDimensions() const
+{
+	unsigned short rows = 0;
+	unsigned short columns = 0;
+	mDataset->findAndGetUint16(DCM_Rows, rows, 0, OFTrue);
+	mDataset->findAndGetUint16(DCM_Columns, columns, 0, OFTrue);
+	return Eigen::Array3i(columns, rows, this->getNumberOfFrames());
+}
+
+int DicomImageReader::getSamplesPerPixel() const
+{
+	unsigned short samples = 0;
+	OFCondition condition = mDataset->findAndGetUint16(DCM_SamplesPerPixel, samples, 0, OFTrue);
+	if (!condition.good() || samples==0)
+		return 1;
+	return samples;
+}
+
 Eigen::Array3d DicomImageReader::getSpacing() const
 {
 	Eigen::Array3d spacing;
@@ -59,6 +59,14 @@ public:
 	int getNumberOfFrames() const;
 	QString getPatientName() const;
 	bool isLocalizerImage() const;
+	Eigen::Array3d getSpacing() const;
+	Eigen::Array3i getDimensions() const; ///< columns, rows, frames as given by the header
+	int getSamplesPerPixel() const;
+	/** Decode the pixel data and write it to target, converted to short
+	 *  the same way as vtkImageCast. numberOfValues is the expected
+	 *  number of values, i.e. pixels times samples per pixel.
+	 */
+	bool readPixelDataAsShort(short* target, unsigned long numberOfValues) const;
 
 private:
 	DcmFileFormat mFileFormat;
@@ -67,7 +75,6 @@ private:
 
 	DicomImageReader();
 	bool loadFile(QString filename);
-	Eigen::Array3d getSpacing() const;
 	Eigen::Array3i getDim(const DicomImage& dicomImage) const;
 	void error(QString message) const;
 	double getDouble(const DcmTagKey& tag, const unsigned long pos=0, const OFBool searchIntoSub = OFFalse) const;
@@ -249,6 +249,31 @@ TEST_CASE("DicomConverter: Convert Kaisa", "[integration][plugins][org.custusx.d
 	cx::LogicManager::shutdown();
 }
 
+TEST_CASE("DicomConverter: Import into volume equals slice by slice import", "[integration][plugins][org.custusx.dicom]")
+{
+	cx::Reporter::initialize();
+	DicomConverterTestFixture fixture;
+
+	QString inputDicomDataDirectory = cx::DataLocations::getTestDataPath()+"/Phantoms/Kaisa/DICOM/";
+	ctkDICOMDatabasePtr db = fixture.loadDirectory(inputDicomDataDirectory);
+
+	QString patient = fixture.getOneFromList(db->patients());
+	QString study = fixture.getOneFromList(db->studiesForPatient(patient));
+	QString series = fixture.getOneFromList(db->seriesForStudy(study));
+	QStringList files = db->filesForSeries(series);
+	REQUIRE(files.size()>1);
+
+	cx::DicomConverter converter;
+	cx::ImagePtr volumeImage = converter.convertFilesToImage(files);
+	cx::ImagePtr sliceImage = converter.convertFilesToImageBySlices(files);
+
+	fixture.checkImagesEqual(volumeImage, sliceImage);
+	CHECK(volumeImage->getName()==sliceImage->getName());
+	CHECK(Eigen::Array3d(volumeImage->getBaseVtkImageData()->GetSpacing()).isApprox(Eigen::Array3d(sliceImage->getBaseVtkImageData()->GetSpacing())));
+
+	cx::Reporter::shutdown();
+}
+
 TEST_CASE("DicomConverter: Convert DICOM dataset from Radiology department - verify .mhd file is written",
           "[integration][plugins][org.custusx.dicom]")
 {
@@ -4,6 +4,7 @@
 #include <vtkPolyData.h>
 #include "cxBranchList.h"
 #include "cxBranch.h"
+#include "cxKdTree.h"
 #include <vtkCellArray.h>
 #include "vtkCardinalSpline.h"
 #include <QDir>
@@ -63,29 +64,40 @@ void RouteToTarget::processCenterline(vtkPolyDataPtr centerline_r)
 	mBranchListPtr->smoothOrientations();
     //mBranchListPtr->smoothBranchPositions(40);
 
+	this->createBranchPositionIndex();
+
 	std::cout << "Number of branches in CT centerline: " << mBranchListPtr->getBranches().size() << std::endl;
 }
 
 
+void RouteToTarget::createBranchPositionIndex()
+{
+	mBranchPositionIndexLookup.clear();
+	std::vector<BranchPtr> branches = mBranchListPtr->getBranches();
+	for (int i = 0; i < branches.size(); i++)
+		for (int j = 0; j < branches[i]->getPositions().cols(); j++)
+			mBranchPositionIndexLookup.push_back(std::make_pair(branches[i], j));
+
+	Eigen::MatrixXd positions(3, mBranchPositionIndexLookup.size());
+	for (int k = 0; k < mBranchPositionIndexLookup.size(); k++)
+		positions.col(k) = mBranchPositionIndexLookup[k].first->getPositions().col(mBranchPositionIndexLookup[k].second);
+
+	mBranchPositionIndex.reset(new KdTree(positions));
+}
+
 void RouteToTarget::findClosestPointInBranches(Vector3D targetCoordinate_r)
 {
+	if (!mBranchPositionIndex)
+		this->createBranchPositionIndex();
+
 	double minDistance = 100000;
-	int minDistancePositionIndex;
+	int minDistancePositionIndex = 0;
 	BranchPtr minDistanceBranch;
-	std::vector<BranchPtr> branches = mBranchListPtr->getBranches();
-	for (int i = 0; i < branches.size(); i++)
+	std::pair<int, double> nearest = mBranchPositionIndex->findNearest(targetCoordinate_r);
+	if (nearest.first >= 0 && nearest.second < minDistance)
 	{
-		Eigen::MatrixXd positions = branches[i]->getPositions();
-		for (int j = 0; j < positions.cols(); j++)
-		{
-            double D = findDistance(positions.col(j), targetCoordinate_r);
-			if (D < minDistance)
-			{
-				minDistance = D;
-				minDistanceBranch = branches[i];
-				minDistancePositionIndex = j;
-			}
-		}
+		minDistanceBranch = mBranchPositionIndexLookup[nearest.first].first;
+		minDistancePositionIndex = mBranchPositionIndexLookup[nearest.first].second;
 	}
 
 		mProjectedBranchPtr = minDistanceBranch;
@@ -12,6 +12,7 @@ typedef std::vector< Eigen::Matrix4d > M4Vector;
 typedef boost::shared_ptr<class RouteToTarget> RouteToTargetPtr;
 typedef boost::shared_ptr<class BranchList> BranchListPtr;
 typedef boost::shared_ptr<class Branch> BranchPtr;
+typedef boost::shared_ptr<class KdTree> KdTreePtr;
 
 
 class RouteToTarget
@@ -35,6 +36,8 @@ public:
 private:
 	Eigen::MatrixXd mCLpoints;
 	BranchListPtr mBranchListPtr;
+	KdTreePtr mBranchPositionIndex; ///< all branch positions, built once per centerline
+	std::vector< std::pair<BranchPtr, int> > mBranchPositionIndexLookup; ///< branch and position index for each point in mBranchPositionIndex
 	BranchPtr mProjectedBranchPtr;
 	int mProjectedIndex;
     Vector3D mTargetPosition;
@@ -43,6 +46,7 @@ private:
 	std::vector<BranchPtr> mSearchBranchPtrVector;
 	std::vector<int> mSearchIndexVector;
     std::vector<Eigen::Vector3d> smoothBranch(BranchPtr branchPtr, int startIndex, Eigen::MatrixXd startPosition);
+	void createBranchPositionIndex();
 };
 
 double findDistanceToLine(Eigen::MatrixXd point, Eigen::MatrixXd line);
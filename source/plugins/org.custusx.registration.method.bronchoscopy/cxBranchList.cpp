@@ -12,8 +12,10 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxBranch.h"
 #include "cxMesh.h"
 #include "cxVector3D.h"
+#include "cxKdTree.h"
 #include <vtkPolyData.h>
 #include <vtkCardinalSpline.h>
+#include <limits>
 
 
 typedef vtkSmartPointer<class vtkCardinalSpline> vtkCardinalSplinePtr;
@@ -203,41 +205,45 @@ void BranchList::smoothBranchPositions(int controlPointDistance)
 void BranchList::findBranchesInCenterline(Eigen::MatrixXd positions_r)
 {
     positions_r = sortMatrix(2,positions_r);
-    Eigen::MatrixXd positionsNotUsed_r = positions_r;
+    KdTree positionsNotUsed_r(positions_r); // indices refer to positions_r
 
-//	int minIndex;
-	int index;
 	int splitIndex;
-	Eigen::MatrixXd::Index startIndex;
+	int startIndex;
 	BranchPtr branchToSplit;
-    while (positionsNotUsed_r.cols() > 0)
+    while (!positionsNotUsed_r.empty())
 	{
+		branchToSplit.reset();
 		if (!mBranches.empty())
 		{
 			double minDistance = 1000;
 			for (int i = 0; i < mBranches.size(); i++)
 			{
-				std::pair<std::vector<Eigen::MatrixXd::Index>, Eigen::VectorXd> distances;
-                distances = dsearchn(positionsNotUsed_r, mBranches[i]->getPositions());
-				double d = distances.second.minCoeff(&index);
+				std::pair<int, double> closest = findClosestPair(positionsNotUsed_r, mBranches[i]->getPositions());
+				double d = closest.second;
 				if (d < minDistance)
 				{
 					minDistance = d;
 					branchToSplit = mBranches[i];
-					startIndex = index;
+					startIndex = closest.first;
 					if (minDistance < 2)
 						break;
 				}
 			}
-            std::pair<Eigen::MatrixXd::Index, double> dsearchResult = dsearch(positionsNotUsed_r.col(startIndex) , branchToSplit->getPositions());
+		}
+
+		if (branchToSplit)
+		{
+            std::pair<Eigen::MatrixXd::Index, double> dsearchResult = dsearch(positions_r.col(startIndex) , branchToSplit->getPositions());
 			splitIndex = dsearchResult.first;
 		}
-		else //if this is the first branch. Select the top position (Trachea).
-            startIndex = positionsNotUsed_r.cols() - 1;
+		else //if this is the first branch, or no branch is close. Select the top position (Trachea).
+		{
+            startIndex = positions_r.cols() - 1;
+			while (positionsNotUsed_r.isRemoved(startIndex))
+				--startIndex;
+		}
 
-        std::pair<Eigen::MatrixXd,Eigen::MatrixXd > connectedPointsResult = findConnectedPointsInCT(startIndex , positionsNotUsed_r);
-		Eigen::MatrixXd branchPositions = connectedPointsResult.first;
-        positionsNotUsed_r = connectedPointsResult.second;
+		Eigen::MatrixXd branchPositions = findConnectedPointsInCT(startIndex , &positionsNotUsed_r);
 
 		if (branchPositions.cols() >= 5) //only include brances of length >= 5 points
 		{
@@ -245,7 +251,7 @@ void BranchList::findBranchesInCenterline(Eigen::MatrixXd positions_r)
 			newBranch->setPositions(branchPositions);
 			mBranches.push_back(newBranch);
 
-			if (mBranches.size() > 1) // do not try to split another branch when the first branch is processed
+			if (branchToSplit) // do not try to split another branch when the first branch is processed
 			{
 				if ((splitIndex + 1 >= 5) && (branchToSplit->getPositions().cols() - splitIndex - 1 >= 5))
 					//do not split branch if the new branch is close to the edge of the branch
@@ -306,12 +312,13 @@ BranchListPtr BranchList::removePositionsForLocalRegistration(Eigen::MatrixXd tr
 	std::vector<BranchPtr> branches = retval->getBranches();
 	Eigen::MatrixXd positions;
 	Eigen::MatrixXd orientations;
+	KdTree trackingPositionsIndex(trackingPositions);
 	for (int i = 0; i < branches.size(); i++)
 	{
 		positions = branches[i]->getPositions();
 		orientations = branches[i]->getOrientations();
 		std::pair<std::vector<Eigen::MatrixXd::Index>, Eigen::VectorXd> distanceData;
-		distanceData = dsearchn(positions, trackingPositions);
+		distanceData = dsearchn(positions, trackingPositionsIndex);
 		Eigen::VectorXd distance = distanceData.second;
         for (int j = positions.cols() - 1; j >= 0; j--)
 		{
@@ -446,40 +453,70 @@ std::pair<Eigen::MatrixXd::Index, double> dsearch(Eigen::Vector3d p, Eigen::Matr
 	return std::make_pair(index , d);
 }
 
-std::pair<std::vector<Eigen::MatrixXd::Index>, Eigen::VectorXd > dsearchn(Eigen::MatrixXd p1, Eigen::MatrixXd p2)
+std::pair<std::vector<Eigen::MatrixXd::Index>, Eigen::VectorXd > dsearchn(const Eigen::MatrixXd& p1, const Eigen::MatrixXd& p2)
+{
+	return dsearchn(p1, KdTree(p2));
+}
+
+/**
+ * For each position in p1, find the nearest position in the index p2.
+ */
+std::pair<std::vector<Eigen::MatrixXd::Index>, Eigen::VectorXd > dsearchn(const Eigen::MatrixXd& p1, const KdTree& p2)
 {
-	Eigen::MatrixXd::Index index;
 	std::vector<Eigen::MatrixXd::Index> indexVector;
 	Eigen::VectorXd D(p1.cols());
 	for (int i = 0; i < p1.cols(); i++)
 	{
 		// find nearest neighbour
-		(p2.colwise() - p1.col(i)).colwise().squaredNorm().minCoeff(&index);
-		D(i) = (p2.col(index) - p1.col(i)).norm();
-		indexVector.push_back(index);
+		std::pair<int, double> nearest = p2.findNearest(p1.col(i));
+		D(i) = nearest.second;
+		indexVector.push_back(nearest.first);
 	}
 	return std::make_pair(indexVector , D);
 }
 
-std::pair<Eigen::MatrixXd,Eigen::MatrixXd > findConnectedPointsInCT(int startIndex , Eigen::MatrixXd positionsNotUsed)
+/**
+ * Find the position in p1 closest to any of the positions in p2.
+ * Return its index in p1 and the distance, or (-1, inf) if p1 is empty.
+ * Of several equally close positions, the lowest index is used.
+ */
+std::pair<int, double> findClosestPair(const KdTree& p1, const Eigen::MatrixXd& p2)
+{
+	std::pair<int, double> retval(-1, std::numeric_limits<double>::infinity());
+	for (int j = 0; j < p2.cols(); j++)
+	{
+		std::pair<int, double> nearest = p1.findNearest(p2.col(j));
+		if (nearest.first < 0)
+			break;
+		if (nearest.second < retval.second || (nearest.second == retval.second && nearest.first < retval.first))
+			retval = nearest;
+	}
+	return retval;
+}
+
+/**
+ * Collect connected positions, starting at startIndex and repeatedly
+ * moving to the closest remaining position. The collected positions
+ * are removed from positionsNotUsed.
+ */
+Eigen::MatrixXd findConnectedPointsInCT(int startIndex , KdTree* positionsNotUsed)
 {
-    //Eigen::MatrixXd branchPositions(positionsNotUsed.rows(), positionsNotUsed.cols());
-	Eigen::MatrixXd thisPosition(3,1);
-    std::vector<Eigen::MatrixXd> branchPositionsVector;
-	thisPosition = positionsNotUsed.col(startIndex);
+	const Eigen::Matrix3Xd& positions = positionsNotUsed->getPositions();
+	Eigen::Vector3d thisPosition = positions.col(startIndex);
+    std::vector<Eigen::Vector3d> branchPositionsVector;
     branchPositionsVector.push_back(thisPosition); //add first position to branch
-	positionsNotUsed = eraseCol(startIndex,positionsNotUsed);; //remove first position from list of remaining points
+	positionsNotUsed->remove(startIndex); //remove first position from list of remaining points
 
-    while (positionsNotUsed.cols() > 0)
+    while (!positionsNotUsed->empty())
 	{
-		std::pair<Eigen::MatrixXd::Index, double > minDistance = dsearch(thisPosition, positionsNotUsed);
-		Eigen::MatrixXd::Index index = minDistance.first;
+		std::pair<int, double> minDistance = positionsNotUsed->findNearest(thisPosition);
+		int index = minDistance.first;
         double d = minDistance.second;
 		if (d > 3) // more than 3 mm distance to closest point --> branch is compledted
 			break;
 
-		thisPosition = positionsNotUsed.col(index);
-		positionsNotUsed = eraseCol(index,positionsNotUsed);
+		thisPosition = positions.col(index);
+		positionsNotUsed->remove(index);
 		//add position to branch
         branchPositionsVector.push_back(thisPosition);
 
@@ -492,7 +529,7 @@ std::pair<Eigen::MatrixXd,Eigen::MatrixXd > findConnectedPointsInCT(int startInd
         branchPositions.block(0,j,3,1) = branchPositionsVector[j];
     }
 
-    return std::make_pair(branchPositions, positionsNotUsed);
+    return branchPositions;
 }
 
 
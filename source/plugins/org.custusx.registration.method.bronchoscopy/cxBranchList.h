@@ -22,6 +22,7 @@ namespace cx
 
 typedef std::vector< Eigen::Matrix4d > M4Vector;
 typedef boost::shared_ptr<class BranchList> BranchListPtr;
+class KdTree;
 
 class org_custusx_registration_method_bronchoscopy_EXPORT BranchList
 {
@@ -43,11 +44,13 @@ public:
 	vtkPolyDataPtr createVtkPolyDataFromBranches(bool fullyConnected = false, bool straightBranches = false) const;
 };
 
-std::pair<Eigen::MatrixXd,Eigen::MatrixXd > findConnectedPointsInCT(int startIndex , Eigen::MatrixXd positionsNotUsed);
+Eigen::MatrixXd findConnectedPointsInCT(int startIndex , KdTree* positionsNotUsed);
 Eigen::MatrixXd sortMatrix(int rowNumber, Eigen::MatrixXd matrix);
 Eigen::MatrixXd eraseCol(int removeIndex, Eigen::MatrixXd positions);
 std::pair<Eigen::MatrixXd::Index, double> dsearch(Eigen::Vector3d p, Eigen::MatrixXd positions);
-std::pair<std::vector<Eigen::MatrixXd::Index>, Eigen::VectorXd > dsearchn(Eigen::MatrixXd p1, Eigen::MatrixXd p2);
+std::pair<std::vector<Eigen::MatrixXd::Index>, Eigen::VectorXd > dsearchn(const Eigen::MatrixXd& p1, const Eigen::MatrixXd& p2);
+std::pair<std::vector<Eigen::MatrixXd::Index>, Eigen::VectorXd > dsearchn(const Eigen::MatrixXd& p1, const KdTree& p2);
+std::pair<int, double> findClosestPair(const KdTree& p1, const Eigen::MatrixXd& p2);
 
 }//namespace cx
 
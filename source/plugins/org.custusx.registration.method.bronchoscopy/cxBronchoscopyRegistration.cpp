@@ -20,6 +20,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxVector3D.h"
 #include "cxLogger.h"
 #include <boost/math/special_functions/fpclassify.hpp> // isnan
+#include <limits>
 
 namespace cx
 {
@@ -171,45 +172,68 @@ Eigen::Matrix4d performLandmarkRegistration(vtkPointsPtr source, vtkPointsPtr ta
 
 
 
-    std::vector<Eigen::MatrixXd::Index> dsearch2n(Eigen::MatrixXd pos1, Eigen::MatrixXd pos2, Eigen::MatrixXd ori1, Eigen::MatrixXd ori2)
+/**
+ * Difference between orientation components, modulo 2.
+ * Components of unit vectors differ by at most 2, thus fmod is rarely needed.
+ */
+inline float orientationDifference(double a, double b)
+{
+	double diff = a - b;
+	if (std::abs(diff) >= 2)
+		diff = fmod(diff, 2);
+	return diff;
+}
+
+/**
+ * For each position in pos1, find the closest position in pos2, using a distance
+ * weighted between position and orientation.
+ *
+ * The weight of the orientation depends on the distances to all positions in pos2,
+ * thus a spatial index cannot be used here. P and O are computed in one pass into
+ * buffers reused for all positions.
+ */
+    std::vector<Eigen::MatrixXd::Index> dsearch2n(const Eigen::MatrixXd& pos1, const Eigen::MatrixXd& pos2, const Eigen::MatrixXd& ori1, const Eigen::MatrixXd& ori2)
     {
-        Eigen::MatrixXd::Index index;
         std::vector<Eigen::MatrixXd::Index> indexVector;
-        
+        indexVector.reserve(pos1.cols());
+        std::vector<float> P(pos2.cols());
+        std::vector<float> O(pos2.cols());
+
         for (int i = 0; i < pos1.cols(); i++)
         {
-            Eigen::VectorXd D(pos2.cols());
-            Eigen::VectorXd P(pos2.cols());
-            Eigen::VectorXd O(pos2.cols());
-            Eigen::VectorXd R(pos2.cols());
-            
+            double sumR = 0;
             for (int j = 0; j < pos2.cols(); j++)
             {
                 float p0 = ( pos2(0,j) - pos1(0,i) );
                 float p1 = ( pos2(1,j) - pos1(1,i) );
                 float p2 = ( pos2(2,j) - pos1(2,i) );
-                float o0 = fmod( ori2(0,j) - ori1(0,i) , 2 );
-                float o1 = fmod( ori2(1,j) - ori1(1,i) , 2 );
-                float o2 = fmod( ori2(2,j) - ori1(2,i) , 2 );
-                
-                P(j) = sqrt( p0*p0 + p1*p1 + p2*p2 );
-                O(j) = sqrt( o0*o0 + o1*o1 + o2*o2 );
-
-                if (boost::math::isnan( O(j) ))
-                    O(j) = 4;
+                float o0 = orientationDifference( ori2(0,j), ori1(0,i) );
+                float o1 = orientationDifference( ori2(1,j), ori1(1,i) );
+                float o2 = orientationDifference( ori2(2,j), ori1(2,i) );
 
-                if ( (o0>2) || (o1>2) || (o2>2) )
-                    std::cout << "Warning in bronchoscopyRegistration.cpp: Error on oriantation calculation in dsearch2n. Orientation > 2." << std::endl;
+                P[j] = sqrt( p0*p0 + p1*p1 + p2*p2 );
+                O[j] = sqrt( o0*o0 + o1*o1 + o2*o2 );
 
-                R(j) = P(j) / O(j);
+                if (boost::math::isnan( O[j] ))
+                    O[j] = 4;
 
+                sumR += double(P[j]) / O[j];
             }
-            float alpha = sqrt( R.mean() );
+            float alpha = sqrt( sumR / pos2.cols() );
 						if (boost::math::isnan( alpha ))
                 alpha = 0;
 
-            D = P + alpha * O;
-            D.minCoeff(&index);
+            Eigen::MatrixXd::Index index = 0;
+            double minD = std::numeric_limits<double>::infinity();
+            for (int j = 0; j < pos2.cols(); j++)
+            {
+                double D = P[j] + double(alpha) * O[j];
+                if (D < minD)
+                {
+                    minD = D;
+                    index = j;
+                }
+            }
             indexVector.push_back(index);
         }
         return indexVector;
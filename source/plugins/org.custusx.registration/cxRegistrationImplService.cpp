@@ -21,7 +21,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxTypeConversions.h"
 #include "cxLogger.h"
 #include "cxRegistrationTransform.h"
-#include "cxFrameForest.h"
+#include "cxFrameGraph.h"
 #include "cxPatientModelService.h"
 #include "cxRegistrationApplicator.h"
 #include "cxLandmark.h"
@@ -37,8 +37,11 @@ RegistrationImplService::RegistrationImplService(ctkPluginContext *context) :
 	mLastRegistrationTime(QDateTime::currentDateTime()),
 	mContext(context),
 	mPatientModelService(new PatientModelServiceProxy(context)),
-	mSession(SessionStorageServiceProxy::create(context))
+	mSession(SessionStorageServiceProxy::create(context)),
+	mFrameGraph(new FrameGraph())
 {
+	connect(mPatientModelService.get(), &PatientModelService::dataAddedOrRemoved, this, &RegistrationImplService::dataAddedOrRemovedSlot);
+	this->dataAddedOrRemovedSlot();
 	connect(mSession.get(), &SessionStorageService::cleared, this, &RegistrationImplService::clearSlot);
     connect(mSession.get(), &SessionStorageService::isLoadingSecond, this, &RegistrationImplService::duringLoadPatientSlot);
 	connect(mSession.get(), &SessionStorageService::isSaving, this, &RegistrationImplService::duringSavePatientSlot);
@@ -101,6 +104,11 @@ void RegistrationImplService::clearSlot()
 	this->setFixedData(DataPtr());
 }
 
+void RegistrationImplService::dataAddedOrRemovedSlot()
+{
+	mFrameGraph->setData(mPatientModelService->getDatas());
+}
+
 void RegistrationImplService::setMovingData(DataPtr data)
 {
 	this->setMovingData((data) ? data->getUid() : "");
@@ -445,7 +453,7 @@ void RegistrationImplService::performPatientRegistration(Transform3D rMpr_new, Q
  */
 void RegistrationImplService::updateRegistration_rMd(QDateTime oldTime, RegistrationTransform dMd, DataPtr data)
 {
-	RegistrationApplicator applicator(mPatientModelService->getDatas());
+	RegistrationApplicator applicator(mPatientModelService->getDatas(), mFrameGraph);
 	dMd.mMoving = data->getUid();
 	applicator.updateRegistration(oldTime, dMd);
 
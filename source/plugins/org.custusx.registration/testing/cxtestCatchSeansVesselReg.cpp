@@ -25,6 +25,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <QDir>
 #include "cxFileManagerServiceProxy.h"
 #include "cxLogicManager.h"
+#include "cxtestPatientModelServiceMock.h"
+#include <QElapsedTimer>
 
 
 TEST_CASE_METHOD(cxtest::SeansVesselRegFixture, "SeansVesselReg: V2V syntectic data", "[integration][modules][registration][not_win32]")
@@ -164,3 +166,59 @@ TEST_CASE_METHOD(cxtest::SeansVesselRegFixture, "SeansVesselReg: V2V registratio
 
 	cx::LogicManager::shutdown();
 }
+
+namespace
+{
+double runVesselReg(cx::DataPtr source, cx::DataPtr target, bool parallel, cx::Transform3D* result)
+{
+	cx::SeansVesselReg vesselReg;
+	vesselReg.mt_doOnlyLinear = true;
+	vesselReg.mt_parallel = parallel;
+
+	QElapsedTimer timer;
+	timer.start();
+	REQUIRE(vesselReg.initialize(source, target, cx::DataLocations::getTestDataPath() + "/Log"));
+	REQUIRE(vesselReg.execute());
+	double elapsed = timer.elapsed();
+
+	*result = vesselReg.getLinearResult();
+	std::vector<cx::SeansVesselReg::IterationTiming> timings = vesselReg.getIterationTimings();
+	double closestPoints = 0;
+	for (unsigned i=0; i<timings.size(); ++i)
+		closestPoints += timings[i].mClosestPoints;
+	std::cout << QString("SeansVesselReg %1: total %2ms, closest points in best LTS path %3ms over %4 iterations")
+				 .arg(parallel ? "parallel" : "serial")
+				 .arg(elapsed)
+				 .arg(closestPoints)
+				 .arg(timings.size()) << std::endl;
+	return elapsed;
+}
+} // namespace
+
+TEST_CASE("Speed: SeansVesselReg parallel compared to serial", "[speed][integration][modules][registration][not_win32]")
+{
+	cx::LogicManager::initialize();
+	cx::FileManagerServicePtr filemanager = cx::FileManagerServiceProxy::create(cx::logicManager()->getPluginContext());
+
+	QString fname1 = cx::DataLocations::getTestDataPath() + "/testing/Centerline/US_aneurism_cl_size1.vtk";
+	QString fname2 = cx::DataLocations::getTestDataPath() + "/testing/Centerline/US_aneurism_cl_size2.vtk";
+
+	{
+		cxtest::PatientModelServiceMock pasm;
+		QString dummy;
+		cx::DataPtr source = pasm.importDataMock(fname1, dummy, filemanager);
+		cx::DataPtr target = pasm.importDataMock(fname2, dummy, filemanager);
+		REQUIRE(source);
+		REQUIRE(target);
+		source->get_rMd_History()->setRegistration(cx::createTransformTranslate(cx::Vector3D(2,2,2)));
+
+		cx::Transform3D serialResult;
+		cx::Transform3D parallelResult;
+		runVesselReg(source, target, false, &serialResult);
+		runVesselReg(source, target, true, &parallelResult);
+
+		CHECK(cx::similar(serialResult, parallelResult, 1.0E-6));
+	}
+
+	cx::LogicManager::shutdown();
+}
@@ -0,0 +1,456 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxPNNBrickEngine.h"
+
+#include <cstring>
+#include <numeric>
+#include <QThread>
+#include <QAtomicInt>
+#include <QtConcurrentRun>
+#include <vtkImageData.h>
+#include "cxLogger.h"
+#include "cxTypeConversions.h"
+#include "cxVolumeHelpers.h"
+#include "cxTimeKeeper.h"
+
+namespace cx
+{
+
+namespace
+{
+/** Max number of binned pixels held in memory at once.
+ *  Records are binned and splatted in batches below this limit.
+ */
+const int gMaxBinnedPixels = 32*1024*1024;
+
+inline int getIndex(int x, int y, int z, const Eigen::Array3i& dim)
+{
+	return x + y*dim[0] + z*dim[0]*dim[1];
+}
+
+/** Same as maskAlongDim() in PNNReconstructionMethodService, but for one
+ *  value of the outer index a only. Lines with different a are disjoint,
+ *  thus different a can be processed in parallel.
+ */
+template <class FUNCTION>
+void maskLinesAlongDim(int a, int b_dim, int c_dim, const Eigen::Array3i& dim, unsigned char *inputPtr, unsigned char *maskPtr, FUNCTION getIndex)
+{
+	for (int b = 0; b < b_dim; b++)
+	{
+		int start = c_dim;
+		int stop = -1;
+		for (int c = 0; c < c_dim; c++)
+		{
+			if (inputPtr[getIndex(a, b, c, dim)]>0)
+			{
+				start = c;
+				break;
+			}
+		}
+		for (int c = c_dim-1; c >=0; c--)
+		{
+			if (inputPtr[getIndex(a, b, c, dim)]>0)
+			{
+				stop = c;
+				break;
+			}
+		}
+		for (int c = start; c <= stop; c++)
+			maskPtr[getIndex(a, b, c, dim)] = 1;
+	}
+}
+
+inline int getIndex_z_last(int x, int y, int z, const Eigen::Array3i& dim) { return getIndex(x, y, z, dim); }
+inline int getIndex_x_last(int y, int z, int x, const Eigen::Array3i& dim) { return getIndex(x, y, z, dim); }
+inline int getIndex_y_last(int z, int x, int y, const Eigen::Array3i& dim) { return getIndex(x, y, z, dim); }
+
+/** As QtConcurrent::blockingMap(), but on the given pool instead of the global one.
+ *  One task per pool thread is started, each taking indices in order until none are left.
+ */
+template <class FUNCTION>
+void blockingMap(QThreadPool* pool, const std::vector<int>& indices, FUNCTION function)
+{
+	QAtomicInt next(0);
+	int tasks = std::min<int>(pool->maxThreadCount(), indices.size());
+	std::vector<QFuture<void> > futures;
+	for (int t = 0; t < tasks; ++t)
+	{
+		futures.push_back(QtConcurrent::run(pool, [&]()
+		{
+			for (int i = next.fetchAndAddOrdered(1); i < int(indices.size()); i = next.fetchAndAddOrdered(1))
+				function(indices[i]);
+		}));
+	}
+	for (unsigned t = 0; t < futures.size(); ++t)
+		futures[t].waitForFinished();
+}
+
+std::vector<int> range(int count)
+{
+	std::vector<int> retval(count);
+	for (int i=0; i<count; ++i)
+		retval[i] = i;
+	return retval;
+}
+
+} // unnamed namespace
+
+QString PNNPhaseTimings::toString() const
+{
+	return QString("bin %1ms, splat %2ms, mask %3ms, fill %4ms, total %5ms")
+			.arg(binning)
+			.arg(splatting)
+			.arg(masking)
+			.arg(holeFilling)
+			.arg(this->total());
+}
+
+PNNBrickEngine::PNNBrickEngine() :
+	mBrickSize(32),
+	mInterpolationSteps(3),
+	mBrickCount(0,0,0),
+	mDims(0,0,0),
+	mSpacing(1,1,1),
+	mInsertedRecords(0)
+{
+	this->setThreadCount(0);
+}
+
+void PNNBrickEngine::setBrickSize(int voxels)
+{
+	mBrickSize = std::max(voxels, 4);
+}
+
+void PNNBrickEngine::setInterpolationSteps(int steps)
+{
+	mInterpolationSteps = std::max(steps, 0);
+}
+
+void PNNBrickEngine::setThreadCount(int count)
+{
+	if (count <= 0)
+		count = std::max(QThread::idealThreadCount(), 1);
+	mThreadPool.setMaxThreadCount(count);
+}
+
+int PNNBrickEngine::getThreadCount() const
+{
+	return mThreadPool.maxThreadCount();
+}
+
+void PNNBrickEngine::createBricks(const Eigen::Array3i& dims)
+{
+	mBricks.clear();
+	for (int i=0; i<3; ++i)
+		mBrickCount[i] = (dims[i] + mBrickSize - 1) / mBrickSize;
+
+	for (int z=0; z<mBrickCount[2]; ++z)
+		for (int y=0; y<mBrickCount[1]; ++y)
+			for (int x=0; x<mBrickCount[0]; ++x)
+			{
+				Brick brick;
+				brick.start = Eigen::Array3i(x, y, z) * mBrickSize;
+				brick.stop = (brick.start + mBrickSize).min(dims);
+				mBricks.push_back(brick);
+			}
+}
+
+int PNNBrickEngine::getBrickIndex(int x, int y, int z) const
+{
+	return x/mBrickSize + (y/mBrickSize)*mBrickCount[0] + (z/mBrickSize)*mBrickCount[0]*mBrickCount[1];
+}
+
+bool PNNBrickEngine::reconstruct(ProcessedUSInputDataPtr input, vtkImageDataPtr output)
+{
+	this->begin(output);
+	if (!this->insert(input))
+	{
+		mTemp = vtkImageDataPtr();
+		mOutput = vtkImageDataPtr();
+		return false;
+	}
+	return this->finish();
+}
+
+void PNNBrickEngine::begin(vtkImageDataPtr output)
+{
+	mTimings = PNNPhaseTimings();
+	mInsertedRecords = 0;
+	mOutput = output;
+	mDims = Eigen::Array3i(output->GetDimensions());
+	mSpacing = Vector3D(output->GetSpacing());
+	mTemp = generateVtkImageData(mDims, mSpacing, 0);
+	this->createBricks(mDims);
+}
+
+bool PNNBrickEngine::insert(ProcessedUSInputDataPtr input)
+{
+	if (!mTemp)
+		return false;
+	input->validate();
+
+	if (input->getFrames().empty())
+		return false;
+	if (input->getDimensions()[2]==0)
+		return false;
+
+	this->binAndSplat(input, static_cast<unsigned char*>(mTemp->GetScalarPointer()), mDims, mSpacing);
+	mInsertedRecords += input->getDimensions()[2];
+	return true;
+}
+
+bool PNNBrickEngine::finish()
+{
+	vtkImageDataPtr temp = mTemp;
+	vtkImageDataPtr output = mOutput;
+	Eigen::Array3i dims = mDims;
+	mTemp = vtkImageDataPtr();
+	mOutput = vtkImageDataPtr();
+
+	if (!temp || (mInsertedRecords==0))
+		return false;
+
+	TimeKeeper timer;
+	vtkImageDataPtr mask = this->createMask(temp);
+	mTimings.masking = timer.getElapsedms();
+
+	timer.reset();
+	unsigned char *inputPointer = static_cast<unsigned char*> (temp->GetScalarPointer());
+	unsigned char *outputPointer = static_cast<unsigned char*> (output->GetScalarPointer());
+	unsigned char *maskPointer = static_cast<unsigned char*> (mask->GetScalarPointer());
+	std::vector<int> removed(mBricks.size(), 0);
+	std::vector<int> ignored(mBricks.size(), 0);
+	std::vector<int> brickIndices = range(mBricks.size());
+	blockingMap(&mThreadPool, brickIndices, [&](int i)
+	{
+		this->fillBrick(mBricks[i], inputPointer, maskPointer, outputPointer, dims, &removed[i], &ignored[i]);
+	});
+	mTimings.holeFilling = timer.getElapsedms();
+
+	double total = double(dims[0]) * dims[1] * dims[2];
+	double totalRemoved = std::accumulate(removed.begin(), removed.end(), 0.0);
+	double totalIgnored = std::accumulate(ignored.begin(), ignored.end(), 0.0);
+	reportDebug(
+				QString("PNN: Size: %1Mb, Valid voxels: %2\%, Outside mask: %3\%  Filled holes [steps=%4]: %5\%, bricks=%6, threads=%7")
+				.arg(int(total/1024/1024))
+				.arg(int(100*totalIgnored/total))
+				.arg(int(100*totalRemoved/total))
+				.arg(mInterpolationSteps)
+				.arg(int(100*(total-totalIgnored-totalRemoved)/total))
+				.arg(mBricks.size())
+				.arg(this->getThreadCount()));
+	reportDebug("PNN phase timings: " + mTimings.toString());
+
+	return true;
+}
+
+/** Transform all input pixels into the volume.
+ *
+ * Records are processed in batches to bound the memory used by the bins.
+ * Inside a batch, each worker bins a consecutive range of records, and
+ * each brick is splatted by emptying the worker bins in worker order.
+ * Thus the pixels are written in the same order as in the serial algorithm.
+ */
+void PNNBrickEngine::binAndSplat(ProcessedUSInputDataPtr input, unsigned char* volume,
+								 const Eigen::Array3i& dims, const Vector3D& outputSpacing)
+{
+	Eigen::Array3i inputDims = input->getDimensions();
+	int records = inputDims[2];
+	int workers = this->getThreadCount();
+	int pixelsPerRecord = std::max(inputDims[0]*inputDims[1], 1);
+	int recordsPerBatch = std::max(gMaxBinnedPixels / pixelsPerRecord, workers);
+
+	mBins.resize(workers);
+	for (unsigned w=0; w<mBins.size(); ++w)
+		mBins[w].resize(mBricks.size());
+
+	std::vector<int> workerIndices = range(workers);
+	std::vector<int> brickIndices = range(mBricks.size());
+
+	TimeKeeper timer;
+	for (int batchStart=0; batchStart<records; batchStart+=recordsPerBatch)
+	{
+		int batchStop = std::min(batchStart+recordsPerBatch, records);
+		int recordsPerWorker = (batchStop - batchStart + workers - 1) / workers;
+
+		timer.reset();
+		blockingMap(&mThreadPool, workerIndices, [&](int w)
+		{
+			int first = std::min(batchStart + w*recordsPerWorker, batchStop);
+			int last = std::min(first + recordsPerWorker, batchStop);
+			this->binRecords(input, first, last, &mBins[w], dims, outputSpacing);
+		});
+		mTimings.binning += timer.getElapsedms();
+
+		timer.reset();
+		blockingMap(&mThreadPool, brickIndices, [&](int b)
+		{
+			for (int w=0; w<workers; ++w)
+			{
+				Bin& bin = mBins[w][b];
+				for (unsigned i=0; i<bin.size(); ++i)
+					volume[bin[i].outputIndex] = bin[i].value;
+				bin.clear();
+			}
+		});
+		mTimings.splatting += timer.getElapsedms();
+	}
+	mBins.clear();
+}
+
+void PNNBrickEngine::binRecords(ProcessedUSInputDataPtr input, int firstRecord, int lastRecord, std::vector<Bin>* bins,
+								const Eigen::Array3i& dims, const Vector3D& outputSpacing)
+{
+	Eigen::Array3i inputDims = input->getDimensions();
+	Vector3D inputSpacing = input->getSpacing();
+	std::vector<TimedPosition> frameInfo = input->getFrames();
+	unsigned char* maskPointer = static_cast<unsigned char*> (input->getMask()->GetScalarPointer());
+
+	for (int record = firstRecord; record < lastRecord; record++)
+	{
+		unsigned char *inputPointer = input->getFrame(record);
+		boost::array<double, 16> tt = frameInfo[record].mPos.flatten();
+		const double* t = tt.begin();
+
+		for (int beam = 0; beam < inputDims[0]; beam++)
+		{
+			for (int sample = 0; sample < inputDims[1]; sample++)
+			{
+				int inputIndex = beam + sample * inputDims[0];
+				if (maskPointer[inputIndex] == 0)
+					continue;
+
+				// identical arithmetic to optimizedCoordTransform() in the serial algorithm
+				double x = beam * inputSpacing[0];
+				double y = sample * inputSpacing[1];
+				double z = 0.0;
+				double px = t[0] * x + t[1] * y + t[2] * z + t[3];
+				double py = t[4] * x + t[5] * y + t[6] * z + t[7];
+				double pz = t[8] * x + t[9] * y + t[10] * z + t[11];
+				int outputVoxelX = static_cast<int> ((px / outputSpacing[0]) + 0.5);
+				int outputVoxelY = static_cast<int> ((py / outputSpacing[1]) + 0.5);
+				int outputVoxelZ = static_cast<int> ((pz / outputSpacing[2]) + 0.5);
+
+				if ((outputVoxelX < 0) || (outputVoxelX >= dims[0])
+						|| (outputVoxelY < 0) || (outputVoxelY >= dims[1])
+						|| (outputVoxelZ < 0) || (outputVoxelZ >= dims[2]))
+					continue;
+
+				BinnedPixel pixel;
+				pixel.outputIndex = getIndex(outputVoxelX, outputVoxelY, outputVoxelZ, dims);
+				// set minimum intensity value to 1. This separates "zero intensity" from "no intensity".
+				pixel.value = std::max<unsigned char>(inputPointer[inputIndex], 1);
+				(*bins)[this->getBrickIndex(outputVoxelX, outputVoxelY, outputVoxelZ)].push_back(pixel);
+			}
+		}
+	}
+}
+
+vtkImageDataPtr PNNBrickEngine::createMask(vtkImageDataPtr inputData)
+{
+	Eigen::Array3i dim(inputData->GetDimensions());
+	Vector3D spacing(inputData->GetSpacing());
+	vtkImageDataPtr mask = generateVtkImageData(dim, spacing, 0);
+	unsigned char *inputPtr = static_cast<unsigned char*> (inputData->GetScalarPointer());
+	unsigned char *maskPtr = static_cast<unsigned char*> (mask->GetScalarPointer());
+
+	// mask along all 3 dimensions, one pass at a time as the passes overlap
+	std::vector<int> z = range(dim[0]);
+	blockingMap(&mThreadPool, z, [&](int a) { maskLinesAlongDim(a, dim[1], dim[2], dim, inputPtr, maskPtr, &getIndex_z_last); });
+	std::vector<int> x = range(dim[1]);
+	blockingMap(&mThreadPool, x, [&](int a) { maskLinesAlongDim(a, dim[2], dim[0], dim, inputPtr, maskPtr, &getIndex_x_last); });
+	std::vector<int> y = range(dim[2]);
+	blockingMap(&mThreadPool, y, [&](int a) { maskLinesAlongDim(a, dim[0], dim[1], dim, inputPtr, maskPtr, &getIndex_y_last); });
+
+	return mask;
+}
+
+/** Fill the holes inside one brick.
+ *
+ * The brick plus a halo of interpolationSteps voxels, clipped to the volume,
+ * is copied into a local buffer. A neighbour inside the volume is always inside
+ * the buffer, so the buffer bounds replace the volume bounds in the search.
+ */
+void PNNBrickEngine::fillBrick(const Brick& brick, unsigned char* inputPointer, unsigned char* maskPointer,
+							   unsigned char* outputPointer, const Eigen::Array3i& dims, int* removed, int* ignored)
+{
+	int halo = mInterpolationSteps;
+	Eigen::Array3i lo = (brick.start - halo).max(Eigen::Array3i::Zero());
+	Eigen::Array3i hi = (brick.stop + halo).min(dims);
+	Eigen::Array3i ldim = hi - lo;
+
+	std::vector<unsigned char> local(size_t(ldim[0])*ldim[1]*ldim[2]);
+	for (int z = lo[2]; z < hi[2]; ++z)
+		for (int y = lo[1]; y < hi[1]; ++y)
+			memcpy(&local[getIndex(0, y-lo[1], z-lo[2], ldim)], &inputPointer[getIndex(lo[0], y, z, dims)], ldim[0]);
+
+	for (int z = brick.start[2]; z < brick.stop[2]; ++z)
+	{
+		for (int y = brick.start[1]; y < brick.stop[1]; ++y)
+		{
+			for (int x = brick.start[0]; x < brick.stop[0]; ++x)
+			{
+				int outputIndex = getIndex(x, y, z, dims);
+
+				// ignore if outside volume of interest
+				if (maskPointer[outputIndex]==0)
+				{
+					++(*removed);
+					continue;
+				}
+				// copy if value already exists
+				if (inputPointer[outputIndex]>0)
+				{
+					outputPointer[outputIndex] = inputPointer[outputIndex];
+					++(*ignored);
+					continue;
+				}
+
+				// fill hole otherwise (empty space within the volume)
+				int lx = x - lo[0];
+				int ly = y - lo[1];
+				int lz = z - lo[2];
+				int localIndex = getIndex(lx, ly, lz, ldim);
+				for (int localArea = 0; localArea <= mInterpolationSteps; ++localArea)
+				{
+					int count = 0;
+					double tempVal = 0;
+					for (int i = -localArea; i < localArea + 1; i++)
+					{
+						for (int j = -localArea; j < localArea + 1; j++)
+						{
+							for (int k = -localArea; k < localArea + 1; k++)
+							{
+								if ((lx+i < 0) || (lx+i >= ldim[0]) || (ly+j < 0) || (ly+j >= ldim[1]) || (lz+k < 0) || (lz+k >= ldim[2]))
+									continue;
+								unsigned char value = local[localIndex + i + j*ldim[0] + k*ldim[0]*ldim[1]];
+								if (value > 0)
+								{
+									tempVal += value;
+									count++;
+								}
+							}
+						}
+					}
+
+					if (count > 0)
+					{
+						outputPointer[outputIndex] = std::max<unsigned char>(1, static_cast<int> ((tempVal / count) + 0.5));
+						break;
+					}
+				}
+			}
+		}
+	}
+}
+
+} // namespace cx
@@ -0,0 +1,125 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXPNNBRICKENGINE_H_
+#define CXPNNBRICKENGINE_H_
+
+#include "org_custusx_usreconstruction_pnn_Export.h"
+#include <vector>
+#include <QThreadPool>
+#include "cxUSFrameData.h"
+#include "cxVector3D.h"
+
+namespace cx
+{
+
+/** Wall-clock time spent in each phase of a PNN reconstruction, in ms.
+ *
+ * \ingroup org_custusx_usreconstruction_pnn
+ */
+struct org_custusx_usreconstruction_pnn_EXPORT PNNPhaseTimings
+{
+	PNNPhaseTimings() : binning(0), splatting(0), masking(0), holeFilling(0) {}
+	double binning; ///< transform input pixels and sort them into bricks
+	double splatting; ///< write binned pixels into the temporary volume
+	double masking; ///< create the hole filling mask
+	double holeFilling; ///< fill holes brick by brick
+	double total() const { return binning + splatting + masking + holeFilling; }
+	QString toString() const;
+};
+
+/** Multithreaded implementation of the PNN algorithm.
+ *
+ * The output volume is partitioned into cubic bricks. Input pixels are
+ * transformed in parallel and binned per brick, then each brick is splatted
+ * by exactly one thread, thus no voxel is ever written by two threads.
+ * Bins are filled in frame order and emptied in the same order, giving the
+ * same "last frame wins" result as the serial algorithm.
+ *
+ * Hole filling is done per brick: the brick and a halo of interpolationSteps
+ * voxels around it are copied into a thread-local buffer, and the holes
+ * inside the brick are filled from that buffer.
+ *
+ * The output is bit-identical to PNNReconstructionMethodService run serially.
+ *
+ * All work runs on a private thread pool, thus setThreadCount() limits the
+ * number of threads used without affecting the global pool.
+ *
+ * \ingroup org_custusx_usreconstruction_pnn
+ *
+ * \date 2026-10-18
+ */
+class org_custusx_usreconstruction_pnn_EXPORT PNNBrickEngine
+{
+public:
+	PNNBrickEngine();
+
+	void setBrickSize(int voxels); ///< side length of each brick, in voxels
+	void setInterpolationSteps(int steps);
+	void setThreadCount(int count); ///< max threads used, 0 means QThread::idealThreadCount()
+
+	/** Reconstruct input into output. Output must be an 8-bit volume with the
+	 * target geometry, and is written only inside the hole filling mask.
+	 */
+	bool reconstruct(ProcessedUSInputDataPtr input, vtkImageDataPtr output);
+	PNNPhaseTimings getTimings() const { return mTimings; }
+
+	/** Incremental version of reconstruct(): begin(output), then insert() each
+	 * window of input frames in frame order, then finish(). The result is the same
+	 * as reconstruct() with all frames, but only one window is needed at a time.
+	 */
+	void begin(vtkImageDataPtr output);
+	bool insert(ProcessedUSInputDataPtr input);
+	bool finish();
+
+private:
+	struct Brick
+	{
+		Eigen::Array3i start; ///< first voxel in brick
+		Eigen::Array3i stop; ///< one past the last voxel in brick
+	};
+	struct BinnedPixel
+	{
+		int outputIndex;
+		unsigned char value;
+	};
+	typedef std::vector<BinnedPixel> Bin;
+
+	int getThreadCount() const;
+	void createBricks(const Eigen::Array3i& dims);
+	int getBrickIndex(int x, int y, int z) const;
+
+	void binAndSplat(ProcessedUSInputDataPtr input, unsigned char* volume,
+					 const Eigen::Array3i& dims, const Vector3D& outputSpacing);
+	void binRecords(ProcessedUSInputDataPtr input, int firstRecord, int lastRecord, std::vector<Bin>* bins,
+					const Eigen::Array3i& dims, const Vector3D& outputSpacing);
+	vtkImageDataPtr createMask(vtkImageDataPtr input);
+	void fillBrick(const Brick& brick, unsigned char* inputPointer, unsigned char* maskPointer,
+				   unsigned char* outputPointer, const Eigen::Array3i& dims, int* removed, int* ignored);
+
+	int mBrickSize;
+	int mInterpolationSteps;
+	QThreadPool mThreadPool;
+	Eigen::Array3i mBrickCount;
+	std::vector<Brick> mBricks;
+	std::vector<std::vector<Bin> > mBins; ///< one set of bins per worker, each with one bin per brick
+	PNNPhaseTimings mTimings;
+
+	vtkImageDataPtr mOutput;
+	vtkImageDataPtr mTemp; ///< splatted pixels, before hole filling
+	Eigen::Array3i mDims;
+	Vector3D mSpacing;
+	int mInsertedRecords;
+};
+
+} // namespace cx
+
+#endif // CXPNNBRICKENGINE_H_
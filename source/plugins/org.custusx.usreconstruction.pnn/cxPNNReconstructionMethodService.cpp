@@ -20,6 +20,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <vtkImageData.h>
 #include "cxImage.h"
 #include "cxDoubleProperty.h"
+#include "cxBoolProperty.h"
+#include "cxPNNBrickEngine.h"
 
 namespace cx
 {
@@ -39,6 +41,8 @@ std::vector<PropertyPtr> PNNReconstructionMethodService::getSettings(QDomElement
 {
 	std::vector<PropertyPtr> retval;
 	retval.push_back(this->getInterpolationStepsOption(root));
+	retval.push_back(this->getMultithreadedOption(root));
+	retval.push_back(this->getBrickSizeOption(root));
 	return retval;
 }
 
@@ -50,6 +54,58 @@ DoublePropertyPtr PNNReconstructionMethodService::getInterpolationStepsOption(QD
 	return retval;
 }
 
+BoolPropertyPtr PNNReconstructionMethodService::getMultithreadedOption(QDomElement root)
+{
+	return BoolProperty::initialize("multithreaded", "Multithreaded",
+		"Run the reconstruction on all cores, on bricks of the output volume.\n"
+		"Gives the same result as the single threaded version.", true, root);
+}
+
+DoublePropertyPtr PNNReconstructionMethodService::getBrickSizeOption(QDomElement root)
+{
+	return DoubleProperty::initialize("brickSize", "Brick size (voxels)",
+		"Side length of the bricks the output volume is split into\n"
+		"when running multithreaded", 32, DoubleRange(8, 128, 8), 0, root);
+}
+
+namespace
+{
+/** Streamed PNN reconstruction, using the incremental interface of PNNBrickEngine.
+ */
+class PNNReconstructionStream : public ReconstructionStream
+{
+public:
+	PNNReconstructionStream(vtkImageDataPtr outputData, int interpolationSteps, int brickSize) :
+		mOutputData(outputData)
+	{
+		mEngine.setInterpolationSteps(interpolationSteps);
+		mEngine.setBrickSize(brickSize);
+		mEngine.begin(outputData);
+	}
+	virtual bool insert(ProcessedUSInputDataPtr window)
+	{
+		return mEngine.insert(window);
+	}
+	virtual bool finish()
+	{
+		if (!mEngine.finish())
+			return false;
+		setDeepModified(mOutputData);
+		return true;
+	}
+private:
+	PNNBrickEngine mEngine;
+	vtkImageDataPtr mOutputData;
+};
+} // unnamed namespace
+
+ReconstructionStreamPtr PNNReconstructionMethodService::createStream(vtkImageDataPtr outputData, QDomElement settings)
+{
+	int interpolationSteps = static_cast<int>(this->getInterpolationStepsOption(settings)->getValue());
+	int brickSize = static_cast<int>(this->getBrickSizeOption(settings)->getValue());
+	return ReconstructionStreamPtr(new PNNReconstructionStream(outputData, interpolationSteps, brickSize));
+}
+
 void optimizedCoordTransform(Vector3D* p, boost::array<double, 16> tt)
 {
 	double* t = tt.begin();
@@ -64,6 +120,9 @@ void optimizedCoordTransform(Vector3D* p, boost::array<double, 16> tt)
 bool PNNReconstructionMethodService::reconstruct(ProcessedUSInputDataPtr input,
 		vtkImageDataPtr outputData, QDomElement settings)
 {
+	if (this->getMultithreadedOption(settings)->getValue())
+		return this->reconstructMultithreaded(input, outputData, settings);
+
 	input->validate();
 
 	std::vector<TimedPosition> frameInfo = input->getFrames();
@@ -139,6 +198,19 @@ bool PNNReconstructionMethodService::reconstruct(ProcessedUSInputDataPtr input,
 	return true;
 }
 
+bool PNNReconstructionMethodService::reconstructMultithreaded(ProcessedUSInputDataPtr input,
+		vtkImageDataPtr outputData, QDomElement settings)
+{
+	PNNBrickEngine engine;
+	engine.setInterpolationSteps(static_cast<int>(this->getInterpolationStepsOption(settings)->getValue()));
+	engine.setBrickSize(static_cast<int>(this->getBrickSizeOption(settings)->getValue()));
+	if (!engine.reconstruct(input, outputData))
+		return false;
+
+	setDeepModified(outputData);
+	return true;
+}
+
 namespace
 {
 /**Used in createMask()
@@ -42,10 +42,16 @@ public:
 
 	virtual std::vector<PropertyPtr> getSettings(QDomElement root);
 	virtual bool reconstruct(ProcessedUSInputDataPtr input, vtkImageDataPtr outputData, QDomElement settings);
+	virtual ReconstructionStreamPtr createStream(vtkImageDataPtr outputData, QDomElement settings);
+	virtual bool canStream(QDomElement settings) { return true; }
+	virtual bool isReentrant() const { return true; }
 
 
 private:
 	DoublePropertyPtr getInterpolationStepsOption(QDomElement root);
+	BoolPropertyPtr getMultithreadedOption(QDomElement root);
+	DoublePropertyPtr getBrickSizeOption(QDomElement root);
+	bool reconstructMultithreaded(ProcessedUSInputDataPtr input, vtkImageDataPtr outputData, QDomElement settings);
 	bool validPixel(int x, int y, const Eigen::Array3i& dims, unsigned char* rawPointer)
 	{
 		return (x >= 0) && (x < dims[0]) && (y >= 0) && (y < dims[1]) && (rawPointer[x + y * dims[0]] != 0);
@@ -18,6 +18,10 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxtestUtilities.h"
 #include "cxLogicManager.h"
 #include "cxFileManagerServiceProxy.h"
+#include "cxPNNBrickEngine.h"
+#include "cxVolumeHelpers.h"
+#include <vtkImageData.h>
+#include <cstring>
 
 namespace cxtest
 {
@@ -86,6 +90,114 @@ TEST_CASE("ReconstructAlgorithm: PNN on sphere, tilt","[unit][usreconstruction][
 	cx::LogicManager::shutdown();
 }
 
+TEST_CASE("ReconstructAlgorithm: PNN multithreaded is identical to single threaded","[unit][usreconstruction][synthetic][pnn]")
+{
+	cx::LogicManager::initialize();
+	ctkPluginContext* pluginContext = cx::logicManager()->getPluginContext();
+
+	SyntheticReconstructInputPtr generator(new SyntheticReconstructInput);
+	generator->defineProbeMovementSteps(40);
+	generator->defineProbeMovementNormalizedTranslationRange(0.8);
+	generator->defineProbeMovementAngleRange(M_PI/6);
+	generator->defineProbe(cx::DummyToolTestUtilities::createProbeDefinitionLinear(100, 100, Eigen::Array2i(150,150)));
+	generator->setOverallBoundsAndSpacing(100, 2);
+	generator->setSpherePhantom();
+
+	cx::ProcessedUSInputDataPtr input = generator->generateSynthetic_ProcessedUSInputData(cx::Transform3D::Identity());
+	Eigen::Array3i dim(51, 51, 51);
+	cx::Vector3D spacing(2, 2, 2);
+
+	cx::PNNReconstructionMethodService algorithm(pluginContext);
+	QDomDocument domdoc;
+	QDomElement serialSettings = domdoc.createElement("pnn");
+	std::vector<cx::PropertyPtr> properties = algorithm.getSettings(serialSettings);
+	for (unsigned i=0; i<properties.size(); ++i)
+		if (properties[i]->getUid()=="multithreaded")
+			properties[i]->setValueFromVariant(false);
+
+	vtkImageDataPtr serial = cx::generateVtkImageData(dim, spacing, 0);
+	REQUIRE(algorithm.reconstruct(input, serial, serialSettings));
+
+	// use small bricks and a few threads in order to exercise brick borders and halos
+	cx::PNNBrickEngine engine;
+	engine.setBrickSize(8);
+	engine.setThreadCount(3);
+	vtkImageDataPtr parallel = cx::generateVtkImageData(dim, spacing, 0);
+	REQUIRE(engine.reconstruct(input, parallel));
+
+	unsigned char* serialPtr = static_cast<unsigned char*>(serial->GetScalarPointer());
+	unsigned char* parallelPtr = static_cast<unsigned char*>(parallel->GetScalarPointer());
+	int size = dim[0]*dim[1]*dim[2];
+	int differences = 0;
+	for (int i=0; i<size; ++i)
+		if (serialPtr[i]!=parallelPtr[i])
+			++differences;
+	CHECK(differences == 0);
+
+	cx::PNNPhaseTimings timings = engine.getTimings();
+	CHECK(timings.total() >= 0);
+
+	cx::LogicManager::shutdown();
+}
+
+TEST_CASE("ReconstructAlgorithm: PNN streamed in windows is identical to PNN on all frames","[unit][usreconstruction][synthetic][pnn]")
+{
+	cx::LogicManager::initialize();
+
+	SyntheticReconstructInputPtr generator(new SyntheticReconstructInput);
+	generator->defineProbeMovementSteps(40);
+	generator->defineProbeMovementNormalizedTranslationRange(0.8);
+	generator->defineProbeMovementAngleRange(M_PI/6);
+	generator->defineProbe(cx::DummyToolTestUtilities::createProbeDefinitionLinear(100, 100, Eigen::Array2i(150,150)));
+	generator->setOverallBoundsAndSpacing(100, 2);
+	generator->setSpherePhantom();
+
+	cx::ProcessedUSInputDataPtr input = generator->generateSynthetic_ProcessedUSInputData(cx::Transform3D::Identity());
+	Eigen::Array3i dim(51, 51, 51);
+	cx::Vector3D spacing(2, 2, 2);
+
+	cx::PNNBrickEngine engine;
+	engine.setBrickSize(8);
+	vtkImageDataPtr whole = cx::generateVtkImageData(dim, spacing, 0);
+	REQUIRE(engine.reconstruct(input, whole));
+
+	// split the input into windows of 7 frames, copying each frame
+	Eigen::Array3i inputDims = input->getDimensions();
+	std::vector<cx::TimedPosition> positions = input->getFrames();
+	std::vector<cx::ProcessedUSInputDataPtr> windows;
+	for (int first=0; first<inputDims[2]; first+=7)
+	{
+		int last = std::min(first+7, inputDims[2]);
+		std::vector<vtkImageDataPtr> frames;
+		for (int i=first; i<last; ++i)
+		{
+			vtkImageDataPtr frame = cx::generateVtkImageData(Eigen::Array3i(inputDims[0], inputDims[1], 1), input->getSpacing(), 0);
+			memcpy(frame->GetScalarPointer(), input->getFrame(i), inputDims[0]*inputDims[1]);
+			frames.push_back(frame);
+		}
+		std::vector<cx::TimedPosition> windowPositions(positions.begin()+first, positions.begin()+last);
+		windows.push_back(cx::ProcessedUSInputDataPtr(new cx::ProcessedUSInputData(frames, windowPositions, input->getMask(), "", "")));
+	}
+	REQUIRE(windows.size() > 1);
+
+	vtkImageDataPtr streamed = cx::generateVtkImageData(dim, spacing, 0);
+	engine.begin(streamed);
+	for (unsigned i=0; i<windows.size(); ++i)
+		REQUIRE(engine.insert(windows[i]));
+	REQUIRE(engine.finish());
+
+	unsigned char* wholePtr = static_cast<unsigned char*>(whole->GetScalarPointer());
+	unsigned char* streamedPtr = static_cast<unsigned char*>(streamed->GetScalarPointer());
+	int size = dim[0]*dim[1]*dim[2];
+	int differences = 0;
+	for (int i=0; i<size; ++i)
+		if (wholePtr[i]!=streamedPtr[i])
+			++differences;
+	CHECK(differences == 0);
+
+	cx::LogicManager::shutdown();
+}
+
 } // namespace cxtest
 
 
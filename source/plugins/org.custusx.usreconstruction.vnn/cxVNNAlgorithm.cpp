@@ -0,0 +1,569 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxVNNAlgorithm.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <QtConcurrentMap>
+#include <vtkImageData.h>
+#include "cxLogger.h"
+#include "cxTimeKeeper.h"
+#include "cxVolumeHelpers.h"
+
+namespace cx
+{
+
+namespace
+{
+/** Side length of the cubes the output volume is split into, same as CUBE_SIZE in kernels.cl.h */
+const int gCubeSize = 4;
+
+inline int roundInt(float value)
+{
+	// same rounding as round_int() in kernels.cl
+	return static_cast<int>(value + 0.5f);
+}
+
+inline float gaussWeight(float dist, float sigma)
+{
+	const float sqrt2pi = 2.506628275f;
+	return (1.0f/(sigma*sqrt2pi)) * exp(-(dist*dist)/(2*sigma*sigma));
+}
+} // unnamed namespace
+
+/** The close planes found for one voxel, as a max-heap on abs(distance).
+ *  Holds at most maxPlanes planes: When full, a closer plane replaces the
+ *  plane farthest away.
+ *  One heap is used per thread.
+ */
+class VNNAlgorithm::ClosePlaneHeap
+{
+public:
+	struct ClosePlane
+	{
+		float dist;
+		int planeId;
+		unsigned char intensity;
+	};
+
+	explicit ClosePlaneHeap(int capacity) : mCapacity(std::max(capacity, 1))
+	{
+		mPlanes.reserve(mCapacity);
+	}
+	void clear()
+	{
+		mPlanes.clear();
+	}
+	/** Distance to the plane that will be replaced by the next insertion,
+	 *  infinite if the heap is not yet full.
+	 */
+	float getMaxDistance() const
+	{
+		if (static_cast<int>(mPlanes.size()) < mCapacity)
+			return std::numeric_limits<float>::infinity();
+		return fabs(mPlanes.front().dist);
+	}
+	void insert(float dist, int planeId)
+	{
+		ClosePlane plane;
+		plane.dist = dist;
+		plane.planeId = planeId;
+		plane.intensity = 0;
+
+		if (static_cast<int>(mPlanes.size()) >= mCapacity)
+		{
+			std::pop_heap(mPlanes.begin(), mPlanes.end(), &ClosePlaneHeap::isCloser);
+			mPlanes.pop_back();
+		}
+		mPlanes.push_back(plane);
+		std::push_heap(mPlanes.begin(), mPlanes.end(), &ClosePlaneHeap::isCloser);
+	}
+	std::vector<ClosePlane>& getPlanes()
+	{
+		return mPlanes;
+	}
+
+private:
+	static bool isCloser(const ClosePlane& a, const ClosePlane& b)
+	{
+		return fabs(a.dist) < fabs(b.dist);
+	}
+	int mCapacity;
+	std::vector<ClosePlane> mPlanes;
+};
+
+VNNParameters::VNNParameters() :
+	method(mDW),
+	planeMethod(pHEURISTIC),
+	maxPlanes(10),
+	nStarts(16),
+	radius(3),
+	newnessWeight(0),
+	brightnessWeight(1)
+{
+}
+
+VNNAlgorithm::VNNAlgorithm() :
+	mMaxStarts(1),
+	mMask(NULL),
+	mOutput(NULL),
+	mExecutionTime(0)
+{
+}
+
+bool VNNAlgorithm::reconstruct(ProcessedUSInputDataPtr input, vtkImageDataPtr outputData)
+{
+	TimeKeeper timer;
+	mExecutionTime = 0;
+
+	Eigen::Array3i inputDims = input->getDimensions();
+	if (inputDims[2] < 2 || static_cast<int>(input->getFrames().size()) != inputDims[2])
+	{
+		reportError(QString("VNN: Need at least 2 frames with positions, got %1").arg(inputDims[2]));
+		return false;
+	}
+	if (outputData->GetScalarType() != VTK_UNSIGNED_CHAR)
+	{
+		reportError("VNN: Output volume must be unsigned char");
+		return false;
+	}
+
+	this->initializePlanes(input);
+	mFrames.resize(inputDims[2]);
+	for (int i=0; i<inputDims[2]; ++i)
+		mFrames[i] = input->getFrame(i);
+	mMask = static_cast<unsigned char*>(input->getMask()->GetScalarPointer());
+	mInputDims = Eigen::Array2i(inputDims[0], inputDims[1]);
+	mInputSpacing = Eigen::Array2f(input->getSpacing()[0], input->getSpacing()[1]);
+
+	mOutput = static_cast<unsigned char*>(outputData->GetScalarPointer());
+	mOutputDims = Eigen::Array3i(outputData->GetDimensions());
+	mOutputSpacing = Eigen::Array3f(outputData->GetSpacing()[0], outputData->GetSpacing()[1], outputData->GetSpacing()[2]);
+	for (int i=0; i<3; ++i)
+		mCubeCount[i] = (mOutputDims[i] + gCubeSize - 1) / gCubeSize;
+
+	// PLANE_CLOSEST in the kernel uses a single start, scanning all planes.
+	mMaxStarts = (mParameters.planeMethod == VNNParameters::pCLOSEST) ? 1 : std::max(mParameters.nStarts, 1);
+
+	std::vector<std::pair<int,int> > rows;
+	for (int z=0; z<mCubeCount[2]; ++z)
+		for (int y=0; y<mCubeCount[1]; ++y)
+			rows.push_back(std::make_pair(y, z));
+	QtConcurrent::blockingMap(rows, [this](const std::pair<int,int>& row)
+	{
+		this->reconstructCubeRow(row.first, row.second);
+	});
+
+	setDeepModified(outputData);
+	mExecutionTime = timer.getElapsedms()/1000.0;
+	report(QString("VNN: Reconstructed %1 planes into %2x%3x%4 voxels in %5s")
+		   .arg(inputDims[2])
+		   .arg(mOutputDims[0]).arg(mOutputDims[1]).arg(mOutputDims[2])
+		   .arg(timer.getElapsedSecondsAsString()));
+	return true;
+}
+
+void VNNAlgorithm::initializePlanes(ProcessedUSInputDataPtr input)
+{
+	std::vector<TimedPosition> frames = input->getFrames();
+	int n = frames.size();
+	mPlanes.resize(n);
+	mNx.resize(n);
+	mNy.resize(n);
+	mNz.resize(n);
+	mW.resize(n);
+
+	for (int i=0; i<n; ++i)
+	{
+		Transform3D pos = frames[i].mPos;
+		Plane& plane = mPlanes[i];
+		plane.e0 = pos.matrix().block<3,1>(0,0).cast<float>();
+		plane.e1 = pos.matrix().block<3,1>(0,1).cast<float>();
+		plane.normal = pos.matrix().block<3,1>(0,2).cast<float>();
+		plane.origin = pos.matrix().block<3,1>(0,3).cast<float>();
+
+		mNx[i] = plane.normal[0];
+		mNy[i] = plane.normal[1];
+		mNz[i] = plane.normal[2];
+		mW[i] = -plane.normal.dot(plane.origin);
+	}
+}
+
+/** Reconstruct all cubes with the given y and z cube index.
+ *  Within a cube, the voxels are visited such that each voxel is
+ *  a neighbour of the previous, letting the search start guesses
+ *  be reused from voxel to voxel.
+ */
+void VNNAlgorithm::reconstructCubeRow(int cubeY, int cubeZ)
+{
+	ClosePlaneHeap heap(mParameters.maxPlanes);
+	std::vector<int> guesses(mMaxStarts);
+
+	for (int cubeX=0; cubeX<mCubeCount[0]; ++cubeX)
+	{
+		Eigen::Array3i origin = Eigen::Array3i(cubeX, cubeY, cubeZ) * gCubeSize;
+		Eigen::Vector3f voxel = (origin.cast<float>() * mOutputSpacing).matrix();
+		int nGuesses = this->findLocalMinimas(&guesses[0], voxel);
+
+		for (int xoffset = 0; xoffset < gCubeSize; xoffset++)
+		{
+			int x = origin[0] + xoffset;
+			if (x >= mOutputDims[0])
+				break;
+
+			int ystart = (xoffset % 2) ? gCubeSize-1 : 0;
+			int yend = (xoffset % 2) ? -1 : gCubeSize;
+			int ydir = (xoffset % 2) ? -1 : 1;
+			for (int yoffset = ystart; yoffset != yend; yoffset += ydir)
+			{
+				int y = origin[1] + yoffset;
+				if (y >= mOutputDims[1])
+					continue;
+
+				bool reverseZ = (yoffset % 2) && (xoffset % 2);
+				int zstart = reverseZ ? gCubeSize-1 : 0;
+				int zend = reverseZ ? -1 : gCubeSize;
+				int zdir = reverseZ ? -1 : 1;
+				for (int zoffset = zstart; zoffset != zend; zoffset += zdir)
+				{
+					int z = origin[2] + zoffset;
+					if (z >= mOutputDims[2])
+						continue;
+
+					voxel = Eigen::Vector3f(x*mOutputSpacing[0], y*mOutputSpacing[1], z*mOutputSpacing[2]);
+					this->findClosePlanesMultistart(&heap, voxel, &guesses[0], nGuesses);
+					mOutput[x + y*mOutputDims[0] + z*mOutputDims[0]*mOutputDims[1]] = this->interpolate(&heap, voxel);
+				}
+			}
+		}
+	}
+}
+
+float VNNAlgorithm::planeDistance(int plane, const Eigen::Vector3f& voxel) const
+{
+	return mNx[plane]*voxel[0] + mNy[plane]*voxel[1] + mNz[plane]*voxel[2] + mW[plane];
+}
+
+/** Project voxel onto plane, and find the (floating point) pixel coordinate.
+ *  Return true if the nearest pixel is inside the image and not masked.
+ */
+bool VNNAlgorithm::getPixel(int plane, const Eigen::Vector3f& voxel, float dist, Eigen::Vector2f* pixel) const
+{
+	const Plane& p = mPlanes[plane];
+	Eigen::Vector3f translated = voxel - dist*p.normal - p.origin;
+	(*pixel)[0] = p.e0.dot(translated) / mInputSpacing[0];
+	(*pixel)[1] = p.e1.dot(translated) / mInputSpacing[1];
+	return this->isValidPixel(roundInt((*pixel)[0]), roundInt((*pixel)[1]));
+}
+
+bool VNNAlgorithm::isValidPixel(int x, int y) const
+{
+	return (x >= 0) && (x < mInputDims[0]) && (y >= 0) && (y < mInputDims[1]) && (mMask[x + y*mInputDims[0]] > 0);
+}
+
+/** Find the start guesses for the close plane search, see findLocalMinimas() in kernels.cl.
+ *
+ *  All planes closer than the cube diagonal plus radius are candidates. Among consecutive
+ *  candidates only the closest is kept, and at most mMaxStarts guesses are returned.
+ */
+int VNNAlgorithm::findLocalMinimas(int* guesses, const Eigen::Vector3f& voxel) const
+{
+	Eigen::Array3f cubeDiagonal = mOutputSpacing * gCubeSize;
+	float maxDist = cubeDiagonal.matrix().norm() + mParameters.radius;
+
+	// distance to all planes, evaluated using SIMD.
+	Eigen::ArrayXf dists = (mNx*voxel[0] + mNy*voxel[1] + mNz*voxel[2] + mW).abs();
+
+	int nMinima = 1;
+	int prevPos = 0;
+	guesses[0] = 0;
+	bool hasHighSinceLastTaken = true;
+	for (int i = 0; i < dists.size(); i++)
+	{
+		float dist = dists[i];
+		if (dist >= maxDist)
+		{
+			hasHighSinceLastTaken = true;
+			continue;
+		}
+
+		if (!hasHighSinceLastTaken)
+		{
+			// We have a previous minima in this valley: keep the closest one.
+			if (dist < dists[guesses[prevPos]])
+				guesses[prevPos] = i;
+		}
+		else if (nMinima < mMaxStarts)
+		{
+			guesses[nMinima] = i;
+			prevPos = nMinima;
+			hasHighSinceLastTaken = false;
+			nMinima++;
+		}
+		else
+		{
+			// Replace the worst minima with this one
+			hasHighSinceLastTaken = false;
+			int biggestIdx = 0;
+			for (int j = 1; j < nMinima; j++)
+				if (dists[guesses[j]] > dists[guesses[biggestIdx]])
+					biggestIdx = j;
+			if (dists[guesses[biggestIdx]] > dist)
+			{
+				guesses[biggestIdx] = i;
+				prevPos = biggestIdx;
+			}
+		}
+	}
+	return nMinima;
+}
+
+/** Find planes within radius of voxel, searching in both directions from guess,
+ *  see findClosestPlanes_heuristic() in kernels.cl.
+ *
+ *  With doTermDistance, the search in one direction stops when a plane farther away
+ *  than the termination distance is found. This assumes the distance increases
+ *  when moving away from the guess, which is not the case if the probe was swept
+ *  back and forth.
+ *
+ *  Return the number of planes inserted into the heap, and the closest plane in smallestIdx.
+ */
+int VNNAlgorithm::findClosePlanesHeuristic(ClosePlaneHeap* heap, const Eigen::Vector3f& voxel, int guess, bool doTermDistance, int* smallestIdx) const
+{
+	int nPlanes = mPlanes.size();
+	float radius = mParameters.radius;
+	float termCondition = std::min(std::max(fabs(this->planeDistance(guess, voxel)), radius), 3*radius);
+	float smallestDist = 99999.9f;
+	float maxDist = std::min(heap->getMaxDistance(), radius);
+	int found = 0;
+	*smallestIdx = guess;
+
+	// the down direction starts at guess-1, thus guess must be >0
+	if (guess == 0)
+		guess = 1;
+
+	bool done[2] = {false, false};
+	Eigen::Vector2f pixel;
+	for (int i = 0; !done[0] || !done[1]; i++)
+	{
+		int idx[2] = { std::min(guess + i, nPlanes-1), std::max(guess - i - 1, 0) };
+
+		for (int dir = 0; dir < 2; ++dir)
+		{
+			float dist = this->planeDistance(idx[dir], voxel);
+			float absDist = fabs(dist);
+
+			if (!done[dir] && absDist < maxDist && this->getPixel(idx[dir], voxel, dist, &pixel))
+			{
+				heap->insert(dist, idx[dir]);
+				found++;
+				maxDist = std::min(heap->getMaxDistance(), radius);
+				if (smallestDist > absDist)
+				{
+					smallestDist = absDist;
+					*smallestIdx = idx[dir];
+				}
+			}
+
+			if (doTermDistance && absDist > termCondition)
+				done[dir] = true;
+		}
+
+		if (idx[0] == nPlanes-1)
+			done[0] = true;
+		if (idx[1] == 0)
+			done[1] = true;
+	}
+
+	return found;
+}
+
+int VNNAlgorithm::findClosePlanesMultistart(ClosePlaneHeap* heap, const Eigen::Vector3f& voxel, int* guesses, int nGuesses) const
+{
+	bool doTermDistance = (mParameters.planeMethod == VNNParameters::pHEURISTIC);
+	heap->clear();
+
+	int found = 0;
+	for (int i = 0; i < nGuesses; i++)
+	{
+		int smallestIdx = 0;
+		int ret = this->findClosePlanesHeuristic(heap, voxel, guesses[i], doTermDistance, &smallestIdx);
+		if (ret > 0)
+			guesses[i] = smallestIdx;
+		found += ret;
+	}
+
+	return std::min(found, mParameters.maxPlanes);
+}
+
+unsigned char VNNAlgorithm::interpolate(ClosePlaneHeap* heap, const Eigen::Vector3f& voxel) const
+{
+	// 1 means "no data", as opposed to 0 meaning "outside"
+	if (heap->getPlanes().empty())
+		return 1;
+
+	switch (mParameters.method)
+	{
+	case VNNParameters::mVNN:
+		return this->interpolateVNN(heap, voxel);
+	case VNNParameters::mVNN2:
+		return this->interpolateDistanceWeighted(heap, voxel, false);
+	case VNNParameters::mDW:
+		return this->interpolateDistanceWeighted(heap, voxel, true);
+	case VNNParameters::mANISOTROPIC:
+		return this->interpolateAnisotropic(heap, voxel);
+	default:
+		return 1;
+	}
+}
+
+/** Voxel Nearest Neighbour: Use the nearest pixel on the closest plane.
+ */
+unsigned char VNNAlgorithm::interpolateVNN(ClosePlaneHeap* heap, const Eigen::Vector3f& voxel) const
+{
+	std::vector<ClosePlaneHeap::ClosePlane>& planes = heap->getPlanes();
+
+	float lowestDist = 10.0f;
+	int closest = 0;
+	for (unsigned i = 0; i < planes.size(); i++)
+	{
+		if (fabs(planes[i].dist) < lowestDist)
+		{
+			lowestDist = fabs(planes[i].dist);
+			closest = i;
+		}
+	}
+
+	int planeId = planes[closest].planeId;
+	Eigen::Vector2f pixel;
+	if (!this->getPixel(planeId, voxel, planes[closest].dist, &pixel))
+		return 1;
+
+	int x = roundInt(pixel[0]);
+	int y = roundInt(pixel[1]);
+	return std::max<unsigned char>(1, mFrames[planeId][x + y*mInputDims[0]]);
+}
+
+/** VNN2 and DW: Inverse distance weighted average of the value from each close plane.
+ *  VNN2 uses the nearest pixel on each plane, DW interpolates bilinearly.
+ */
+unsigned char VNNAlgorithm::interpolateDistanceWeighted(ClosePlaneHeap* heap, const Eigen::Vector3f& voxel, bool bilinear) const
+{
+	std::vector<ClosePlaneHeap::ClosePlane>& planes = heap->getPlanes();
+
+	float scale = 0.0f;
+	float val = 0.0f;
+	Eigen::Vector2f pixel;
+	for (unsigned i = 0; i < planes.size(); i++)
+	{
+		int planeId = planes[i].planeId;
+		if (!this->getPixel(planeId, voxel, planes[i].dist, &pixel))
+			continue;
+
+		float value;
+		if (bilinear)
+			value = this->bilinearInterpolation(mFrames[planeId], pixel);
+		else
+			value = mFrames[planeId][roundInt(pixel[0]) + roundInt(pixel[1])*mInputDims[0]];
+
+		float weight = 1.0f / std::max(fabs(planes[i].dist), 0.001f);
+		scale += weight;
+		val += value * weight;
+	}
+
+	if (scale == 0.0f)
+		return 1;
+	return std::max<unsigned char>(1, static_cast<unsigned char>(val / scale));
+}
+
+/** Anisotropic: Gaussian distance weighting with a sigma adapted to the
+ *  variance of the close pixels, plus extra weight to newer planes and brighter pixels.
+ */
+unsigned char VNNAlgorithm::interpolateAnisotropic(ClosePlaneHeap* heap, const Eigen::Vector3f& voxel) const
+{
+	std::vector<ClosePlaneHeap::ClosePlane>& planes = heap->getPlanes();
+
+	// Move the planes with a valid pixel to the front, the rest are ignored.
+	// The heap order is not needed after the search.
+	int n = 0;
+	Eigen::Vector2f pixel;
+	for (unsigned i = 0; i < planes.size(); i++)
+	{
+		if (!this->getPixel(planes[i].planeId, voxel, planes[i].dist, &pixel))
+			continue;
+		planes[i].intensity = static_cast<unsigned char>(this->bilinearInterpolation(mFrames[planes[i].planeId], pixel));
+		planes[n++] = planes[i];
+	}
+	if (n == 0)
+		return 1;
+
+	float meanValue = 0.0f;
+	int sumIds = 0;
+	for (int i = 0; i < n; i++)
+	{
+		meanValue += planes[i].intensity;
+		sumIds += planes[i].planeId;
+	}
+	float meanId = static_cast<float>(sumIds) / n;
+	meanValue = meanValue / n;
+
+	float variance = 0.0f;
+	for (int i = 0; i < n; i++)
+	{
+		float diff = planes[i].intensity - meanValue;
+		variance += diff*diff;
+	}
+
+	// High variance regions get a sharp weight function, low variance regions a smooth one.
+	variance = (n > 1) ? variance/(n-1) : 1.0f;
+	variance = std::min(std::max(variance, 1.0f), 10000000.0f);
+	float sigma = 32.0f/sqrt(variance);
+
+	float sumWeights = 0.0f;
+	float sum = 0.0f;
+	for (int i = 0; i < n; i++)
+	{
+		float weight = gaussWeight(planes[i].dist, sigma);
+		if (planes[i].planeId >= meanId)
+			weight += mParameters.newnessWeight;
+		if (planes[i].intensity >= meanValue)
+			weight += mParameters.brightnessWeight;
+		sum += planes[i].intensity * weight;
+		sumWeights += weight;
+	}
+
+	if (sumWeights == 0.0f)
+		return 1;
+	return std::max<unsigned char>(1, static_cast<unsigned char>(sum / sumWeights));
+}
+
+float VNNAlgorithm::bilinearInterpolation(const unsigned char* image, const Eigen::Vector2f& pixel) const
+{
+	// valid pixels are rounded, and can be up to half a pixel outside the image: clamp.
+	float px = std::min(std::max(pixel[0], 0.0f), static_cast<float>(mInputDims[0] - 1));
+	float py = std::min(std::max(pixel[1], 0.0f), static_cast<float>(mInputDims[1] - 1));
+	int x0 = static_cast<int>(px);
+	int y0 = static_cast<int>(py);
+	float ox = px - x0;
+	float oy = py - y0;
+	int x1 = std::min(x0 + 1, mInputDims[0] - 1);
+	int y1 = std::min(y0 + 1, mInputDims[1] - 1);
+	int w = mInputDims[0];
+
+	return image[x0 + y0*w] * (1.0f - ox)*(1.0f - oy)
+			+ image[x1 + y0*w] * ox*(1.0f - oy)
+			+ image[x1 + y1*w] * ox*oy
+			+ image[x0 + y1*w] * (1.0f - ox)*oy;
+}
+
+} // namespace cx
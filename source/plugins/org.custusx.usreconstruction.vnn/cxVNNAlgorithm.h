@@ -0,0 +1,118 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXVNNALGORITHM_H_
+#define CXVNNALGORITHM_H_
+
+#include "org_custusx_usreconstruction_vnn_Export.h"
+#include <vector>
+#include <Eigen/Core>
+#include "cxUSFrameData.h"
+
+namespace cx
+{
+
+/** Parameters for VNNAlgorithm. Same meaning as the compile time
+ *  definitions of the OpenCL kernel in org.custusx.usreconstruction.vnncl.
+ *
+ * \ingroup org_custusx_usreconstruction_vnn
+ */
+struct org_custusx_usreconstruction_vnn_EXPORT VNNParameters
+{
+	enum METHOD { mVNN=0, mVNN2=1, mDW=2, mANISOTROPIC=3 };
+	enum PLANE_METHOD { pHEURISTIC=0, pCLOSEST=1 };
+
+	VNNParameters();
+	int method; ///< METHOD
+	int planeMethod; ///< PLANE_METHOD
+	int maxPlanes; ///< max number of close planes used per voxel
+	int nStarts; ///< number of starts in the multistart search for close planes
+	float radius; ///< max distance from voxel to plane, mm
+	float newnessWeight; ///< anisotropic only: extra weight to planes newer than mean
+	float brightnessWeight; ///< anisotropic only: extra weight to pixels brighter than mean
+};
+
+/** Multithreaded CPU implementation of the voxel based reconstruction
+ *  methods VNN, VNN2, DW and Anisotropic.
+ *
+ * This is a port of kernels.cl from org.custusx.usreconstruction.vnncl:
+ * The output volume is split into cubes of 4x4x4 voxels. Each cube gets a set of
+ * start guesses from a scan over all planes, then the close planes of each voxel
+ * are found by searching outwards from the guesses. Cubes are reconstructed in
+ * parallel, each thread owning its own close plane heap.
+ *
+ * The plane equations are stored as structure-of-arrays, so that the scan over
+ * all planes is evaluated with SIMD instructions through Eigen.
+ *
+ * \ingroup org_custusx_usreconstruction_vnn
+ *
+ * \date 2026-10-18
+ */
+class org_custusx_usreconstruction_vnn_EXPORT VNNAlgorithm
+{
+public:
+	VNNAlgorithm();
+	void setParameters(VNNParameters parameters) { mParameters = parameters; }
+	bool reconstruct(ProcessedUSInputDataPtr input, vtkImageDataPtr outputData);
+	double getExecutionTime() const { return mExecutionTime; } ///< seconds spent in last reconstruct()
+
+private:
+	class ClosePlaneHeap;
+	struct Plane
+	{
+		Eigen::Vector3f e0; ///< image x axis
+		Eigen::Vector3f e1; ///< image y axis
+		Eigen::Vector3f normal; ///< image z axis
+		Eigen::Vector3f origin; ///< image origin
+	};
+
+	void initializePlanes(ProcessedUSInputDataPtr input);
+	void reconstructCubeRow(int cubeY, int cubeZ);
+
+	float planeDistance(int plane, const Eigen::Vector3f& voxel) const;
+	bool getPixel(int plane, const Eigen::Vector3f& voxel, float dist, Eigen::Vector2f* pixel) const;
+	bool isValidPixel(int x, int y) const;
+	int findLocalMinimas(int* guesses, const Eigen::Vector3f& voxel) const;
+	int findClosePlanesHeuristic(ClosePlaneHeap* heap, const Eigen::Vector3f& voxel, int guess, bool doTermDistance, int* smallestIdx) const;
+	int findClosePlanesMultistart(ClosePlaneHeap* heap, const Eigen::Vector3f& voxel, int* guesses, int nGuesses) const;
+
+	unsigned char interpolate(ClosePlaneHeap* heap, const Eigen::Vector3f& voxel) const;
+	unsigned char interpolateVNN(ClosePlaneHeap* heap, const Eigen::Vector3f& voxel) const;
+	unsigned char interpolateDistanceWeighted(ClosePlaneHeap* heap, const Eigen::Vector3f& voxel, bool bilinear) const;
+	unsigned char interpolateAnisotropic(ClosePlaneHeap* heap, const Eigen::Vector3f& voxel) const;
+	float bilinearInterpolation(const unsigned char* image, const Eigen::Vector2f& pixel) const;
+
+	VNNParameters mParameters;
+	int mMaxStarts;
+
+	std::vector<Plane> mPlanes;
+	// plane equations as structure-of-arrays: dist = nx*x + ny*y + nz*z + w
+	Eigen::ArrayXf mNx;
+	Eigen::ArrayXf mNy;
+	Eigen::ArrayXf mNz;
+	Eigen::ArrayXf mW;
+
+	std::vector<unsigned char*> mFrames;
+	unsigned char* mMask;
+	Eigen::Array2i mInputDims;
+	Eigen::Array2f mInputSpacing;
+
+	unsigned char* mOutput;
+	Eigen::Array3i mOutputDims;
+	Eigen::Array3f mOutputSpacing;
+	Eigen::Array3i mCubeCount;
+
+	double mExecutionTime;
+};
+
+} // namespace cx
+
+#endif // CXVNNALGORITHM_H_
@@ -0,0 +1,45 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+                 
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+                 
+CustusX is released under a BSD 3-Clause license.
+                 
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxVNNPluginActivator.h"
+
+#include <QtPlugin>
+#include <iostream>
+
+#include "cxVNNReconstructionMethodService.h"
+#include "cxRegisteredService.h"
+
+namespace cx
+{
+
+VNNPluginActivator::VNNPluginActivator()
+{
+}
+
+VNNPluginActivator::~VNNPluginActivator()
+{
+}
+
+void VNNPluginActivator::start(ctkPluginContext* context)
+{
+	mRegistration = RegisteredService::create<VNNReconstructionMethodService>(context, ReconstructionMethodService_iid);
+}
+
+void VNNPluginActivator::stop(ctkPluginContext* context)
+{
+	mRegistration.reset();
+	Q_UNUSED(context);
+}
+
+} // namespace cx
+
+
+
@@ -0,0 +1,157 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+                 
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+                 
+CustusX is released under a BSD 3-Clause license.
+                 
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXVNNRECONSTRUCTIONMETHODSERVICE_H_
+#define CXVNNRECONSTRUCTIONMETHODSERVICE_H_
+
+#include "org_custusx_usreconstruction_vnn_Export.h"
+
+#include "cxReconstructionMethodService.h"
+#include "cxUSFrameData.h"
+#include "cxStringProperty.h"
+#include "cxDoubleProperty.h"
+#include "cxVNNAlgorithm.h"
+#include <QMutex>
+class ctkPluginContext;
+
+
+namespace cx
+{
+
+/**
+ * CPU implementation of the VNN, VNN2, DW and Anisotropic reconstruction methods.
+ *
+ * Same methods and settings as VNNclReconstructionMethodService, but running
+ * multithreaded on the CPU. Use when no OpenCL capable GPU is available.
+ *
+ * \ingroup org_custusx_usreconstruction_vnn
+ *
+ * \date 2026-10-18
+ */
+class org_custusx_usreconstruction_vnn_EXPORT VNNReconstructionMethodService : public ReconstructionMethodService
+{
+	Q_INTERFACES(cx::ReconstructionMethodService)
+public:
+	VNNReconstructionMethodService(ctkPluginContext* context);
+	virtual ~VNNReconstructionMethodService();
+
+    /**
+     * Time spent in the last reconstruction, in seconds
+     */
+    double getExecutionTime();
+
+    /**
+     * Return the name of the algorithm
+     */
+    virtual QString getName() const;
+
+    /**
+	 * Return a set of Properties describing the algorithm settings.
+     * @param root The root element of the settings for this algorithm
+     * @return A vector containing all the settings for this algorithm
+     */
+    virtual std::vector<PropertyPtr> getSettings(QDomElement root);
+
+    /**
+     * Reconstruction entry point.
+     * @param input The processed input US data
+     * @param outputData The volume will be stored here
+     * @param settings The selected algorithms settings
+     */
+    virtual bool reconstruct(ProcessedUSInputDataPtr input,
+                             vtkImageDataPtr outputData,
+                             QDomElement settings);
+
+    /**
+     * Each reconstruction uses its own VNNAlgorithm, thus
+     * several reconstructions can run at the same time.
+     */
+    virtual bool isReentrant() const { return true; }
+
+    /**
+     * Make method option for the UI
+     * @param root The root of the configuration ui
+     * @return List of available methods - with the selected one available by ->getValue()
+     */
+    virtual StringPropertyPtr getMethodOption(QDomElement root);
+
+    /**
+     * Make radius option for the UI
+     * @param root The root of the configuration ui
+     * @return Radius data adapter - with selected value available by ->getValue()
+     */
+    virtual DoublePropertyPtr getRadiusOption(QDomElement root);
+
+
+    /**
+     * Make plane method option for the UI
+     * @param root The root of the configuration ui
+     * @return List of available methods - with the selected one available by ->getValue()
+     */
+    virtual StringPropertyPtr getPlaneMethodOption(QDomElement root);
+
+    /**
+     * Make max planes option for the UI
+     * @param root The root of the configuration ui
+     * @return List of available methods - with the selected one available by ->getValue()
+     */
+    virtual DoublePropertyPtr getMaxPlanesOption(QDomElement root);
+
+    /**
+     * Make number of starts for multistart search option for the UI
+     * @param root The root of the configuration ui
+     * @return Number of multistart search starts option
+     */
+    virtual DoublePropertyPtr getNStartsOption(QDomElement root);
+
+    /**
+     * Make brightness weight(anisotropic method only) option for the UI
+     * @param root The root of the configuration ui
+     * @return Number of multistart search starts option
+     */
+    virtual DoublePropertyPtr getBrightnessWeightOption(QDomElement root);
+
+        /**
+     * Make Newness weight(anisotropic method only) option for the UI
+     * @param root The root of the configuration ui
+     * @return Number of multistart search starts option
+     */
+    virtual DoublePropertyPtr getNewnessWeightOption(QDomElement root);
+
+protected:
+
+    /**
+     * Retrieve the method ID from the settings
+     * @param root The algorithm settings from the UI
+     * @return the method ID, see VNNParameters::METHOD
+     */
+    virtual int getMethodID(QDomElement root);
+
+
+    /**
+     * Retrieve the plane method ID from the settings
+     * @param root The algorithm settings from the UI
+     * @return the plane method ID, see VNNParameters::PLANE_METHOD
+     */
+    virtual int getPlaneMethodID(QDomElement root);
+
+    // Method names. Indices into this array corresponds to method IDs in VNNParameters.
+    std::vector<QString> mMethods;
+    std::vector<QString> mPlaneMethods;
+
+    QMutex mExecutionTimeMutex;
+    double mExecutionTime;
+};
+
+} /* namespace cx */
+
+#endif /* CXVNNRECONSTRUCTIONMETHODSERVICE_H_ */
+
@@ -0,0 +1,5 @@
+set(Require-Plugin org.custusx.usreconstruction)
+set(Plugin-Name "VNN CPU Reconstruction")
+set(Plugin-Version "0.1.0")
+set(Plugin-Vendor "SINTEF")
+set(Plugin-Category "Reconstruction Method")
@@ -0,0 +1,113 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+#include <QDomElement>
+#include "cxVNNReconstructionMethodService.h"
+
+#include "cxtestReconstructionAlgorithmFixture.h"
+#include "cxtestReconstructionManagerFixture.h"
+#include "cxtestReconstructRealData.h"
+#include "cxtestUtilities.h"
+#include "cxLogicManager.h"
+
+namespace cxtest
+{
+
+namespace
+{
+void reconstructSphere(QString method, QString planeMethod, int nStarts)
+{
+	cx::LogicManager::initialize();
+	ctkPluginContext* pluginContext = cx::logicManager()->getPluginContext();
+
+	ReconstructionAlgorithmFixture fixture;
+	QDomDocument domdoc;
+	QDomElement settings = domdoc.createElement("vnn_cpu");
+
+	fixture.setOverallBoundsAndSpacing(100, 5);
+	fixture.getInputGenerator()->setSpherePhantom();
+
+	cx::VNNReconstructionMethodService* algorithm = new cx::VNNReconstructionMethodService(pluginContext);
+	algorithm->getRadiusOption(settings)->setValue(10);
+	algorithm->getMethodOption(settings)->setValue(method);
+	algorithm->getPlaneMethodOption(settings)->setValue(planeMethod);
+	algorithm->getMaxPlanesOption(settings)->setValue(8);
+	algorithm->getNStartsOption(settings)->setValue(nStarts);
+	algorithm->getBrightnessWeightOption(settings)->setValue(0);
+	algorithm->getNewnessWeightOption(settings)->setValue(0);
+
+	fixture.setAlgorithm(algorithm);
+	fixture.reconstruct(settings);
+
+	fixture.checkRMSBelow(20.0);
+	fixture.checkCentroidDifferenceBelow(1);
+	fixture.checkMassDifferenceBelow(0.01);
+
+	delete algorithm;
+	cx::LogicManager::shutdown();
+}
+} // namespace
+
+TEST_CASE("VNNcpu: VNN on sphere", "[unit][VNNcpu][usreconstruction][synthetic]")
+{
+	reconstructSphere("VNN", "Heuristic", 1);
+}
+
+TEST_CASE("VNNcpu: VNN2 on sphere", "[unit][VNNcpu][usreconstruction][synthetic]")
+{
+	reconstructSphere("VNN2", "Heuristic", 1);
+}
+
+TEST_CASE("VNNcpu: DW on sphere", "[unit][VNNcpu][usreconstruction][synthetic]")
+{
+	reconstructSphere("DW", "Heuristic", 1);
+}
+
+TEST_CASE("VNNcpu: Anisotropic on sphere", "[unit][VNNcpu][usreconstruction][synthetic]")
+{
+	reconstructSphere("Anisotropic", "Heuristic", 1);
+}
+
+TEST_CASE("VNNcpu: VNN multistart on sphere", "[unit][VNNcpu][usreconstruction][synthetic]")
+{
+	reconstructSphere("VNN", "Heuristic", 5);
+}
+
+TEST_CASE("VNNcpu: VNN closest on sphere", "[unit][VNNcpu][usreconstruction][synthetic]")
+{
+	reconstructSphere("VNN", "Closest", 1);
+}
+
+TEST_CASE("VNNcpu: DW on real data", "[usreconstruction][integration][VNNcpu]")
+{
+	ReconstructionManagerTestFixture fixture;
+	ReconstructRealTestData realData;
+	cx::UsReconstructionServicePtr reconstructer = fixture.getManager();
+
+	reconstructer->selectData(realData.getSourceFilename());
+	reconstructer->getParam("Algorithm")->setValueFromVariant("vnn_cpu");
+	reconstructer->getParam("Angio data")->setValueFromVariant(false);
+	reconstructer->getParam("Dual Angio")->setValueFromVariant(false);
+
+	QDomElement algo = reconstructer->getSettings().getElement("algorithms", "vnn_cpu");
+	cx::VNNReconstructionMethodService algorithm(NULL);
+	algorithm.getRadiusOption(algo)->setValue(1.0);
+	algorithm.getMethodOption(algo)->setValue("DW");
+	algorithm.getMaxPlanesOption(algo)->setValue(8);
+
+	fixture.reconstruct();
+
+	REQUIRE(fixture.getOutput().size()==1);
+	realData.validateBModeData(fixture.getOutput()[0]);
+}
+
+} // namespace cxtest
@@ -13,6 +13,15 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include "cxVNNclAlgorithm.h"
 #include "cxtestVNNclFixture.h"
+#include "cxVNNclReconstructionMethodService.h"
+#include "cxReconstructionMethodService.h"
+#include "cxLogicManager.h"
+#include "cxReporter.h"
+#include "cxVolumeHelpers.h"
+#include "cxDummyTool.h"
+#include <vtkImageData.h>
+#include <ctkServiceTracker.h>
+#include <ctkPluginContext.h>
 
 //#ifdef CX_USE_OPENCL_UTILITY
 //#include "cxSimpleSyntheticVolume.h"
@@ -116,6 +125,112 @@ TEST_CASE("VNNcl: VNN Closest on real data", "[usreconstruction][integration][VN
 	vnnClFixture.verify();
 }
 
+namespace
+{
+void setOption(cx::ReconstructionMethodService* algorithm, QDomElement settings, QString uid, QVariant value)
+{
+	std::vector<cx::PropertyPtr> options = algorithm->getSettings(settings);
+	for (unsigned i=0; i<options.size(); ++i)
+		if (options[i]->getUid() == uid)
+			options[i]->setValueFromVariant(value);
+}
+
+/** Reconstruct the same synthetic input with the OpenCL and the CPU implementation,
+ *  and require that the results are close.
+ *
+ *  The CPU implementation is found in the plugin framework, and the
+ *  test is skipped if the plugin is not available.
+ */
+void compareCLWithCPU(QString method)
+{
+	cx::LogicManager::initialize();
+	cx::Reporter::initialize();
+	ctkPluginContext* pluginContext = cx::logicManager()->getPluginContext();
+
+	ctkServiceTracker<cx::ReconstructionMethodService*> tracker(pluginContext);
+	tracker.open();
+	cx::ReconstructionMethodService* cpuAlgorithm = NULL;
+	QList<cx::ReconstructionMethodService*> services = tracker.getServices();
+	for (int i=0; i<services.size(); ++i)
+		if (services[i]->getName() == "vnn_cpu")
+			cpuAlgorithm = services[i];
+	if (!cpuAlgorithm)
+	{
+		WARN("The CPU VNN reconstruction plugin is not available, skipping comparison.");
+		tracker.close();
+		cx::Reporter::shutdown();
+		cx::LogicManager::shutdown();
+		return;
+	}
+
+	SyntheticReconstructInputPtr generator(new SyntheticReconstructInput);
+	generator->defineProbe(cx::DummyToolTestUtilities::createProbeDefinitionLinear(100, 100, Eigen::Array2i(150,150)));
+	generator->setOverallBoundsAndSpacing(100, 2);
+	generator->setSpherePhantom();
+	cx::ProcessedUSInputDataPtr input = generator->generateSynthetic_ProcessedUSInputData(cx::Transform3D::Identity());
+	Eigen::Array3i dim(51, 51, 51);
+	cx::Vector3D spacing(2, 2, 2);
+
+	QDomDocument domdoc;
+	cx::VNNclReconstructionMethodService* clAlgorithm = new cx::VNNclReconstructionMethodService(pluginContext);
+	QDomElement clSettings = domdoc.createElement("vnn_cl");
+	QDomElement cpuSettings = domdoc.createElement("vnn_cpu");
+	clAlgorithm->getMethodOption(clSettings)->setValue(method);
+	setOption(cpuAlgorithm, cpuSettings, "Method", method);
+	clAlgorithm->getMaxPlanesOption(clSettings)->setValue(8);
+	setOption(cpuAlgorithm, cpuSettings, "nPlanes", 8);
+	clAlgorithm->getNStartsOption(clSettings)->setValue(1);
+	setOption(cpuAlgorithm, cpuSettings, "nStarts", 1);
+
+	vtkImageDataPtr clOutput = cx::generateVtkImageData(dim, spacing, 0);
+	vtkImageDataPtr cpuOutput = cx::generateVtkImageData(dim, spacing, 0);
+	REQUIRE(clAlgorithm->reconstruct(input, clOutput, clSettings));
+	REQUIRE(cpuAlgorithm->reconstruct(input, cpuOutput, cpuSettings));
+
+	unsigned char* clPtr = static_cast<unsigned char*>(clOutput->GetScalarPointer());
+	unsigned char* cpuPtr = static_cast<unsigned char*>(cpuOutput->GetScalarPointer());
+	int size = dim[0]*dim[1]*dim[2];
+	double sumDifference = 0;
+	int largeDifferences = 0;
+	for (int i=0; i<size; ++i)
+	{
+		int difference = abs(int(clPtr[i]) - int(cpuPtr[i]));
+		sumDifference += difference;
+		if (difference > 2)
+			++largeDifferences;
+	}
+	// float rounding and ordering of equally distant planes may differ between the implementations
+	CHECK(sumDifference/size < 0.5);
+	CHECK(double(largeDifferences)/size < 0.01);
+
+	delete clAlgorithm;
+	tracker.close();
+	Utilities::sleep_sec(1);
+	cx::Reporter::shutdown();
+	cx::LogicManager::shutdown();
+}
+} // namespace
+
+TEST_CASE("VNNcl: OpenCL and CPU VNN give the same result", "[unit][VNNcl][VNNcpu][usreconstruction][synthetic][not_apple]")
+{
+	compareCLWithCPU("VNN");
+}
+
+TEST_CASE("VNNcl: OpenCL and CPU VNN2 give the same result", "[unit][VNNcl][VNNcpu][usreconstruction][synthetic][not_apple]")
+{
+	compareCLWithCPU("VNN2");
+}
+
+TEST_CASE("VNNcl: OpenCL and CPU DW give the same result", "[unit][VNNcl][VNNcpu][usreconstruction][synthetic][not_apple]")
+{
+	compareCLWithCPU("DW");
+}
+
+TEST_CASE("VNNcl: OpenCL and CPU Anisotropic give the same result", "[unit][VNNcl][VNNcpu][usreconstruction][synthetic][not_apple]")
+{
+	compareCLWithCPU("Anisotropic");
+}
+
 #endif//CX_USE_OPENCL_UTILITY
 
 } //namespace cxtest
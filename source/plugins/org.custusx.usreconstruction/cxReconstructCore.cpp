@@ -88,6 +88,55 @@ void ReconstructCore::threadedReconstruct()
 	timer.printElapsedSeconds("Reconstruct core time");
 }
 
+bool ReconstructCore::canStream()
+{
+	if (!this->validInputData())
+		return false;
+	return mInput.mStreaming && mAlgorithm->canStream(mInput.mAlgoSettings);
+}
+
+bool ReconstructCore::canRunInParallel()
+{
+	if (!this->validInputData())
+		return false;
+	return mAlgorithm->isReentrant();
+}
+
+/**Start a streamed reconstruction, replaces threadedReconstruct().
+ * Input is then added using insertStreamedInput().
+ */
+void ReconstructCore::beginStreamedReconstruct()
+{
+	mSuccess = false;
+	if (!this->validInputData())
+		return;
+	CX_ASSERT(mRawOutput);
+
+	mStream = mAlgorithm->createStream(mRawOutput, mInput.mAlgoSettings);
+	if (!mStream)
+		reportError(QString("Algorithm %1 does not support streaming").arg(mAlgorithm->getName()));
+}
+
+/**Add a window of processed input frames to the streamed reconstruction.
+ * The last inserted window is used as file data for naming the output.
+ */
+void ReconstructCore::insertStreamedInput(ProcessedUSInputDataPtr window)
+{
+	if (!mStream)
+		return;
+	mFileData = window;
+	if (!mStream->insert(window))
+		mStream.reset();
+}
+
+void ReconstructCore::endStreamedReconstruct()
+{
+	if (!mStream)
+		return;
+	mSuccess = mStream->finish();
+	mStream.reset();
+}
+
 /**The reconstruct part that must be done post-rec in the main thread.
  *
  */
@@ -47,7 +47,9 @@ public:
             mPosFilterStrength(0),
             mMaskReduce(0),
 			mAngio(false),
-			mMaxOutputVolumeSize(1024*1024)
+			mMaxOutputVolumeSize(1024*1024),
+			mStreaming(false),
+			mStreamingMemoryLimit(256*1024*1024)
 		{}
 		double mExtraTimeCalibration;
 		bool mAlignTimestamps;
@@ -64,6 +66,8 @@ public:
 		bool mAngio; ///< true for angio data, false is B-mode.
 		QString mTransferFunctionPreset;
 		double mMaxOutputVolumeSize;
+		bool mStreaming; ///< read and reconstruct the input frames in windows, if supported by the algorithm.
+		double mStreamingMemoryLimit; ///< max memory used by the input frames in a streamed reconstruction, bytes.
 	};
 
 	ReconstructCore(PatientModelServicePtr patientModelService);
@@ -78,6 +82,13 @@ public:
 	void threadedPostReconstruct();
 	ImagePtr getOutput();
 
+	// used for streamed reconstruction: call threadedPreReconstruct() first, threadedPostReconstruct() last.
+	bool canStream();
+	bool canRunInParallel(); ///< true if the algorithm can run in parallel with other cores
+	void beginStreamedReconstruct();
+	void insertStreamedInput(ProcessedUSInputDataPtr window);
+	void endStreamedReconstruct();
+
 	// published helper methods, also needed for parameter display outside of reconstruction execution:
 	InputParams getInputParams() { return mInput; }
 
@@ -95,6 +106,7 @@ private:
 
 	// generated data
 	ReconstructionMethodService* mAlgorithm;///< The used reconstruction algorithm
+	boost::shared_ptr<class ReconstructionStream> mStream; ///< Used during streamed reconstruction
 	vtkImageDataPtr mRawOutput; ///< Output image, prior to conversion to Image.
 	ImagePtr mOutput;///< Output image from reconstruction
 	OutputVolumeParams mOutputVolumeParams;
@@ -129,6 +129,21 @@ void ReconstructParams::createParameters()
 	connect(mCreateBModeWhenAngio.get(), SIGNAL(valueWasSet()), this, SIGNAL(changedInputSettings()));
 	this->add(mCreateBModeWhenAngio);
 
+	mStreaming = BoolProperty::initialize("Streaming", "",
+		"Read and reconstruct the input frames in windows instead of loading all frames first.\n"
+		"Limits memory use for long recordings. Ignored if not supported by the algorithm.", false,
+		mSettings.getElement());
+	connect(mStreaming.get(), SIGNAL(valueWasSet()), this, SIGNAL(changedInputSettings()));
+	this->add(mStreaming);
+
+	mStreamingMemoryLimit = DoubleProperty::initialize("Streaming Memory Limit", "",
+		"Max memory used by input frames when streaming (Mb)", 256*maxVolumeSizeFactor,
+		DoubleRange(16*maxVolumeSizeFactor, maxVolumeSizeFactor*4096, 16*maxVolumeSizeFactor), 0,
+		mSettings.getElement());
+	mStreamingMemoryLimit->setInternal2Display(1.0/maxVolumeSizeFactor);
+	connect(mStreamingMemoryLimit.get(), SIGNAL(valueWasSet()), this, SIGNAL(changedInputSettings()));
+	this->add(mStreamingMemoryLimit);
+
 	mAlgorithmAdapter = StringProperty::initialize("Algorithm", "", "Choose algorithm to use for reconstruction",
 			QString(), QStringList(), mSettings.getElement());
 	connect(mAlgorithmAdapter.get(), &StringProperty::valueWasSet, this, &ReconstructParams::changedInputSettings);
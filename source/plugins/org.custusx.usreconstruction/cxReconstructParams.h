@@ -53,6 +53,8 @@ public:
 	DoublePropertyPtr getMaxVolumeSize() { this->createParameters(); return mMaxVolumeSize; }
 	BoolPropertyPtr getAngioAdapter() { this->createParameters(); return mAngioAdapter; }
 	BoolPropertyPtr getCreateBModeWhenAngio() { this->createParameters(); return mCreateBModeWhenAngio; }
+	BoolPropertyPtr getStreaming() { this->createParameters(); return mStreaming; }
+	DoublePropertyPtr getStreamingMemoryLimit() { this->createParameters(); return mStreamingMemoryLimit; }
 
 signals:
 	void changedInputSettings();
@@ -77,6 +79,8 @@ private:
 	DoublePropertyPtr mMaxVolumeSize; ///< Set max size of output volume.
 	BoolPropertyPtr mAngioAdapter; ///US angio data is used as input
 	BoolPropertyPtr mCreateBModeWhenAngio; /// If angio requested, create a B-mode reoconstruction based on the same data set.
+	BoolPropertyPtr mStreaming; ///< Reconstruct input frames in windows.
+	DoublePropertyPtr mStreamingMemoryLimit; ///< Max memory used by input frames when streaming.
 
 	PatientModelServicePtr mPatientModelService;
 	XmlOptionFile mSettings;
@@ -49,16 +49,38 @@ ReconstructPreprocessor::~ReconstructPreprocessor()
 
 std::vector<ProcessedUSInputDataPtr> ReconstructPreprocessor::createProcessedInput(std::vector<bool> angio)
 {
-
 	std::vector<std::vector<vtkImageDataPtr> > frames = mFileData.mUsRaw->initializeFrames(angio);
+	return this->createProcessedInput(frames, mFileData.mFrames);
+}
+
+std::vector<ProcessedUSInputDataPtr> ReconstructPreprocessor::createProcessedInput(std::vector<bool> angio, unsigned first, unsigned count)
+{
+	first = std::min<unsigned>(first, mFileData.mFrames.size());
+	count = std::min<unsigned>(count, mFileData.mFrames.size() - first);
+
+	std::vector<std::vector<vtkImageDataPtr> > frames = mFileData.mUsRaw->initializeFrames(angio, first, count);
+	std::vector<TimedPosition> positions(mFileData.mFrames.begin() + first, mFileData.mFrames.begin() + first + count);
+	return this->createProcessedInput(frames, positions);
+}
 
+unsigned ReconstructPreprocessor::getFramesPerWindow(unsigned outputCount) const
+{
+	double frameSize = mFileData.mUsRaw->getEstimatedFrameMemoryUse(outputCount);
+	if (frameSize <= 0)
+		return mFileData.mFrames.size();
+	double frames = mInput.mStreamingMemoryLimit / frameSize;
+	return static_cast<unsigned>(std::max(frames, 1.0));
+}
+
+std::vector<ProcessedUSInputDataPtr> ReconstructPreprocessor::createProcessedInput(std::vector<std::vector<vtkImageDataPtr> > frames, std::vector<TimedPosition> positions)
+{
 	std::vector<ProcessedUSInputDataPtr> retval;
 
-	for (unsigned i=0; i<angio.size(); ++i)
+	for (unsigned i=0; i<frames.size(); ++i)
 	{
 		ProcessedUSInputDataPtr input;
 		input.reset(new ProcessedUSInputData(frames[i],
-											 mFileData.mFrames,
+											 positions,
 											 mFileData.getMask(),
 											 mFileData.mFilename,
 											 QFileInfo(mFileData.mFilename).completeBaseName() ));
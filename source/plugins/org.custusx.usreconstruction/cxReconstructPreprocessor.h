@@ -42,8 +42,18 @@ public:
     ReconstructCore::InputParams getInputParams() { return mInput; }
 
     std::vector<ProcessedUSInputDataPtr> createProcessedInput(std::vector<bool> angio);
+    /** Create processed input for the frames [first, first+count) only.
+     *  Used for streamed reconstruction, where the frames are processed in windows.
+     */
+    std::vector<ProcessedUSInputDataPtr> createProcessedInput(std::vector<bool> angio, unsigned first, unsigned count);
+    unsigned getNumberOfFrames() const { return mFileData.mFrames.size(); }
+    /** Number of frames that can be processed in one window for outputCount outputs
+     *  without exceeding InputParams::mStreamingMemoryLimit.
+     */
+    unsigned getFramesPerWindow(unsigned outputCount) const;
 
 private:
+    std::vector<ProcessedUSInputDataPtr> createProcessedInput(std::vector<std::vector<vtkImageDataPtr> > frames, std::vector<TimedPosition> positions);
     void cropInputData();
 		IntBoundingBox3D reduceCropboxToImageSize(IntBoundingBox3D cropbox, QSize size);
     void updateFromOriginalFileData();
@@ -16,6 +16,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxReconstructCore.h"
 #include "cxPatientModelService.h"
 #include "cxViewService.h"
+#include "cxLogger.h"
 
 //Windows fix
 #ifndef M_PI
@@ -97,5 +98,72 @@ void ThreadedTimedReconstructCore::postProcessingSlot()
 	mViewService->autoShowData(mReconstructer->getOutput());
 }
 
+//---------------------------------------------------------
+//---------------------------------------------------------
+//---------------------------------------------------------
+
+
+ThreadedTimedReconstructStreamer::ThreadedTimedReconstructStreamer(PatientModelServicePtr patientModelService, ViewServicePtr viewService, ReconstructPreprocessorPtr input, std::vector<ReconstructCorePtr> cores) :
+	cx::ThreadedTimedAlgorithm<void> ("US Streamed Reconstruction", 30),
+	mPatientModelService(patientModelService),
+	mViewService(viewService)
+{
+	mUseDefaultMessages = false;
+	mInput = input;
+	mCores = cores;
+}
+
+ThreadedTimedReconstructStreamer::~ThreadedTimedReconstructStreamer()
+{
+}
+
+void ThreadedTimedReconstructStreamer::preProcessingSlot()
+{
+	for (unsigned i=0; i<mCores.size(); ++i)
+	{
+		mCores[i]->initialize(ProcessedUSInputDataPtr(), mInput->getOutputVolumeParams());
+		mCores[i]->threadedPreReconstruct();
+	}
+}
+
+void ThreadedTimedReconstructStreamer::calculate()
+{
+	streamInput(mInput, mCores);
+}
+
+void ThreadedTimedReconstructStreamer::postProcessingSlot()
+{
+	for (unsigned i=0; i<mCores.size(); ++i)
+	{
+		mCores[i]->threadedPostReconstruct();
+		mViewService->autoShowData(mCores[i]->getOutput());
+	}
+	mPatientModelService->autoSave();
+}
+
+void ThreadedTimedReconstructStreamer::streamInput(ReconstructPreprocessorPtr input, std::vector<ReconstructCorePtr> cores)
+{
+	std::vector<bool> angio;
+	for (unsigned i=0; i<cores.size(); ++i)
+		angio.push_back(cores[i]->getInputParams().mAngio);
+
+	unsigned frameCount = input->getNumberOfFrames();
+	unsigned windowSize = input->getFramesPerWindow(cores.size());
+	reportDebug(QString("Streaming %1 frames in windows of %2 frames.").arg(frameCount).arg(windowSize));
+
+	for (unsigned i=0; i<cores.size(); ++i)
+		cores[i]->beginStreamedReconstruct();
+
+	for (unsigned first=0; first<frameCount; first+=windowSize)
+	{
+		std::vector<cx::ProcessedUSInputDataPtr> window = input->createProcessedInput(angio, first, windowSize);
+		for (unsigned i=0; i<cores.size(); ++i)
+			cores[i]->insertStreamedInput(window[i]);
+	}
+
+	for (unsigned i=0; i<cores.size(); ++i)
+		cores[i]->endStreamedReconstruct();
+}
+
 }
 
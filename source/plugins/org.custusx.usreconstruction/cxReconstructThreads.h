@@ -34,6 +34,7 @@ typedef boost::shared_ptr<class ReconstructCore> ReconstructCorePtr;
 typedef boost::shared_ptr<class ThreadedTimedReconstructer> ThreadedTimedReconstructerPtr;
 typedef boost::shared_ptr<class ThreadedTimedReconstructPreprocessor> ThreadedTimedReconstructPreprocessorPtr;
 typedef boost::shared_ptr<class ThreadedTimedReconstructCore> ThreadedTimedReconstructCorePtr;
+typedef boost::shared_ptr<class ThreadedTimedReconstructStreamer> ThreadedTimedReconstructStreamerPtr;
 
 /**
  * \brief Threading adapter for the reconstruction algorithm.
@@ -105,6 +106,47 @@ private:
 	ViewServicePtr mViewService;
 };
 
+/**
+ * \brief Threading adapter for streamed reconstruction.
+ *
+ * Replaces both ThreadedTimedReconstructPreprocessor and ThreadedTimedReconstructCore
+ * when all cores can stream: The input frames are preprocessed and inserted into the
+ * cores one window at a time, thus only one window of frames is held in memory.
+ *
+ * Executes ReconstructCore functions:
+ *  - threadedPreReconstruct() [main thread]
+ *  - beginStreamedReconstruct(), insertStreamedInput(), endStreamedReconstruct() [work thread]
+ *  - threadedPostReconstruct() [main thread]
+ *
+ * \date 2026-10-18
+ */
+class org_custusx_usreconstruction_EXPORT ThreadedTimedReconstructStreamer: public cx::ThreadedTimedAlgorithm<void>
+{
+Q_OBJECT
+public:
+	static ThreadedTimedReconstructStreamerPtr create(PatientModelServicePtr patientModelService, ViewServicePtr viewService, ReconstructPreprocessorPtr input, std::vector<ReconstructCorePtr> cores)
+	{
+		return ThreadedTimedReconstructStreamerPtr(new ThreadedTimedReconstructStreamer(patientModelService, viewService, input, cores));
+	}
+	ThreadedTimedReconstructStreamer(PatientModelServicePtr patientModelService, ViewServicePtr viewService, ReconstructPreprocessorPtr input, std::vector<ReconstructCorePtr> cores);
+	virtual ~ThreadedTimedReconstructStreamer();
+
+	/** Preprocess the input in windows and insert each window into all cores.
+	  * The cores must have been prepared with threadedPreReconstruct().
+	  */
+	static void streamInput(ReconstructPreprocessorPtr input, std::vector<ReconstructCorePtr> cores);
+
+private slots:
+	virtual void preProcessingSlot();
+	virtual void postProcessingSlot();
+
+private:
+	virtual void calculate();
+	ReconstructPreprocessorPtr mInput;
+	std::vector<ReconstructCorePtr> mCores;
+	PatientModelServicePtr mPatientModelService;
+	ViewServicePtr mViewService;
+};
 
 /**
  * @}
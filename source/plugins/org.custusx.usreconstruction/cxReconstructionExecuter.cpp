@@ -28,6 +28,19 @@ void ReconstructionExecuter::startNonThreadedReconstruction(ReconstructionMethod
 	cx::ReconstructPreprocessorPtr preprocessor = this->createPreprocessor(par, fileData);
 	mCores = this->createCores(algo, par, createBModeWhenAngio);
 
+	if (this->canCoresStream(mCores))
+	{
+		for (unsigned i=0; i<mCores.size(); ++i)
+		{
+			mCores[i]->initialize(ProcessedUSInputDataPtr(), preprocessor->getOutputVolumeParams());
+			mCores[i]->threadedPreReconstruct();
+		}
+		ThreadedTimedReconstructStreamer::streamInput(preprocessor, mCores);
+		for (unsigned i=0; i<mCores.size(); ++i)
+			mCores[i]->threadedPostReconstruct();
+		return;
+	}
+
 	std::vector<bool> angio;
 	for (unsigned i=0; i<mCores.size(); ++i)
 		angio.push_back(mCores[i]->getInputParams().mAngio);
@@ -93,6 +106,14 @@ cx::CompositeTimedAlgorithmPtr ReconstructionExecuter::assembleReconstructionPip
 	cx::CompositeSerialTimedAlgorithmPtr pipeline(new cx::CompositeSerialTimedAlgorithm("US Reconstruction"));
 
 	ReconstructPreprocessorPtr preprocessor = this->createPreprocessor(par, fileData);
+
+	if (this->canCoresStream(cores))
+	{
+		pipeline->append(ThreadedTimedReconstructStreamer::create(mPatientModelService, mViewService, preprocessor, cores));
+		reportDebug("Running streamed reconstruction.");
+		return pipeline;
+	}
+
 	pipeline->append(ThreadedTimedReconstructPreprocessor::create(mPatientModelService, preprocessor, cores));
 
 	cx::CompositeTimedAlgorithmPtr temp = pipeline;
@@ -116,11 +137,22 @@ bool ReconstructionExecuter::canCoresRunInParallel(std::vector<ReconstructCorePt
 
 	std::vector<ReconstructCorePtr>::iterator it;
 	for(it = cores.begin(); it != cores.end(); ++it)
-		parallelizable = parallelizable && (it->get()->getInputParams().mAlgorithmUid == "pnn");
+		parallelizable = parallelizable && it->get()->canRunInParallel();
 
 	return parallelizable;
 }
 
+bool ReconstructionExecuter::canCoresStream(std::vector<ReconstructCorePtr> cores)
+{
+	if (cores.empty())
+		return false;
+
+	bool streamable = true;
+	for (unsigned i=0; i<cores.size(); ++i)
+		streamable = streamable && cores[i]->canStream();
+	return streamable;
+}
+
 ReconstructPreprocessorPtr ReconstructionExecuter::createPreprocessor(ReconstructCore::InputParams par, USReconstructInputData fileData)
 {
 	ReconstructPreprocessorPtr retval(new ReconstructPreprocessor(mPatientModelService));
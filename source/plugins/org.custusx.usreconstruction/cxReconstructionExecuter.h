@@ -71,6 +71,7 @@ private:
 	ReconstructCorePtr createBModeCore(ReconstructCore::InputParams par, ReconstructionMethodService* algo); ///< core version for B-mode in case of angio recording.
 	cx::CompositeTimedAlgorithmPtr assembleReconstructionPipeline(std::vector<ReconstructCorePtr> cores, ReconstructCore::InputParams par, USReconstructInputData fileData); ///< assembles the different steps that is needed to reconstruct
 	bool canCoresRunInParallel(std::vector<ReconstructCorePtr> cores);
+	bool canCoresStream(std::vector<ReconstructCorePtr> cores);
 
 	std::vector<ReconstructCorePtr> mCores;
 	cx::TimedAlgorithmPtr mPipeline;
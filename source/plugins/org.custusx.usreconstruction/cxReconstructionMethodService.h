@@ -42,6 +42,31 @@ typedef boost::shared_ptr<class ProcessedUSInputData> ProcessedUSInputDataPtr;
 
 typedef boost::shared_ptr<class ReconstructionMethodService> ReconstructionMethodServicePtr;
 
+/**
+ * \brief Incremental reconstruction of one output volume.
+ *
+ * Created by ReconstructionMethodService::createStream(). The input
+ * frames are inserted in windows of consecutive frames, in frame order,
+ * and the output volume is completed by finish().
+ *
+ *  \date 2026-10-18
+ */
+class org_custusx_usreconstruction_EXPORT ReconstructionStream
+{
+public:
+	virtual ~ReconstructionStream() {}
+	/**
+	 * Add a window of input frames to the reconstruction. The window can be
+	 * released by the caller after this call.
+	 */
+	virtual bool insert(ProcessedUSInputDataPtr window) = 0;
+	/**
+	 * Complete the output volume after all windows have been inserted.
+	 */
+	virtual bool finish() = 0;
+};
+typedef boost::shared_ptr<ReconstructionStream> ReconstructionStreamPtr;
+
 /**
  * \brief Abstract interface for reconstruction algorithm.
  *
@@ -69,6 +94,24 @@ public:
 	 * \param settings Reference to settings file containing algorithm-specific settings
 	 */
 	virtual bool reconstruct(ProcessedUSInputDataPtr input, vtkImageDataPtr outputData, QDomElement settings) = 0;
+	/**
+	 * Create a stream that reconstructs into outputData from windows of input
+	 * frames, thus avoiding holding all frames in memory at once.
+	 * Return zero if streaming is not supported by the algorithm.
+	 *
+	 * \param outputData [Out] The reconstructed volume. Memory must be allocated in advance.
+	 * \param settings Reference to settings file containing algorithm-specific settings
+	 */
+	virtual ReconstructionStreamPtr createStream(vtkImageDataPtr outputData, QDomElement settings) { return ReconstructionStreamPtr(); }
+	/**
+	 * Return true if createStream() is supported with the given settings.
+	 */
+	virtual bool canStream(QDomElement settings) { return false; }
+	/**
+	 * Return true if reconstruct() can be called from several threads at the same time.
+	 * Reconstructions from the same input, such as angio and B-mode, are then run in parallel.
+	 */
+	virtual bool isReentrant() const { return false; }
 };
 
 /**
@@ -152,6 +152,8 @@ QWidget* ReconstructionWidget::createOptionsWidget()
 //    sscCreateDataWidget(this, mReconstructer->getParam("Position Thinning"), layout, line++);
     sscCreateDataWidget(this, mReconstructer->getParam("Position Filter Strength"), layout, line++);
 	sscCreateDataWidget(this, mReconstructer->getParam("Reduce mask (% in 1D)"), layout, line++);
+	sscCreateDataWidget(this, mReconstructer->getParam("Streaming"), layout, line++);
+	sscCreateDataWidget(this, mReconstructer->getParam("Streaming Memory Limit"), layout, line++);
 
 	return retval;
 }
@@ -250,6 +250,8 @@ ReconstructCore::InputParams UsReconstructionImplService::createCoreParameters()
     par.mPosFilterStrength = mParams->getPosFilterStrength()->getValue().toDouble();;
 	par.mMaskReduce = mParams->getMaskReduce()->getValue().toDouble();
 	par.mOrientation = mParams->getOrientationAdapter()->getValue();
+	par.mStreaming = mParams->getStreaming()->getValue();
+	par.mStreamingMemoryLimit = mParams->getStreamingMemoryLimit()->getValue();
 	return par;
 }
 
@@ -71,6 +71,38 @@ TEST_CASE("ReconstructManager: PNN on sphere","[unit][usreconstruction][syntheti
 	CHECK(!messageListener->containsErrors());
 }
 
+TEST_CASE("ReconstructManager: Streamed PNN on sphere","[unit][usreconstruction][synthetic][not_win32][pnn]")
+{
+	ReconstructionManagerTestFixture fixture;
+	cx::MessageListenerPtr messageListener = cx::MessageListener::createWithQueue();
+
+	SyntheticReconstructInputPtr input(new SyntheticReconstructInput);
+	input->setOverallBoundsAndSpacing(100, 5);
+	input->setSpherePhantom();
+	cx::USReconstructInputData inputData = input->generateSynthetic_USReconstructInputData();
+
+	cx::UsReconstructionServicePtr reconstructer = fixture.getManager();
+	reconstructer->selectData(inputData);
+	reconstructer->getParam("Algorithm")->setValueFromVariant("pnn");
+	reconstructer->getParam("Dual Angio")->setValueFromVariant(false);
+	reconstructer->getParam("Position Filter Strength")->setValueFromVariant("0");
+	reconstructer->getParam("Streaming")->setValueFromVariant(true);
+	reconstructer->getParam("Streaming Memory Limit")->setValueFromVariant(16*1024*1024);
+	fixture.setPNN_InterpolationSteps(1);
+
+	fixture.reconstruct();
+
+	REQUIRE(fixture.getOutput().size()==1);
+
+	SyntheticVolumeComparerPtr comparer = fixture.getComparerForOutput(input, 0);
+	comparer->checkRMSBelow(30.0);
+	comparer->checkCentroidDifferenceBelow(1);
+	comparer->checkMassDifferenceBelow(0.01);
+	comparer->checkValueWithin(input->getPhantom()->getBounds()/2, 200, 255);
+
+	CHECK(!messageListener->containsErrors());
+}
+
 TEST_CASE("ReconstructManager: PNN on angio sphere","[unit][usreconstruction][synthetic][pnn][hide]")
 {
 	/** Test on a phantom containing a colored sphere and a gray sphere.
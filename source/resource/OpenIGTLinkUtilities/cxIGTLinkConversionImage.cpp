@@ -24,6 +24,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 ==========================================================================*/
 #include "cxIGTLinkConversionImage.h"
 #include "vtkImageData.h"
+#include "vtkPointData.h"
+#include "vtkDataArray.h"
 
 #include <igtl_util.h>
 #include "cxLogger.h"
@@ -49,6 +51,22 @@ igtl::ImageMessage::Pointer IGTLinkConversionImage::encode(ImagePtr image, PATIE
 ImagePtr IGTLinkConversionImage::decode(igtl::ImageMessage *msg)
 {
 	vtkImageDataPtr vtkImage = this->decode_vtkImageData(msg);
+	return this->createImage(msg, vtkImage);
+}
+
+ImagePtr IGTLinkConversionImage::decode(igtl::ImageMessage::Pointer msg, IGTLinkImageMessagePoolPtr pool)
+{
+	vtkImageDataPtr vtkImage = this->share_vtkImageData(msg, pool);
+	if (vtkImage)
+		return this->createImage(msg, vtkImage);
+
+	ImagePtr retval = this->decode(msg);
+	pool->release(msg);
+	return retval;
+}
+
+ImagePtr IGTLinkConversionImage::createImage(igtl::ImageMessage *msg, vtkImageDataPtr vtkImage)
+{
 	QDateTime timestamp = IGTLinkConversionBase().decode_timestamp(msg);
 	QString deviceName = msg->GetDeviceName();
 
@@ -268,6 +286,48 @@ vtkImageDataPtr IGTLinkConversionImage::decode_vtkImageData(igtl::ImageMessage *
 	return imageData;
 }
 
+/** Create image data using the pack buffer of msg as voxel storage.
+ *  Return null if the voxels must be converted, i.e. if a byte swap or
+ *  sub-volume copy is needed, or if the voxels are not aligned.
+ */
+vtkImageDataPtr IGTLinkConversionImage::share_vtkImageData(igtl::ImageMessage::Pointer imgMsg, IGTLinkImageMessagePoolPtr pool)
+{
+	int scalarType = IGTLToVTKScalarType(imgMsg->GetScalarType());
+	int scalarSize = imgMsg->GetScalarSize();
+	int endian = imgMsg->GetEndian();
+	bool byteSwap = scalarSize > 1 &&
+			((igtl_is_little_endian() && endian == igtl::ImageMessage::ENDIAN_BIG) ||
+			 (!igtl_is_little_endian() && endian == igtl::ImageMessage::ENDIAN_LITTLE));
+	void* scalars = imgMsg->GetScalarPointer();
+
+	if (scalarType == VTK_VOID || byteSwap)
+		return vtkImageDataPtr();
+	if (vtkDataArray::GetDataTypeSize(scalarType) != scalarSize)
+		return vtkImageDataPtr();
+	if (imgMsg->GetImageSize() != imgMsg->GetSubVolumeImageSize())
+		return vtkImageDataPtr();
+	if (reinterpret_cast<size_t>(scalars) % scalarSize != 0)
+		return vtkImageDataPtr();
+
+	int size[3];
+	float spacing[3];
+	imgMsg->GetDimensions(size);
+	imgMsg->GetSpacing(spacing);
+	int numComponents = imgMsg->GetNumComponents();
+
+	vtkSmartPointer<vtkDataArray> array = vtkSmartPointer<vtkDataArray>::Take(vtkDataArray::CreateDataArray(scalarType));
+	array->SetNumberOfComponents(numComponents);
+	array->SetVoidArray(scalars, vtkIdType(size[0])*size[1]*size[2]*numComponents, 1);
+	pool->releaseWhenDeleted(array, imgMsg);
+
+	vtkImageDataPtr imageData = vtkImageDataPtr::New();
+	imageData->SetExtent(0, size[0]-1, 0, size[1]-1, 0, size[2]-1);
+	imageData->SetOrigin(0.0, 0.0, 0.0);
+	imageData->SetSpacing(spacing[0], spacing[1], spacing[2]);
+	imageData->GetPointData()->SetScalars(array);
+	return imageData;
+}
+
 void IGTLinkConversionImage::encode_vtkImageData(vtkImageDataPtr in, igtl::ImageMessage *outmsg)
 {
 	// NOTE: This method is mostly a copy-paste from Slicer.
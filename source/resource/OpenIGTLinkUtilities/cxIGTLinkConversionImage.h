@@ -28,6 +28,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "igtlImageMessage.h"
 #include "cxImage.h"
 #include "cxOpenIGTLinkUtilitiesExport.h"
+#include "cxIGTLinkImageMessagePool.h"
 
 
 namespace cx
@@ -43,15 +44,22 @@ namespace cx
  *
  * decode methods assume Unpack() has been called.
  * encode methods assume Pack() will be called.
+ *
+ * decode with a pool avoids copying the voxels when possible: The pack
+ * buffer of the message is used directly as voxel storage, and the message
+ * is returned to the pool when the image data is deleted.
  */
 class cxOpenIGTLinkUtilities_EXPORT IGTLinkConversionImage
 {
 public:
 	igtl::ImageMessage::Pointer encode(ImagePtr in, PATIENT_COORDINATE_SYSTEM externalSpace);
 	ImagePtr decode(igtl::ImageMessage *in);
+	ImagePtr decode(igtl::ImageMessage::Pointer in, IGTLinkImageMessagePoolPtr pool); ///< the pool takes ownership of in
 
 private:
+	ImagePtr createImage(igtl::ImageMessage *in, vtkImageDataPtr imageData);
 	vtkImageDataPtr decode_vtkImageData(igtl::ImageMessage* in);
+	vtkImageDataPtr share_vtkImageData(igtl::ImageMessage::Pointer in, IGTLinkImageMessagePoolPtr pool);
 	void decode_rMd(igtl::ImageMessage* msg, ImagePtr out);
 //	void encode_Transform3D(Transform3D rMd, igtl::ImageMessage *outmsg);
 	void encode_rMd(ImagePtr image, igtl::ImageMessage *outmsg, PATIENT_COORDINATE_SYSTEM externalSpace);
@@ -0,0 +1,116 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+                 
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+                 
+CustusX is released under a BSD 3-Clause license.
+                 
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxIGTLinkImageMessagePool.h"
+
+#include <vtkDataArray.h>
+#include <vtkCallbackCommand.h>
+#include <vtkSmartPointer.h>
+
+namespace cx
+{
+
+namespace
+{
+struct LentMessage
+{
+	IGTLinkImageMessagePoolPtr mPool;
+	igtl::ImageMessage::Pointer mMessage;
+};
+
+void returnMessageCallback(vtkObject*, unsigned long, void* clientData, void*)
+{
+	LentMessage* lent = static_cast<LentMessage*>(clientData);
+	lent->mPool->release(lent->mMessage);
+	delete lent;
+}
+} // namespace
+
+IGTLinkImageMessagePoolPtr IGTLinkImageMessagePool::create(unsigned maxPoolSize)
+{
+	return IGTLinkImageMessagePoolPtr(new IGTLinkImageMessagePool(maxPoolSize));
+}
+
+IGTLinkImageMessagePool::IGTLinkImageMessagePool(unsigned maxPoolSize) :
+	mMaxPoolSize(maxPoolSize),
+	mCreated(0),
+	mRecycled(0),
+	mLent(0)
+{
+}
+
+igtl::ImageMessage::Pointer IGTLinkImageMessagePool::getMessage(igtl::MessageHeader* header)
+{
+	igtl::ImageMessage::Pointer retval;
+	{
+		QMutexLocker lock(&mMutex);
+		if (mPool.empty())
+		{
+			++mCreated;
+		}
+		else
+		{
+			retval = mPool.back();
+			mPool.pop_back();
+			++mRecycled;
+		}
+	}
+
+	if (!retval)
+		retval = igtl::ImageMessage::New();
+	retval->SetMessageHeader(header);
+	retval->AllocatePack(); // reuses the buffer if the size is unchanged
+	return retval;
+}
+
+void IGTLinkImageMessagePool::release(igtl::ImageMessage::Pointer msg)
+{
+	if (!msg)
+		return;
+	QMutexLocker lock(&mMutex);
+	if (mPool.size() < mMaxPoolSize)
+		mPool.push_back(msg);
+}
+
+void IGTLinkImageMessagePool::releaseWhenDeleted(vtkDataArray* array, igtl::ImageMessage::Pointer msg)
+{
+	LentMessage* lent = new LentMessage();
+	lent->mPool = this->shared_from_this();
+	lent->mMessage = msg;
+
+	vtkSmartPointer<vtkCallbackCommand> callback = vtkSmartPointer<vtkCallbackCommand>::New();
+	callback->SetCallback(returnMessageCallback);
+	callback->SetClientData(lent);
+	array->AddObserver(vtkCommand::DeleteEvent, callback);
+
+	QMutexLocker lock(&mMutex);
+	++mLent;
+}
+
+unsigned IGTLinkImageMessagePool::getCreatedCount() const
+{
+	QMutexLocker lock(&mMutex);
+	return mCreated;
+}
+
+unsigned IGTLinkImageMessagePool::getRecycledCount() const
+{
+	QMutexLocker lock(&mMutex);
+	return mRecycled;
+}
+
+unsigned IGTLinkImageMessagePool::getLentCount() const
+{
+	QMutexLocker lock(&mMutex);
+	return mLent;
+}
+
+} // namespace cx
@@ -0,0 +1,71 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+                 
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+                 
+CustusX is released under a BSD 3-Clause license.
+                 
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXIGTLINKIMAGEMESSAGEPOOL_H
+#define CXIGTLINKIMAGEMESSAGEPOOL_H
+
+#include "cxOpenIGTLinkUtilitiesExport.h"
+
+#include <vector>
+#include <QMutex>
+#include <boost/shared_ptr.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include "igtlImageMessage.h"
+#include "igtlMessageHeader.h"
+
+class vtkDataArray;
+
+namespace cx
+{
+typedef boost::shared_ptr<class IGTLinkImageMessagePool> IGTLinkImageMessagePoolPtr;
+
+/** Pool of recycled igtl::ImageMessage objects for receiving image streams.
+ *
+ * The pack buffer of a message is reallocated only when the message size
+ * changes, thus for a stream of equally sized images, no allocations are
+ * needed once the pool is filled.
+ *
+ * A message can be lent to a vtkDataArray using its pack buffer as storage,
+ * see IGTLinkConversionImage::decode(). The message is then returned to
+ * the pool when the array is deleted, which may happen in any thread.
+ *
+ * \ingroup cx_resource_OpenIGTLinkUtilities
+ * \date 2026-10-18
+ */
+class cxOpenIGTLinkUtilities_EXPORT IGTLinkImageMessagePool : public boost::enable_shared_from_this<IGTLinkImageMessagePool>
+{
+public:
+	static IGTLinkImageMessagePoolPtr create(unsigned maxPoolSize=8);
+
+	/** Get a message with pack allocated for the body described by header.
+	 */
+	igtl::ImageMessage::Pointer getMessage(igtl::MessageHeader* header);
+	void release(igtl::ImageMessage::Pointer msg); ///< return message to the pool
+	void releaseWhenDeleted(vtkDataArray* array, igtl::ImageMessage::Pointer msg); ///< return message to the pool when array is deleted
+
+	unsigned getCreatedCount() const; ///< number of messages created
+	unsigned getRecycledCount() const; ///< number of messages reused from the pool
+	unsigned getLentCount() const; ///< number of messages lent to a vtkDataArray
+
+private:
+	explicit IGTLinkImageMessagePool(unsigned maxPoolSize);
+
+	mutable QMutex mMutex;
+	std::vector<igtl::ImageMessage::Pointer> mPool;
+	unsigned mMaxPoolSize;
+	unsigned mCreated;
+	unsigned mRecycled;
+	unsigned mLent;
+};
+
+} // namespace cx
+
+#endif // CXIGTLINKIMAGEMESSAGEPOOL_H
@@ -65,6 +65,43 @@ TEST_CASE_METHOD(IGTLinkConversionFixture, "IGTLinkConversion: Decode/encode ima
 	}
 }
 
+TEST_CASE_METHOD(IGTLinkConversionFixture, "IGTLinkConversion: Decode image sharing the message buffer", "[unit][resource][OpenIGTLinkUtilities]")
+{
+	vtkImageDataPtr rawImage = cx::generateVtkImageData(Eigen::Array3i(100, 120, 10),
+													cx::Vector3D(0.5, 0.6, 0.7),
+													0);
+	this->setValue(rawImage, 10, 20, 2, 4);
+	cx::ImagePtr input(new cx::Image("my_uid", rawImage));
+
+	cx::IGTLinkConversionImage converter;
+	igtl::ImageMessage::Pointer msg = converter.encode(input, pcsLPS);
+	msg->Pack();
+
+	// simulate reading the message from a socket
+	cx::IGTLinkImageMessagePoolPtr pool = cx::IGTLinkImageMessagePool::create();
+	igtl::MessageHeader::Pointer header = igtl::MessageHeader::New();
+	header->InitPack();
+	memcpy(header->GetPackPointer(), msg->GetPackPointer(), header->GetPackSize());
+	header->Unpack();
+	igtl::ImageMessage::Pointer received = pool->getMessage(header);
+	memcpy(received->GetPackBodyPointer(), msg->GetPackBodyPointer(), received->GetPackBodySize());
+	received->Unpack();
+
+	cx::ImagePtr output = converter.decode(received, pool);
+	REQUIRE(output);
+	CHECK(pool->getLentCount() == 1);
+	CHECK(output->getBaseVtkImageData()->GetScalarPointer() == received->GetScalarPointer());
+	CHECK(this->getValue(output, 10, 20, 2) == 4);
+	REQUIRE(cx::similar(Eigen::Array3i(input->getBaseVtkImageData()->GetDimensions()), Eigen::Array3i(output->getBaseVtkImageData()->GetDimensions())));
+
+	// the message is returned to the pool when the image is deleted
+	received = igtl::ImageMessage::Pointer();
+	output.reset();
+	pool->getMessage(header);
+	CHECK(pool->getCreatedCount() == 1);
+	CHECK(pool->getRecycledCount() == 1);
+}
+
 TEST_CASE_METHOD(IGTLinkConversionFixture, "IGTLinkConversion: Decode/encode color image RGBA", "[unit][resource][OpenIGTLinkUtilities]")
 {
 	//testimage
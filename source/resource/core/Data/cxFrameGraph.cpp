@@ -0,0 +1,264 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxFrameGraph.h"
+
+#include "cxData.h"
+#include "cxLogger.h"
+
+namespace cx
+{
+
+FrameGraph::FrameGraph() :
+	mBuilt(true),
+	mIndexed(true)
+{
+}
+
+/**Create a graph representing all Data objects and their spatial relationships.
+ */
+FrameGraph::FrameGraph(const std::map<QString, DataPtr>& source) :
+	mBuilt(true),
+	mIndexed(true)
+{
+	this->setData(source);
+}
+
+/** Set the Data to represent. The graph is rebuilt on the next query.
+ */
+void FrameGraph::setData(const std::map<QString, DataPtr>& source)
+{
+	for (std::map<QString, DataPtr>::iterator iter = mSource.begin(); iter != mSource.end(); ++iter)
+		disconnect(iter->second.get(), &Data::transformChanged, this, &FrameGraph::dataTransformChangedSlot);
+
+	mSource = source;
+	mBuilt = false;
+	mIndexed = false;
+
+	for (std::map<QString, DataPtr>::iterator iter = mSource.begin(); iter != mSource.end(); ++iter)
+		connect(iter->second.get(), &Data::transformChanged, this, &FrameGraph::dataTransformChangedSlot);
+	emit changed();
+}
+
+/** Move the frame of a Data if its parent space has changed.
+ */
+void FrameGraph::dataTransformChangedSlot()
+{
+	Data* data = dynamic_cast<Data*>(this->sender());
+	if (!data || !mBuilt)
+		return;
+	const Node* node = this->getNode(data->getSpace());
+	QString parent = data->getParentSpace();
+	if (node && node->mParent == parent)
+		return;
+
+	this->setParent(data->getSpace(), parent);
+	emit changed();
+}
+
+void FrameGraph::build() const
+{
+	mNodes.clear();
+	mRoots.clear();
+	for (std::map<QString, DataPtr>::const_iterator iter = mSource.begin(); iter != mSource.end(); ++iter)
+		this->insertFrame(iter->second);
+	mBuilt = true;
+	mIndexed = false;
+}
+
+/** Insert one data in the correct position in the graph
+ */
+void FrameGraph::insertFrame(DataPtr data) const
+{
+	this->setParent(data->getSpace(), data->getParentSpace());
+}
+
+/** Make parent the parent of frame, creating both frames if necessary.
+ *  An empty parent makes frame a root.
+ */
+void FrameGraph::setParent(QString frame, QString parent) const
+{
+	if (frame.isEmpty())
+		return;
+
+	if (!mNodes.contains(frame))
+	{
+		mNodes.insert(frame, Node());
+		mRoots << frame;
+	}
+	if (!parent.isEmpty() && !mNodes.contains(parent))
+	{
+		mNodes.insert(parent, Node());
+		mRoots << parent;
+	}
+
+	if (mNodes[frame].mParent == parent)
+		return;
+	for (QString ancestor = parent; !ancestor.isEmpty(); ancestor = mNodes[ancestor].mParent)
+	{
+		if (ancestor == frame)
+		{
+			reportWarning(QString("Ignored parent space %1 for %2: would create a cycle").arg(parent).arg(frame));
+			return;
+		}
+	}
+
+	QString oldParent = mNodes[frame].mParent;
+	if (oldParent.isEmpty())
+		mRoots.removeOne(frame);
+	else
+		mNodes[oldParent].mChildren.removeOne(frame);
+
+	mNodes[frame].mParent = parent;
+	if (parent.isEmpty())
+		mRoots << frame;
+	else
+		mNodes[parent].mChildren << frame;
+
+	mIndexed = false;
+}
+
+/** Compute depth, root and tree order for all frames.
+ */
+void FrameGraph::updateIndex() const
+{
+	mOrder.clear();
+	int counter = 0;
+	for (int i = 0; i < mRoots.size(); ++i)
+		this->index(mRoots[i], mRoots[i], 0, &counter);
+	mIndexed = true;
+}
+
+void FrameGraph::index(QString frame, QString root, int depth, int* counter) const
+{
+	Node& node = mNodes[frame];
+	node.mDepth = depth;
+	node.mRoot = root;
+	node.mFirst = (*counter)++;
+	mOrder << frame;
+	for (int i = 0; i < node.mChildren.size(); ++i)
+		this->index(node.mChildren[i], root, depth + 1, counter);
+	node.mLast = (*counter) - 1;
+}
+
+void FrameGraph::update() const
+{
+	if (!mBuilt)
+		this->build();
+	if (!mIndexed)
+		this->updateIndex();
+}
+
+const FrameGraph::Node* FrameGraph::getNode(QString frame) const
+{
+	this->update();
+	QHash<QString, Node>::const_iterator iter = mNodes.constFind(frame);
+	if (iter == mNodes.constEnd())
+		return NULL;
+	return &iter.value();
+}
+
+bool FrameGraph::contains(QString frame) const
+{
+	return this->getNode(frame) != NULL;
+}
+
+QString FrameGraph::getParent(QString frame) const
+{
+	const Node* node = this->getNode(frame);
+	return node ? node->mParent : QString();
+}
+
+QStringList FrameGraph::getChildren(QString frame) const
+{
+	const Node* node = this->getNode(frame);
+	return node ? node->mChildren : QStringList();
+}
+
+QStringList FrameGraph::getRootFrames() const
+{
+	this->update();
+	return mRoots;
+}
+
+int FrameGraph::getDepth(QString frame) const
+{
+	const Node* node = this->getNode(frame);
+	return node ? node->mDepth : -1;
+}
+
+bool FrameGraph::isAncestorOf(QString frame, QString ancestor) const
+{
+	const Node* node = this->getNode(frame);
+	const Node* ancestorNode = this->getNode(ancestor);
+	if (!node || !ancestorNode)
+		return false;
+	return (ancestorNode->mFirst <= node->mFirst) && (node->mFirst <= ancestorNode->mLast);
+}
+
+/** Find the oldest ancestor of frame, i.e. the root of its tree.
+ */
+QString FrameGraph::getOldestAncestor(QString frame) const
+{
+	const Node* node = this->getNode(frame);
+	return node ? node->mRoot : QString();
+}
+
+/** Find the oldest ancestor of frame, that is not also an ancestor of ref.
+ *  Return empty if frame is an ancestor of ref.
+ */
+QString FrameGraph::getOldestAncestorNotCommonToRef(QString frame, QString ref) const
+{
+	const Node* node = this->getNode(frame);
+	if (!node || this->isAncestorOf(ref, frame))
+		return QString();
+
+	const Node* refNode = this->getNode(ref);
+	if (!refNode || refNode->mRoot != node->mRoot)
+		return node->mRoot;
+
+	// walk up from frame to the child of the nearest common ancestor
+	while (!node->mParent.isEmpty() && !this->isAncestorOf(ref, node->mParent))
+	{
+		frame = node->mParent;
+		node = this->getNode(frame);
+	}
+	return frame;
+}
+
+/** Return the frame and all its descendants, in tree order.
+ */
+QStringList FrameGraph::getDescendantsAndSelf(QString frame) const
+{
+	const Node* node = this->getNode(frame);
+	if (!node)
+		return QStringList();
+	return mOrder.mid(node->mFirst, node->mLast - node->mFirst + 1);
+}
+
+/** As getDescendantsAndSelf(), but return the frames as data objects.
+ *  Those frames not representing data are discarded.
+ */
+std::vector<DataPtr> FrameGraph::getDataFromDescendantsAndSelf(QString frame) const
+{
+	QStringList frames = this->getDescendantsAndSelf(frame);
+	std::vector<DataPtr> retval;
+
+	for (int i = 0; i < frames.size(); ++i)
+	{
+		std::map<QString, DataPtr>::const_iterator iter = mSource.find(frames[i]);
+		if (iter != mSource.end() && iter->second)
+			retval.push_back(iter->second);
+	}
+	return retval;
+}
+
+} // namespace cx
@@ -0,0 +1,103 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXFRAMEGRAPH_H_
+#define CXFRAMEGRAPH_H_
+
+#include "cxResourceExport.h"
+
+#include <map>
+#include <vector>
+#include <QObject>
+#include <QHash>
+#include <QStringList>
+#include "cxForwardDeclarations.h"
+
+namespace cx
+{
+
+typedef boost::shared_ptr<class FrameGraph> FrameGraphPtr;
+
+/**
+ * \brief A graph combining Space dependencies between all Data.
+ * \ingroup cx_resource_core_data
+ *
+ * Each Data defines a frame (its uid) with its parent space as parent
+ * frame. Frames without a parent are roots, thus the graph is a forest.
+ * Frames are identified by uid, also those not representing a Data.
+ *
+ * Frames are kept in a hash with links to parent and children. Depth,
+ * root and tree order are cached, thus all ancestry queries are O(1).
+ * The cache is rebuilt after the structure has changed.
+ *
+ * The graph listens to the Data, and is updated when a parent space
+ * changes. Call setData() when Data are added or removed.
+ *
+ *  \date 2026-10-18
+ */
+class cxResource_EXPORT FrameGraph : public QObject
+{
+	Q_OBJECT
+public:
+	FrameGraph();
+	explicit FrameGraph(const std::map<QString, DataPtr>& source);
+	void setData(const std::map<QString, DataPtr>& source);
+
+	bool contains(QString frame) const;
+	QString getParent(QString frame) const; ///< empty for root frames
+	QStringList getChildren(QString frame) const;
+	QStringList getRootFrames() const;
+	int getDepth(QString frame) const; ///< 0 for root frames, -1 if unknown
+
+	bool isAncestorOf(QString frame, QString ancestor) const; ///< true if ancestor is frame or one of its ancestors
+	QString getOldestAncestor(QString frame) const;
+	QString getOldestAncestorNotCommonToRef(QString frame, QString ref) const;
+	QStringList getDescendantsAndSelf(QString frame) const;
+	std::vector<DataPtr> getDataFromDescendantsAndSelf(QString frame) const;
+
+signals:
+	void changed();
+
+private slots:
+	void dataTransformChangedSlot();
+
+private:
+	struct Node
+	{
+		Node() : mDepth(0), mFirst(0), mLast(0) {}
+		QString mParent;
+		QStringList mChildren;
+		// cached, see updateIndex()
+		int mDepth;
+		QString mRoot;
+		int mFirst; ///< position in tree order
+		int mLast; ///< position in tree order of the last descendant
+	};
+
+	void update() const;
+	void build() const;
+	void insertFrame(DataPtr data) const;
+	void setParent(QString frame, QString parent) const;
+	void updateIndex() const;
+	void index(QString frame, QString root, int depth, int* counter) const;
+	const Node* getNode(QString frame) const;
+
+	std::map<QString, DataPtr> mSource;
+	mutable QHash<QString, Node> mNodes;
+	mutable QStringList mRoots;
+	mutable QStringList mOrder; ///< all frames in tree order
+	mutable bool mBuilt;
+	mutable bool mIndexed;
+};
+
+} // namespace cx
+
+#endif /* CXFRAMEGRAPH_H_ */
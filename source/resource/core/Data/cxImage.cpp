@@ -14,7 +14,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include <QDomDocument>
 #include <QDir>
-#include <vtkImageAccumulate.h>
+#include <QFileInfo>
+#include <QtConcurrentRun>
 #include <vtkImageReslice.h>
 #include <vtkImageData.h>
 #include <vtkMatrix4x4.h>
@@ -23,7 +24,6 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <vtkImageResample.h>
 #include <vtkImageChangeInformation.h>
 #include <vtkImageClip.h>
-#include <vtkImageIterator.h>
 #include <vtkPiecewiseFunction.h>
 #include <vtkColorTransferFunction.h>
 #include "cxImageTF3D.h"
@@ -41,6 +41,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxSettings.h"
 
 #include "cxUnsignedDerivedImage.h"
+#include "cxCustomMetaImage.h"
+#include "cxTime.h"
 
 typedef vtkSmartPointer<vtkImageChangeInformation> vtkImageChangeInformationPtr;
 
@@ -103,7 +105,9 @@ Image::~Image()
 }
 
 Image::Image(const QString& uid, const vtkImageDataPtr& data, const QString& name) :
-	Data(uid, name), mBaseImageData(data), mMaxRGBIntensity(-1), mThresholdPreview(false)
+	Data(uid, name), mBaseImageData(data), mThresholdPreview(false),
+	mVoxelDataRequested(false), mVoxelDataLoaded(false), mVoxelDataMTime(0), mLastVoxelDataAccess(0),
+	mStatisticsMTime(0), mStatisticsFutureMTime(0), mPyramidMTime(0)
 {
 	mInitialWindowWidth = -1;
 	mInitialWindowLevel = -1;
@@ -117,12 +121,14 @@ Image::Image(const QString& uid, const vtkImageDataPtr& data, const QString& nam
 	mImageTransferFunctions3D.reset();
 
 	this->setAcquisitionTime(QDateTime::currentDateTime());
+
+	connect(this, &Image::vtkImageDataChanged, this, &Image::vtkImageDataChangedSlot);
 }
 
 ImagePtr Image::copy()
 {
 	vtkImageDataPtr baseImageDataCopy;
-	if(mBaseImageData)
+	if(this->getBaseVtkImageData())
 	{
 		baseImageDataCopy = vtkImageDataPtr::New();
 		baseImageDataCopy->DeepCopy(mBaseImageData);
@@ -133,7 +139,6 @@ ImagePtr Image::copy()
 	retval->mUnsigned = mUnsigned;
 	retval->mModality = mModality;
 	retval->mImageType = mImageType;
-	retval->mMaxRGBIntensity = mMaxRGBIntensity;
 	retval->mInterpolationType = mInterpolationType;
 	retval->mImageLookupTable2D = mImageLookupTable2D;
 	retval->mImageTransferFunctions3D = mImageTransferFunctions3D;
@@ -187,14 +192,13 @@ ImagePtr Image::getUnsigned(ImagePtr self)
 
 void Image::resetTransferFunctions(bool _2D, bool _3D)
 {
-	if (!mBaseImageData)
+	if (!this->getBaseVtkImageData())
 	{
 		reportWarning("Image has no image data");
 		return;
 	}
 
 	mBaseImageData->GetScalarRange(); // this line updates some internal vtk value, and (on fedora) removes 4.5s in the second render().
-	mMaxRGBIntensity = -1;
 
 	ImageDefaultTFGenerator tfGenerator(ImagePtr(this, null_deleter()));
 	if (_3D)
@@ -266,9 +270,11 @@ void Image::moveThisAndChildrenToThread(QThread* thread)
 
 void Image::setVtkImageData(const vtkImageDataPtr& data, bool resetTransferFunctions)
 {
+	this->clearVoxelDataSource();
 	mBaseImageData = data;
 	mBaseGrayScaleImageData = NULL;
-	mHistogramPtr = NULL;
+	this->resetStatistics();
+	this->resetPyramid();
 
 	if (resetTransferFunctions)
 		this->resetTransferFunctions();
@@ -333,11 +339,16 @@ void Image::setLookupTable2D(ImageLUT2DPtr imageLookupTable2D)
 
 vtkImageDataPtr Image::getBaseVtkImageData()
 {
-	return mBaseImageData;
+	bool loaded = false;
+	vtkImageDataPtr retval = this->loadVoxelData(&loaded);
+	if (loaded)
+		emit vtkImageDataChanged(mUid);
+	return retval;
 }
 
 DoubleBoundingBox3D Image::boundingBox() const
 {
+	QMutexLocker locker(&mVoxelDataMutex);
 //	mBaseImageData->UpdateInformation();
 	DoubleBoundingBox3D bounds(mBaseImageData->GetBounds());
 	return bounds;
@@ -345,93 +356,118 @@ DoubleBoundingBox3D Image::boundingBox() const
 
 Eigen::Array3d Image::getSpacing() const
 {
+	QMutexLocker locker(&mVoxelDataMutex);
 	return Eigen::Array3d(mBaseImageData->GetSpacing());
 }
 
-vtkImageAccumulatePtr Image::getHistogram()
+/** Return the cached statistics if computed from the current voxel data,
+ *  otherwise wait for the background computation or compute them now.
+ */
+ImageStatisticsPtr Image::getStatistics()
 {
-	if (mHistogramPtr.GetPointer() == NULL)
+	vtkImageDataPtr data = this->getBaseVtkImageData();
+	unsigned long mtime = data ? data->GetMTime() : 0;
+
+	QMutexLocker locker(&mStatisticsMutex);
+	if (mStatistics && mStatisticsMTime==mtime)
+		return mStatistics;
+
+	if (mStatisticsFuture.isStarted() && mStatisticsFutureMTime==mtime)
+		mStatistics = mStatisticsFuture.result();
+	else
+		mStatistics = ImageStatistics::create(data);
+	mStatisticsMTime = mtime;
+	mStatisticsFuture = QFuture<ImageStatisticsPtr>();
+	return mStatistics;
+}
+
+void Image::requestStatistics()
+{
+	if (!this->isVoxelDataLoaded())
+		return;
+	vtkImageDataPtr data = this->getBaseVtkImageData();
+	if (!data)
+		return;
+	unsigned long mtime = data->GetMTime();
+
+	QMutexLocker locker(&mStatisticsMutex);
+	if (mStatistics && mStatisticsMTime==mtime)
+		return;
+	if (mStatisticsFuture.isStarted() && mStatisticsFutureMTime==mtime)
+		return;
+
+	mStatisticsFuture = QtConcurrent::run([data]()
 	{
-		mHistogramPtr = vtkImageAccumulatePtr::New();
-		mHistogramPtr->SetInputData(this->getGrayScaleVtkImageData());
-		mHistogramPtr->IgnoreZeroOn(); // required for Sonowand CT volumes, where data are placed between 31K and 35K.
-		// Set up only a 1D histogram for now, so y and z values are set to 0
-		mHistogramPtr->SetComponentExtent(0, this->getRange(), 0, 0, 0, 0);
-		mHistogramPtr->SetComponentOrigin(this->getMin(), 0, 0);
-		mHistogramPtr->SetComponentSpacing(1, 0, 0);
-	}
-	mHistogramPtr->Update();
-	return mHistogramPtr;
+		return ImageStatistics::create(data);
+	});
+	mStatisticsFutureMTime = mtime;
 }
 
-template<typename scalartype> static int getRGBMax(vtkImageDataPtr image)
+void Image::resetStatistics()
 {
-	int max = 0;
-	vtkImageIterator<scalartype> iter(image, image->GetExtent());
-	while (!iter.IsAtEnd())
+	QMutexLocker locker(&mStatisticsMutex);
+	mStatistics.reset();
+	mStatisticsFuture = QFuture<ImageStatisticsPtr>();
+}
+
+ImagePyramidPtr Image::getPyramid()
+{
+	vtkImageDataPtr data = this->getBaseVtkImageData();
+	unsigned long mtime = data ? data->GetMTime() : 0;
+
+	QMutexLocker locker(&mPyramidMutex);
+	if (!mPyramid || mPyramidMTime!=mtime)
 	{
-		typename vtkImageIterator<scalartype>::SpanIterator siter = iter.BeginSpan();
-		while (siter != iter.EndSpan())
-		{
-			int value = *siter;
-			++siter;
-			value += *siter;
-			++siter;
-			value += *siter;
-			++siter;
-			if (value > max)
-			{
-				max = value;
-			}
-		}
-		iter.NextSpan();
+		if (mPyramid)
+			mPyramid->cancel(); // built from modified voxels
+		mPyramid = ImagePyramid::create(data);
+		mPyramidMTime = mtime;
+		mResampled.clear();
 	}
-	return max/3;
+	return mPyramid;
 }
 
+void Image::resetPyramid()
+{
+	QMutexLocker locker(&mPyramidMutex);
+	if (mPyramid)
+		mPyramid->cancel();
+	mPyramid.reset();
+	mResampled.clear();
+}
 
-int Image::getMax()
+/** Drop statistics made obsolete by the change, and start computing new
+ *  ones, thus they are ready when e.g. the transfer function widget is shown.
+ */
+void Image::vtkImageDataChangedSlot()
 {
-	// Alternatively create max from histogram
-	//IntIntMap::iterator iter = this->getHistogram()->end();
-	//iter--;
-	//return (*iter).first;
-	if (mBaseImageData->GetNumberOfScalarComponents() == 3)
+	if (!this->isVoxelDataLoaded())
+		return;
+	vtkImageDataPtr data;
 	{
-		if (mMaxRGBIntensity != -1)
-		{
-			return mMaxRGBIntensity;
-		}
-		double max = 0.0;
-		switch (mBaseImageData->GetScalarType())
-		{
-		case VTK_UNSIGNED_CHAR:
-			max = getRGBMax<unsigned char>(mBaseImageData);
-			break;
-		case VTK_UNSIGNED_SHORT:
-			max = getRGBMax<unsigned short>(mBaseImageData);
-			break;
-		default:
-			CX_LOG_ERROR() << "Unhandled RGB data type in image " << this->getUid();
-			break;
-		}
-		mMaxRGBIntensity = max;
-		return (int)mMaxRGBIntensity;
+		QMutexLocker locker(&mVoxelDataMutex);
+		data = mBaseImageData;
 	}
-	else
+	if (!data)
+		return;
+
 	{
-//		return (int) this->getTransferFunctions3D()->getScalarMax();
-		return mBaseImageData->GetScalarRange()[1];
+		QMutexLocker locker(&mStatisticsMutex);
+		if (!mStatistics || mStatisticsMTime==data->GetMTime())
+			return; // not in use, or still valid
+		mStatistics.reset();
 	}
+	this->requestStatistics();
+}
+
+int Image::getMax()
+{
+	return this->getStatistics()->getMax();
 }
 
 int Image::getMin()
 {
-	// Alternatively create min from histogram
-	//IntIntMap::iterator iter = this->getHistogram()->begin();
-	//return (*iter).first;
-	return mBaseImageData->GetScalarRange()[0];
-//	return (int) this->getTransferFunctions3D()->getScalarMin();
+	return this->getStatistics()->getMin();
 }
 
 int Image::getRange()
@@ -446,7 +482,7 @@ int Image::getMaxAlphaValue()
 
 double Image::getVTKMinValue()
 {
-	int vtkScalarType = mBaseImageData->GetScalarType();
+	int vtkScalarType = this->getBaseVtkImageData()->GetScalarType();
 
 	if (vtkScalarType==VTK_CHAR)
 		return VTK_CHAR_MIN;
@@ -471,7 +507,7 @@ double Image::getVTKMinValue()
 
 double Image::getVTKMaxValue()
 {
-	int vtkScalarType = mBaseImageData->GetScalarType();
+	int vtkScalarType = this->getBaseVtkImageData()->GetScalarType();
 
 	if (vtkScalarType==VTK_CHAR)
 		return VTK_CHAR_MAX;
@@ -496,7 +532,7 @@ double Image::getVTKMaxValue()
 
 bool Image::is2D()
 {
-	return this->getBaseVtkImageData()->GetDimensions()[2]==1;
+	return mBaseImageData->GetDimensions()[2]==1;
 }
 
 void Image::addXml(QDomNode& dataNode)
@@ -573,6 +609,211 @@ bool Image::load(QString path, FileManagerServicePtr filemanager)
 	return this->getBaseVtkImageData()!=0;
 }
 
+bool Image::loadHeader(QString path, FileManagerServicePtr filemanager)
+{
+	// .mha files contain the voxel data after the header, reading them as text is too slow
+	if (QFileInfo(path).suffix().compare("mhd", Qt::CaseInsensitive) != 0)
+		return false;
+	if (!QFileInfo(path).exists())
+		return false;
+
+	CustomMetaImagePtr header = CustomMetaImage::create(path);
+	QStringList dimensions = header->readKey("DimSize").split(" ", QString::SkipEmptyParts);
+	QStringList spacing = header->readKey("ElementSpacing").split(" ", QString::SkipEmptyParts);
+	if (dimensions.size() < 2)
+		return false;
+
+	Eigen::Array3i dim(1, 1, 1);
+	Eigen::Array3d space(1, 1, 1);
+	for (int i=0; i<3; ++i)
+	{
+		if (i < dimensions.size())
+			dim[i] = dimensions[i].toInt();
+		if (i < spacing.size())
+			space[i] = spacing[i].toDouble();
+	}
+
+	// geometry only, the origin is zeroed as when reading the voxel data
+	vtkImageDataPtr geometry = vtkImageDataPtr::New();
+	geometry->SetExtent(0, dim[0]-1, 0, dim[1]-1, 0, dim[2]-1);
+	geometry->SetSpacing(space.data());
+
+	{
+		QMutexLocker locker(&mVoxelDataMutex);
+		mBaseImageData = geometry;
+		mBaseGrayScaleImageData = NULL;
+		this->resetStatistics();
+		this->resetPyramid();
+		mVoxelDataFilename = path;
+		mVoxelDataFileManager = filemanager;
+		mVoxelDataFuture = QFuture<vtkImageDataPtr>();
+		mVoxelDataRequested = false;
+		mVoxelDataLoaded = false;
+		mLastVoxelDataAccess = getMilliSecondsSinceEpoch();
+	}
+
+	this->get_rMd_History()->setRegistration(header->readTransform());
+	this->setModality(header->readModality());
+	this->setImageType(header->readImageType());
+
+	bool ok1 = true;
+	bool ok2 = true;
+	double level = header->readKey("WindowLevel").toDouble(&ok1);
+	double window = header->readKey("WindowWidth").toDouble(&ok2);
+	if (ok1 && ok2)
+		this->setInitialWindowLevel(window, level);
+
+	emit vtkImageDataChanged(mUid);
+	return true;
+}
+
+bool Image::isVoxelDataLoaded() const
+{
+	QMutexLocker locker(&mVoxelDataMutex);
+	return mVoxelDataFilename.isEmpty() || mVoxelDataLoaded;
+}
+
+void Image::requestVoxelData()
+{
+	QMutexLocker locker(&mVoxelDataMutex);
+	if (mVoxelDataFilename.isEmpty() || mVoxelDataLoaded || mVoxelDataRequested)
+		return;
+
+	FileManagerServicePtr filemanager = mVoxelDataFileManager;
+	QString filename = mVoxelDataFilename;
+	mVoxelDataFuture = QtConcurrent::run([filemanager, filename]()
+	{
+		return filemanager->loadVtkImageData(filename);
+	});
+	mVoxelDataRequested = true;
+}
+
+/** Read the voxel data, or wait for the read started by requestVoxelData().
+ *  Return the voxel data, taken while locked, thus they stay valid if
+ *  another thread calls purgeVoxelData(). justLoaded is set if this call
+ *  read the data. Can be called from any thread.
+ */
+vtkImageDataPtr Image::loadVoxelData(bool* justLoaded)
+{
+	QMutexLocker locker(&mVoxelDataMutex);
+	if (mVoxelDataFilename.isEmpty())
+		return mBaseImageData;
+	mLastVoxelDataAccess = getMilliSecondsSinceEpoch();
+	if (mVoxelDataLoaded)
+		return mBaseImageData;
+
+	vtkImageDataPtr data;
+	if (mVoxelDataRequested)
+		data = mVoxelDataFuture.result();
+	else
+		data = mVoxelDataFileManager->loadVtkImageData(mVoxelDataFilename);
+	mVoxelDataFuture = QFuture<vtkImageDataPtr>();
+	mVoxelDataRequested = false;
+
+	if (!data)
+	{
+		reportError(QString("Failed to read voxel data for image %1 from %2").arg(mUid).arg(mVoxelDataFilename));
+		return mBaseImageData;
+	}
+
+	// detach from the reader pipeline, thus this is the only reference to the data
+	mBaseImageData = vtkImageDataPtr::New();
+	mBaseImageData->ShallowCopy(data);
+	mBaseGrayScaleImageData = NULL;
+	unsigned long previousMTime = mVoxelDataMTime;
+	mVoxelDataMTime = mBaseImageData->GetMTime();
+	mVoxelDataLoaded = true;
+
+	{
+		// reread after purgeVoxelData(): statistics from the previous read are still valid
+		QMutexLocker statisticsLocker(&mStatisticsMutex);
+		if (mStatistics && previousMTime!=0 && mStatisticsMTime==previousMTime)
+			mStatisticsMTime = mVoxelDataMTime;
+	}
+	if (justLoaded)
+		*justLoaded = true;
+	return mBaseImageData;
+}
+
+/** Drop the voxel data if they can be reread from file. Emits
+ *  vtkImageDataChanged, thus users fetch the data again when needed.
+ */
+bool Image::purgeVoxelData()
+{
+	{
+		QMutexLocker locker(&mVoxelDataMutex);
+		if (mVoxelDataFilename.isEmpty() || !mVoxelDataLoaded)
+			return false;
+		if (mBaseImageData->GetMTime() != mVoxelDataMTime)
+			return false; // modified after reading, the file is not up to date
+
+		// drop cached derived data, they are recreated on demand. Statistics are small and kept.
+		mBaseGrayScaleImageData = NULL;
+		this->resetPyramid();
+		if (mBaseImageData->GetReferenceCount() > 1)
+			return false; // in use, e.g. shown in a view
+
+		vtkImageDataPtr geometry = vtkImageDataPtr::New();
+		geometry->CopyStructure(mBaseImageData);
+		mBaseImageData = geometry;
+		mVoxelDataLoaded = false;
+	}
+	emit vtkImageDataChanged(mUid);
+	return true;
+}
+
+double Image::getLastVoxelDataAccessTime() const
+{
+	QMutexLocker locker(&mVoxelDataMutex);
+	return mLastVoxelDataAccess;
+}
+
+unsigned long Image::getLazyVoxelDataMemorySize() const
+{
+	QMutexLocker locker(&mVoxelDataMutex);
+	if (mVoxelDataFilename.isEmpty() || !mVoxelDataLoaded)
+		return 0;
+	return mBaseImageData->GetActualMemorySize();
+}
+
+void Image::clearVoxelDataSource()
+{
+	QMutexLocker locker(&mVoxelDataMutex);
+	mVoxelDataFilename.clear();
+	mVoxelDataFileManager.reset();
+	mVoxelDataFuture = QFuture<vtkImageDataPtr>();
+	mVoxelDataRequested = false;
+	mVoxelDataLoaded = false;
+}
+
+/** True if filename is the file the voxel data are read lazily from,
+ *  and the data have not been changed since.
+ */
+bool Image::isVoxelDataUnchangedInFile(QString filename)
+{
+	QMutexLocker locker(&mVoxelDataMutex);
+	if (mVoxelDataFilename.isEmpty())
+		return false;
+	QString source = QFileInfo(mVoxelDataFilename).canonicalFilePath();
+	if (source.isEmpty() || source != QFileInfo(filename).canonicalFilePath())
+		return false;
+	return !mVoxelDataLoaded || (mBaseImageData->GetMTime() == mVoxelDataMTime);
+}
+
+/** Write the image properties to an existing MetaImage header,
+ *  as done by the file writer after writing the voxel data.
+ */
+void Image::saveHeader(QString filename)
+{
+	CustomMetaImagePtr header = CustomMetaImage::create(filename);
+	header->setTransform(this->get_rMd());
+	header->setModality(this->getModality());
+	header->setImageType(this->getImageType());
+	header->setKey("WindowLevel", qstring_cast(this->getInitialWindowLevel()));
+	header->setKey("WindowWidth", qstring_cast(this->getInitialWindowWidth()));
+	header->write();
+}
+
 void Image::parseXml(QDomNode& dataNode)
 {
 	Data::parseXml(dataNode);
@@ -586,7 +827,12 @@ void Image::parseXml(QDomNode& dataNode)
 	//transferefunctions
 	QDomNode transferfunctionsNode = dataNode.namedItem("transferfunctions");
 	if (!transferfunctionsNode.isNull())
+	{
+		// the stored functions replace the defaults: avoid reading lazy voxel data to generate them
+		if (!mImageTransferFunctions3D && !this->isVoxelDataLoaded())
+			this->resetTransferFunction(ImageTF3DPtr(new ImageTF3D()));
 		this->getUnmodifiedTransferFunctions3D()->parseXml(transferfunctionsNode);
+	}
 	else
 	{
 		std::cout << "Warning: Image::parseXml() found no transferfunctions";
@@ -596,7 +842,10 @@ void Image::parseXml(QDomNode& dataNode)
 	mInitialWindowWidth = this->loadAttribute(dataNode.namedItem("initialWindow"), "width", mInitialWindowWidth);
 	mInitialWindowLevel = this->loadAttribute(dataNode.namedItem("initialWindow"), "level", mInitialWindowLevel);
 
-	this->getUnmodifiedLookupTable2D()->parseXml(dataNode.namedItem("lookuptable2D"));
+	QDomNode lookupTable2DNode = dataNode.namedItem("lookuptable2D");
+	if (!lookupTable2DNode.isNull() && !mImageLookupTable2D && !this->isVoxelDataLoaded())
+		this->resetTransferFunction(ImageLUT2DPtr(new ImageLUT2D()));
+	this->getUnmodifiedLookupTable2D()->parseXml(lookupTable2DNode);
 
 	// backward compatibility:
 	mShading.on = dataNode.namedItem("shading").toElement().text().toInt();
@@ -767,6 +1016,7 @@ void Image::mergevtkSettingsIntosscTransform()
 {
 	// the internal CustusX format does not handle extents starting at non-zero.
 	// Move extent to zero and change rMd.
+	this->getBaseVtkImageData();
 	Vector3D origin(mBaseImageData->GetOrigin());
 	Vector3D spacing(mBaseImageData->GetSpacing());
 	IntBoundingBox3D extent(mBaseImageData->GetExtent());
@@ -866,14 +1116,34 @@ int Image::getInterpolationType() const
 	return mInterpolationType;
 }
 
+/** Resample from the nearest pyramid level at or above the budget, thus
+ *  the result is close to maxVoxels, and the resampling reads at most
+ *  8 times the output size. Results are cached per budget until the voxel
+ *  data change, e.g. when a view switches between preview and full quality.
+ */
 vtkImageDataPtr Image::resample(long maxVoxels)
 {
+	ImagePyramidPtr pyramid = this->getPyramid();
+	{
+		QMutexLocker locker(&mPyramidMutex);
+		std::map<long, vtkImageDataPtr>::iterator iter = mResampled.find(maxVoxels);
+		if (iter!=mResampled.end() && pyramid==mPyramid)
+			return iter->second;
+	}
+
 	// also use grayscale as vtk is incapable of rendering 3component color.
-	vtkImageDataPtr retval = this->getGrayScaleVtkImageData();
+	int level = pyramid->findSourceLevel(maxVoxels);
+	vtkImageDataPtr retval;
+	if (level==0)
+		retval = this->getGrayScaleVtkImageData();
+	else
+		retval = convertImageDataToGrayScale(pyramid->getLevel(level));
 
-	double factor = computeResampleFactor(maxVoxels);
+	double factor = 1.0;
+	if (maxVoxels>0 && retval->GetNumberOfPoints()>0)
+		factor = pow(double(maxVoxels)/double(retval->GetNumberOfPoints()), 1.0/3.0);
 
-	if (fabs(1.0-factor)>0.01) // resampling
+	if (factor<0.99) // resampling
 	{
 		vtkImageResamplePtr resampler = vtkImageResamplePtr::New();
 		resampler->SetInterpolationModeToLinear();
@@ -881,37 +1151,41 @@ vtkImageDataPtr Image::resample(long maxVoxels)
 		resampler->SetAxisMagnificationFactor(1, factor);
 		resampler->SetAxisMagnificationFactor(2, factor);
 		resampler->SetInputData(retval);
-//		resampler->GetOutput()->Update();
 		resampler->Update();
 		resampler->GetOutput()->GetScalarRange();
 		retval = resampler->GetOutput();
+	}
 
-//		long voxelsDown = retval->GetNumberOfPoints();
-//		long voxelsOrig = this->getBaseVtkImageData()->GetNumberOfPoints();
-//		report("Created downsampled volume in Image: "
-//									 + this->getName()
-//									 + " below " + qstring_cast(voxelsDown/1000/1000) + "M. "
-//									 + "Ratio: " + QString::number(factor, 'g', 2) + ", "
-//									 + "Original size: " + qstring_cast(voxelsOrig/1000/1000) + "M.");
+	QMutexLocker locker(&mPyramidMutex);
+	if (pyramid==mPyramid)
+	{
+		if (mResampled.size() >= 4)
+			mResampled.clear();
+		mResampled[maxVoxels] = retval;
 	}
 	return retval;
 }
 
-double Image::computeResampleFactor(long maxVoxels)
+bool Image::isResampleReady(long maxVoxels)
 {
-	if (maxVoxels==0)
-		return 1.0;
+	ImagePyramidPtr pyramid = this->getPyramid();
+	int level = pyramid->findSourceLevel(maxVoxels);
+	return level==0 || pyramid->isBuilt(level);
+}
 
-	long voxels = this->getBaseVtkImageData()->GetNumberOfPoints();
-	double factor = (double)maxVoxels/(double)voxels;
-	factor = pow(factor, 1.0/3.0);
-	// cubic function leads to trouble for 138M-volume - must downsample to as low as 5-10 Mv in order to succeed on Mac.
+QFuture<void> Image::requestResample(long maxVoxels)
+{
+	ImagePyramidPtr pyramid = this->getPyramid();
+	return pyramid->requestLevel(pyramid->findSourceLevel(maxVoxels));
+}
 
-	if (factor<0.99)
-	{
-		return factor;
-	}
-	return 1.0;
+vtkImageDataPtr Image::getCoarseResample(long maxVoxels)
+{
+	ImagePyramidPtr pyramid = this->getPyramid();
+	for (int level=pyramid->findSourceLevel(maxVoxels)+1; level<pyramid->getNumberOfLevels(); ++level)
+		if (pyramid->isBuilt(level))
+			return convertImageDataToGrayScale(pyramid->getLevel(level));
+	return vtkImageDataPtr();
 }
 
 void Image::save(const QString& basePath, FileManagerServicePtr filemanager)
@@ -919,6 +1193,12 @@ void Image::save(const QString& basePath, FileManagerServicePtr filemanager)
 	QString filename = basePath + "/Images/" + this->getUid() + ".mhd";
 	this->setFilename(QDir(basePath).relativeFilePath(filename));
 
+	if (this->isVoxelDataUnchangedInFile(filename))
+	{
+		this->saveHeader(filename);
+		return;
+	}
+
 	ImagePtr self = ImagePtr(this, null_deleter());
 	filemanager->save(self, filename);
 }
@@ -19,10 +19,14 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <map>
 #include <vector>
 #include <boost/shared_ptr.hpp>
+#include <QFuture>
+#include <QMutex>
 #include "cxBoundingBox3D.h"
 #include "vtkForwardDeclarations.h"
 #include "cxForwardDeclarations.h"
 #include "cxData.h"
+#include "cxImageStatistics.h"
+#include "cxImagePyramid.h"
 
 typedef boost::shared_ptr<std::map<int, int> > HistogramMapPtr;
 
@@ -40,6 +44,12 @@ typedef std::map<int, QColor> ColorMap;
  * One volumetric data set, represented as a vtkImageData,
  * along with auxiliary data.
  *
+ * The image can be read lazily from a MetaImage file, see loadHeader():
+ * Only the header is read initially, giving the geometry of the image,
+ * and the voxel data are read on first access through
+ * getBaseVtkImageData(). Voxel data read this way can be released
+ * again with purgeVoxelData() when not in use.
+ *
  * \ingroup cx_resource_core_data
  */
 class cxResource_EXPORT Image : public Data
@@ -98,9 +108,18 @@ public:
 
 	virtual DoubleBoundingBox3D boundingBox() const; ///< bounding box in image space
 	virtual Eigen::Array3d getSpacing() const;
-	virtual vtkImageAccumulatePtr getHistogram();///< \return The histogram for the image
-	virtual int getMax();	///< \return Return highest used value in the image
-	virtual int getMin();	///< \return Return lowest used value in the image
+	/** Statistics for the voxel values: histogram, min/max, mean and percentiles.
+	 *  Computed on first access, or in the background by requestStatistics(),
+	 *  and cached until the voxel data change. Can be called from any thread.
+	 */
+	ImageStatisticsPtr getStatistics();
+	void requestStatistics(); ///< start computing the statistics in the background, if not cached. Lazily read images are not loaded.
+	/** Multiresolution pyramid of the voxel data. Levels are built on demand,
+	 *  and cached until the voxel data change. Can be called from any thread.
+	 */
+	ImagePyramidPtr getPyramid();
+	virtual int getMax();	///< \return Return highest used value in the image. RGB images use intensity, the mean of the components.
+	virtual int getMin();	///< \return Return lowest used value in the image. RGB images use intensity, as getMax(). Before, the first component was used.
 	virtual int getRange();///< For convenience: getMax() - getMin()
 	virtual int getMaxAlphaValue();///<Max alpha value (probably 255)
 	virtual void setShadingOn(bool on);
@@ -119,6 +138,20 @@ public:
 	void addXml(QDomNode& dataNode); ///< adds xml information about the image and its variabels \param dataNode Data node in the XML tree \return The created subnode
 	virtual void parseXml(QDomNode& dataNode);///< Use a XML node to load data. \param dataNode A XML data representation of this object.
 	virtual bool load(QString path, FileManagerServicePtr filemanager);
+	/** Read only the header of a MetaImage (.mhd) file: geometry, transform,
+	 *  modality and initial window. The voxel data are read from the file
+	 *  on first access. Return false if the file cannot be read this way.
+	 */
+	virtual bool loadHeader(QString path, FileManagerServicePtr filemanager);
+	bool isVoxelDataLoaded() const; ///< false if the voxel data are yet to be read from file
+	void requestVoxelData(); ///< start reading the voxel data in the background, if not loaded
+	/** Release voxel data that have been read lazily, if unchanged and not
+	 *  used by anyone else. They are read again on next access.
+	 *  Return true if the data were released.
+	 */
+	bool purgeVoxelData();
+	double getLastVoxelDataAccessTime() const; ///< time of last access to lazily read voxel data, ms since epoch
+	unsigned long getLazyVoxelDataMemorySize() const; ///< kB used by lazily read voxel data, 0 if not loaded
 	virtual QString getType() const
 	{
 		return getTypeName();
@@ -148,12 +181,16 @@ public:
 	void setInterpolationType(int val);
 	int getInterpolationType() const;
 
-	vtkImageDataPtr resample(long maxVoxels);
+	vtkImageDataPtr resample(long maxVoxels); ///< grayscale image with about maxVoxels voxels, resampled from the pyramid. 0 means full resolution.
+	bool isResampleReady(long maxVoxels); ///< resample() will not build pyramid levels
+	QFuture<void> requestResample(long maxVoxels); ///< build the pyramid levels needed by resample() in the background
+	vtkImageDataPtr getCoarseResample(long maxVoxels); ///< grayscale of the finest built pyramid level below maxVoxels, to show while resample() is not ready. NULL if none.
 
 	virtual void save(const QString &basePath, FileManagerServicePtr filemanager);
 
 	void startThresholdPreview(const Eigen::Vector2d& threshold);
 	void stopThresholdPreview();
+	bool isThresholdPreview() const { return mThresholdPreview; }
 	double getVTKMinValue();
 	double getVTKMaxValue();
 	bool is2D();
@@ -165,6 +202,8 @@ signals:
 
 protected slots:
 	virtual void transformChangedSlot();
+private slots:
+	void vtkImageDataChangedSlot();
 
 protected:
 	vtkImageDataPtr mBaseImageData; ///< image data in data space
@@ -172,7 +211,6 @@ protected:
 //	vtkImageReslicePtr mOrientator; ///< converts imagedata to outputimagedata
 //	vtkMatrix4x4Ptr mOrientatorMatrix;
 //	vtkImageDataPtr mReferenceImageData; ///< imagedata after filtering through the orientatior, given in reference space
-	vtkImageAccumulatePtr mHistogramPtr;///< Histogram
 	ImagePtr mUnsigned; ///< version of this containing unsigned data.
 
 //	LandmarksPtr mLandmarks;
@@ -184,7 +222,6 @@ protected:
 
 	QString mModality; ///< modality of the image, defined as DICOM tag (0008,0060), Section 3, C.7.3.1.1.1
 	QString mImageType; ///< type of the image, defined as DICOM tag (0008,0008) (mainly value 3, but might be a merge of value 4), Section 3, C.7.6.1.1.2
-	double mMaxRGBIntensity;
 	int mInterpolationType; ///< mirror the interpolationType in vtkVolumeProperty
 
 
@@ -197,8 +234,6 @@ private:
 	DoubleBoundingBox3D getInitialBoundingBox() const;
 	double loadAttribute(QDomNode dataNode, QString name, double defVal);
 
-	double computeResampleFactor(long maxVoxels);
-
 	ColorMap createPreviewColorMap(const Eigen::Vector2d &threshold);
 	IntIntMap createPreviewOpacityMap(const Eigen::Vector2d &threshold);
 	void createThresholdPreviewTransferFunctions3D(const Eigen::Vector2d &threshold);
@@ -207,6 +242,13 @@ private:
 	ImageTF3DPtr getUnmodifiedTransferFunctions3D();
 	ImageLUT2DPtr getUnmodifiedLookupTable2D();
 
+	vtkImageDataPtr loadVoxelData(bool* justLoaded=NULL);
+	void clearVoxelDataSource();
+	bool isVoxelDataUnchangedInFile(QString filename);
+	void saveHeader(QString filename);
+	void resetStatistics();
+	void resetPyramid();
+
 	ImageTF3DPtr mImageTransferFunctions3D;
 	ImageLUT2DPtr mImageLookupTable2D;
 
@@ -216,6 +258,26 @@ private:
 	bool mThresholdPreview;
 	ImageTF3DPtr mTresholdPreviewTransferfunctions3D;
 	ImageLUT2DPtr mTresholdPreviewLookupTable2D;
+
+	QString mVoxelDataFilename; ///< file to read voxel data from, empty if not read lazily
+	FileManagerServicePtr mVoxelDataFileManager;
+	QFuture<vtkImageDataPtr> mVoxelDataFuture;
+	bool mVoxelDataRequested;
+	bool mVoxelDataLoaded;
+	unsigned long mVoxelDataMTime; ///< MTime of the voxel data when read, used to detect changes
+	double mLastVoxelDataAccess;
+	mutable QMutex mVoxelDataMutex;
+
+	ImageStatisticsPtr mStatistics;
+	unsigned long mStatisticsMTime; ///< MTime of the voxel data the statistics were computed from
+	QFuture<ImageStatisticsPtr> mStatisticsFuture;
+	unsigned long mStatisticsFutureMTime;
+	mutable QMutex mStatisticsMutex; ///< lock order: mVoxelDataMutex before mStatisticsMutex
+
+	ImagePyramidPtr mPyramid;
+	unsigned long mPyramidMTime; ///< MTime of the voxel data the pyramid was built from
+	std::map<long, vtkImageDataPtr> mResampled; ///< resample() results from mPyramid, per voxel budget
+	mutable QMutex mPyramidMutex; ///< lock order: mVoxelDataMutex before mPyramidMutex
 };
 
 } // end namespace cx
@@ -42,7 +42,7 @@ public:
 private:
 	ImagePtr mImage;
 	double_pair guessInitialScalarRange() const;
-	double_pair getFullScalarRange() const;
+	double_pair getFullScalarRange() const; ///< range of the image statistics, i.e. of the intensity for RGB images
 	double_pair getInitialWindowRange() const;
 	bool hasValidInitialWindow() const;
 	double_pair guessMRRange() const;
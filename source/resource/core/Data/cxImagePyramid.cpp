@@ -0,0 +1,276 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#include "cxImagePyramid.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
+#include <vtkImageData.h>
+
+namespace cx
+{
+
+namespace
+{
+Eigen::Array3i getDecimatedDimensions(const Eigen::Array3i& dim)
+{
+	return (dim+1)/2; // axes of size 1 are kept
+}
+
+template<class T> T toScalar(double value)
+{
+	if (std::numeric_limits<T>::is_integer)
+		return T(std::floor(value + 0.5));
+	return T(value);
+}
+
+/** Average blocks of step voxels in input into one z-slice of output.
+ */
+template<class T> void decimateSlice(const T* input, T* output, const Eigen::Array3i& inDim, const Eigen::Array3i& outDim, const Eigen::Array3i& step, int components, int z)
+{
+	std::vector<double> sum(components);
+	int z0 = z*step[2];
+	int z1 = std::min(z0+step[2], inDim[2]);
+	for (int y=0; y<outDim[1]; ++y)
+	{
+		int y0 = y*step[1];
+		int y1 = std::min(y0+step[1], inDim[1]);
+		for (int x=0; x<outDim[0]; ++x)
+		{
+			int x0 = x*step[0];
+			int x1 = std::min(x0+step[0], inDim[0]);
+
+			std::fill(sum.begin(), sum.end(), 0.0);
+			int count = 0;
+			for (int k=z0; k<z1; ++k)
+				for (int j=y0; j<y1; ++j)
+					for (int i=x0; i<x1; ++i)
+					{
+						const T* voxel = input + components*(i + vtkIdType(inDim[0])*(j + vtkIdType(inDim[1])*k));
+						for (int c=0; c<components; ++c)
+							sum[c] += voxel[c];
+						++count;
+					}
+
+			T* target = output + components*(x + vtkIdType(outDim[0])*(y + vtkIdType(outDim[1])*z));
+			for (int c=0; c<components; ++c)
+				target[c] = toScalar<T>(sum[c]/count);
+		}
+	}
+}
+
+/** Decimate input into output, skipping the remaining slices if cancel is set.
+ */
+template<class T> void decimateVolume(vtkImageDataPtr input, vtkImageDataPtr output, const Eigen::Array3i& step, const QAtomicInt* cancel)
+{
+	Eigen::Array3i inDim(input->GetDimensions());
+	Eigen::Array3i outDim(output->GetDimensions());
+	int components = input->GetNumberOfScalarComponents();
+	const T* in = static_cast<const T*>(input->GetScalarPointer());
+	T* out = static_cast<T*>(output->GetScalarPointer());
+
+	std::vector<int> slices(outDim[2]);
+	for (unsigned z=0; z<slices.size(); ++z)
+		slices[z] = z;
+	QtConcurrent::blockingMap(slices, [&](int& z)
+	{
+		if (cancel && cancel->loadAcquire())
+			return;
+		decimateSlice(in, out, inDim, outDim, step, components, z);
+	});
+}
+} // namespace
+
+ImagePyramidPtr ImagePyramid::create(vtkImageDataPtr base)
+{
+	return ImagePyramidPtr(new ImagePyramid(base));
+}
+
+ImagePyramid::ImagePyramid(vtkImageDataPtr base) :
+	mCancelled(0)
+{
+	if (!base)
+		return;
+	Eigen::Array3i dim(base->GetDimensions());
+	mDimensions.push_back(dim);
+	while ((dim>1).any())
+	{
+		dim = getDecimatedDimensions(dim);
+		mDimensions.push_back(dim);
+	}
+	mLevels.resize(mDimensions.size());
+	mLevels[0] = base;
+}
+
+Eigen::Array3i ImagePyramid::getDimensions(int level) const
+{
+	if (level<0 || level>=this->getNumberOfLevels())
+		return Eigen::Array3i::Zero();
+	return mDimensions[level];
+}
+
+long ImagePyramid::getNumberOfVoxels(int level) const
+{
+	Eigen::Array3i dim = this->getDimensions(level);
+	return long(dim[0])*dim[1]*dim[2];
+}
+
+int ImagePyramid::findLevel(long maxVoxels) const
+{
+	if (maxVoxels<=0)
+		return 0;
+	for (int level=0; level<this->getNumberOfLevels(); ++level)
+		if (this->getNumberOfVoxels(level) <= maxVoxels)
+			return level;
+	return std::max(this->getNumberOfLevels()-1, 0);
+}
+
+int ImagePyramid::findSourceLevel(long maxVoxels) const
+{
+	if (maxVoxels<=0)
+		return 0;
+	for (int level=this->getNumberOfLevels()-1; level>0; --level)
+		if (this->getNumberOfVoxels(level) >= maxVoxels)
+			return level;
+	return 0;
+}
+
+vtkImageDataPtr ImagePyramid::getLevel(int level)
+{
+	return this->getLevel(level, false);
+}
+
+vtkImageDataPtr ImagePyramid::getLevel(int level, bool cancellable)
+{
+	if (level<0 || level>=this->getNumberOfLevels())
+		return vtkImageDataPtr();
+	{
+		QMutexLocker locker(&mMutex);
+		if (mLevels[level])
+			return mLevels[level];
+	}
+	QMutexLocker buildLocker(&mBuildMutex);
+	return this->build(level, cancellable);
+}
+
+vtkImageDataPtr ImagePyramid::getLevelWithin(long maxVoxels)
+{
+	return this->getLevel(this->findLevel(maxVoxels));
+}
+
+bool ImagePyramid::isBuilt(int level) const
+{
+	if (level<0 || level>=this->getNumberOfLevels())
+		return false;
+	QMutexLocker locker(&mMutex);
+	return mLevels[level];
+}
+
+QFuture<void> ImagePyramid::requestLevel(int level)
+{
+	if (level<0 || level>=this->getNumberOfLevels())
+		return QFuture<void>();
+	if (this->isBuilt(level) || this->isCancelled())
+		return QFuture<void>();
+
+	// the task owns the pyramid, thus the pyramid is never deleted while building
+	ImagePyramidPtr self = this->shared_from_this();
+	return QtConcurrent::run([self, level]()
+	{
+		self->getLevel(level, true);
+	});
+}
+
+void ImagePyramid::cancel()
+{
+	mCancelled.storeRelease(1);
+}
+
+bool ImagePyramid::isCancelled() const
+{
+	return mCancelled.loadAcquire();
+}
+
+/** Build level from the nearest built finer level. Call with mBuildMutex locked.
+ *  If cancellable, stop when cancelled and return zero.
+ */
+vtkImageDataPtr ImagePyramid::build(int level, bool cancellable)
+{
+	QMutexLocker locker(&mMutex);
+	int first = level;
+	while (!mLevels[first])
+		--first;
+	vtkImageDataPtr current = mLevels[first];
+	locker.unlock();
+
+	const QAtomicInt* cancel = cancellable ? &mCancelled : NULL;
+	for (int i=first+1; i<=level; ++i)
+	{
+		current = decimate(current, cancel);
+		if (!current)
+			return current;
+		locker.relock();
+		mLevels[i] = current;
+		locker.unlock();
+	}
+	return current;
+}
+
+vtkImageDataPtr ImagePyramid::decimate(vtkImageDataPtr input)
+{
+	return decimate(input, NULL);
+}
+
+/** Decimate input, return zero if cancel is set before all slices are done.
+ */
+vtkImageDataPtr ImagePyramid::decimate(vtkImageDataPtr input, const QAtomicInt* cancel)
+{
+	if (!input || (cancel && cancel->loadAcquire()))
+		return vtkImageDataPtr();
+
+	Eigen::Array3i dim(input->GetDimensions());
+	int* extent = input->GetExtent();
+	double* spacing = input->GetSpacing();
+	double* origin = input->GetOrigin();
+	Eigen::Array3i outDim = getDecimatedDimensions(dim);
+
+	Eigen::Array3i step;
+	Vector3D outSpacing;
+	Vector3D outOrigin;
+	for (int i=0; i<3; ++i)
+	{
+		step[i] = (dim[i]>1) ? 2 : 1;
+		// center of the first block, a partial last block is placed as a full one
+		outSpacing[i] = spacing[i]*step[i];
+		outOrigin[i] = origin[i] + spacing[i]*(extent[2*i] + 0.5*(step[i]-1));
+	}
+
+	vtkImageDataPtr retval = vtkImageDataPtr::New();
+	retval->SetExtent(0, outDim[0]-1, 0, outDim[1]-1, 0, outDim[2]-1);
+	retval->SetSpacing(outSpacing.data());
+	retval->SetOrigin(outOrigin.data());
+	retval->AllocateScalars(input->GetScalarType(), input->GetNumberOfScalarComponents());
+
+	if (!input->GetScalarPointer() || (outDim==0).any())
+		return retval;
+
+	switch (input->GetScalarType())
+	{
+		vtkTemplateMacro(decimateVolume<VTK_TT>(input, retval, step, cancel));
+	}
+	if (cancel && cancel->loadAcquire())
+		return vtkImageDataPtr(); // slices may be missing
+	return retval;
+}
+
+} // namespace cx
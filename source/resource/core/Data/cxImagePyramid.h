@@ -0,0 +1,102 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXIMAGEPYRAMID_H
+#define CXIMAGEPYRAMID_H
+
+#include "cxResourceExport.h"
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <QFuture>
+#include <QMutex>
+#include <QAtomicInt>
+#include "vtkForwardDeclarations.h"
+#include "cxVector3D.h"
+
+namespace cx
+{
+typedef boost::shared_ptr<class ImagePyramid> ImagePyramidPtr;
+
+/**
+ * Multiresolution pyramid of an image.
+ *
+ * Level 0 is the image itself. Each following level is made from the
+ * previous one by 2x box decimation: Every axis with more than one voxel
+ * is halved (rounded up), and each output voxel is the mean of the 2x2x2
+ * input voxels it covers, placed at the center of the block with twice
+ * the input spacing. With odd dimensions the last block along an axis is
+ * partial, but placed as a full block, i.e. half an input voxel beyond
+ * the voxel it averages: The region covered by a level is then only
+ * approximately that of the base image, extending up to one voxel of
+ * the level beyond its upper end. The last level has one voxel along
+ * all axes.
+ *
+ * All scalar types are supported, each component is averaged separately.
+ * Integer types are rounded to nearest.
+ *
+ * Levels are built on demand from the next finer level, with the slices
+ * processed in parallel. Use findLevel() to get the finest level within
+ * a voxel budget, and requestLevel() to build a finer level in the
+ * background while a coarser one is in use, keeping the building off
+ * the GUI thread. A background build keeps the pyramid alive until it
+ * finishes, thus releasing the pyramid never waits for it.
+ *
+ * The base image must not be modified while the pyramid is in use:
+ * Call cancel() on a pyramid made obsolete by a modified base, this
+ * stops the background builds at the next slice.
+ * Can be used from any thread.
+ *
+ * \ingroup cx_resource_core_data
+ * \date 2026-10-18
+ */
+class cxResource_EXPORT ImagePyramid : public boost::enable_shared_from_this<ImagePyramid>
+{
+public:
+	static ImagePyramidPtr create(vtkImageDataPtr base);
+
+	int getNumberOfLevels() const { return int(mDimensions.size()); }
+	Eigen::Array3i getDimensions(int level) const; ///< dimensions of level, without building it
+	long getNumberOfVoxels(int level) const;
+	/** Finest level with at most maxVoxels voxels, or the coarsest level if none are small enough.
+	 *  maxVoxels==0 means no limit, i.e. level 0.
+	 */
+	int findLevel(long maxVoxels) const;
+	/** Coarsest level with at least maxVoxels voxels, i.e. the level to resample
+	 *  from in order to get maxVoxels voxels. maxVoxels==0 means level 0.
+	 */
+	int findSourceLevel(long maxVoxels) const;
+
+	vtkImageDataPtr getLevel(int level); ///< get level, build it and all finer levels if necessary
+	vtkImageDataPtr getLevelWithin(long maxVoxels); ///< getLevel(findLevel(maxVoxels))
+	bool isBuilt(int level) const;
+	QFuture<void> requestLevel(int level); ///< start building level in the background, if not built. The future finishes when the level is built or the build is cancelled.
+	void cancel(); ///< stop all background builds, the levels they have not finished are left unbuilt
+	bool isCancelled() const;
+
+	static vtkImageDataPtr decimate(vtkImageDataPtr input); ///< 2x box decimation of input, as used between levels
+
+private:
+	explicit ImagePyramid(vtkImageDataPtr base);
+	vtkImageDataPtr getLevel(int level, bool cancellable);
+	vtkImageDataPtr build(int level, bool cancellable);
+	static vtkImageDataPtr decimate(vtkImageDataPtr input, const QAtomicInt* cancel);
+
+	std::vector<Eigen::Array3i> mDimensions;
+	std::vector<vtkImageDataPtr> mLevels;
+	QAtomicInt mCancelled;
+	mutable QMutex mMutex;
+	QMutex mBuildMutex; ///< held while building levels. Lock order: mBuildMutex before mMutex
+};
+
+} // namespace cx
+
+#endif // CXIMAGEPYRAMID_H
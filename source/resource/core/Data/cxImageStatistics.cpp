@@ -0,0 +1,295 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+                 
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+                 
+CustusX is released under a BSD 3-Clause license.
+                 
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#include "cxImageStatistics.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkDataArray.h>
+
+namespace cx
+{
+
+namespace
+{
+const unsigned long MAX_BINS = 1 << 16;
+const unsigned long MIN_CHUNK_SIZE = 1 << 16;
+
+/** A range of voxels, processed by one thread.
+ */
+struct Chunk
+{
+	unsigned index;
+	unsigned long begin;
+	unsigned long end;
+};
+
+std::vector<Chunk> createChunks(unsigned long numberOfVoxels)
+{
+	unsigned long count = std::max(QThread::idealThreadCount(), 1);
+	count = std::max(std::min(count, numberOfVoxels/MIN_CHUNK_SIZE), 1ul);
+
+	std::vector<Chunk> retval(count);
+	for (unsigned i=0; i<count; ++i)
+	{
+		retval[i].index = i;
+		retval[i].begin = numberOfVoxels*i/count;
+		retval[i].end = numberOfVoxels*(i+1)/count;
+	}
+	return retval;
+}
+
+/** Intensity of one voxel: the value, or the mean of the RGB components.
+ */
+template<class T> double getIntensity(const T* voxel, int components)
+{
+	if (components < 3)
+		return voxel[0];
+	return (double(voxel[0]) + double(voxel[1]) + double(voxel[2])) / 3;
+}
+
+/** As getIntensity(), but truncated to an integer.
+ */
+template<class T> long getIntegerIntensity(const T* voxel, int components)
+{
+	if (components < 3)
+		return long(voxel[0]);
+	return (long(voxel[0]) + long(voxel[1]) + long(voxel[2])) / 3;
+}
+
+struct Moments
+{
+	Moments() : mMin(std::numeric_limits<double>::max()), mMax(-std::numeric_limits<double>::max()), mSum(0), mSumSquared(0), mCount(0) {}
+	double mMin;
+	double mMax;
+	double mSum;
+	double mSumSquared;
+	unsigned long mCount;
+};
+} // namespace
+
+ImageStatistics::ImageStatistics() :
+	mMin(0),
+	mMax(0),
+	mMean(0),
+	mStandardDeviation(0),
+	mNumberOfVoxels(0),
+	mHistogramOrigin(0),
+	mHistogramSpacing(1)
+{
+}
+
+ImageStatisticsPtr ImageStatistics::create(vtkImageDataPtr image)
+{
+	ImageStatisticsPtr retval(new ImageStatistics());
+	if (!image || !image->GetPointData()->GetScalars())
+		return retval;
+
+	switch (image->GetScalarType())
+	{
+		vtkTemplateMacro(retval->compute<VTK_TT>(image));
+	}
+	return retval;
+}
+
+template<class T> void ImageStatistics::compute(vtkImageDataPtr image)
+{
+	const T* data = static_cast<const T*>(image->GetPointData()->GetScalars()->GetVoidPointer(0));
+	unsigned long numberOfVoxels = image->GetNumberOfPoints();
+	int components = image->GetNumberOfScalarComponents();
+	if (!data || numberOfVoxels==0)
+		return;
+
+	if (std::numeric_limits<T>::is_integer && sizeof(T)<=2)
+		this->computeFromTypeRange(data, numberOfVoxels, components);
+	else
+		this->computeFromValueRange(data, numberOfVoxels, components);
+}
+
+/** Accumulate a histogram over the full range of T, then derive
+ *  all statistics from it. Used for 8 and 16 bit types.
+ */
+template<class T> void ImageStatistics::computeFromTypeRange(const T* data, unsigned long numberOfVoxels, int components)
+{
+	const long typeMin = long(std::numeric_limits<T>::min());
+	const unsigned long bins = (unsigned long)(double(std::numeric_limits<T>::max()) - double(std::numeric_limits<T>::min()) + 1);
+
+	std::vector<Chunk> chunks = createChunks(numberOfVoxels);
+	std::vector<std::vector<unsigned long> > histograms(chunks.size());
+	QtConcurrent::blockingMap(chunks, [&](Chunk& chunk)
+	{
+		std::vector<unsigned long>& histogram = histograms[chunk.index];
+		histogram.assign(bins, 0);
+		for (unsigned long i=chunk.begin; i<chunk.end; ++i)
+			++histogram[getIntegerIntensity(data + i*components, components) - typeMin];
+	});
+
+	std::vector<unsigned long> total(bins, 0);
+	for (unsigned c=0; c<histograms.size(); ++c)
+		for (unsigned long i=0; i<bins; ++i)
+			total[i] += histograms[c][i];
+
+	unsigned long first = 0;
+	while (first<bins && total[first]==0)
+		++first;
+	unsigned long last = bins-1;
+	while (last>first && total[last]==0)
+		--last;
+
+	double sum = 0;
+	double sumSquared = 0;
+	for (unsigned long i=first; i<=last; ++i)
+	{
+		double value = double(typeMin + long(i));
+		sum += value * total[i];
+		sumSquared += value * value * total[i];
+	}
+
+	mNumberOfVoxels = numberOfVoxels;
+	mMin = typeMin + long(first);
+	mMax = typeMin + long(last);
+	mMean = sum / numberOfVoxels;
+	mStandardDeviation = sqrt(std::max(sumSquared/numberOfVoxels - mMean*mMean, 0.0));
+	mHistogram.assign(total.begin()+first, total.begin()+last+1);
+	mHistogramOrigin = mMin;
+	mHistogramSpacing = 1;
+}
+
+/** Find min, max and moments in one pass, then accumulate the
+ *  histogram in a second. Used for large int and float types.
+ *  NaN voxels are ignored.
+ */
+template<class T> void ImageStatistics::computeFromValueRange(const T* data, unsigned long numberOfVoxels, int components)
+{
+	std::vector<Chunk> chunks = createChunks(numberOfVoxels);
+	std::vector<Moments> moments(chunks.size());
+	QtConcurrent::blockingMap(chunks, [&](Chunk& chunk)
+	{
+		Moments& current = moments[chunk.index];
+		for (unsigned long i=chunk.begin; i<chunk.end; ++i)
+		{
+			double value = getIntensity(data + i*components, components);
+			if (value!=value)
+				continue;
+			current.mMin = std::min(current.mMin, value);
+			current.mMax = std::max(current.mMax, value);
+			current.mSum += value;
+			current.mSumSquared += value * value;
+			++current.mCount;
+		}
+	});
+
+	Moments total;
+	for (unsigned c=0; c<moments.size(); ++c)
+	{
+		total.mMin = std::min(total.mMin, moments[c].mMin);
+		total.mMax = std::max(total.mMax, moments[c].mMax);
+		total.mSum += moments[c].mSum;
+		total.mSumSquared += moments[c].mSumSquared;
+		total.mCount += moments[c].mCount;
+	}
+	if (total.mCount==0)
+		return;
+
+	mNumberOfVoxels = total.mCount;
+	mMin = total.mMin;
+	mMax = total.mMax;
+	mMean = total.mSum / total.mCount;
+	mStandardDeviation = sqrt(std::max(total.mSumSquared/total.mCount - mMean*mMean, 0.0));
+	this->setHistogramRange(mMin, mMax, std::numeric_limits<T>::is_integer);
+
+	std::vector<std::vector<unsigned long> > histograms(chunks.size());
+	QtConcurrent::blockingMap(chunks, [&](Chunk& chunk)
+	{
+		std::vector<unsigned long>& histogram = histograms[chunk.index];
+		histogram.assign(mHistogram.size(), 0);
+		for (unsigned long i=chunk.begin; i<chunk.end; ++i)
+		{
+			int bin = this->getBin(getIntensity(data + i*components, components));
+			if (bin >= 0) // NaN gives -1
+				++histogram[bin];
+		}
+	});
+
+	for (unsigned c=0; c<histograms.size(); ++c)
+		for (unsigned long i=0; i<mHistogram.size(); ++i)
+			mHistogram[i] += histograms[c][i];
+}
+
+/** Use one bin per integer value if possible, otherwise MAX_BINS bins covering [min,max].
+ */
+void ImageStatistics::setHistogramRange(double min, double max, bool integer)
+{
+	double range = max - min;
+	mHistogramOrigin = min;
+	if (integer && range < MAX_BINS)
+	{
+		mHistogramSpacing = 1;
+		mHistogram.assign((unsigned long)(range) + 1, 0);
+	}
+	else if (range==0)
+	{
+		mHistogramSpacing = 1;
+		mHistogram.assign(1, 0);
+	}
+	else
+	{
+		mHistogramSpacing = range / (MAX_BINS-1);
+		mHistogram.assign(MAX_BINS, 0);
+	}
+}
+
+double ImageStatistics::getBinValue(int bin) const
+{
+	return mHistogramOrigin + bin * mHistogramSpacing;
+}
+
+int ImageStatistics::getBin(double value) const
+{
+	if (value!=value || mHistogram.empty())
+		return -1;
+	long bin = std::lround((value - mHistogramOrigin) / mHistogramSpacing);
+	if (bin < 0 || bin >= long(mHistogram.size()))
+		return -1;
+	return int(bin);
+}
+
+unsigned long ImageStatistics::getCount(double value) const
+{
+	int bin = this->getBin(value);
+	if (bin < 0)
+		return 0;
+	return mHistogram[bin];
+}
+
+double ImageStatistics::getPercentile(double fraction) const
+{
+	if (mHistogram.empty() || fraction <= 0)
+		return mMin;
+	if (fraction >= 1)
+		return mMax;
+
+	double target = fraction * mNumberOfVoxels;
+	unsigned long accumulated = 0;
+	for (unsigned i=0; i<mHistogram.size(); ++i)
+	{
+		accumulated += mHistogram[i];
+		if (accumulated >= target)
+			return this->getBinValue(i);
+	}
+	return mMax;
+}
+
+} // namespace cx
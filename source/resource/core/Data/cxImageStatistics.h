@@ -0,0 +1,82 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+                 
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+                 
+CustusX is released under a BSD 3-Clause license.
+                 
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXIMAGESTATISTICS_H
+#define CXIMAGESTATISTICS_H
+
+#include "cxResourceExport.h"
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include "vtkForwardDeclarations.h"
+
+namespace cx
+{
+typedef boost::shared_ptr<class ImageStatistics> ImageStatisticsPtr;
+
+/**
+ * Statistics for the voxel values of an image: min/max, mean,
+ * standard deviation, histogram and percentiles.
+ *
+ * For multi-component images, the statistics are computed for the
+ * intensity, i.e. the mean of the first three components (RGB).
+ * This differs from vtkImageData::GetScalarRange(), which uses the
+ * first component only.
+ *
+ * All statistics are found in one parallel pass over the voxels:
+ * For 8 and 16 bit data a histogram covering the full type range is
+ * accumulated, and everything else is derived from it. Other types
+ * need an extra pass to find the histogram range.
+ *
+ * The histogram has one bin per integer value from min to max, unless
+ * this gives too many bins, as for large int or float ranges.
+ *
+ * The object is immutable, thus can be shared between threads.
+ *
+ * \ingroup cx_resource_core_data
+ * \date 2026-10-18
+ */
+class cxResource_EXPORT ImageStatistics
+{
+public:
+	static ImageStatisticsPtr create(vtkImageDataPtr image); ///< compute statistics for image. Can be called from any thread.
+	ImageStatistics();
+
+	double getMin() const { return mMin; }
+	double getMax() const { return mMax; }
+	double getMean() const { return mMean; }
+	double getStandardDeviation() const { return mStandardDeviation; }
+	unsigned long getNumberOfVoxels() const { return mNumberOfVoxels; }
+	double getPercentile(double fraction) const; ///< value below which fraction [0,1] of the voxels are found
+
+	const std::vector<unsigned long>& getHistogram() const { return mHistogram; }
+	double getBinValue(int bin) const; ///< value at the centre of bin. Bins are centred on their value, i.e. bin i covers getBinValue(i) +/- half the bin width.
+	int getBin(double value) const; ///< bin containing value, i.e. with the closest centre, -1 if outside the histogram
+	unsigned long getCount(double value) const; ///< number of voxels in the bin containing value
+
+private:
+	template<class T> void compute(vtkImageDataPtr image);
+	template<class T> void computeFromTypeRange(const T* data, unsigned long numberOfVoxels, int components);
+	template<class T> void computeFromValueRange(const T* data, unsigned long numberOfVoxels, int components);
+	void setHistogramRange(double min, double max, bool integer);
+
+	double mMin;
+	double mMax;
+	double mMean;
+	double mStandardDeviation;
+	unsigned long mNumberOfVoxels;
+	std::vector<unsigned long> mHistogram;
+	double mHistogramOrigin; ///< centre value of first bin
+	double mHistogramSpacing; ///< value range of each bin
+};
+
+} // namespace cx
+
+#endif // CXIMAGESTATISTICS_H
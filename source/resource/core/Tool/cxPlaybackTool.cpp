@@ -38,18 +38,18 @@ void PlaybackTool::timeChangedSlot()
 	QDateTime time = mTime->getTime();
 	qint64 time_ms = time.toMSecsSinceEpoch();
 
-	TimedTransformMapPtr positions = mBase->getPositionHistory();
+	ToolPositionHistoryPtr positions = mBase->getPositionHistory();
 	if (positions->empty())
 		return;
 
 	// find last stored time before current time.
-	TimedTransformMap::iterator lastSample = positions->lower_bound(time_ms);
+	ToolPositionHistory::const_iterator lastSample = positions->lowerBound(time_ms);
 	if (lastSample!=positions->begin())
 		--lastSample;
 
 	// interpret as hidden if no samples has been received the last time:
 	qint64 timeout = 200;
-	bool visible = (lastSample!=positions->end()) && (fabs(time_ms - lastSample->first) < timeout);
+	bool visible = (lastSample!=positions->end()) && (fabs(time_ms - lastSample.time()) < timeout);
 
 	// change visibility if applicable
 	if (mVisible!=visible)
@@ -61,8 +61,8 @@ void PlaybackTool::timeChangedSlot()
 	// emit new position if visible
 	if (this->getVisible())
 	{
-		m_rMpr = lastSample->second;
-		mTimestamp = lastSample->first;
+		m_rMpr = lastSample.transform();
+		mTimestamp = lastSample.time();
 		emit toolTransformAndTimestamp(m_rMpr, mTimestamp);
 	}
 }
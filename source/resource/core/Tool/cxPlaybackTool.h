@@ -53,7 +53,7 @@ public:
 	virtual std::map<int, Vector3D> getReferencePoints() const;
 
 
-	virtual TimedTransformMapPtr getPositionHistory() { return mBase->getPositionHistory(); }
+	virtual ToolPositionHistoryPtr getPositionHistory() { return mBase->getPositionHistory(); }
 	virtual bool isInitialized() const;
 	virtual ProbePtr getProbe() const { return mBase->getProbe(); }
 	virtual bool hasReferencePointWithId(int id) { return mBase->hasReferencePointWithId(id); }
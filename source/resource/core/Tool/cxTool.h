@@ -34,6 +34,7 @@ typedef boost::shared_ptr<class Tool> ToolPtr;
 typedef std::map<QString, ToolPtr> ToolMap;
 typedef std::map<double, Transform3D> TimedTransformMap;
 typedef boost::shared_ptr<TimedTransformMap> TimedTransformMapPtr;
+typedef boost::shared_ptr<class ToolPositionHistory> ToolPositionHistoryPtr;
 typedef boost::shared_ptr<class TrackingPositionFilter> TrackingPositionFilterPtr;
 
 /**
@@ -100,7 +101,7 @@ public:
 		return this->getTypes().count(type);
 	}
 	virtual vtkPolyDataPtr getGraphicsPolyData() const = 0; ///< get geometric 3D description
-	virtual TimedTransformMapPtr getPositionHistory() = 0; ///< get historical positions
+	virtual ToolPositionHistoryPtr getPositionHistory() = 0; ///< get historical positions
 
 	virtual bool getVisible() const = 0; ///< \return the visibility status of the tool
 	virtual bool isInitialized() const	{ return true; }
@@ -15,6 +15,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include "cxTool.h"
 #include "cxToolFileParser.h"
+#include "cxToolPositionHistory.h"
 
 namespace cx
 {
@@ -34,7 +35,7 @@ public:
 	explicit ToolImpl(const QString& uid="", const QString& name ="");
 	virtual ~ToolImpl();
 
-	virtual TimedTransformMapPtr getPositionHistory();
+	virtual ToolPositionHistoryPtr getPositionHistory();
 	virtual TimedTransformMap getSessionHistory(double startTime, double stopTime);
 	virtual Transform3D get_prMt() const;
 
@@ -56,7 +57,7 @@ protected:
 	virtual void set_prMt(const Transform3D& prMt, double timestamp);
 	void createToolGraphic();
 
-	TimedTransformMapPtr mPositionHistory;
+	ToolPositionHistoryPtr mPositionHistory;
 	Transform3D m_prMt; ///< the transform from the tool to the patient reference
 	TrackingPositionFilterPtr mTrackingPositionFilter;
 	std::map<double, ToolPositionMetadata> mMetadata;
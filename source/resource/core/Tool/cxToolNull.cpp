@@ -13,9 +13,9 @@ vtkPolyDataPtr ToolNull::getGraphicsPolyData() const
 	return vtkPolyDataPtr();
 }
 
-TimedTransformMapPtr ToolNull::getPositionHistory()
+ToolPositionHistoryPtr ToolNull::getPositionHistory()
 {
-	return TimedTransformMapPtr();
+	return ToolPositionHistoryPtr();
 }
 
 ToolPositionMetadata ToolNull::getMetadata() const
@@ -0,0 +1,327 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxToolPositionHistory.h"
+
+#include <algorithm>
+#include <Eigen/Geometry>
+#include "cxVector3D.h"
+
+namespace cx
+{
+
+double ToolPositionHistory::const_iterator::time() const
+{
+	return mHistory->mChunks[mChunk].mTimes[mIndex];
+}
+
+Transform3D ToolPositionHistory::const_iterator::transform() const
+{
+	const Chunk& chunk = mHistory->mChunks[mChunk];
+	const float* q = &chunk.mRotations[4*mIndex];
+	const double* t = &chunk.mTranslations[3*mIndex];
+
+	Eigen::Quaterniond rotation(q[0], q[1], q[2], q[3]);
+	rotation.normalize();
+	Transform3D retval = Transform3D::Identity();
+	retval.linear() = rotation.toRotationMatrix();
+	retval.translation() = Vector3D(t[0], t[1], t[2]);
+	return retval;
+}
+
+ToolPositionHistory::const_iterator& ToolPositionHistory::const_iterator::operator++()
+{
+	++mIndex;
+	if (mIndex >= mHistory->mChunks[mChunk].size())
+	{
+		++mChunk;
+		mIndex = 0;
+	}
+	return *this;
+}
+
+ToolPositionHistory::const_iterator& ToolPositionHistory::const_iterator::operator--()
+{
+	if (mIndex==0)
+	{
+		--mChunk;
+		mIndex = mHistory->mChunks[mChunk].size()-1;
+	}
+	else
+	{
+		--mIndex;
+	}
+	return *this;
+}
+
+///--------------------------------------------------------
+///--------------------------------------------------------
+///--------------------------------------------------------
+
+ToolPositionHistory::ToolPositionHistory(unsigned chunkSize) :
+	mChunkSize(std::max(chunkSize, 2u)),
+	mSize(0)
+{
+}
+
+void ToolPositionHistory::insert(double timestamp, const Transform3D& prMt)
+{
+	if (this->empty() || timestamp > this->getLastTimestamp())
+	{
+		this->append(timestamp, prMt);
+		return;
+	}
+
+	unsigned c = this->findChunk(timestamp);
+	Chunk& chunk = mChunks[c];
+	unsigned i = std::lower_bound(chunk.mTimes.begin(), chunk.mTimes.end(), timestamp) - chunk.mTimes.begin();
+	if (i<chunk.size() && chunk.mTimes[i]==timestamp)
+	{
+		this->set(&chunk, i, timestamp, prMt);
+		return;
+	}
+
+	chunk.mTimes.insert(chunk.mTimes.begin()+i, timestamp);
+	chunk.mRotations.insert(chunk.mRotations.begin()+4*i, 4, 0.0f);
+	chunk.mTranslations.insert(chunk.mTranslations.begin()+3*i, 3, 0.0);
+	this->set(&chunk, i, timestamp, prMt);
+	++mSize;
+
+	if (chunk.size() >= 2*mChunkSize)
+		this->split(c);
+}
+
+/** Merge the two sorted sequences into a new set of chunks.
+ *  Linear in the total size, regardless of how the times interleave.
+ */
+void ToolPositionHistory::merge(const TimedTransformMap& positions)
+{
+	if (positions.empty())
+		return;
+
+	if (this->empty() || positions.begin()->first > this->getLastTimestamp())
+	{
+		for (TimedTransformMap::const_iterator iter=positions.begin(); iter!=positions.end(); ++iter)
+			this->append(iter->first, iter->second);
+		return;
+	}
+
+	ToolPositionHistory merged(mChunkSize);
+	const_iterator current = this->begin();
+	TimedTransformMap::const_iterator next = positions.begin();
+	while (current!=this->end() || next!=positions.end())
+	{
+		if (next==positions.end() || (current!=this->end() && current.time() <= next->first))
+		{
+			if (next!=positions.end() && current.time()==next->first)
+				++next; // keep the existing position
+			merged.appendFrom(mChunks[current.mChunk], current.mIndex);
+			++current;
+		}
+		else
+		{
+			merged.append(next->first, next->second);
+			++next;
+		}
+	}
+
+	mChunks.swap(merged.mChunks);
+	mSize = merged.mSize;
+}
+
+void ToolPositionHistory::clear()
+{
+	mChunks.clear();
+	mSize = 0;
+}
+
+void ToolPositionHistory::setSource(Source source)
+{
+	mSource = source;
+}
+
+void ToolPositionHistory::downsample(double beforeTime, double minInterval)
+{
+	if (minInterval<=0 || this->empty() || this->getFirstTimestamp() >= beforeTime)
+		return;
+
+	ToolPositionHistory result(mChunkSize);
+	double lastKept = 0;
+	for (const_iterator iter=this->begin(); iter!=this->end(); ++iter)
+	{
+		double timestamp = iter.time();
+		if (timestamp < beforeTime && !result.empty() && timestamp-lastKept < minInterval)
+			continue;
+		result.appendFrom(mChunks[iter.mChunk], iter.mIndex);
+		lastKept = timestamp;
+	}
+
+	mChunks.swap(result.mChunks);
+	mSize = result.mSize;
+}
+
+double ToolPositionHistory::getFirstTimestamp() const
+{
+	if (this->empty())
+		return 0;
+	return mChunks.front().mTimes.front();
+}
+
+double ToolPositionHistory::getLastTimestamp() const
+{
+	if (this->empty())
+		return 0;
+	return mChunks.back().mTimes.back();
+}
+
+bool ToolPositionHistory::find(double timestamp, Transform3D* prMt) const
+{
+	const_iterator iter = this->lowerBound(timestamp);
+	if (iter==this->end() || iter.time()!=timestamp)
+		return false;
+	*prMt = iter.transform();
+	return true;
+}
+
+ToolPositionHistory::const_iterator ToolPositionHistory::begin() const
+{
+	return const_iterator(this, 0, 0);
+}
+
+ToolPositionHistory::const_iterator ToolPositionHistory::end() const
+{
+	return const_iterator(this, (unsigned)mChunks.size(), 0);
+}
+
+ToolPositionHistory::const_iterator ToolPositionHistory::lowerBound(double timestamp) const
+{
+	if (this->empty())
+		return this->end();
+	unsigned c = this->findChunk(timestamp);
+	const std::vector<double>& times = mChunks[c].mTimes;
+	return this->normalized(c, std::lower_bound(times.begin(), times.end(), timestamp) - times.begin());
+}
+
+ToolPositionHistory::const_iterator ToolPositionHistory::upperBound(double timestamp) const
+{
+	if (this->empty())
+		return this->end();
+	unsigned c = this->findChunk(timestamp);
+	const std::vector<double>& times = mChunks[c].mTimes;
+	return this->normalized(c, std::upper_bound(times.begin(), times.end(), timestamp) - times.begin());
+}
+
+ToolPositionHistory::Range ToolPositionHistory::getRange(double startTime, double stopTime) const
+{
+	const_iterator begin = this->lowerBound(startTime);
+	const_iterator end = this->upperBound(stopTime);
+	if (stopTime < startTime)
+		end = begin;
+	return Range(begin, end);
+}
+
+TimedTransformMap ToolPositionHistory::getSessionHistory(double startTime, double stopTime) const
+{
+	TimedTransformMap retval;
+	Range range = this->getRange(startTime, stopTime);
+	for (const_iterator iter=range.begin(); iter!=range.end(); ++iter)
+		retval.insert(retval.end(), std::make_pair(iter.time(), iter.transform()));
+
+	if (mSource)
+	{
+		TimedTransformMap stored = mSource(startTime, stopTime);
+		retval.insert(stored.begin(), stored.end()); // positions in memory are kept
+	}
+	return retval;
+}
+
+bool ToolPositionHistory::chunkStartsAfter(double timestamp, const Chunk& chunk)
+{
+	return timestamp < chunk.mTimes.front();
+}
+
+/** Return the last chunk starting at or before timestamp, or the first chunk.
+ */
+unsigned ToolPositionHistory::findChunk(double timestamp) const
+{
+	std::vector<Chunk>::const_iterator iter = std::upper_bound(mChunks.begin(), mChunks.end(), timestamp, chunkStartsAfter);
+	if (iter==mChunks.begin())
+		return 0;
+	return (unsigned)(iter - mChunks.begin()) - 1;
+}
+
+ToolPositionHistory::const_iterator ToolPositionHistory::normalized(unsigned chunk, unsigned index) const
+{
+	if (index >= mChunks[chunk].size())
+		return const_iterator(this, chunk+1, 0);
+	return const_iterator(this, chunk, index);
+}
+
+void ToolPositionHistory::append(double timestamp, const Transform3D& prMt)
+{
+	if (mChunks.empty() || mChunks.back().size() >= mChunkSize)
+		mChunks.push_back(Chunk());
+
+	Chunk& chunk = mChunks.back();
+	chunk.mTimes.push_back(timestamp);
+	chunk.mRotations.resize(chunk.mRotations.size()+4);
+	chunk.mTranslations.resize(chunk.mTranslations.size()+3);
+	this->set(&chunk, chunk.size()-1, timestamp, prMt);
+	++mSize;
+}
+
+void ToolPositionHistory::appendFrom(const Chunk& source, unsigned index)
+{
+	if (mChunks.empty() || mChunks.back().size() >= mChunkSize)
+		mChunks.push_back(Chunk());
+
+	Chunk& chunk = mChunks.back();
+	chunk.mTimes.push_back(source.mTimes[index]);
+	chunk.mRotations.insert(chunk.mRotations.end(), source.mRotations.begin()+4*index, source.mRotations.begin()+4*index+4);
+	chunk.mTranslations.insert(chunk.mTranslations.end(), source.mTranslations.begin()+3*index, source.mTranslations.begin()+3*index+3);
+	++mSize;
+}
+
+void ToolPositionHistory::set(Chunk* chunk, unsigned index, double timestamp, const Transform3D& prMt)
+{
+	Eigen::Quaterniond rotation(Eigen::Matrix3d(prMt.linear()));
+	float* q = &chunk->mRotations[4*index];
+	q[0] = rotation.w();
+	q[1] = rotation.x();
+	q[2] = rotation.y();
+	q[3] = rotation.z();
+
+	Vector3D translation = prMt.translation();
+	double* t = &chunk->mTranslations[3*index];
+	t[0] = translation[0];
+	t[1] = translation[1];
+	t[2] = translation[2];
+
+	chunk->mTimes[index] = timestamp;
+}
+
+void ToolPositionHistory::split(unsigned c)
+{
+	Chunk upper;
+	{
+		Chunk& lower = mChunks[c];
+		unsigned half = lower.size()/2;
+		upper.mTimes.assign(lower.mTimes.begin()+half, lower.mTimes.end());
+		upper.mRotations.assign(lower.mRotations.begin()+4*half, lower.mRotations.end());
+		upper.mTranslations.assign(lower.mTranslations.begin()+3*half, lower.mTranslations.end());
+		lower.mTimes.resize(half);
+		lower.mRotations.resize(4*half);
+		lower.mTranslations.resize(3*half);
+	}
+	mChunks.insert(mChunks.begin()+c+1, upper);
+}
+
+} // namespace cx
@@ -0,0 +1,144 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXTOOLPOSITIONHISTORY_H
+#define CXTOOLPOSITIONHISTORY_H
+
+#include "cxResourceExport.h"
+
+#include <map>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+#include "cxTransform3D.h"
+
+namespace cx
+{
+typedef std::map<double, Transform3D> TimedTransformMap;
+
+/** \brief Time sorted history of tool positions.
+ *
+ * Positions are stored in chunks of parallel arrays: timestamp,
+ * rotation as a unit quaternion (float) and translation. This uses
+ * about a quarter of the memory of a TimedTransformMap, and keeps
+ * the samples contiguous.
+ *
+ * Lookup by time is O(log n). getRange() returns a view into the
+ * history, and iteration computes each transform on the fly, thus
+ * no copy is made.
+ *
+ * Positions are normally appended in time order. Inserting out of
+ * order is supported, but slower.
+ *
+ * Positions not held in memory, e.g. from earlier sessions or removed
+ * by downsample(), can be supplied by a source, see setSource().
+ * getSessionHistory() merges them with the positions in memory.
+ *
+ * The transforms are assumed to be rigid.
+ *
+ * \ingroup cx_resource_core_tool
+ * \date 2026-10-18
+ */
+class cxResource_EXPORT ToolPositionHistory
+{
+	struct Chunk
+	{
+		std::vector<double> mTimes;
+		std::vector<float> mRotations; ///< w,x,y,z for each sample
+		std::vector<double> mTranslations; ///< x,y,z for each sample
+		unsigned size() const { return (unsigned)mTimes.size(); }
+	};
+
+public:
+	class cxResource_EXPORT const_iterator
+	{
+	public:
+		const_iterator() : mHistory(NULL), mChunk(0), mIndex(0) {}
+		double time() const;
+		Transform3D transform() const;
+		const_iterator& operator++();
+		const_iterator& operator--();
+		bool operator==(const const_iterator& other) const { return mChunk==other.mChunk && mIndex==other.mIndex; }
+		bool operator!=(const const_iterator& other) const { return !(*this==other); }
+	private:
+		friend class ToolPositionHistory;
+		const_iterator(const ToolPositionHistory* history, unsigned chunk, unsigned index) :
+			mHistory(history), mChunk(chunk), mIndex(index) {}
+		const ToolPositionHistory* mHistory;
+		unsigned mChunk;
+		unsigned mIndex;
+	};
+
+	/** View of the positions in a time interval.
+	 *  Valid until the history is modified.
+	 */
+	class Range
+	{
+	public:
+		Range(const_iterator begin, const_iterator end) : mBegin(begin), mEnd(end) {}
+		const_iterator begin() const { return mBegin; }
+		const_iterator end() const { return mEnd; }
+		bool empty() const { return mBegin==mEnd; }
+	private:
+		const_iterator mBegin;
+		const_iterator mEnd;
+	};
+
+	/** Function returning the positions in [startTime, stopTime]
+	 *  stored outside the history, such as the position log.
+	 */
+	typedef boost::function<TimedTransformMap (double startTime, double stopTime)> Source;
+
+	explicit ToolPositionHistory(unsigned chunkSize=1024);
+
+	void insert(double timestamp, const Transform3D& prMt); ///< add position, replacing any position with the same timestamp
+	void merge(const TimedTransformMap& positions); ///< add positions, keeping existing positions with the same timestamps
+	void clear();
+	void setSource(Source source); ///< positions added by getSessionHistory()
+	/** Thin out positions older than beforeTime, keeping at most one
+	 *  position per minInterval ms. Used to limit memory use in long
+	 *  sessions. The removed positions must be available from the
+	 *  source, as readers of recorded sessions such as RecordSession
+	 *  get the full resolution through getSessionHistory().
+	 */
+	void downsample(double beforeTime, double minInterval);
+
+	unsigned size() const { return mSize; }
+	bool empty() const { return mSize==0; }
+	double getFirstTimestamp() const; ///< 0 if empty
+	double getLastTimestamp() const; ///< 0 if empty
+	bool find(double timestamp, Transform3D* prMt) const; ///< get position with exactly this timestamp
+
+	const_iterator begin() const;
+	const_iterator end() const;
+	const_iterator lowerBound(double timestamp) const; ///< first position at or after timestamp
+	const_iterator upperBound(double timestamp) const; ///< first position after timestamp
+	Range getRange(double startTime, double stopTime) const; ///< positions in [startTime, stopTime]
+	TimedTransformMap getSessionHistory(double startTime, double stopTime) const; ///< copy of getRange(), completed from the source
+
+private:
+	static bool chunkStartsAfter(double timestamp, const Chunk& chunk);
+	unsigned findChunk(double timestamp) const;
+	const_iterator normalized(unsigned chunk, unsigned index) const;
+	void append(double timestamp, const Transform3D& prMt);
+	void appendFrom(const Chunk& source, unsigned index);
+	void set(Chunk* chunk, unsigned index, double timestamp, const Transform3D& prMt);
+	void split(unsigned chunk);
+
+	std::vector<Chunk> mChunks;
+	unsigned mChunkSize;
+	unsigned mSize;
+	Source mSource;
+};
+typedef boost::shared_ptr<ToolPositionHistory> ToolPositionHistoryPtr;
+
+} // namespace cx
+
+#endif // CXTOOLPOSITIONHISTORY_H
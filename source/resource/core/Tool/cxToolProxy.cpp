@@ -72,7 +72,7 @@ vtkPolyDataPtr ToolProxy::getGraphicsPolyData() const
 	return mTool->getGraphicsPolyData();
 }
 
-TimedTransformMapPtr ToolProxy::getPositionHistory()
+ToolPositionHistoryPtr ToolProxy::getPositionHistory()
 {
 	return mTool->getPositionHistory();
 }
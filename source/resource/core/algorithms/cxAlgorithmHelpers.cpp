@@ -14,6 +14,10 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxTypeConversions.h"
 #include "itkImageFileReader.h"
 #include "vtkMetaImageWriter.h"
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkShortArray.h>
+#include <vtkCallbackCommand.h>
 #include "cxSettings.h"
 #include <QDir>
 #include "cxUtilHelpers.h"
@@ -24,11 +28,141 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 namespace cx
 {
 
+namespace
+{
+/** Pixel container using the voxels of a vtkImageData,
+ *  keeping the vtkImageData alive as long as the container.
+ */
+class VtkImportImageContainer : public itkImageType::PixelContainer
+{
+public:
+	typedef VtkImportImageContainer Self;
+	typedef itkImageType::PixelContainer Superclass;
+	typedef itk::SmartPointer<Self> Pointer;
+	itkNewMacro(Self);
+	itkTypeMacro(VtkImportImageContainer, ImportImageContainer);
+
+	void setSource(vtkImageDataPtr source)
+	{
+		mSource = source;
+		this->SetImportPointer(static_cast<PixelType*>(source->GetScalarPointer()), source->GetNumberOfPoints(), false);
+	}
+
+protected:
+	VtkImportImageContainer() {}
+	virtual ~VtkImportImageContainer() {}
+
+private:
+	vtkImageDataPtr mSource;
+};
+
+template<class T>
+void copyToPixelType(const T* source, PixelType* target, vtkIdType size)
+{
+	for (vtkIdType i=0; i<size; ++i)
+		target[i] = static_cast<PixelType>(source[i]);
+}
+
+void releaseItkImageCallback(vtkObject*, unsigned long, void* clientData, void*)
+{
+	delete static_cast<itkImageType::ConstPointer*>(clientData);
+}
+} // namespace
+
 //---------------------------------------------------------------------------------------------------------------------
-itkImageType::ConstPointer AlgorithmHelper::getITKfromVTKImage(vtkImageDataPtr image)
+/** Convert to ITK in memory. The voxels are copied, casting to short as the ITK
+ *  file reader does. If shareVoxels is set, short images share the voxel buffer
+ *  with the input instead: ITK filters run in place by default, so consumers of
+ *  a shared image must call InPlaceOff() to keep the input unchanged.
+ */
+itkImageType::ConstPointer AlgorithmHelper::getITKfromVTKImage(vtkImageDataPtr input, bool shareVoxels)
 {
-  //HACK
-  return AlgorithmHelper::getITKfromVTKImageViaFile(image);
+	if (!input)
+	{
+		std::cout << "getITKfromSSCImage(): NO image!!!" << std::endl;
+		return itkImageType::ConstPointer();
+	}
+	if (input->GetNumberOfScalarComponents() != 1)
+		return AlgorithmHelper::getITKfromVTKImageViaFile(input);
+
+	int dim[3];
+	int extent[6];
+	input->GetDimensions(dim);
+	input->GetExtent(extent);
+	double* spacing = input->GetSpacing();
+	double* origin = input->GetOrigin();
+
+	itkImageType::Pointer retval = itkImageType::New();
+	itkImageType::SizeType size;
+	itkImageType::IndexType start;
+	itkImageType::SpacingType itkSpacing;
+	itkImageType::PointType itkOrigin;
+	for (unsigned i=0; i<Dimension; ++i)
+	{
+		size[i] = dim[i];
+		start[i] = 0;
+		itkSpacing[i] = spacing[i];
+		itkOrigin[i] = origin[i] + extent[2*i]*spacing[i];
+	}
+	itkImageType::RegionType region;
+	region.SetSize(size);
+	region.SetIndex(start);
+	retval->SetRegions(region);
+	retval->SetSpacing(itkSpacing);
+	retval->SetOrigin(itkOrigin);
+
+	if (shareVoxels && input->GetScalarType() == VTK_SHORT)
+	{
+		VtkImportImageContainer::Pointer container = VtkImportImageContainer::New();
+		container->setSource(input);
+		retval->SetPixelContainer(container);
+		return itkImageType::ConstPointer(retval);
+	}
+
+	double minVal = input->GetScalarRange()[0];
+	double maxVal = input->GetScalarRange()[1];
+	if(maxVal > SHRT_MAX || minVal < SHRT_MIN)
+		reportWarning("Image values out of range. max: " + qstring_cast(maxVal)
+				+ " min: " + qstring_cast(minVal) + " See bug #363 if this needs to be fixed");
+
+	retval->Allocate();
+	void* source = input->GetScalarPointer();
+	PixelType* target = retval->GetBufferPointer();
+	vtkIdType count = input->GetNumberOfPoints();
+	switch (input->GetScalarType())
+	{
+	case VTK_CHAR:
+		copyToPixelType(static_cast<char*>(source), target, count);
+		break;
+	case VTK_SIGNED_CHAR:
+		copyToPixelType(static_cast<signed char*>(source), target, count);
+		break;
+	case VTK_UNSIGNED_CHAR:
+		copyToPixelType(static_cast<unsigned char*>(source), target, count);
+		break;
+	case VTK_SHORT:
+		copyToPixelType(static_cast<short*>(source), target, count);
+		break;
+	case VTK_UNSIGNED_SHORT:
+		copyToPixelType(static_cast<unsigned short*>(source), target, count);
+		break;
+	case VTK_INT:
+		copyToPixelType(static_cast<int*>(source), target, count);
+		break;
+	case VTK_UNSIGNED_INT:
+		copyToPixelType(static_cast<unsigned int*>(source), target, count);
+		break;
+	case VTK_FLOAT:
+		copyToPixelType(static_cast<float*>(source), target, count);
+		break;
+	case VTK_DOUBLE:
+		copyToPixelType(static_cast<double*>(source), target, count);
+		break;
+	default:
+		return AlgorithmHelper::getITKfromVTKImageViaFile(input);
+	}
+
+	return itkImageType::ConstPointer(retval);
 }
 //---------------------------------------------------------------------------------------------------------------------
 
@@ -95,7 +229,39 @@ itkImageType::ConstPointer AlgorithmHelper::getITKfromVTKImageViaFile(vtkImageDa
 }
 //---------------------------------------------------------------------------------------------------------------------
 
+/** Convert to VTK in memory, sharing the voxel buffer with the input.
+ *  The input is kept alive as long as the voxel array of the result.
+ */
 vtkImageDataPtr AlgorithmHelper::getVTKFromITK(itkImageType::ConstPointer input)
+{
+	if (!input)
+		return vtkImageDataPtr();
+
+	itkImageType::RegionType region = input->GetBufferedRegion();
+	if (region != input->GetLargestPossibleRegion())
+		return AlgorithmHelper::getVTKFromITKByCopy(input);
+
+	itkImageType::IndexType start = region.GetIndex();
+	itkImageType::SizeType size = region.GetSize();
+	vtkImageDataPtr retval = vtkImageDataPtr::New();
+	retval->SetExtent(start[0], start[0]+size[0]-1, start[1], start[1]+size[1]-1, start[2], start[2]+size[2]-1);
+	retval->SetSpacing(input->GetSpacing()[0], input->GetSpacing()[1], input->GetSpacing()[2]);
+	retval->SetOrigin(input->GetOrigin()[0], input->GetOrigin()[1], input->GetOrigin()[2]);
+
+	vtkSmartPointer<vtkShortArray> array = vtkSmartPointer<vtkShortArray>::New();
+	array->SetNumberOfComponents(1);
+	array->SetArray(const_cast<PixelType*>(input->GetBufferPointer()), region.GetNumberOfPixels(), 1);
+	// the itk image is released when the array is deleted
+	vtkSmartPointer<vtkCallbackCommand> release = vtkSmartPointer<vtkCallbackCommand>::New();
+	release->SetCallback(releaseItkImageCallback);
+	release->SetClientData(new itkImageType::ConstPointer(input));
+	array->AddObserver(vtkCommand::DeleteEvent, release);
+	retval->GetPointData()->SetScalars(array);
+
+	return retval;
+}
+
+vtkImageDataPtr AlgorithmHelper::getVTKFromITKByCopy(itkImageType::ConstPointer input)
 {
 	//Convert ITK to VTK
 	itkToVtkFilterType::Pointer itkToVtkFilter = itkToVtkFilterType::New();
@@ -36,6 +36,12 @@ typedef itk::VTKImageToImageFilter<itkImageType> itkVTKImageToImageFilterType;
  * \brief Class with helper functions for algorithms.
  * \ingroup cx_resource_core_algorithms
  *
+ * Conversion between vtkImageData and itkImageType is done in memory.
+ * In the VTK to ITK direction the voxels are copied, casting to short,
+ * unless sharing is requested for a single component short image. The
+ * ITK to VTK direction always shares the voxel buffer. A shared source
+ * is kept alive as long as the result.
+ *
  * \date Feb 16, 2011
  * \author Janne Beate Bakeng, SINTEF
  */
@@ -43,13 +49,15 @@ class cxResource_EXPORT AlgorithmHelper
 {
 public:
   static itkImageType::ConstPointer getITKfromSSCImage(ImagePtr image);
-  static itkImageType::ConstPointer getITKfromVTKImage(vtkImageDataPtr image);
+  static itkImageType::ConstPointer getITKfromVTKImage(vtkImageDataPtr image, bool shareVoxels = false); ///< shared voxels are modified by in-place ITK filters
 
   static vtkImageDataPtr getVTKFromITK(itkImageType::ConstPointer input);
   static vtkImageDataPtr execute_itk_GrayscaleFillholeImageFilter(vtkImageDataPtr input);
 
+  static itkImageType::ConstPointer getITKfromVTKImageViaFile(vtkImageDataPtr image); ///< old conversion via disk, used for multicomponent images
+
 private:
-  static itkImageType::ConstPointer getITKfromVTKImageViaFile(vtkImageDataPtr image);
+  static vtkImageDataPtr getVTKFromITKByCopy(itkImageType::ConstPointer input);
 };
 
 
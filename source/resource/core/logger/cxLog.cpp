@@ -104,6 +104,7 @@ void Log::stopThread()
 	LogThreadPtr tempWorker = mWorker;
 	mWorker.reset();
 
+	tempWorker->shutdown(); // posted events are processed after quit, see EventProcessingThread
 	mThread->quit();
 	mThread->wait(); // forever or until dead thread
 
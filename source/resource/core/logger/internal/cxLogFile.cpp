@@ -49,12 +49,16 @@ LogFile LogFile::fromFilename(QString filename)
 	return retval;
 }
 
-void LogFile::writeHeader()
+QString LogFile::getHeaderText() const
 {
 	QString timestamp = QDateTime::currentDateTime().toString(timestampMilliSecondsFormatNice());
 	QString formatInfo = "[timestamp][source info][severity][thread] <text> ";
-	QString text = QString("-------> Logging initialized [%1], format: %2\n").arg(timestamp).arg(formatInfo);
-	bool success = this->appendToLogfile(this->getFilename(), text);
+	return QString("-------> Logging initialized [%1], format: %2\n").arg(timestamp).arg(formatInfo);
+}
+
+void LogFile::writeHeader()
+{
+	bool success = this->appendToLogfile(this->getFilename(), this->getHeaderText());
 //	return success;
 }
 
@@ -80,7 +84,7 @@ QString LogFile::timestampFormat() const
 	return "hh:mm:ss.zzz";
 }
 
-QString LogFile::formatMessage(Message msg)
+QString LogFile::formatMessage(Message msg) const
 {
 	QString retval;
 
@@ -22,7 +22,7 @@ namespace cx
  *
  * \addtogroup cx_resource_core_logger
  */
-class LogFile
+class cxResource_EXPORT LogFile
 {
 public:
 	explicit LogFile();
@@ -31,7 +31,9 @@ public:
 	virtual ~LogFile() {}
 
 	void writeHeader();
-	void write(Message message);
+	void write(Message message); ///< unbuffered: opens and closes the file for each message
+	QString getHeaderText() const; ///< text written by writeHeader()
+	QString formatMessage(Message msg) const; ///< text written by write(), excluding the newline
 	bool isWritable() const;
 	QString getFilename() const;
 
@@ -46,7 +48,6 @@ private:
 	Message readMessageFirstLine(QString line);
 	MESSAGE_LEVEL readMessageLevel(QString line);
 	QRegExp getRX_Timestamp() const;
-	QString formatMessage(Message msg);
 	bool appendToLogfile(QString filename, QString text);
 	QString readFileTail();
 //	QString removeEarlierSessionsAndSetStartTime(QString text);
@@ -0,0 +1,64 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+                 
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+                 
+CustusX is released under a BSD 3-Clause license.
+                 
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxLogFileWriter.h"
+
+namespace cx
+{
+
+LogFileWriter::LogFileWriter(QString filename, int bufferSize) :
+	mFile(filename),
+	mBufferSize(bufferSize)
+{
+	if (!filename.isEmpty())
+		mFile.open(QFile::WriteOnly | QFile::Append);
+	mBuffer.reserve(mBufferSize);
+}
+
+LogFileWriter::~LogFileWriter()
+{
+	this->flush();
+}
+
+/** Append text to the buffer. Text is encoded as in the
+ *  unbuffered LogFile, i.e. using the locale codec.
+ */
+void LogFileWriter::write(QString text)
+{
+	if (!this->isWritable())
+		return;
+
+	mBuffer.append(text.toLocal8Bit());
+	if (mBuffer.size() >= mBufferSize)
+		this->flush();
+}
+
+void LogFileWriter::flush()
+{
+	if (mBuffer.isEmpty() || !this->isWritable())
+		return;
+
+	mFile.write(mBuffer);
+	mFile.flush();
+	mBuffer.resize(0); // keeps the allocated capacity
+}
+
+bool LogFileWriter::isWritable() const
+{
+	return mFile.isOpen();
+}
+
+QString LogFileWriter::getFilename() const
+{
+	return mFile.fileName();
+}
+
+} //End namespace cx
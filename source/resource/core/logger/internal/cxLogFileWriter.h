@@ -0,0 +1,55 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+                 
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+                 
+CustusX is released under a BSD 3-Clause license.
+                 
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXLOGFILEWRITER_H
+#define CXLOGFILEWRITER_H
+
+#include "cxResourceExport.h"
+
+#include <QFile>
+#include <QByteArray>
+#include "boost/shared_ptr.hpp"
+
+namespace cx
+{
+
+/**\brief Buffered writer to a log file.
+ *
+ * The file is kept open for the lifetime of the object, and text is
+ * collected in memory and written in batches. The buffer is written
+ * when it exceeds bufferSize, on flush(), and on destruction.
+ *
+ * The owner is responsible for calling flush() regularly, and for
+ * important messages that must reach the disk immediately.
+ *
+ * \addtogroup cx_resource_core_logger
+ */
+class cxResource_EXPORT LogFileWriter
+{
+public:
+	explicit LogFileWriter(QString filename, int bufferSize=64*1024);
+	~LogFileWriter();
+
+	void write(QString text);
+	void flush();
+	bool isWritable() const;
+	QString getFilename() const;
+
+private:
+	QFile mFile;
+	QByteArray mBuffer;
+	int mBufferSize;
+};
+typedef boost::shared_ptr<LogFileWriter> LogFileWriterPtr;
+
+} //namespace cx
+
+#endif // CXLOGFILEWRITER_H
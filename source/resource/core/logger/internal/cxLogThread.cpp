@@ -97,6 +97,12 @@ void LogThread::setLoggingFolder(QString absoluteLoggingFolderPath)
 	this->callInLogThread(action);
 }
 
+void LogThread::shutdown()
+{
+	ActionType action = boost::bind(&LogThread::executeShutdown, this);
+	this->callInLogThread(action);
+}
+
 void LogThread::callInLogThread(ThreadMethodInvoker::ActionType action)
 {
     mQueue->callInLogThread(action);
@@ -92,6 +92,7 @@ public:
 	virtual void setLoggingFolder(QString absoluteLoggingFolderPath); ///< call during startup, will fail if called when running
 	virtual void installObserver(MessageObserverPtr observer, bool resend);
 	virtual void uninstallObserver(MessageObserverPtr observer);
+	void shutdown(); ///< call before stopping the thread, the shutdown is completed in the log thread
 
 signals:
 	void emittedMessage(Message message); ///< emitted for each new message, in addition to writing to observer.
@@ -100,6 +101,7 @@ public slots:
 
 protected:
 	virtual void executeSetLoggingFolder(QString absoluteLoggingFolderPath) = 0;
+	virtual void executeShutdown() {}
     void callInLogThread(ThreadMethodInvoker::ActionType action);
 	Message cleanupMessage(Message message);
 	MessageRepositoryPtr mRepository;
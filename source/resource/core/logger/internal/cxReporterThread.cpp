@@ -37,7 +37,8 @@ namespace cx
 {
 
 ReporterThread::ReporterThread(QObject *parent) :
-	LogThread(parent)
+	LogThread(parent),
+	mShutdown(false)
 {
 	qInstallMessageHandler(convertQtMessagesToCxMessages);
 	qRegisterMetaType<Message>("Message");
@@ -50,11 +51,17 @@ ReporterThread::ReporterThread(QObject *parent) :
 
 	mCout.reset(new SingleStreamerImpl(std::cout, mlCOUT));
 	mCerr.reset(new SingleStreamerImpl(std::cerr, mlCERR));
+
+	// Batch file writes: Started in the log thread, see executeSetLoggingFolder()
+	mFlushTimer = new QTimer(this);
+	mFlushTimer->setInterval(200);
+	connect(mFlushTimer, &QTimer::timeout, this, &ReporterThread::flushLogFiles);
 }
 
 ReporterThread::~ReporterThread()
 {
 	qInstallMessageHandler(0);
+	this->closeLogFiles();
 	mCout.reset();
 	mCerr.reset();
 }
@@ -67,9 +74,10 @@ bool ReporterThread::initializeLogFile(LogFile file)
 
 	mInitializedFiles << filename;
 
-	file.writeHeader();
+	LogFileWriterPtr writer = this->getWriter(filename);
+	writer->write(file.getHeaderText());
 
-	if (!file.isWritable())
+	if (!writer->isWritable())
 	{
 		this->processMessage(Message("Failed to open log file " + filename, mlERROR));
 		return false;
@@ -78,9 +86,41 @@ bool ReporterThread::initializeLogFile(LogFile file)
 	return true;
 }
 
+LogFileWriterPtr ReporterThread::getWriter(QString filename)
+{
+	LogFileWriterPtr& writer = mWriters[filename];
+	if (!writer)
+		writer.reset(new LogFileWriter(filename));
+	return writer;
+}
+
+void ReporterThread::flushLogFiles()
+{
+	for (std::map<QString, LogFileWriterPtr>::iterator iter=mWriters.begin(); iter!=mWriters.end(); ++iter)
+		iter->second->flush();
+}
+
+/** Flush and close all log files. Files are reopened on demand.
+ */
+void ReporterThread::closeLogFiles()
+{
+	this->flushLogFiles();
+	mWriters.clear();
+}
+
+void ReporterThread::executeShutdown()
+{
+	mShutdown = true;
+	mFlushTimer->stop();
+	this->closeLogFiles();
+}
+
 void ReporterThread::executeSetLoggingFolder(QString absoluteLoggingFolderPath)
 {
+	this->closeLogFiles();
 	mLogPath = absoluteLoggingFolderPath;
+	if (!mShutdown)
+		mFlushTimer->start();
 
 	QFileInfo(mLogPath+"/").absoluteDir().mkpath(".");
 
@@ -119,8 +159,13 @@ void ReporterThread::sendToFile(Message message)
 
 	this->initializeLogFile(channelLog);
 
-	channelLog.write(message);
-	allLog.write(message);
+	QString text = channelLog.formatMessage(message) + "\n";
+	this->getWriter(channelLog.getFilename())->write(text);
+	this->getWriter(allLog.getFilename())->write(text);
+
+	// errors often precede a crash: get them to disk at once.
+	if (mShutdown || message.getMessageLevel()==mlERROR)
+		this->flushLogFiles();
 }
 
 void ReporterThread::sendToCout(Message message)
@@ -32,12 +32,14 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <QList>
 #include <QThread>
 #include "cxLogThread.h"
+#include "cxLogFileWriter.h"
 
 class QString;
 class QDomNode;
 class QDomDocument;
 class QFile;
 class QTextStream;
+class QTimer;
 
 /**
  * \file
@@ -68,11 +70,15 @@ signals:
 
 protected:
 	virtual void executeSetLoggingFolder(QString absoluteLoggingFolderPath);
+	virtual void executeShutdown();
 
 private slots:
 	void onMessageEmitted(Message msg);
+	void flushLogFiles();
 private:
 	bool initializeLogFile(LogFile file);
+	LogFileWriterPtr getWriter(QString filename);
+	void closeLogFiles();
 
 	void sendToFile(Message message);
 	void sendToCout(Message message);
@@ -83,6 +89,9 @@ private:
 
 	QString mLogPath;
 	QStringList mInitializedFiles;
+	std::map<QString, LogFileWriterPtr> mWriters; ///< open log files, keyed by filename
+	QTimer* mFlushTimer;
+	bool mShutdown;
 
 };
 
@@ -72,6 +72,11 @@ void StateService::fillDefaultSettings()
 
 	this->fillDefault("TrackingPositionFilter/enabled", false);
 	this->fillDefault("TrackingPositionFilter/cutoffFrequency", 3.0);
+	this->fillDefault("TrackingPositionHistory/downsampleInterval", 0.0);
+	this->fillDefault("Data/lazyImageLoading", false);
+	this->fillDefault("Data/lazyImagePurgeAge", 300); // seconds
+	this->fillDefault("Data/lazyImageMemoryLimit", 4096); // MB
+	this->fillDefault("Data/loadConcurrency", 4); // concurrent file reads when opening a patient
 
 	this->fillDefault("renderingInterval", 33);
 	this->fillDefault("backgroundColor", QColor(30,60,70)); // a dark, grey-blue hue
@@ -80,6 +85,10 @@ void StateService::fillDefaultSettings()
 	this->fillDefault("Ultrasound/acquisitionName", "US-Acq");
 	this->fillDefault("Ultrasound/8bitAcquisitionData", false);
 	this->fillDefault("Ultrasound/CompressAcquisition", true);
+	this->fillDefault("Ultrasound/FrameContainerFormat", false);
+	this->fillDefault("Ultrasound/LiveReconstruction", false);
+	this->fillDefault("Ultrasound/LiveReconstructionInterval", 1000);
+	this->fillDefault("Ultrasound/LiveReconstructionSpacing", 0.5);
 	this->fillDefault("View3D/sphereRadius", 1.0);
 	this->fillDefault("View3D/labelSize", 2.5);
 	this->fillDefault("Navigation/anyplaneViewOffset", 0.25);
@@ -0,0 +1,154 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <QElapsedTimer>
+#include <vtkImageData.h>
+#include <itkBinaryThresholdImageFilter.h>
+#include "cxAlgorithmHelpers.h"
+#include "cxVector3D.h"
+#include "cxtestUtilities.h"
+
+namespace cxtest
+{
+
+namespace
+{
+vtkImageDataPtr createImage(int scalarType, Eigen::Array3i dim)
+{
+	vtkImageDataPtr retval = Utilities::create3DVtkImageDataWithPattern(scalarType, dim);
+	retval->SetSpacing(0.5, 0.6, 0.7);
+	retval->SetOrigin(10, 20, 30);
+	return retval;
+}
+
+void checkEqual(cx::itkImageType::ConstPointer a, cx::itkImageType::ConstPointer b)
+{
+	REQUIRE(a->GetLargestPossibleRegion() == b->GetLargestPossibleRegion());
+	for (unsigned i=0; i<cx::Dimension; ++i)
+	{
+		CHECK(a->GetSpacing()[i] == Approx(b->GetSpacing()[i]));
+		CHECK(a->GetOrigin()[i] == Approx(b->GetOrigin()[i]));
+	}
+
+	unsigned count = a->GetLargestPossibleRegion().GetNumberOfPixels();
+	unsigned differences = 0;
+	for (unsigned i=0; i<count; ++i)
+		if (a->GetBufferPointer()[i] != b->GetBufferPointer()[i])
+			++differences;
+	CHECK(differences == 0);
+}
+} // namespace
+
+TEST_CASE("AlgorithmHelper: VTK to ITK in memory equals conversion via file", "[unit][resource][core]")
+{
+	std::vector<int> types;
+	types.push_back(VTK_CHAR);
+	types.push_back(VTK_UNSIGNED_CHAR);
+	types.push_back(VTK_SHORT);
+	types.push_back(VTK_UNSIGNED_SHORT);
+	types.push_back(VTK_INT);
+	types.push_back(VTK_UNSIGNED_INT);
+	types.push_back(VTK_FLOAT);
+	types.push_back(VTK_DOUBLE);
+
+	for (unsigned i=0; i<types.size(); ++i)
+	{
+		INFO("Scalar type " << types[i]);
+		vtkImageDataPtr input = createImage(types[i], Eigen::Array3i(20, 30, 10));
+		cx::itkImageType::ConstPointer viaFile = cx::AlgorithmHelper::getITKfromVTKImageViaFile(input);
+		cx::itkImageType::ConstPointer inMemory = cx::AlgorithmHelper::getITKfromVTKImage(input);
+		checkEqual(inMemory, viaFile);
+	}
+}
+
+TEST_CASE("AlgorithmHelper: Share voxels between VTK and ITK", "[unit][resource][core]")
+{
+	vtkImageDataPtr input = createImage(VTK_SHORT, Eigen::Array3i(20, 30, 10));
+	cx::itkImageType::ConstPointer itkImage = cx::AlgorithmHelper::getITKfromVTKImage(input, true);
+	CHECK(static_cast<const void*>(itkImage->GetBufferPointer()) == input->GetScalarPointer());
+
+	vtkImageDataPtr output = cx::AlgorithmHelper::getVTKFromITK(itkImage);
+	CHECK(output->GetScalarPointer() == input->GetScalarPointer());
+	CHECK(output->GetScalarType() == VTK_SHORT);
+	CHECK(cx::similar(cx::Vector3D(output->GetSpacing()), cx::Vector3D(input->GetSpacing())));
+	CHECK(cx::similar(cx::Vector3D(output->GetOrigin()), cx::Vector3D(input->GetOrigin())));
+
+	// the voxels must stay valid when the other representations are gone
+	input = vtkImageDataPtr();
+	itkImage = cx::itkImageType::ConstPointer();
+	CHECK(output->GetScalarComponentAsDouble(3, 2, 1, 0) == Approx(Utilities::getPatternValue((1*30+2)*20+3)));
+}
+
+TEST_CASE("AlgorithmHelper: Thresholding an ITK import leaves the source voxels unchanged", "[unit][resource][core]")
+{
+	vtkImageDataPtr input = createImage(VTK_SHORT, Eigen::Array3i(20, 30, 10));
+	vtkImageDataPtr original = vtkImageDataPtr::New();
+	original->DeepCopy(input);
+
+	typedef itk::BinaryThresholdImageFilter<cx::itkImageType, cx::itkImageType> ThresholdFilterType;
+	ThresholdFilterType::Pointer thresholdFilter = ThresholdFilterType::New();
+	thresholdFilter->SetOutsideValue(0);
+	thresholdFilter->SetInsideValue(1);
+	thresholdFilter->SetLowerThreshold(20);
+	thresholdFilter->SetUpperThreshold(60);
+
+	SECTION("Copied import, filter in place")
+	{
+		cx::itkImageType::ConstPointer itkImage = cx::AlgorithmHelper::getITKfromVTKImage(input);
+		CHECK(static_cast<const void*>(itkImage->GetBufferPointer()) != input->GetScalarPointer());
+		thresholdFilter->InPlaceOn();
+		thresholdFilter->SetInput(itkImage);
+	}
+	SECTION("Shared import, filter not in place")
+	{
+		cx::itkImageType::ConstPointer itkImage = cx::AlgorithmHelper::getITKfromVTKImage(input, true);
+		CHECK(static_cast<const void*>(itkImage->GetBufferPointer()) == input->GetScalarPointer());
+		thresholdFilter->InPlaceOff();
+		thresholdFilter->SetInput(itkImage);
+	}
+	thresholdFilter->Update();
+
+	cx::itkImageType::ConstPointer output = thresholdFilter->GetOutput();
+	CHECK(output->GetBufferPointer()[0] == 0);
+	CHECK(output->GetBufferPointer()[3] == 1); // pattern value 21
+
+	short* inputVoxels = static_cast<short*>(input->GetScalarPointer());
+	short* originalVoxels = static_cast<short*>(original->GetScalarPointer());
+	vtkIdType differences = 0;
+	for (vtkIdType i=0; i<input->GetNumberOfPoints(); ++i)
+		if (inputVoxels[i] != originalVoxels[i])
+			++differences;
+	CHECK(differences == 0);
+}
+
+TEST_CASE("Speed: VTK to ITK in memory compared to via file", "[speed][resource][core]")
+{
+	vtkImageDataPtr input = createImage(VTK_UNSIGNED_SHORT, Eigen::Array3i(256, 256, 256));
+	QElapsedTimer timer;
+
+	timer.start();
+	cx::itkImageType::ConstPointer viaFile = cx::AlgorithmHelper::getITKfromVTKImageViaFile(input);
+	qint64 fileTime = timer.elapsed();
+
+	timer.start();
+	cx::itkImageType::ConstPointer inMemory = cx::AlgorithmHelper::getITKfromVTKImage(input);
+	qint64 memoryTime = timer.elapsed();
+
+	std::cout << "VTK to ITK via file: " << fileTime << " ms" << std::endl;
+	std::cout << "VTK to ITK in memory: " << memoryTime << " ms" << std::endl;
+
+	checkEqual(inMemory, viaFile);
+	CHECK(memoryTime <= fileTime);
+}
+
+} // namespace cxtest
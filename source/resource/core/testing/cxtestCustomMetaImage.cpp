@@ -0,0 +1,106 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <vtkImageData.h>
+#include <vtkMetaImageWriter.h>
+#include "cxCustomMetaImage.h"
+#include "cxVolumeHelpers.h"
+#include "cxDataLocations.h"
+#include "cxTypeConversions.h"
+
+namespace cxtest
+{
+
+namespace
+{
+vtkImageDataPtr createTestVolume()
+{
+	vtkImageDataPtr retval = cx::generateVtkImageDataSignedShort(Eigen::Array3i(7, 5, 3), cx::Vector3D(0.5, 0.6, 0.7), 0);
+	cx::fillShortImageDataWithGradient(retval, 1000);
+	return retval;
+}
+
+QString writeTestVolume(vtkImageDataPtr volume, bool compression)
+{
+	QString path = cx::DataLocations::getTestDataPath() + "/temp/CustomMetaImage";
+	QDir().mkpath(path);
+	QString filename = path + "/volume.mhd";
+	QFile::remove(filename);
+
+	vtkSmartPointer<vtkMetaImageWriter> writer = vtkSmartPointer<vtkMetaImageWriter>::New();
+	writer->SetInputData(volume);
+	writer->SetFileName(cstring_cast(filename));
+	writer->SetCompression(compression);
+	writer->Write();
+	return filename;
+}
+} // namespace
+
+TEST_CASE("CustomMetaImage: Change header and write in one go", "[unit][resource][core]")
+{
+	QString filename = writeTestVolume(createTestVolume(), false);
+	cx::Transform3D rMd = cx::createTransformTranslate(cx::Vector3D(1, 2, 3)) * cx::createTransformRotateZ(0.3);
+
+	{
+		cx::CustomMetaImagePtr header = cx::CustomMetaImage::create(filename);
+		header->setTransform(rMd);
+		header->setModality("CT");
+		header->setImageType("Angio");
+		header->setKey("WindowWidth", "500");
+		CHECK(cx::CustomMetaImage(filename).readModality()!="CT"); // not written yet
+		REQUIRE(header->write());
+	}
+
+	cx::CustomMetaImagePtr header = cx::CustomMetaImage::create(filename);
+	CHECK(cx::similar(header->readTransform(), rMd));
+	CHECK(header->readModality()=="CT");
+	CHECK(header->readImageType().trimmed()=="Angio");
+	CHECK(header->readKey("WindowWidth").toDouble()==500);
+	CHECK(header->readKey("ElementDataFile").trimmed()=="volume.raw");
+}
+
+TEST_CASE("CustomMetaImage: Map uncompressed voxel data", "[unit][resource][core]")
+{
+	vtkImageDataPtr volume = createTestVolume();
+	QString filename = writeTestVolume(volume, false);
+
+	vtkImageDataPtr mapped = cx::CustomMetaImage::create(filename)->mapVoxelData();
+	REQUIRE(mapped);
+	CHECK(mapped->GetScalarType()==VTK_SHORT);
+	CHECK(Eigen::Array3i(mapped->GetDimensions()).isApprox(Eigen::Array3i(volume->GetDimensions())));
+	CHECK(cx::similar(cx::Vector3D(mapped->GetSpacing()), cx::Vector3D(volume->GetSpacing())));
+	CHECK(cx::similar(cx::Vector3D(mapped->GetOrigin()), cx::Vector3D(0, 0, 0)));
+
+	short* a = static_cast<short*>(volume->GetScalarPointer());
+	short* b = static_cast<short*>(mapped->GetScalarPointer());
+	bool equal = true;
+	for (int i=0; i<volume->GetNumberOfPoints(); ++i)
+		equal = equal && (a[i]==b[i]);
+	CHECK(equal);
+
+	// the mapping is private
+	b[0] = 1234;
+	vtkImageDataPtr reread = cx::CustomMetaImage::create(filename)->mapVoxelData();
+	REQUIRE(reread);
+	CHECK(static_cast<short*>(reread->GetScalarPointer())[0]==a[0]);
+}
+
+TEST_CASE("CustomMetaImage: Compressed voxel data are not mapped", "[unit][resource][core]")
+{
+	QString filename = writeTestVolume(createTestVolume(), true);
+	CHECK(!cx::CustomMetaImage::create(filename)->mapVoxelData());
+}
+
+} // namespace cxtest
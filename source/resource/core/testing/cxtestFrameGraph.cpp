@@ -0,0 +1,97 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include "cxFrameGraph.h"
+#include "cxMesh.h"
+#include "cxRegistrationTransform.h"
+
+namespace cxtest
+{
+
+namespace
+{
+cx::DataPtr addData(std::map<QString, cx::DataPtr>* source, QString frame, QString parentFrame)
+{
+	cx::MeshPtr mesh = cx::Mesh::create(frame);
+	mesh->get_rMd_History()->setParentSpace(parentFrame);
+	(*source)[mesh->getUid()] = mesh;
+	return mesh;
+}
+
+/*  A           B
+ *  +-MR1       +-MR2
+ *  | +-S1
+ *  | +-S2
+ *  +-CT1
+ */
+std::map<QString, cx::DataPtr> createForest()
+{
+	std::map<QString, cx::DataPtr> source;
+	addData(&source, "S1", "MR1");
+	addData(&source, "S2", "MR1");
+	addData(&source, "MR1", "A");
+	addData(&source, "CT1", "A");
+	addData(&source, "MR2", "B");
+	return source;
+}
+} // namespace
+
+TEST_CASE("FrameGraph: Build from data", "[unit][resource][core]")
+{
+	cx::FrameGraph graph(createForest());
+
+	CHECK(graph.getRootFrames().toSet() == (QStringList() << "A" << "B").toSet());
+	CHECK(graph.getParent("S1") == "MR1");
+	CHECK(graph.getParent("A") == "");
+	CHECK(graph.getChildren("MR1").toSet() == (QStringList() << "S1" << "S2").toSet());
+	CHECK(graph.getDepth("A") == 0);
+	CHECK(graph.getDepth("S2") == 2);
+	CHECK(graph.getDepth("unknown") == -1);
+	CHECK(!graph.contains(""));
+
+	CHECK(graph.isAncestorOf("S1", "A"));
+	CHECK(graph.isAncestorOf("S1", "S1"));
+	CHECK(!graph.isAncestorOf("A", "S1"));
+	CHECK(!graph.isAncestorOf("S1", "CT1"));
+	CHECK(!graph.isAncestorOf("S1", "B"));
+
+	CHECK(graph.getOldestAncestor("S2") == "A");
+	CHECK(graph.getOldestAncestor("B") == "B");
+	CHECK(graph.getOldestAncestorNotCommonToRef("S1", "CT1") == "MR1");
+	CHECK(graph.getOldestAncestorNotCommonToRef("S1", "MR2") == "A");
+	CHECK(graph.getOldestAncestorNotCommonToRef("MR1", "S1") == "");
+
+	CHECK(graph.getDescendantsAndSelf("MR1").toSet() == (QStringList() << "MR1" << "S1" << "S2").toSet());
+	CHECK(graph.getDataFromDescendantsAndSelf("A").size() == 4);
+}
+
+TEST_CASE("FrameGraph: Follow parent space changes", "[unit][resource][core]")
+{
+	std::map<QString, cx::DataPtr> source = createForest();
+	cx::FrameGraph graph(source);
+	CHECK(graph.getOldestAncestor("S1") == "A");
+
+	source["MR1"]->get_rMd_History()->setParentSpace("MR2");
+	CHECK(graph.getParent("MR1") == "MR2");
+	CHECK(graph.getOldestAncestor("S1") == "B");
+	CHECK(graph.getDepth("S1") == 3);
+	CHECK(graph.getChildren("A") == QStringList() << "CT1");
+	CHECK(graph.getDataFromDescendantsAndSelf("B").size() == 4);
+
+	source["MR1"]->get_rMd_History()->setParentSpace("");
+	CHECK(graph.getParent("MR1") == "");
+	CHECK(graph.getRootFrames().contains("MR1"));
+	CHECK(!graph.isAncestorOf("S1", "B"));
+}
+
+} // namespace cxtest
@@ -301,4 +301,55 @@ TEST_CASE("Image: Changed initial window is kept after using addXml and parseXml
 	cx::LogicManager::shutdown();
 }
 
+TEST_CASE("Image: Read lazily from mhd header, load voxel data on access", "[unit][resource][core]")
+{
+	cx::LogicManager::initialize();
+	cx::FileManagerServicePtr filemanager = cx::FileManagerServiceProxy::create(cx::logicManager()->getPluginContext());
+
+	QString filename = cx::DataLocations::getTestDataPath()+"/Phantoms/Kaisa/MetaImage/Kaisa.mhd";
+	cx::ImagePtr reference = readKaisaTestImage(filemanager);
+
+	cx::ImagePtr image = cx::Image::create("lazy", "lazy");
+	REQUIRE(image->loadHeader(filename, filemanager));
+	CHECK(!image->isVoxelDataLoaded());
+	CHECK(image->getLazyVoxelDataMemorySize()==0);
+	CHECK(cx::similar(image->boundingBox(), reference->boundingBox()));
+	CHECK(cx::similar(image->get_rMd(), reference->get_rMd()));
+	CHECK(image->getModality()==reference->getModality());
+	CHECK(image->getInitialWindowWidth()==reference->getInitialWindowWidth());
+	CHECK(!image->isVoxelDataLoaded());
+
+	// users are told to fetch the data again when loaded or purged
+	int changes = 0;
+	QObject::connect(image.get(), &cx::Image::vtkImageDataChanged, [&changes]() { ++changes; });
+
+	image->requestVoxelData();
+	vtkImageDataPtr data = image->getBaseVtkImageData();
+	REQUIRE(image->isVoxelDataLoaded());
+	CHECK(changes==1);
+	CHECK(image->getBaseVtkImageData()==data);
+	CHECK(changes==1);
+	CHECK(data->GetScalarType()==reference->getBaseVtkImageData()->GetScalarType());
+	CHECK(Eigen::Array3i(data->GetDimensions()).isApprox(Eigen::Array3i(reference->getBaseVtkImageData()->GetDimensions())));
+	CHECK(image->getMax()==reference->getMax());
+
+	// in use: cannot purge
+	CHECK(!image->purgeVoxelData());
+	CHECK(changes==1);
+	data = NULL;
+	CHECK(image->purgeVoxelData());
+	CHECK(changes==2);
+	CHECK(!image->isVoxelDataLoaded());
+	CHECK(cx::similar(image->boundingBox(), reference->boundingBox()));
+	CHECK(image->getBaseVtkImageData()->GetScalarPointer()!=NULL);
+	CHECK(changes==3);
+
+	// replaced data are never purged
+	image->setVtkImageData(reference->getBaseVtkImageData());
+	CHECK(image->isVoxelDataLoaded());
+	CHECK(!image->purgeVoxelData());
+
+	cx::LogicManager::shutdown();
+}
+
 } // namespace cxtest
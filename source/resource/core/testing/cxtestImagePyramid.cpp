@@ -0,0 +1,288 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <vtkImageData.h>
+#include "cxImage.h"
+#include "cxImagePyramid.h"
+
+namespace cxtest
+{
+
+namespace
+{
+double ramp(const cx::Vector3D& p)
+{
+	return p[0] + 2*p[1] + 3*p[2];
+}
+
+cx::Vector3D getPosition(vtkImageDataPtr image, int i, int j, int k)
+{
+	double* origin = image->GetOrigin();
+	double* spacing = image->GetSpacing();
+	int* extent = image->GetExtent();
+	return cx::Vector3D(origin[0]+(extent[0]+i)*spacing[0], origin[1]+(extent[2]+j)*spacing[1], origin[2]+(extent[4]+k)*spacing[2]);
+}
+
+/** Image with value ramp(position) in each voxel, with extent starting at start.
+ */
+vtkImageDataPtr createRampImage(Eigen::Array3i dim, Eigen::Array3i start = Eigen::Array3i::Zero())
+{
+	vtkImageDataPtr retval = vtkImageDataPtr::New();
+	retval->SetExtent(start[0], start[0]+dim[0]-1, start[1], start[1]+dim[1]-1, start[2], start[2]+dim[2]-1);
+	retval->SetSpacing(0.5, 1, 2);
+	retval->SetOrigin(10, -5, 2);
+	retval->AllocateScalars(VTK_FLOAT, 1);
+
+	float* voxels = static_cast<float*>(retval->GetScalarPointer());
+	for (int k=0; k<dim[2]; ++k)
+		for (int j=0; j<dim[1]; ++j)
+			for (int i=0; i<dim[0]; ++i)
+				*voxels++ = ramp(getPosition(retval, i, j, k));
+	return retval;
+}
+
+/** Lower and upper corner of the region covered by the voxels.
+ */
+std::pair<cx::Vector3D, cx::Vector3D> getCoveredRegion(vtkImageDataPtr image)
+{
+	cx::Vector3D spacing(image->GetSpacing());
+	int* dim = image->GetDimensions();
+	cx::Vector3D lower = getPosition(image, 0, 0, 0) - spacing/2;
+	cx::Vector3D upper = getPosition(image, dim[0]-1, dim[1]-1, dim[2]-1) + spacing/2;
+	return std::make_pair(lower, upper);
+}
+} // namespace
+
+TEST_CASE("ImagePyramid: Level geometry matches the full volume", "[unit][resource][core]")
+{
+	vtkImageDataPtr base = createRampImage(Eigen::Array3i(32, 16, 8));
+	cx::ImagePyramidPtr pyramid = cx::ImagePyramid::create(base);
+	REQUIRE(pyramid->getNumberOfLevels() == 6);
+	CHECK(pyramid->getLevel(0) == base);
+
+	std::pair<cx::Vector3D, cx::Vector3D> region = getCoveredRegion(base);
+	Eigen::Array3i expectedDim(32, 16, 8);
+	cx::Vector3D expectedSpacing(0.5, 1, 2);
+	for (int level=1; level<pyramid->getNumberOfLevels(); ++level)
+	{
+		INFO("level " << level);
+		for (int i=0; i<3; ++i)
+		{
+			if (expectedDim[i] > 1)
+			{
+				expectedDim[i] /= 2;
+				expectedSpacing[i] *= 2;
+			}
+		}
+
+		vtkImageDataPtr image = pyramid->getLevel(level);
+		REQUIRE(image);
+		int* extent = image->GetExtent();
+		CHECK(extent[0] == 0);
+		CHECK(extent[2] == 0);
+		CHECK(extent[4] == 0);
+		CHECK(cx::similar(pyramid->getDimensions(level), expectedDim));
+		CHECK(cx::similar(Eigen::Array3i(image->GetDimensions()), expectedDim));
+		CHECK(cx::similar(cx::Vector3D(image->GetSpacing()), expectedSpacing));
+
+		// the level covers the same region as the base, thus the voxel centers are shifted
+		std::pair<cx::Vector3D, cx::Vector3D> levelRegion = getCoveredRegion(image);
+		CHECK(cx::similar(levelRegion.first, region.first));
+		CHECK(cx::similar(levelRegion.second, region.second));
+
+		// the mean of a linear function is the value in the center
+		for (int k=0; k<expectedDim[2]; ++k)
+			for (int j=0; j<expectedDim[1]; ++j)
+				for (int i=0; i<expectedDim[0]; ++i)
+					CHECK(image->GetScalarComponentAsDouble(i, j, k, 0) == Approx(ramp(getPosition(image, i, j, k))));
+	}
+	CHECK(pyramid->getNumberOfVoxels(5) == 1);
+}
+
+TEST_CASE("ImagePyramid: Odd dimensions are rounded up", "[unit][resource][core]")
+{
+	vtkImageDataPtr base = vtkImageDataPtr::New();
+	base->SetExtent(0, 4, 0, 2, 0, 0);
+	base->SetSpacing(1, 1, 3);
+	base->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+	unsigned char* voxels = static_cast<unsigned char*>(base->GetScalarPointer());
+	for (int i=0; i<15; ++i)
+		voxels[i] = 10*i;
+
+	vtkImageDataPtr level = cx::ImagePyramid::decimate(base);
+	CHECK(cx::similar(Eigen::Array3i(level->GetDimensions()), Eigen::Array3i(3, 2, 1)));
+	// voxels at the block centers, the partial blocks at the end of x and y placed as full blocks
+	CHECK(cx::similar(cx::Vector3D(level->GetSpacing()), cx::Vector3D(2, 2, 3)));
+	CHECK(cx::similar(cx::Vector3D(level->GetOrigin()), cx::Vector3D(0.5, 0.5, 0)));
+
+	CHECK(level->GetScalarComponentAsDouble(0, 0, 0, 0) == 30); // (0+10+50+60)/4
+	CHECK(level->GetScalarComponentAsDouble(2, 0, 0, 0) == 65); // (40+90)/2
+	CHECK(level->GetScalarComponentAsDouble(2, 1, 0, 0) == 140); // last voxel alone
+}
+
+TEST_CASE("ImagePyramid: Levels of odd dimensions cover the full volume", "[unit][resource][core]")
+{
+	Eigen::Array3i baseDim(33, 17, 9);
+	vtkImageDataPtr base = createRampImage(baseDim, Eigen::Array3i(2, 0, 1)); // extent not starting at zero
+	cx::ImagePyramidPtr pyramid = cx::ImagePyramid::create(base);
+	REQUIRE(pyramid->getNumberOfLevels() == 7);
+
+	std::pair<cx::Vector3D, cx::Vector3D> region = getCoveredRegion(base);
+	cx::Vector3D baseSpacing(base->GetSpacing());
+	for (int level=1; level<pyramid->getNumberOfLevels(); ++level)
+	{
+		INFO("level " << level);
+		vtkImageDataPtr image = pyramid->getLevel(level);
+		REQUIRE(image);
+		cx::Vector3D spacing(image->GetSpacing());
+
+		// the partial blocks at the upper end extend the region by less than a voxel
+		std::pair<cx::Vector3D, cx::Vector3D> levelRegion = getCoveredRegion(image);
+		CHECK(cx::similar(levelRegion.first, region.first));
+		for (int i=0; i<3; ++i)
+		{
+			CHECK(levelRegion.second[i] >= region.second[i] - 1.0E-6);
+			CHECK(levelRegion.second[i] < region.second[i] + spacing[i]);
+		}
+
+		// voxels averaging full blocks of base voxels have the ramp value at their center
+		Eigen::Array3i factor = (spacing.array()/baseSpacing.array() + 0.5).cast<int>();
+		Eigen::Array3i dim(image->GetDimensions());
+		for (int k=0; k<dim[2]; ++k)
+			for (int j=0; j<dim[1]; ++j)
+				for (int i=0; i<dim[0]; ++i)
+				{
+					if (((Eigen::Array3i(i+1, j+1, k+1)*factor) > baseDim).any())
+						continue;
+					CHECK(image->GetScalarComponentAsDouble(i, j, k, 0) == Approx(ramp(getPosition(image, i, j, k))));
+				}
+	}
+	CHECK(cx::similar(pyramid->getDimensions(1), Eigen::Array3i(17, 9, 5)));
+	CHECK(pyramid->getNumberOfVoxels(6) == 1);
+}
+
+TEST_CASE("ImagePyramid: Decimate all scalar types and RGB", "[unit][resource][core]")
+{
+	int types[] = { VTK_CHAR, VTK_SIGNED_CHAR, VTK_UNSIGNED_CHAR, VTK_SHORT, VTK_UNSIGNED_SHORT,
+					VTK_INT, VTK_UNSIGNED_INT, VTK_LONG, VTK_UNSIGNED_LONG, VTK_FLOAT, VTK_DOUBLE };
+	for (unsigned t=0; t<sizeof(types)/sizeof(int); ++t)
+	{
+		vtkImageDataPtr base = vtkImageDataPtr::New();
+		base->SetExtent(0, 7, 0, 5, 0, 3);
+		base->AllocateScalars(types[t], 3);
+		for (int k=0; k<4; ++k)
+			for (int j=0; j<6; ++j)
+				for (int i=0; i<8; ++i)
+				{
+					base->SetScalarComponentFromDouble(i, j, k, 0, (i%2) ? 6 : 4);
+					base->SetScalarComponentFromDouble(i, j, k, 1, 10*i);
+					base->SetScalarComponentFromDouble(i, j, k, 2, 100);
+				}
+
+		vtkImageDataPtr level = cx::ImagePyramid::decimate(base);
+		INFO("scalar type " << base->GetScalarTypeAsString());
+		REQUIRE(level->GetScalarType() == types[t]);
+		REQUIRE(level->GetNumberOfScalarComponents() == 3);
+		CHECK(level->GetScalarComponentAsDouble(0, 0, 0, 0) == 5);
+		CHECK(level->GetScalarComponentAsDouble(3, 2, 1, 0) == 5);
+		CHECK(level->GetScalarComponentAsDouble(0, 0, 0, 1) == 5);
+		CHECK(level->GetScalarComponentAsDouble(3, 2, 1, 1) == 65);
+		CHECK(level->GetScalarComponentAsDouble(3, 2, 1, 2) == 100);
+	}
+}
+
+TEST_CASE("ImagePyramid: Find level within a voxel budget", "[unit][resource][core]")
+{
+	cx::ImagePyramidPtr pyramid = cx::ImagePyramid::create(createRampImage(Eigen::Array3i(32, 16, 8)));
+
+	CHECK(pyramid->findLevel(0) == 0);
+	CHECK(pyramid->findLevel(4096) == 0);
+	CHECK(pyramid->findLevel(4095) == 1);
+	CHECK(pyramid->findLevel(512) == 1);
+	CHECK(pyramid->findLevel(100) == 2);
+	CHECK(pyramid->findLevel(1) == 5);
+
+	CHECK(!pyramid->isBuilt(2));
+	pyramid->requestLevel(2);
+	vtkImageDataPtr level = pyramid->getLevelWithin(100);
+	CHECK(pyramid->isBuilt(1));
+	CHECK(pyramid->isBuilt(2));
+	CHECK(level->GetNumberOfPoints() == 64);
+	CHECK(pyramid->getLevel(2) == level);
+}
+
+TEST_CASE("ImagePyramid: Cancel stops background builds only", "[unit][resource][core]")
+{
+	cx::ImagePyramidPtr pyramid = cx::ImagePyramid::create(createRampImage(Eigen::Array3i(32, 16, 8)));
+
+	// the running build owns the pyramid, thus it can be released at once
+	QFuture<void> future = pyramid->requestLevel(2);
+	pyramid.reset();
+	future.waitForFinished();
+
+	pyramid = cx::ImagePyramid::create(createRampImage(Eigen::Array3i(32, 16, 8)));
+	pyramid->cancel();
+	CHECK(pyramid->isCancelled());
+	pyramid->requestLevel(2).waitForFinished();
+	CHECK(!pyramid->isBuilt(1));
+	CHECK(!pyramid->isBuilt(2));
+
+	REQUIRE(pyramid->getLevel(2));
+	CHECK(pyramid->isBuilt(2));
+}
+
+TEST_CASE("ImagePyramid: Image resamples from a cached pyramid", "[unit][resource][core]")
+{
+	vtkImageDataPtr data = createRampImage(Eigen::Array3i(32, 16, 8));
+	cx::ImagePtr image(new cx::Image("test", data));
+
+	cx::ImagePyramidPtr pyramid = image->getPyramid();
+	CHECK(image->getPyramid() == pyramid);
+	CHECK(image->resample(0)->GetNumberOfPoints() == 4096);
+	CHECK(image->resample(512) == pyramid->getLevel(1));
+
+	// resampled to the budget from the nearest finer level, not snapped to a coarser level
+	CHECK(pyramid->findSourceLevel(3000) == 0);
+	CHECK(pyramid->findSourceLevel(100) == 1);
+	vtkImageDataPtr resampled = image->resample(3000);
+	CHECK(resampled->GetNumberOfPoints() > 2000);
+	CHECK(resampled->GetNumberOfPoints() < 4096);
+	CHECK(image->resample(3000) == resampled);
+	CHECK(image->resample(400)->GetNumberOfPoints() > 256);
+
+	data->Modified();
+	CHECK(image->getPyramid() != pyramid);
+	CHECK(pyramid->isCancelled());
+	CHECK(image->resample(3000) != resampled);
+}
+
+TEST_CASE("ImagePyramid: Image builds levels in the background, coarse first", "[unit][resource][core]")
+{
+	cx::ImagePtr image(new cx::Image("test", createRampImage(Eigen::Array3i(32, 16, 8))));
+
+	CHECK(image->isResampleReady(0));
+	CHECK(image->isResampleReady(3000)); // resampled from the full volume
+	CHECK(!image->isResampleReady(50));
+	CHECK(!image->getCoarseResample(50));
+
+	image->requestResample(50).waitForFinished();
+	REQUIRE(image->isResampleReady(50));
+	CHECK(image->resample(50)->GetNumberOfPoints() < 100);
+
+	// a coarser level is shown while the finer one is built
+	vtkImageDataPtr coarse = image->getCoarseResample(100);
+	REQUIRE(coarse);
+	CHECK(coarse->GetNumberOfPoints() == 64);
+}
+
+} // namespace cxtest
@@ -0,0 +1,170 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+                 
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+                 
+CustusX is released under a BSD 3-Clause license.
+                 
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <algorithm>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkDataArray.h>
+#include "cxImage.h"
+#include "cxImageStatistics.h"
+#include "cxVolumeHelpers.h"
+#include "cxtestUtilities.h"
+
+namespace cxtest
+{
+
+namespace
+{
+/** Offset the pattern to test negative and fractional values.
+ */
+double getOffset(int scalarType)
+{
+	if (scalarType==VTK_SHORT || scalarType==VTK_INT)
+		return -50;
+	if (scalarType==VTK_FLOAT)
+		return 0.25;
+	return 0;
+}
+
+double createValue(vtkIdType i, int scalarType)
+{
+	return Utilities::getPatternValue(i) + getOffset(scalarType);
+}
+
+vtkImageDataPtr createImage(int scalarType, Eigen::Array3i dim)
+{
+	return Utilities::create3DVtkImageDataWithPattern(scalarType, dim, getOffset(scalarType));
+}
+
+void checkStatistics(int scalarType)
+{
+	vtkImageDataPtr image = createImage(scalarType, Eigen::Array3i(64, 50, 40));
+	cx::ImageStatisticsPtr statistics = cx::ImageStatistics::create(image);
+
+	std::vector<double> values(image->GetNumberOfPoints());
+	double sum = 0;
+	for (unsigned i=0; i<values.size(); ++i)
+	{
+		values[i] = createValue(i, scalarType);
+		sum += values[i];
+	}
+	double mean = sum / values.size();
+	double sumSquared = 0;
+	for (unsigned i=0; i<values.size(); ++i)
+		sumSquared += (values[i]-mean)*(values[i]-mean);
+	std::sort(values.begin(), values.end());
+	double min = values.front();
+	double max = values.back();
+	double median = values[values.size()/2 - 1];
+	unsigned long numberOfMin = std::count(values.begin(), values.end(), min);
+	unsigned long numberOfMax = std::count(values.begin(), values.end(), max);
+
+	INFO("scalar type " << image->GetScalarTypeAsString());
+	CHECK(statistics->getNumberOfVoxels() == values.size());
+	CHECK(statistics->getMin() == Approx(min));
+	CHECK(statistics->getMax() == Approx(max));
+	CHECK(statistics->getMean() == Approx(mean));
+	CHECK(statistics->getStandardDeviation() == Approx(sqrt(sumSquared/values.size())));
+	CHECK(statistics->getPercentile(0) == Approx(min));
+	CHECK(statistics->getPercentile(1) == Approx(max));
+	CHECK(fabs(statistics->getPercentile(0.5) - median) < 0.01);
+	CHECK(statistics->getCount(min) == numberOfMin);
+	CHECK(statistics->getCount(max) == numberOfMax);
+
+	unsigned long total = 0;
+	for (unsigned i=0; i<statistics->getHistogram().size(); ++i)
+		total += statistics->getHistogram()[i];
+	CHECK(total == values.size());
+}
+} // namespace
+
+TEST_CASE("ImageStatistics: Compute statistics for several scalar types", "[unit][resource][core]")
+{
+	checkStatistics(VTK_UNSIGNED_CHAR);
+	checkStatistics(VTK_SHORT);
+	checkStatistics(VTK_UNSIGNED_SHORT);
+	checkStatistics(VTK_INT);
+	checkStatistics(VTK_FLOAT);
+}
+
+TEST_CASE("ImageStatistics: Use intensity for RGB images", "[unit][resource][core]")
+{
+	vtkImageDataPtr data = vtkImageDataPtr::New();
+	data->SetExtent(0, 19, 0, 19, 0, 9);
+	data->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+	unsigned char* voxels = static_cast<unsigned char*>(data->GetScalarPointer());
+	int min = 255;
+	int max = 0;
+	for (vtkIdType i=0; i<data->GetNumberOfPoints(); ++i)
+	{
+		voxels[3*i+0] = i % 200;
+		voxels[3*i+1] = (2*i) % 250;
+		voxels[3*i+2] = 30;
+		int intensity = (voxels[3*i+0]+voxels[3*i+1]+voxels[3*i+2])/3;
+		min = std::min(min, intensity);
+		max = std::max(max, intensity);
+	}
+	REQUIRE(min == 10);
+
+	cx::ImagePtr image(new cx::Image("rgb", data));
+	CHECK(image->getMax() == max);
+	CHECK(image->getStatistics()->getMin() == min);
+	// min and max are both intensity, not the range of the first component as in vtk
+	CHECK(image->getMin() == min);
+	CHECK(data->GetScalarRange()[0] == 0);
+}
+
+TEST_CASE("ImageStatistics: Histogram bins are centred on their value", "[unit][resource][core]")
+{
+	vtkImageDataPtr data = vtkImageDataPtr::New();
+	data->SetExtent(0, 2, 0, 0, 0, 0);
+	data->AllocateScalars(VTK_INT, 1);
+	int* voxels = static_cast<int*>(data->GetScalarPointer());
+	voxels[0] = 0;
+	voxels[1] = 1;
+	voxels[2] = 2;
+
+	cx::ImageStatisticsPtr statistics = cx::ImageStatistics::create(data);
+	REQUIRE(statistics->getHistogram().size() == 3);
+	CHECK(statistics->getBin(0.4) == 0);
+	CHECK(statistics->getBin(0.6) == 1);
+	CHECK(statistics->getBin(1.4) == 1);
+	CHECK(statistics->getBinValue(1) == Approx(1));
+	CHECK(statistics->getBin(-0.6) == -1);
+}
+
+TEST_CASE("ImageStatistics: Image caches statistics until the voxel data change", "[unit][resource][core]")
+{
+	vtkImageDataPtr data = createImage(VTK_UNSIGNED_SHORT, Eigen::Array3i(20, 20, 20));
+	cx::ImagePtr image(new cx::Image("test", data));
+
+	cx::ImageStatisticsPtr first = image->getStatistics();
+	CHECK(image->getStatistics() == first);
+	CHECK(image->getMax() == 119);
+	CHECK(cx::calculateNumVoxelsWithMaxValue(image) == first->getCount(119));
+
+	data->GetPointData()->GetScalars()->SetTuple1(0, 200);
+	data->Modified();
+	cx::ImageStatisticsPtr second = image->getStatistics();
+	CHECK(second != first);
+	CHECK(image->getMax() == 200);
+	CHECK(cx::calculateNumVoxelsWithMaxValue(image) == 1);
+
+	data->GetPointData()->GetScalars()->SetTuple1(1, 300);
+	data->Modified();
+	image->requestStatistics();
+	CHECK(image->getStatistics() != second);
+	CHECK(image->getMax() == 300);
+}
+
+} // namespace cxtest
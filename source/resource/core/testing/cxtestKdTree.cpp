@@ -0,0 +1,111 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <cstdlib>
+#include "cxKdTree.h"
+
+namespace cxtest
+{
+
+namespace
+{
+Eigen::MatrixXd createRandomPositions(int count, unsigned seed=42)
+{
+	std::srand(seed);
+	Eigen::MatrixXd retval(3, count);
+	for (int i=0; i<count; ++i)
+		for (int j=0; j<3; ++j)
+			retval(j, i) = (std::rand() % 2000) / 10.0; // on a grid, giving some duplicates
+	return retval;
+}
+
+std::pair<int, double> findNearestLinear(const Eigen::MatrixXd& positions, const std::vector<bool>& removed, Eigen::Vector3d p)
+{
+	std::pair<int, double> retval(-1, 0);
+	for (int i=0; i<positions.cols(); ++i)
+	{
+		if (removed[i])
+			continue;
+		double d = (positions.col(i)-p).norm();
+		if (retval.first<0 || d<retval.second)
+			retval = std::make_pair(i, d);
+	}
+	return retval;
+}
+} // namespace
+
+TEST_CASE("KdTree: Nearest point equals linear search", "[unit][resource][core]")
+{
+	Eigen::MatrixXd positions = createRandomPositions(2000);
+	cx::KdTree tree(positions);
+	std::vector<bool> removed(positions.cols(), false);
+	REQUIRE(tree.size()==2000);
+
+	Eigen::MatrixXd queries = createRandomPositions(200, 7); // a different seed, thus not copies of the positions
+	for (int i=0; i<queries.cols(); ++i)
+	{
+		std::pair<int, double> expected = findNearestLinear(positions, removed, queries.col(i));
+		std::pair<int, double> actual = tree.findNearest(queries.col(i));
+		CHECK(actual.first==expected.first);
+		CHECK(actual.second==Approx(expected.second));
+	}
+	CHECK(tree.findNearest(positions.col(17)).first<=17);
+	CHECK(tree.findNearest(positions.col(17)).second==0);
+}
+
+TEST_CASE("KdTree: Removed points are skipped", "[unit][resource][core]")
+{
+	Eigen::MatrixXd positions = createRandomPositions(500);
+	cx::KdTree tree(positions);
+	std::vector<bool> removed(positions.cols(), false);
+
+	// consume the points by walking to the nearest remaining point
+	Eigen::Vector3d current = positions.col(0);
+	while (!tree.empty())
+	{
+		std::pair<int, double> expected = findNearestLinear(positions, removed, current);
+		std::pair<int, double> actual = tree.findNearest(current);
+		REQUIRE(actual.first==expected.first);
+		tree.remove(actual.first);
+		removed[actual.first] = true;
+		current = positions.col(actual.first);
+	}
+	CHECK(tree.findNearest(current).first==-1);
+}
+
+TEST_CASE("KdTree: Find points within radius", "[unit][resource][core]")
+{
+	Eigen::MatrixXd positions = createRandomPositions(1000);
+	cx::KdTree tree(positions);
+	tree.remove(3);
+
+	Eigen::Vector3d p(100, 100, 100);
+	double radius = 40;
+	std::vector<int> expected;
+	for (int i=0; i<positions.cols(); ++i)
+		if (i!=3 && (positions.col(i)-p).norm()<=radius)
+			expected.push_back(i);
+
+	CHECK(tree.findWithinRadius(p, radius)==expected);
+	CHECK(tree.findWithinRadius(Eigen::Vector3d(-100, -100, -100), 10).empty());
+}
+
+TEST_CASE("KdTree: Empty tree", "[unit][resource][core]")
+{
+	cx::KdTree tree(Eigen::MatrixXd(3, 0));
+	CHECK(tree.empty());
+	CHECK(tree.findNearest(Eigen::Vector3d(0, 0, 0)).first==-1);
+	CHECK(tree.findWithinRadius(Eigen::Vector3d(0, 0, 0), 10).empty());
+}
+
+} // namespace cxtest
@@ -0,0 +1,127 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+                 
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+                 
+CustusX is released under a BSD 3-Clause license.
+                 
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <iostream>
+#include <QDir>
+#include <QFile>
+#include <QElapsedTimer>
+#include "internal/cxLogFile.h"
+#include "internal/cxLogFileWriter.h"
+#include "cxDataLocations.h"
+
+namespace cxtest
+{
+
+namespace
+{
+QString getTestLogPath()
+{
+	QString path = cx::DataLocations::getTestDataPath() + "/temp/LogFileWriter";
+	QDir().mkpath(path);
+	return path;
+}
+
+cx::LogFile createLogFile(QString channel)
+{
+	cx::LogFile retval = cx::LogFile::fromChannel(getTestLogPath(), channel);
+	QFile::remove(retval.getFilename());
+	return retval;
+}
+
+cx::Message createMessage(int i)
+{
+	cx::Message retval(QString("Test message number %1 with some typical content").arg(i), cx::mlINFO);
+	retval.mChannel = "test";
+	retval.mSourceFile = "resource/core/testing/cxtestLogFileWriter.cpp";
+	retval.mSourceLine = 42;
+	retval.mThread = "main";
+	return retval;
+}
+} // namespace
+
+TEST_CASE("LogFileWriter: Writes buffered text on flush and destruction", "[unit][resource][core]")
+{
+	cx::LogFile log = createLogFile("writer");
+	std::vector<cx::Message> expected;
+	{
+		cx::LogFileWriter writer(log.getFilename());
+		REQUIRE(writer.isWritable());
+		writer.write(log.getHeaderText());
+		for (int i=0; i<10; ++i)
+		{
+			expected.push_back(createMessage(i));
+			writer.write(log.formatMessage(expected.back()) + "\n");
+		}
+		CHECK(cx::LogFile::fromFilename(log.getFilename()).readMessages().empty());
+
+		writer.flush();
+		CHECK(cx::LogFile::fromFilename(log.getFilename()).readMessages().size()==11); // header + messages
+
+		expected.push_back(createMessage(10));
+		writer.write(log.formatMessage(expected.back()) + "\n");
+	}
+
+	std::vector<cx::Message> messages = cx::LogFile::fromFilename(log.getFilename()).readMessages();
+	REQUIRE(messages.size()==expected.size()+1);
+	for (unsigned i=0; i<expected.size(); ++i)
+	{
+		CHECK(messages[i+1].getText().trimmed()==expected[i].getText());
+		CHECK(messages[i+1].getMessageLevel()==expected[i].getMessageLevel());
+	}
+
+	QFile::remove(log.getFilename());
+}
+
+TEST_CASE("LogFileWriter: Flushes when the buffer is full", "[unit][resource][core]")
+{
+	cx::LogFile log = createLogFile("smallbuffer");
+	cx::LogFileWriter writer(log.getFilename(), 100);
+	writer.write(QString(60, 'a'));
+	CHECK(QFile(log.getFilename()).size()==0);
+	writer.write(QString(60, 'b') + "\n");
+	CHECK(QFile(log.getFilename()).size()==121);
+
+	QFile::remove(log.getFilename());
+}
+
+TEST_CASE("Speed: LogFileWriter compared to unbuffered LogFile", "[speed][resource][core]")
+{
+	int count = 20000;
+	QElapsedTimer timer;
+
+	cx::LogFile unbuffered = createLogFile("unbuffered");
+	timer.start();
+	for (int i=0; i<count; ++i)
+		unbuffered.write(createMessage(i));
+	double unbufferedRate = count / std::max<double>(timer.elapsed(), 1) * 1000;
+
+	cx::LogFile buffered = createLogFile("buffered");
+	timer.start();
+	{
+		cx::LogFileWriter writer(buffered.getFilename());
+		for (int i=0; i<count; ++i)
+			writer.write(buffered.formatMessage(createMessage(i)) + "\n");
+	}
+	double bufferedRate = count / std::max<double>(timer.elapsed(), 1) * 1000;
+
+	std::cout << "LogFile (unbuffered): " << unbufferedRate << " messages/s" << std::endl;
+	std::cout << "LogFileWriter (buffered): " << bufferedRate << " messages/s" << std::endl;
+
+	CHECK(QFile(buffered.getFilename()).size()==QFile(unbuffered.getFilename()).size());
+	CHECK(bufferedRate > unbufferedRate);
+
+	QFile::remove(unbuffered.getFilename());
+	QFile::remove(buffered.getFilename());
+}
+
+} // namespace cxtest
@@ -0,0 +1,167 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <QDir>
+#include <QFile>
+#include "cxPositionLogFile.h"
+#include "cxPositionStorageFile.h"
+#include "cxDataLocations.h"
+
+namespace cxtest
+{
+
+namespace
+{
+QString getTestFilename(QString suffix)
+{
+	QString path = cx::DataLocations::getTestDataPath() + "/temp/PositionLogFile";
+	QDir().mkpath(path);
+	QString filename = path + "/toolpositions." + suffix;
+	QFile::remove(filename);
+	return filename;
+}
+
+cx::PositionLogMap createPositions(double startTime, int count, double offset)
+{
+	cx::PositionLogMap retval;
+	for (int i=0; i<count; ++i)
+	{
+		cx::Transform3D rMt = cx::createTransformTranslate(cx::Vector3D(offset+i%100, 2*(i%50), 10))
+				* cx::createTransformRotateZ(0.01*i)
+				* cx::createTransformRotateX(0.5);
+		retval[startTime + 20*i] = rMt;
+	}
+	return retval;
+}
+
+void checkPositions(const cx::PositionLogMap& expected, const cx::PositionLogMap& actual)
+{
+	REQUIRE(expected.size()==actual.size());
+	cx::PositionLogMap::const_iterator a = expected.begin();
+	cx::PositionLogMap::const_iterator b = actual.begin();
+	for (; a!=expected.end(); ++a, ++b)
+	{
+		CHECK(a->first==b->first);
+		CHECK(cx::similar(a->second, b->second, 1.0E-3));
+	}
+}
+} // namespace
+
+TEST_CASE("PositionLogFile: Write and read positions for several tools", "[unit][resource][core]")
+{
+	QString filename = getTestFilename(cx::PositionLogReader::getSuffix());
+	double t0 = 1.5E12;
+	cx::PositionLogMap probe = createPositions(t0, 3000, 0);
+	cx::PositionLogMap pointer = createPositions(t0+5, 500, 50);
+	{
+		cx::PositionLogWriter writer(filename);
+		REQUIRE(writer.isValid());
+		writer.write("probe", probe);
+		writer.write("pointer", pointer);
+	}
+
+	cx::PositionLogReader reader(filename);
+	REQUIRE(reader.isValid());
+	CHECK(reader.getToolUids().size()==2);
+	CHECK(reader.getNumberOfPositions("probe")==3000);
+	CHECK(reader.getNumberOfPositions("pointer")==500);
+	checkPositions(probe, reader.getPositionHistory("probe"));
+	checkPositions(pointer, reader.getPositionHistory("pointer"));
+	CHECK(reader.getPositionHistory("unknown").empty());
+
+	QFile::remove(filename);
+}
+
+TEST_CASE("PositionLogFile: Read time range spanning several chunks", "[unit][resource][core]")
+{
+	QString filename = getTestFilename(cx::PositionLogReader::getSuffix());
+	double t0 = 1.5E12;
+	cx::PositionLogMap probe = createPositions(t0, 5000, 0);
+	{
+		cx::PositionLogWriter writer(filename);
+		writer.write("probe", probe);
+	}
+
+	double startTime = t0 + 20*900;
+	double stopTime = t0 + 20*2200;
+	cx::PositionLogMap expected(probe.lower_bound(startTime), probe.upper_bound(stopTime));
+
+	cx::PositionLogReader reader(filename);
+	checkPositions(expected, reader.getSessionHistory("probe", startTime, stopTime));
+
+	std::map<QString, cx::PositionLogMap> all = reader.getSessionHistory(startTime, stopTime);
+	CHECK(all.size()==1);
+	CHECK(all["probe"].size()==expected.size());
+	CHECK(reader.getSessionHistory("probe", t0-1000, t0-1).empty());
+
+	QFile::remove(filename);
+}
+
+TEST_CASE("PositionLogFile: Append to file and recover from truncated chunk", "[unit][resource][core]")
+{
+	QString filename = getTestFilename(cx::PositionLogReader::getSuffix());
+	double t0 = 1.5E12;
+	cx::PositionLogMap first = createPositions(t0, 100, 0);
+	cx::PositionLogMap second = createPositions(t0+10000, 100, 0);
+	{
+		cx::PositionLogWriter writer(filename);
+		writer.write("probe", first);
+		writer.write("probe", second);
+	}
+	// cut into the last chunk, as after a crash during writing
+	QFile file(filename);
+	REQUIRE(file.open(QIODevice::ReadWrite));
+	file.resize(file.size()-40);
+	file.close();
+
+	{
+		cx::PositionLogReader reader(filename);
+		checkPositions(first, reader.getPositionHistory("probe"));
+	}
+
+	{
+		cx::PositionLogWriter writer(filename);
+		writer.write("probe", second);
+	}
+	cx::PositionLogMap expected = first;
+	expected.insert(second.begin(), second.end());
+	cx::PositionLogReader reader(filename);
+	checkPositions(expected, reader.getPositionHistory("probe"));
+
+	QFile::remove(filename);
+}
+
+TEST_CASE("PositionLogFile: Convert legacy position file", "[unit][resource][core]")
+{
+	QString legacyFilename = getTestFilename("snwpos");
+	QString filename = getTestFilename(cx::PositionLogReader::getSuffix());
+	double t0 = 1.5E12;
+	cx::PositionLogMap probe = createPositions(t0, 1500, 0);
+	{
+		cx::PositionStorageWriter writer(legacyFilename);
+		// the legacy writer consumes the first position of each tool as a tool change entry
+		writer.write(cx::Transform3D::Identity(), 0, "probe");
+		for (cx::PositionLogMap::iterator iter=probe.begin(); iter!=probe.end(); ++iter)
+			writer.write(iter->second, iter->first, "probe");
+	}
+
+	REQUIRE(cx::convertPositionStorageToPositionLog(legacyFilename, filename));
+
+	cx::PositionLogReader reader(filename);
+	checkPositions(probe, reader.getPositionHistory("probe"));
+
+	QFile::remove(legacyFilename);
+	QFile::remove(filename);
+}
+
+} // namespace cxtest
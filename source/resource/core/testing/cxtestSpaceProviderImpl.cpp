@@ -0,0 +1,116 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include "cxSpaceProviderImpl.h"
+#include "cxtestPatientModelServiceMock.h"
+#include "cxTrackingService.h"
+#include "cxRegistrationTransform.h"
+#include "cxNullDeleter.h"
+#include "cxMesh.h"
+
+namespace cxtest
+{
+
+namespace
+{
+class ValidPatientModelServiceMock : public PatientModelServiceMock
+{
+public:
+	virtual bool isPatientValid() const { return true; }
+};
+} // namespace
+
+TEST_CASE("SpaceProviderImpl: Cache transforms until invalidated", "[unit][resource][core]")
+{
+	ValidPatientModelServiceMock patientModel;
+	cx::PatientModelServicePtr patientModelPtr(&patientModel, cx::null_deleter());
+	cx::SpaceProviderImpl spaceProvider(cx::TrackingService::getNullObject(), patientModelPtr);
+
+	cx::MeshPtr mesh = cx::Mesh::create("mesh1");
+	patientModel.insertData(mesh);
+	cx::Transform3D rMd = cx::createTransformTranslate(cx::Vector3D(1, 2, 3));
+	cx::Transform3D rMpr = cx::createTransformRotateZ(0.5);
+	mesh->get_rMd_History()->setRegistration(rMd);
+	patientModel.get_rMpr_History()->setRegistration(rMpr);
+
+	cx::CoordinateSystem d(cx::csDATA, mesh->getUid());
+	cx::CoordinateSystem pr = cx::CoordinateSystem::patientReference();
+
+	CHECK(cx::similar(spaceProvider.get_toMfrom(d, pr), rMpr.inv()*rMd));
+	CHECK(cx::similar(spaceProvider.get_toMfrom(d, pr), rMpr.inv()*rMd));
+	CHECK(spaceProvider.getCacheStatistics().misses == 1);
+	CHECK(spaceProvider.getCacheStatistics().hits == 1);
+
+	rMd = cx::createTransformTranslate(cx::Vector3D(4, 5, 6));
+	mesh->get_rMd_History()->setRegistration(rMd);
+	CHECK(cx::similar(spaceProvider.get_toMfrom(d, pr), rMpr.inv()*rMd));
+	CHECK(spaceProvider.getCacheStatistics().invalidations == 1);
+
+	rMpr = cx::createTransformRotateX(0.3);
+	patientModel.get_rMpr_History()->setRegistration(rMpr);
+	CHECK(cx::similar(spaceProvider.get_toMfrom(d, pr), rMpr.inv()*rMd));
+
+	cx::SpaceProviderImpl::CacheStatistics statistics = spaceProvider.getCacheStatistics();
+	CHECK(statistics.misses == 3);
+	CHECK(statistics.hits == 1);
+	CHECK(statistics.invalidations == 2);
+	CHECK(statistics.getHitRate() == Approx(0.25));
+}
+
+TEST_CASE("SpaceProviderImpl: Listeners notified before the cache get current transforms", "[unit][resource][core]")
+{
+	ValidPatientModelServiceMock patientModel;
+	cx::PatientModelServicePtr patientModelPtr(&patientModel, cx::null_deleter());
+	cx::SpaceProviderImpl spaceProvider(cx::TrackingService::getNullObject(), patientModelPtr);
+
+	cx::MeshPtr mesh = cx::Mesh::create("mesh1");
+	patientModel.insertData(mesh);
+	cx::CoordinateSystem d(cx::csDATA, mesh->getUid());
+	cx::CoordinateSystem r = cx::CoordinateSystem::reference();
+
+	// connected before the cache is first used, thus called first on changes
+	cx::Transform3D rMdInSlot = cx::Transform3D::Identity();
+	QObject::connect(mesh.get(), &cx::Data::transformChanged, [&]()
+	{
+		rMdInSlot = spaceProvider.get_toMfrom(d, r);
+	});
+
+	CHECK(cx::similar(spaceProvider.get_toMfrom(d, r), cx::Transform3D::Identity()));
+
+	cx::Transform3D rMd = cx::createTransformTranslate(cx::Vector3D(1, 2, 3));
+	mesh->get_rMd_History()->setRegistration(rMd);
+	CHECK(cx::similar(rMdInSlot, rMd));
+
+	rMd = cx::createTransformRotateY(0.4);
+	mesh->get_rMd_History()->setRegistration(rMd);
+	CHECK(cx::similar(rMdInSlot, rMd));
+	CHECK(cx::similar(spaceProvider.get_toMfrom(d, r), rMd));
+	CHECK(spaceProvider.getCacheStatistics().hits == 1);
+}
+
+TEST_CASE("SpaceProviderImpl: Do not cache active aliases", "[unit][resource][core]")
+{
+	ValidPatientModelServiceMock patientModel;
+	cx::PatientModelServicePtr patientModelPtr(&patientModel, cx::null_deleter());
+	cx::SpaceProviderImpl spaceProvider(cx::TrackingService::getNullObject(), patientModelPtr);
+
+	cx::CoordinateSystem active(cx::csTOOL, "active");
+	cx::CoordinateSystem r = cx::CoordinateSystem::reference();
+	spaceProvider.get_toMfrom(active, r);
+	spaceProvider.get_toMfrom(active, r);
+
+	CHECK(spaceProvider.getCacheStatistics().misses == 2);
+	CHECK(spaceProvider.getCacheStatistics().hits == 0);
+}
+
+} // namespace cxtest
@@ -0,0 +1,167 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include "cxToolPositionHistory.h"
+#include "cxVector3D.h"
+
+namespace cxtest
+{
+
+namespace
+{
+cx::Transform3D createPosition(int i)
+{
+	return cx::createTransformTranslate(cx::Vector3D(i, 2*i, 100))
+			* cx::createTransformRotateZ(0.01*i)
+			* cx::createTransformRotateX(0.5);
+}
+
+cx::TimedTransformMap createPositions(int first, int count, int step)
+{
+	cx::TimedTransformMap retval;
+	for (int i=first; i<first+count*step; i+=step)
+		retval[1000+10*i] = createPosition(i);
+	return retval;
+}
+
+void checkHistory(const cx::TimedTransformMap& expected, const cx::ToolPositionHistory& history)
+{
+	REQUIRE(history.size()==expected.size());
+	cx::TimedTransformMap::const_iterator a = expected.begin();
+	cx::ToolPositionHistory::const_iterator b = history.begin();
+	for (; a!=expected.end(); ++a, ++b)
+	{
+		CHECK(a->first==b.time());
+		CHECK(cx::similar(a->second, b.transform(), 1.0E-5));
+	}
+	CHECK(b==history.end());
+}
+} // namespace
+
+TEST_CASE("ToolPositionHistory: Append and iterate over several chunks", "[unit][resource][core]")
+{
+	cx::ToolPositionHistory history(16);
+	cx::TimedTransformMap expected = createPositions(0, 100, 1);
+	for (cx::TimedTransformMap::iterator iter=expected.begin(); iter!=expected.end(); ++iter)
+		history.insert(iter->first, iter->second);
+
+	checkHistory(expected, history);
+	CHECK(history.getFirstTimestamp()==expected.begin()->first);
+	CHECK(history.getLastTimestamp()==expected.rbegin()->first);
+
+	cx::ToolPositionHistory::const_iterator last = history.end();
+	--last;
+	CHECK(last.time()==expected.rbegin()->first);
+}
+
+TEST_CASE("ToolPositionHistory: Find time ranges", "[unit][resource][core]")
+{
+	cx::ToolPositionHistory history(16);
+	cx::TimedTransformMap expected = createPositions(0, 100, 1);
+	history.merge(expected);
+
+	double startTime = 1000+10*20-5;
+	double stopTime = 1000+10*70;
+	cx::TimedTransformMap range = history.getSessionHistory(startTime, stopTime);
+	REQUIRE(range.size()==51);
+	CHECK(range.begin()->first==1000+10*20);
+	CHECK(range.rbegin()->first==stopTime);
+
+	unsigned count = 0;
+	cx::ToolPositionHistory::Range view = history.getRange(startTime, stopTime);
+	for (cx::ToolPositionHistory::const_iterator iter=view.begin(); iter!=view.end(); ++iter)
+		++count;
+	CHECK(count==51);
+
+	CHECK(history.getRange(0, 999).empty());
+	CHECK(history.getRange(5000, 6000).empty());
+	CHECK(history.lowerBound(1000+10*16)==history.upperBound(1000+10*15));
+
+	cx::Transform3D found;
+	CHECK(history.find(1000+10*33, &found));
+	CHECK(cx::similar(found, createPosition(33), 1.0E-5));
+	CHECK(!history.find(1000+10*33+1, &found));
+}
+
+TEST_CASE("ToolPositionHistory: Insert out of order and replace", "[unit][resource][core]")
+{
+	cx::ToolPositionHistory history(8);
+	cx::TimedTransformMap even = createPositions(0, 50, 2);
+	cx::TimedTransformMap odd = createPositions(1, 50, 2);
+	history.merge(even);
+	for (cx::TimedTransformMap::reverse_iterator iter=odd.rbegin(); iter!=odd.rend(); ++iter)
+		history.insert(iter->first, iter->second);
+
+	cx::TimedTransformMap expected = even;
+	expected.insert(odd.begin(), odd.end());
+	checkHistory(expected, history);
+
+	history.insert(1000+10*10, createPosition(99));
+	expected[1000+10*10] = createPosition(99);
+	checkHistory(expected, history);
+}
+
+TEST_CASE("ToolPositionHistory: Merge keeps existing positions", "[unit][resource][core]")
+{
+	cx::ToolPositionHistory history(8);
+	cx::TimedTransformMap recent = createPositions(30, 20, 1);
+	history.merge(recent);
+
+	cx::TimedTransformMap logged = createPositions(0, 40, 1);
+	for (cx::TimedTransformMap::iterator iter=logged.begin(); iter!=logged.end(); ++iter)
+		iter->second = cx::Transform3D::Identity();
+	history.merge(logged);
+
+	cx::TimedTransformMap expected = recent;
+	expected.insert(logged.begin(), logged.end());
+	checkHistory(expected, history);
+}
+
+TEST_CASE("ToolPositionHistory: Downsample old positions", "[unit][resource][core]")
+{
+	cx::ToolPositionHistory history(16);
+	history.merge(createPositions(0, 100, 1)); // times 1000..1990, 10 ms apart
+
+	history.downsample(1500, 50);
+
+	cx::TimedTransformMap expected = createPositions(0, 10, 5);
+	cx::TimedTransformMap recent = createPositions(50, 50, 1);
+	expected.insert(recent.begin(), recent.end());
+	checkHistory(expected, history);
+}
+
+TEST_CASE("ToolPositionHistory: Session history has full resolution after downsampling", "[unit][resource][core]")
+{
+	cx::TimedTransformMap logged = createPositions(0, 100, 1);
+	cx::ToolPositionHistory history(16);
+	history.merge(logged);
+	history.setSource([logged](double start, double stop)
+	{
+		return cx::TimedTransformMap(logged.lower_bound(start), logged.upper_bound(stop));
+	});
+
+	history.downsample(1500, 50);
+	REQUIRE(history.size() == 60);
+
+	cx::TimedTransformMap session = history.getSessionHistory(1200, 1600);
+	REQUIRE(session.size() == 41);
+	CHECK(session.begin()->first == 1200);
+	CHECK(session.rbegin()->first == 1600);
+	for (cx::TimedTransformMap::iterator iter=session.begin(); iter!=session.end(); ++iter)
+		CHECK(cx::similar(iter->second, logged[iter->first], 1.0E-5));
+
+	history.setSource(cx::ToolPositionHistory::Source());
+	CHECK(history.getSessionHistory(1200, 1600).size() == 17);
+}
+
+} // namespace cxtest
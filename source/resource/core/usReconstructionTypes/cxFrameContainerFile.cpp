@@ -0,0 +1,323 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxFrameContainerFile.h"
+
+#include <cstring>
+#include <QDataStream>
+#include <QtEndian>
+#include <vtkImageData.h>
+#include "cxLogger.h"
+
+namespace cx
+{
+
+namespace
+{
+const char gFileMagic[] = "CXFRAMES";
+const char gFrameMagic[] = "FRAM";
+const char gIndexMagic[] = "INDX";
+const char gTrailerMagic[] = "CXFRIDX1";
+const quint32 gVersion = 1;
+const qint64 gFileHeaderSize = 16;
+const qint64 gFrameHeaderSize = 188;
+const qint64 gTrailerSize = 16;
+
+void setupStream(QDataStream& stream)
+{
+	stream.setByteOrder(QDataStream::LittleEndian);
+	stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+}
+}
+
+struct MappedFrameContainer::FrameHeader
+{
+	qint32 dims[3];
+	double spacing[3];
+	qint32 scalarType;
+	qint32 components;
+	double times[3];
+	double rMu[12];
+	quint32 compression;
+	quint64 rawSize;
+	quint64 storedSize;
+	qint64 dataOffset;
+};
+
+///--------------------------------------------------------
+///--------------------------------------------------------
+///--------------------------------------------------------
+
+FrameContainerWriter::FrameContainerWriter() :
+	mCompressed(false)
+{
+}
+
+FrameContainerWriter::~FrameContainerWriter()
+{
+	this->close();
+}
+
+bool FrameContainerWriter::open(QString filename, bool compressed)
+{
+	this->close();
+	mCompressed = compressed;
+	mOffsets.clear();
+
+	mFile.setFileName(filename);
+	if (!mFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		reportError("Cannot open "+mFile.fileName());
+		return false;
+	}
+
+	QByteArray header;
+	QDataStream stream(&header, QIODevice::WriteOnly);
+	setupStream(stream);
+	stream.writeRawData(gFileMagic, 8);
+	stream << gVersion << quint32(compressed ? 1 : 0);
+	return mFile.write(header)==header.size();
+}
+
+bool FrameContainerWriter::append(vtkImageDataPtr image, TimeInfo timestamp, Transform3D rMu)
+{
+	if (!mFile.isOpen() || !image)
+		return false;
+
+	int* dims = image->GetDimensions();
+	int components = image->GetNumberOfScalarComponents();
+	qint64 rawSize = qint64(dims[0])*dims[1]*dims[2]*components*image->GetScalarSize();
+	QByteArray data = QByteArray::fromRawData(static_cast<const char*>(image->GetScalarPointer()), rawSize);
+	if (mCompressed)
+		data = qCompress(data, 1); // favour speed, the write thread must keep up with the video stream
+
+	QByteArray header;
+	QDataStream stream(&header, QIODevice::WriteOnly);
+	setupStream(stream);
+	stream.writeRawData(gFrameMagic, 4);
+	for (int i=0; i<3; ++i)
+		stream << qint32(dims[i]);
+	for (int i=0; i<3; ++i)
+		stream << image->GetSpacing()[i];
+	stream << qint32(image->GetScalarType()) << qint32(components);
+	stream << timestamp.getAcquisitionTime() << timestamp.getSoftwareAcquisitionTime() << timestamp.getScannerAcquisitionTime();
+	for (int r=0; r<3; ++r)
+		for (int c=0; c<4; ++c)
+			stream << rMu(r,c);
+	stream << quint32(mCompressed ? 1 : 0) << quint64(rawSize) << quint64(data.size());
+	CX_ASSERT(header.size()==gFrameHeaderSize);
+
+	qint64 offset = mFile.pos();
+	if (mFile.write(header)!=header.size() || mFile.write(data)!=data.size())
+	{
+		reportError("Failed to write frame to "+mFile.fileName());
+		return false;
+	}
+	mOffsets.push_back(offset);
+	return true;
+}
+
+bool FrameContainerWriter::close()
+{
+	if (!mFile.isOpen())
+		return false;
+
+	QByteArray index;
+	QDataStream stream(&index, QIODevice::WriteOnly);
+	setupStream(stream);
+	qint64 indexOffset = mFile.pos();
+	stream.writeRawData(gIndexMagic, 4);
+	stream << quint64(mOffsets.size());
+	for (unsigned i=0; i<mOffsets.size(); ++i)
+		stream << quint64(mOffsets[i]);
+	stream << quint64(indexOffset);
+	stream.writeRawData(gTrailerMagic, 8);
+
+	bool success = mFile.write(index)==index.size();
+	mFile.close();
+	return success;
+}
+
+///--------------------------------------------------------
+///--------------------------------------------------------
+///--------------------------------------------------------
+
+MappedFrameContainer::MappedFrameContainer(QString filename) :
+	mFile(filename),
+	mData(NULL),
+	mSize(0),
+	mDeleteFileOnRelease(false)
+{
+	if (!mFile.open(QIODevice::ReadOnly))
+	{
+		reportError("Cannot open "+mFile.fileName());
+		return;
+	}
+
+	mSize = mFile.size();
+	if (mSize >= gFileHeaderSize)
+		mData = mFile.map(0, mSize);
+	if (!mData || std::memcmp(mData, gFileMagic, 8)!=0)
+	{
+		reportError("Not a frame container file: "+mFile.fileName());
+		if (mData)
+			mFile.unmap(mData);
+		mData = NULL;
+		return;
+	}
+
+	if (!this->readIndex())
+		this->scanFrames();
+}
+
+MappedFrameContainer::~MappedFrameContainer()
+{
+	if (mData)
+		mFile.unmap(mData);
+	mFile.close();
+	if (mDeleteFileOnRelease)
+		mFile.remove();
+}
+
+bool MappedFrameContainer::readIndex()
+{
+	if (mSize < gFileHeaderSize + gTrailerSize)
+		return false;
+	if (std::memcmp(mData+mSize-8, gTrailerMagic, 8)!=0)
+		return false;
+
+	qint64 indexOffset = qFromLittleEndian<quint64>(mData+mSize-gTrailerSize);
+	if (indexOffset < gFileHeaderSize || indexOffset+12 > mSize-gTrailerSize)
+		return false;
+	if (std::memcmp(mData+indexOffset, gIndexMagic, 4)!=0)
+		return false;
+	qint64 count = qFromLittleEndian<quint64>(mData+indexOffset+4);
+	if (indexOffset+12+8*count != mSize-gTrailerSize)
+		return false;
+
+	mOffsets.resize(count);
+	for (qint64 i=0; i<count; ++i)
+		mOffsets[i] = qFromLittleEndian<quint64>(mData+indexOffset+12+8*i);
+	return true;
+}
+
+/** Find the frames by walking through the file. Used when the
+ *  writer did not finish, e.g. after a crash during recording.
+ */
+void MappedFrameContainer::scanFrames()
+{
+	mOffsets.clear();
+	FrameHeader header;
+	qint64 offset = gFileHeaderSize;
+	while (this->readFrameHeader(offset, &header))
+	{
+		mOffsets.push_back(offset);
+		offset = header.dataOffset + header.storedSize;
+	}
+	reportWarning(QString("Frame container %1 has no index, recovered %2 frames.")
+				  .arg(mFile.fileName())
+				  .arg(mOffsets.size()));
+}
+
+bool MappedFrameContainer::readFrameHeader(qint64 offset, FrameHeader* header) const
+{
+	if (offset+gFrameHeaderSize > mSize)
+		return false;
+	if (std::memcmp(mData+offset, gFrameMagic, 4)!=0)
+		return false;
+
+	QByteArray buffer = QByteArray::fromRawData(reinterpret_cast<const char*>(mData+offset+4), gFrameHeaderSize-4);
+	QDataStream stream(buffer);
+	setupStream(stream);
+	for (int i=0; i<3; ++i)
+		stream >> header->dims[i];
+	for (int i=0; i<3; ++i)
+		stream >> header->spacing[i];
+	stream >> header->scalarType >> header->components;
+	for (int i=0; i<3; ++i)
+		stream >> header->times[i];
+	for (int i=0; i<12; ++i)
+		stream >> header->rMu[i];
+	stream >> header->compression >> header->rawSize >> header->storedSize;
+	header->dataOffset = offset + gFrameHeaderSize;
+
+	return header->dataOffset + qint64(header->storedSize) <= mSize;
+}
+
+unsigned MappedFrameContainer::size() const
+{
+	return (unsigned)mOffsets.size();
+}
+
+vtkImageDataPtr MappedFrameContainer::get(unsigned index)
+{
+	FrameHeader header;
+	if (index>=this->size() || !this->readFrameHeader(mOffsets[index], &header))
+	{
+		reportError(QString("Failed to read frame %1 from %2").arg(index).arg(mFile.fileName()));
+		return vtkImageDataPtr();
+	}
+
+	vtkImageDataPtr retval = vtkImageDataPtr::New();
+	retval->SetSpacing(header.spacing);
+	retval->SetExtent(0, header.dims[0]-1, 0, header.dims[1]-1, 0, header.dims[2]-1);
+	retval->AllocateScalars(header.scalarType, header.components);
+	quint64 size = quint64(retval->GetNumberOfPoints())*header.components*retval->GetScalarSize();
+	char* dst = static_cast<char*>(retval->GetScalarPointer());
+	const uchar* src = mData + header.dataOffset;
+
+	if (header.compression==1)
+	{
+		QByteArray raw = qUncompress(src, header.storedSize);
+		if (quint64(raw.size())!=size)
+		{
+			reportError(QString("Corrupt frame %1 in %2").arg(index).arg(mFile.fileName()));
+			return vtkImageDataPtr();
+		}
+		std::memcpy(dst, raw.constData(), size);
+	}
+	else
+	{
+		if (header.storedSize!=size)
+		{
+			reportError(QString("Corrupt frame %1 in %2").arg(index).arg(mFile.fileName()));
+			return vtkImageDataPtr();
+		}
+		std::memcpy(dst, src, size);
+	}
+	return retval;
+}
+
+TimeInfo MappedFrameContainer::getTimestamp(unsigned index) const
+{
+	TimeInfo retval;
+	FrameHeader header;
+	if (index>=this->size() || !this->readFrameHeader(mOffsets[index], &header))
+		return retval;
+	retval.mAcquisitionTime.setMSecsSinceEpoch(header.times[0]);
+	retval.mSoftwareAcquisitionTime.setMSecsSinceEpoch(header.times[1]);
+	retval.mOriginalAcquisitionTime.setMSecsSinceEpoch(header.times[2]);
+	return retval;
+}
+
+Transform3D MappedFrameContainer::getTransform(unsigned index) const
+{
+	Transform3D retval = Transform3D::Identity();
+	FrameHeader header;
+	if (index>=this->size() || !this->readFrameHeader(mOffsets[index], &header))
+		return retval;
+	for (int r=0; r<3; ++r)
+		for (int c=0; c<4; ++c)
+			retval(r,c) = header.rMu[4*r+c];
+	return retval;
+}
+
+} // namespace cx
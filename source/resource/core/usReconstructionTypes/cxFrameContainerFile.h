@@ -0,0 +1,111 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXFRAMECONTAINERFILE_H
+#define CXFRAMECONTAINERFILE_H
+
+#include "cxResourceExport.h"
+
+#include <vector>
+#include <QFile>
+#include "cxImageDataContainer.h"
+#include "cxData.h"
+#include "cxTransform3D.h"
+
+namespace cx
+{
+
+/**
+ * \addtogroup cx_resource_usreconstructiontypes
+ * \{
+ */
+
+/** Writer for the single file frame container format (.cxframes).
+ *
+ * All frames of a video stream are appended to one file, each frame
+ * followed by its data, optionally zlib compressed. The frame index is
+ * written by close(). A file that was never closed can still be read,
+ * see MappedFrameContainer.
+ *
+ * Layout, all numbers little endian:
+ *  - file header: "CXFRAMES", version (uint32), flags (uint32)
+ *  - per frame: "FRAM", dims (3*int32), spacing (3*double), scalar type (int32),
+ *    components (int32), acquisition/software/original time (3*double, ms since epoch),
+ *    rMu (12*double, row major 3x4), compression (uint32, 0=none, 1=zlib),
+ *    raw size (uint64), stored size (uint64), data (stored size bytes)
+ *  - index: "INDX", frame count (uint64), offset of each frame (count*uint64)
+ *  - trailer: index offset (uint64), "CXFRIDX1"
+ *
+ * \date 2026-10-18
+ */
+class cxResource_EXPORT FrameContainerWriter
+{
+public:
+	FrameContainerWriter();
+	~FrameContainerWriter();
+	bool open(QString filename, bool compressed);
+	bool append(vtkImageDataPtr image, TimeInfo timestamp, Transform3D rMu = Transform3D::Identity());
+	bool close(); ///< write the frame index and close the file
+	unsigned size() const { return mOffsets.size(); }
+	QString getFilename() const { return mFile.fileName(); }
+
+	static QString getSuffix() { return "cxframes"; }
+
+private:
+	QFile mFile;
+	bool mCompressed;
+	std::vector<qint64> mOffsets;
+};
+
+/** Memory mapped reader for the frame container format written by FrameContainerWriter.
+ *
+ * Frames are copied out of the mapped file on request, nothing is kept in memory.
+ * If the index is missing (the writer was not closed), the frames are found by
+ * scanning the file, and a truncated last frame is ignored.
+ *
+ * \date 2026-10-18
+ */
+class cxResource_EXPORT MappedFrameContainer : public ImageDataContainer
+{
+public:
+	explicit MappedFrameContainer(QString filename);
+	virtual ~MappedFrameContainer();
+	virtual vtkImageDataPtr get(unsigned index);
+	virtual unsigned size() const;
+	TimeInfo getTimestamp(unsigned index) const;
+	Transform3D getTransform(unsigned index) const; ///< rMu as given to FrameContainerWriter::append()
+	bool isValid() const { return mData!=NULL; }
+	QString getFilename() const { return mFile.fileName(); }
+	/**
+	* If set, the file will be deleted when the object goes out of scope
+	*/
+	void setDeleteFileOnRelease(bool on) { mDeleteFileOnRelease = on; }
+
+private:
+	struct FrameHeader;
+	bool readFrameHeader(qint64 offset, FrameHeader* header) const;
+	bool readIndex();
+	void scanFrames();
+
+	QFile mFile;
+	uchar* mData;
+	qint64 mSize;
+	std::vector<qint64> mOffsets;
+	bool mDeleteFileOnRelease;
+};
+typedef boost::shared_ptr<MappedFrameContainer> MappedFrameContainerPtr;
+
+/**
+ * \}
+ */
+
+} // namespace cx
+
+#endif // CXFRAMECONTAINERFILE_H
@@ -0,0 +1,123 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxFrameRingBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vtkImageData.h>
+#include "cxLogger.h"
+
+namespace cx
+{
+
+FrameRingBuffer::FrameRingBuffer() :
+	mMemoryLimit(512*1024*1024),
+	mMaxCapacity(1000),
+	mCapacity(0),
+	mHead(0),
+	mTail(0)
+{
+}
+
+void FrameRingBuffer::setMemoryLimit(double bytes)
+{
+	mMemoryLimit = bytes;
+}
+
+void FrameRingBuffer::setMaxCapacity(int frames)
+{
+	mMaxCapacity = frames;
+}
+
+void FrameRingBuffer::allocate(vtkImageDataPtr format)
+{
+	double frameSize = double(format->GetNumberOfPoints()) * format->GetNumberOfScalarComponents() * format->GetScalarSize();
+	// one slot is always kept empty to tell a full ring from an empty one
+	mCapacity = std::min<double>(mMaxCapacity, mMemoryLimit/std::max(frameSize, 1.0)) + 1;
+	mCapacity = std::max(mCapacity, 3);
+
+	mSlots.resize(mCapacity);
+	for (unsigned i=0; i<mSlots.size(); ++i)
+	{
+		mSlots[i].mImage = vtkImageDataPtr::New();
+		mSlots[i].mImage->SetExtent(format->GetExtent());
+		mSlots[i].mImage->AllocateScalars(format->GetScalarType(), format->GetNumberOfScalarComponents());
+		mSlots[i].mIndex = -1;
+	}
+
+	reportDebug(QString("Allocated %1 frames of %2 MB for recording")
+				.arg(mCapacity)
+				.arg(frameSize/1024/1024, 0, 'f', 1));
+}
+
+void FrameRingBuffer::copy(vtkImageDataPtr source, vtkImageDataPtr target) const
+{
+	int* sourceExtent = source->GetExtent();
+	int* targetExtent = target->GetExtent();
+	bool sameFormat = std::equal(sourceExtent, sourceExtent+6, targetExtent)
+			&& source->GetScalarType()==target->GetScalarType()
+			&& source->GetNumberOfScalarComponents()==target->GetNumberOfScalarComponents();
+
+	if (!sameFormat)
+	{
+		target->DeepCopy(source); // allocates, happens only when the stream format changes
+		return;
+	}
+
+	size_t size = size_t(source->GetNumberOfPoints()) * source->GetNumberOfScalarComponents() * source->GetScalarSize();
+	std::memcpy(target->GetScalarPointer(), source->GetScalarPointer(), size);
+	target->SetSpacing(source->GetSpacing());
+	target->SetOrigin(source->GetOrigin());
+	target->Modified();
+}
+
+bool FrameRingBuffer::push(vtkImageDataPtr image, TimeInfo timestamp, int index)
+{
+	if (!mCapacity)
+		this->allocate(image);
+
+	int head = mHead.loadAcquire();
+	int next = (head+1) % mCapacity;
+	if (next==mTail.loadAcquire())
+		return false;
+
+	Frame& slot = mSlots[head];
+	this->copy(image, slot.mImage);
+	slot.mTimestamp = timestamp;
+	slot.mIndex = index;
+
+	mHead.storeRelease(next);
+	return true;
+}
+
+FrameRingBuffer::Frame* FrameRingBuffer::front()
+{
+	int tail = mTail.loadAcquire();
+	if (tail==mHead.loadAcquire())
+		return NULL;
+	return &mSlots[tail];
+}
+
+void FrameRingBuffer::pop()
+{
+	int tail = mTail.loadAcquire();
+	if (tail==mHead.loadAcquire())
+		return;
+	mTail.storeRelease((tail+1) % mCapacity);
+}
+
+bool FrameRingBuffer::empty() const
+{
+	return mTail.loadAcquire()==mHead.loadAcquire();
+}
+
+} // namespace cx
@@ -0,0 +1,73 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXFRAMERINGBUFFER_H
+#define CXFRAMERINGBUFFER_H
+
+#include "cxResourceExport.h"
+
+#include <vector>
+#include <QAtomicInt>
+#include "vtkForwardDeclarations.h"
+#include "cxData.h"
+
+namespace cx
+{
+
+/** Fixed size ring of preallocated frames, handed from one producer
+ * thread to one consumer thread without locking.
+ *
+ * The slots are allocated at the first push(), with the format of that
+ * frame and as many slots as fit within the memory limit. Later frames
+ * are copied into the slots, thus no allocation is done unless the
+ * format of the stream changes. When the ring is full, push() fails and
+ * the caller decides what to do with the frame.
+ *
+ * Only one thread may call push(), and only one other thread may
+ * call front() and pop().
+ *
+ * \date 2026-10-18
+ * \ingroup cx_resource_usreconstructiontypes
+ */
+class cxResource_EXPORT FrameRingBuffer
+{
+public:
+	struct Frame
+	{
+		vtkImageDataPtr mImage;
+		TimeInfo mTimestamp;
+		int mIndex; ///< running index given to push()
+	};
+
+	FrameRingBuffer();
+	void setMemoryLimit(double bytes); ///< used to size the ring at the first push()
+	void setMaxCapacity(int frames);
+
+	bool push(vtkImageDataPtr image, TimeInfo timestamp, int index); ///< producer: copy image into a free slot, false if full
+	Frame* front(); ///< consumer: oldest frame, or NULL if empty. Valid until pop().
+	void pop(); ///< consumer: release the frame returned by front()
+	bool empty() const;
+	int getCapacity() const { return mCapacity; }
+
+private:
+	void allocate(vtkImageDataPtr format);
+	void copy(vtkImageDataPtr source, vtkImageDataPtr target) const;
+
+	double mMemoryLimit;
+	int mMaxCapacity;
+	std::vector<Frame> mSlots;
+	int mCapacity;
+	QAtomicInt mHead; ///< next slot to write, written by the producer only
+	QAtomicInt mTail; ///< next slot to read, written by the consumer only
+};
+
+} // namespace cx
+
+#endif // CXFRAMERINGBUFFER_H
@@ -28,16 +28,19 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxXmlOptionItem.h"
 #include "cxImageDataContainer.h"
 #include "cxVideoSource.h"
+#include "cxFrameContainerFile.h"
 
 namespace cx
 {
 
-VideoRecorderSaveThread::VideoRecorderSaveThread(QObject* parent, QString saveFolder, QString prefix, bool compressed, bool writeColor) :
+VideoRecorderSaveThread::VideoRecorderSaveThread(QObject* parent, QString saveFolder, QString prefix, bool compressed, bool writeColor, bool useFrameContainer) :
 	QThread(parent),
 	mSaveFolder(saveFolder),
 	mPrefix(prefix),
 	mImageIndex(0),
-	mMutex(QMutex::Recursive),
+	mDroppedFrames(0),
+	mWrittenFrames(0),
+	mWaiting(0),
 	mStop(false),
 	mCancel(false),
 	mTimestampsFile(saveFolder+"/"+prefix+".fts"),
@@ -45,6 +48,8 @@ VideoRecorderSaveThread::VideoRecorderSaveThread(QObject* parent, QString saveFo
 	mWriteColor(writeColor)
 {
 	this->setObjectName("org.custusx.resource.videorecordersave"); // becomes the thread name
+	if (useFrameContainer)
+		mFrameContainer.reset(new FrameContainerWriter());
 }
 
 VideoRecorderSaveThread::~VideoRecorderSaveThread()
@@ -56,33 +61,65 @@ QString VideoRecorderSaveThread::addData(TimeInfo timestamp, vtkImageDataPtr ima
 	if (!image)
 		return "";
 
-	DataType data;
-	data.mTimestamp = timestamp;
-	data.mImage = vtkImageDataPtr::New();
-	data.mImage->DeepCopy(image);
-	data.mImageFilename = QString("%1/%2_%3.mhd").arg(mSaveFolder).arg(mPrefix).arg(mImageIndex++);
-
+	if (!mPendingData.push(image, timestamp, mImageIndex))
 	{
-		QMutexLocker sentry(&mMutex);
-		mPendingData.push_back(data);
+		mDroppedFrames.ref();
+		return "";
 	}
 
-	return data.mImageFilename;
+	QString filename = mFrameContainer ? this->getFrameContainerFilename() : this->getImageFilename(mImageIndex);
+	++mImageIndex;
+	this->wakeThread();
+	return filename;
+}
+
+QString VideoRecorderSaveThread::getImageFilename(int index) const
+{
+	return QString("%1/%2_%3.mhd").arg(mSaveFolder).arg(mPrefix).arg(index);
+}
+
+void VideoRecorderSaveThread::setMemoryLimit(double bytes)
+{
+	mPendingData.setMemoryLimit(bytes);
+}
+
+/** Wake the thread if it is waiting for data. The flag is read after the
+ *  data is published, and the thread sets the flag before it checks for data,
+ *  thus at least one of them will see the other.
+ */
+void VideoRecorderSaveThread::wakeThread()
+{
+	if (!mWaiting.fetchAndAddOrdered(0))
+		return;
+	QMutexLocker sentry(&mMutex);
+	mDataAdded.wakeAll();
+}
+
+QString VideoRecorderSaveThread::getFrameContainerFilename() const
+{
+	return QString("%1/%2.%3").arg(mSaveFolder).arg(mPrefix).arg(FrameContainerWriter::getSuffix());
 }
 
 void VideoRecorderSaveThread::stop()
 {
+	QMutexLocker sentry(&mMutex);
 	mStop = true;
+	mDataAdded.wakeAll();
 }
 
 void VideoRecorderSaveThread::cancel()
 {
+	QMutexLocker sentry(&mMutex);
 	mCancel = true;
 	mStop = true;
+	mDataAdded.wakeAll();
 }
 
 bool VideoRecorderSaveThread::openTimestampsFile()
 {
+	if (mFrameContainer)
+		return mFrameContainer->open(this->getFrameContainerFilename(), mCompressed);
+
 	if(!mTimestampsFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
 	{
 	  reportError("Cannot open "+mTimestampsFile.fileName());
@@ -94,6 +131,9 @@ bool VideoRecorderSaveThread::openTimestampsFile()
 
 bool VideoRecorderSaveThread::closeTimestampsFile()
 {
+	if (mFrameContainer)
+		return mFrameContainer->close();
+
 	mTimestampsFile.close();
 
 //	QFileInfo info(mTimestampsFile);
@@ -106,24 +146,31 @@ bool VideoRecorderSaveThread::closeTimestampsFile()
 	return true;
 }
 
-void VideoRecorderSaveThread::write(VideoRecorderSaveThread::DataType data)
+void VideoRecorderSaveThread::write(const FrameRingBuffer::Frame& data)
 {
-	this->writeTimeStampsFile(data.mTimestamp);
+	if (!mFrameContainer)
+		this->writeTimeStampsFile(data.mTimestamp);
 
+	vtkImageDataPtr image = data.mImage;
 	// convert to 8 bit data if applicable.
-	if (!mWriteColor && data.mImage->GetNumberOfScalarComponents()>2)
+	if (!mWriteColor && image->GetNumberOfScalarComponents()>2)
 	{
 		  vtkSmartPointer<vtkImageLuminance> luminance = vtkSmartPointer<vtkImageLuminance>::New();
-		  luminance->SetInputData(data.mImage);
+		  luminance->SetInputData(image);
 		  luminance->Update();
-		  data.mImage = luminance->GetOutput();
-//		  data.mImage->Update();
+		  image = luminance->GetOutput();
+	}
+
+	if (mFrameContainer)
+	{
+		mFrameContainer->append(image, data.mTimestamp);
+		return;
 	}
 
 	// write image
 	vtkMetaImageWriterPtr writer = vtkMetaImageWriterPtr::New();
-	writer->SetInputData(data.mImage);
-	writer->SetFileName(cstring_cast(data.mImageFilename));
+	writer->SetInputData(image);
+	writer->SetFileName(cstring_cast(this->getImageFilename(data.mIndex)));
 	writer->SetCompression(mCompressed);
 	writer->Write();
 }
@@ -140,30 +187,31 @@ void VideoRecorderSaveThread::writeTimeStampsFile(TimeInfo timeStamps)
   */
 void VideoRecorderSaveThread::writeQueue()
 {
-	while(!mPendingData.empty())
+	while (FrameRingBuffer::Frame* current = mPendingData.front())
 	{
 		if (mCancel)
 			return;
 
-		DataType current;
-
-		{
-			QMutexLocker sentry(&mMutex);
-			current = mPendingData.front();
-			mPendingData.pop_front();
-		}
-
-		this->write(current);
+		this->write(*current);
+		mPendingData.pop(); // release the slot only after the frame is written
+		mWrittenFrames.ref();
 	}
 }
 
 void VideoRecorderSaveThread::run()
 {
 	this->openTimestampsFile();
-	while (!mStop)
+	while (true)
 	{
 		this->writeQueue();
-		this->msleep(20);
+
+		QMutexLocker sentry(&mMutex);
+		if (mStop)
+			break;
+		mWaiting.fetchAndStoreOrdered(1);
+		if (mPendingData.empty())
+			mDataAdded.wait(&mMutex);
+		mWaiting.fetchAndStoreOrdered(0);
 	}
 
 	this->writeQueue();
@@ -175,16 +223,20 @@ void VideoRecorderSaveThread::run()
 //---------------------------------------------------------
 
 
-SavingVideoRecorder::SavingVideoRecorder(VideoSourcePtr source, QString saveFolder, QString prefix, bool compressed, bool writeColor, FileManagerServicePtr filemanagerservice) :
+SavingVideoRecorder::SavingVideoRecorder(VideoSourcePtr source, QString saveFolder, QString prefix, bool compressed, bool writeColor, FileManagerServicePtr filemanagerservice, bool useFrameContainer) :
 //	mLastPurgedImageIndex(-1),
-	mSource(source)
+	mSource(source),
+	mDroppedFramesReported(false)
 {
-	mImages.reset(new cx::CachedImageDataContainer(filemanagerservice));
-	mImages->setDeleteFilesOnRelease(true);
+	if (!useFrameContainer)
+	{
+		mImages.reset(new cx::CachedImageDataContainer(filemanagerservice));
+		mImages->setDeleteFilesOnRelease(true);
+	}
 
 	mPrefix = prefix;
 	mSaveFolder = saveFolder;
-	mSaveThread.reset(new VideoRecorderSaveThread(NULL, saveFolder, prefix, compressed, writeColor));
+	mSaveThread.reset(new VideoRecorderSaveThread(NULL, saveFolder, prefix, compressed, writeColor, useFrameContainer));
 	mSaveThread->start();
 }
 
@@ -212,14 +264,19 @@ void SavingVideoRecorder::newFrameSlot()
 	vtkImageDataPtr image = mSource->getVtkImageData();
 	TimeInfo timestamp = mSource->getAdvancedTimeInfo();
 	QString filename = mSaveThread->addData(timestamp, image);
+	if (filename.isEmpty())
+		return; // dropped
 
-	mImages->append(filename);
+	if (mImages)
+		mImages->append(filename);
 	mTimestamps.push_back(timestamp);
 }
 
-CachedImageDataContainerPtr SavingVideoRecorder::getImageData()
+ImageDataContainerPtr SavingVideoRecorder::getImageData()
 {
-	return mImages;
+	if (mImages)
+		return mImages;
+	return mFrameContainerImages;
 }
 
 std::vector<TimeInfo> SavingVideoRecorder::getTimestamps()
@@ -242,7 +299,7 @@ void SavingVideoRecorder::cancel()
 void SavingVideoRecorder::deleteFolder(QString folder)
 {
 	QStringList filters;
-	filters << "*.fts" << "*.mhd" << "*.raw" << "*.zraw";
+	filters << "*.fts" << "*.mhd" << "*.raw" << "*.zraw" << "*."+FrameContainerWriter::getSuffix();
 	for (int i=0; i<filters.size(); ++i) // prepend prefix, ensuring files from other savers are not deleted.
 		filters[i] = mPrefix + filters[i];
 
@@ -258,6 +315,29 @@ void SavingVideoRecorder::completeSave()
 {
 	mSaveThread->stop();
 	mSaveThread->wait(); // wait indefinitely for thread to finish
+
+	int dropped = mSaveThread->getDroppedFrames();
+	if (dropped && !mDroppedFramesReported)
+	{
+		reportWarning(QString("Recording of %1 dropped %2 of %3 frames, saving was too slow.")
+					  .arg(mSource->getName())
+					  .arg(dropped)
+					  .arg(dropped + mSaveThread->getWrittenFrames()));
+		mDroppedFramesReported = true;
+	}
+
+	// the container can be read only after the index has been written
+	if (!mImages && !mFrameContainerImages)
+	{
+		MappedFrameContainerPtr container(new MappedFrameContainer(mSaveThread->getFrameContainerFilename()));
+		container->setDeleteFileOnRelease(true);
+		mFrameContainerImages = container;
+	}
+}
+
+int SavingVideoRecorder::getDroppedFrames() const
+{
+	return mSaveThread->getDroppedFrames();
 }
 
 } // namespace cx
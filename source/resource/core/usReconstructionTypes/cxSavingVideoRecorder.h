@@ -17,14 +17,19 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <QFile>
 #include <QThread>
 #include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
 
 #include "vtkForwardDeclarations.h"
 #include "cxForwardDeclarations.h"
 #include "cxData.h"
+#include "cxFrameRingBuffer.h"
 
 namespace cx
 {
 typedef boost::shared_ptr<class CachedImageDataContainer> CachedImageDataContainerPtr;
+typedef boost::shared_ptr<class ImageDataContainer> ImageDataContainerPtr;
+typedef boost::shared_ptr<class FrameContainerWriter> FrameContainerWriterPtr;
 
 /** Class that saves vtkImageData continously to file.
   *
@@ -36,6 +41,13 @@ typedef boost::shared_ptr<class CachedImageDataContainer> CachedImageDataContain
   * A sequence of N files named \<prefix\>_i.mhd (0<i<N) and corresponding .raw
   * files are written.
   *
+  * If useFrameContainer is set, all frames and timestamps are instead appended
+  * to the single file \<prefix\>.cxframes, see FrameContainerWriter.
+  *
+  * Incoming frames are copied into a preallocated FrameRingBuffer and handed
+  * to the thread without locking. If the thread falls behind and the ring
+  * is full, new frames are dropped and counted, see getDroppedFrames().
+  *
   * If stop() is called, the thread will continue to write all remaining data,
   * then close files and return from run().
   *
@@ -52,32 +64,37 @@ public:
 	/**
 	  * Create the thread object, set folder to save to.
 	  */
-	VideoRecorderSaveThread(QObject* parent, QString saveFolder, QString prefix, bool compressed, bool writeColor);
+	VideoRecorderSaveThread(QObject* parent, QString saveFolder, QString prefix, bool compressed, bool writeColor, bool useFrameContainer = false);
 	virtual ~VideoRecorderSaveThread();
 	/**
-	  * Add data to be saved.
+	  * Add data to be saved. Return the file the data will be saved to,
+	  * or empty if the frame was dropped.
 	  */
 	QString addData(TimeInfo timestamp, vtkImageDataPtr data);
+	QString getFrameContainerFilename() const;
+	void setMemoryLimit(double bytes); ///< max memory used for frames waiting to be written. Call before the first addData().
 	void stop();
 	void cancel();
 
+	int getDroppedFrames() const { return mDroppedFrames.load(); } ///< frames not saved because the queue was full
+	int getWrittenFrames() const { return mWrittenFrames.load(); }
+
 protected:
-	struct DataType
-	{
-		TimeInfo mTimestamp;
-		QString mImageFilename;
-		vtkImageDataPtr mImage;
-	};
 	QString mSaveFolder;
 	QString mPrefix;
 	int mImageIndex;
-	std::list<DataType> mPendingData;
-	QMutex mMutex; ///< protects the mPendingData
+	FrameRingBuffer mPendingData;
+	QAtomicInt mDroppedFrames;
+	QAtomicInt mWrittenFrames;
+	QMutex mMutex; ///< used for waking the thread only, mPendingData is lock-free
+	QWaitCondition mDataAdded;
+	QAtomicInt mWaiting; ///< the thread is waiting for data
 	bool mStop;
 	bool mCancel;
 	QFile mTimestampsFile;
 	bool mCompressed;
 	bool mWriteColor;
+	FrameContainerWriterPtr mFrameContainer; ///< used instead of mhd files if set
 	/**
 	  * Save the images to disk
 	  */
@@ -86,8 +103,10 @@ protected:
 	void writeQueue();
 	bool openTimestampsFile();
 	bool closeTimestampsFile();
-	void write(DataType data);
+	void write(const FrameRingBuffer::Frame& data);
 	void writeTimeStampsFile(TimeInfo timeStamps);
+	QString getImageFilename(int index) const;
+	void wakeThread();
 };
 
 /** \brief Recorder for a VideoSource.
@@ -106,20 +125,26 @@ class cxResource_EXPORT SavingVideoRecorder : public QObject
 	Q_OBJECT
 
 public:
-	SavingVideoRecorder(VideoSourcePtr source, QString saveFolder, QString prefix, bool compressed, bool writeColor, FileManagerServicePtr filemanagerservice);
+	SavingVideoRecorder(VideoSourcePtr source, QString saveFolder, QString prefix, bool compressed, bool writeColor, FileManagerServicePtr filemanagerservice, bool useFrameContainer = false);
 	virtual ~SavingVideoRecorder();
 
 	virtual void startRecord();
 	virtual void stopRecord();
 	void cancel();
 
-	CachedImageDataContainerPtr getImageData();
+	/** Return the recorded frames. If a frame container is used,
+	  * this is NULL until completeSave() has been called.
+	  */
+	ImageDataContainerPtr getImageData();
 	std::vector<TimeInfo> getTimestamps();
 	QString getSaveFolder() { return mSaveFolder; }
 
 	/** Call to force complete the writing of data to disk.
+	  * If a frame container is used, it is opened for reading here.
+	  * Can be called several times.
 	  */
 	void completeSave();
+	int getDroppedFrames() const; ///< frames not saved because the save thread could not keep up
 
 	VideoSourcePtr getSource() { return mSource; }
 
@@ -131,11 +156,13 @@ private:
 	  */
 	void deleteFolder(QString folder);
 	CachedImageDataContainerPtr mImages;
+	ImageDataContainerPtr mFrameContainerImages;
 	std::vector<TimeInfo> mTimestamps;
 	QString mSaveFolder;
 	QString mPrefix;
 	VideoSourcePtr mSource;
 	boost::shared_ptr<VideoRecorderSaveThread> mSaveThread;
+	bool mDroppedFramesReported;
 
 };
 
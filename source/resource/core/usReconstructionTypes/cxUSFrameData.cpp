@@ -22,10 +22,14 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <QFileInfo>
 #include "cxTimeKeeper.h"
 #include "cxImageDataContainer.h"
+#include "cxFrameContainerFile.h"
 #include "cxVolumeHelpers.h"
 #include "cxLogger.h"
 #include "cxFileManagerService.h"
 #include "cxImage.h"
+#include <QThread>
+#include <QtConcurrentMap>
+#include <algorithm>
 
 
 typedef vtkSmartPointer<vtkImageAppend> vtkImageAppendPtr;
@@ -126,6 +130,7 @@ USFrameDataPtr USFrameData::create(ImagePtr inputFrameData)
 }
 
 /** Create object from file.
+  * If file+.cxframes exists, read frames from this frame container.
   * If file or file+.mhd exists, use this,
   * Otherwise assume input is split over several
   * files and try to load all mhdFile + i + ".mhd".
@@ -137,6 +142,14 @@ USFrameDataPtr USFrameData::create(QString inputFilename, FileManagerServicePtr
 
 	TimeKeeper timer;
 	QString mhdSingleFile = info.absolutePath()+"/"+info.completeBaseName()+".mhd";
+	QString frameContainerFile = info.absolutePath()+"/"+info.completeBaseName()+"."+FrameContainerWriter::getSuffix();
+
+	if (QFileInfo(frameContainerFile).exists())
+	{
+		MappedFrameContainerPtr container(new MappedFrameContainer(frameContainerFile));
+		if (container->isValid())
+			return USFrameData::create(info.completeBaseName(), container);
+	}
 
 	if (QFileInfo(mhdSingleFile).exists())
 	{
@@ -348,6 +361,21 @@ vtkImageDataPtr USFrameData::useAngio(vtkImageDataPtr inData, vtkImageDataPtr gr
 
 	vtkImageDataPtr outData = vtkImageDataPtr::New();
 	outData->DeepCopy(grayFrame);
+	this->removeGrayscale(inData, outData);
+	return outData;
+}
+
+/** Zero all pixels in outData that are gray or near gray in the color image inData.
+ *  outData must be a grayscale copy of inData.
+ *
+ *  Thread safety: The VTK calls used, GetExtent(), GetScalarPointerForExtent() and
+ *  GetContinuousIncrements(), only read the image geometry and the scalar pointer of the
+ *  plain arrays used for frames. They do not update a pipeline or allocate. The images are
+ *  passed by reference, thus the reference counts are not touched. Thus it can be called
+ *  in parallel for different outData, as long as no thread modifies inData.
+ */
+void USFrameData::removeGrayscale(const vtkImageDataPtr& inData, const vtkImageDataPtr& outData) const
+{
 //	outData->Update(); // updates whole extent.
 
 //	printStuff("Clipped color in", inData);
@@ -410,8 +438,6 @@ vtkImageDataPtr USFrameData::useAngio(vtkImageDataPtr inData, vtkImageDataPtr gr
 		}
 		inPtr += inInc[2];
 	}
-
-	return outData;
 }
 
 void USFrameData::setPurgeInputDataAfterInitialize(bool value)
@@ -421,50 +447,104 @@ void USFrameData::setPurgeInputDataAfterInitialize(bool value)
 
 std::vector<std::vector<vtkImageDataPtr> > USFrameData::initializeFrames(std::vector<bool> angio)
 {
+	std::vector<std::vector<vtkImageDataPtr> > raw = this->initializeFrames(angio, 0, mReducedToFull.size());
+
+	if (mPurgeInput)
+		mImageContainer->purgeAll();
+
+	return raw;
+}
+
+/** Frames are processed in chunks: The VTK part (reading, cropping, grayscale
+ *  conversion and allocation of output frames) is done serially, then the angio
+ *  extraction is run for all frames in the chunk in parallel. Each raw frame is
+ *  read and converted to grayscale once, and the gray and angio frames are
+ *  shared between all outputs requesting them.
+ */
+std::vector<std::vector<vtkImageDataPtr> > USFrameData::initializeFrames(std::vector<bool> angio, unsigned first, unsigned count)
+{
+	first = std::min<unsigned>(first, mReducedToFull.size());
+	count = std::min<unsigned>(count, mReducedToFull.size() - first);
 
 	std::vector<std::vector<vtkImageDataPtr> > raw(angio.size());
 
 	for (unsigned i=0; i<raw.size(); ++i)
 	{
-		raw[i].resize(mReducedToFull.size());
+		raw[i].resize(count);
 	}
 
-	// apply cropping and angio
-	for (unsigned i=0; i<mReducedToFull.size(); ++i)
+	bool anyAngio = std::find(angio.begin(), angio.end(), true) != angio.end();
+	unsigned chunkSize = 4 * std::max(QThread::idealThreadCount(), 1);
+
+	for (unsigned chunkStart=0; chunkStart<count; chunkStart+=chunkSize)
 	{
-		CX_ASSERT(mImageContainer->size() > mReducedToFull[i]);
-		vtkImageDataPtr current = mImageContainer->get(mReducedToFull[i]);
+		unsigned chunkStop = std::min(chunkStart+chunkSize, count);
+		std::vector<std::pair<vtkImageDataPtr, vtkImageDataPtr> > angioJobs; // color input, angio output
 
-		if (mCropbox.range()[0]!=0)
-			current = this->cropImageExtent(current, mCropbox);
+		// apply cropping, grayscale and allocate angio frames
+		for (unsigned i=chunkStart; i<chunkStop; ++i)
+		{
+			unsigned frame = first + i;
+			CX_ASSERT(mImageContainer->size() > mReducedToFull[frame]);
+			vtkImageDataPtr current = mImageContainer->get(mReducedToFull[frame]);
 
-		// optimization: grayFrame is used in both calculations: compute once
-		vtkImageDataPtr grayFrame = this->to8bitGrayscaleAndEffectuateCropping(current);
+			if (mCropbox.range()[0]!=0)
+				current = this->cropImageExtent(current, mCropbox);
 
-		for (unsigned j=0; j<angio.size(); ++j)
-		{
+			// optimization: grayFrame is used in both calculations: compute once
+			vtkImageDataPtr grayFrame = this->to8bitGrayscaleAndEffectuateCropping(current);
+			vtkImageDataPtr angioFrame = grayFrame;
 
-			if (angio[j])
+			if (anyAngio)
 			{
-				vtkImageDataPtr angioFrame = this->useAngio(current, grayFrame, i);
-				raw[j][i] = angioFrame;
+				if (current->GetNumberOfScalarComponents() != 3)
+				{
+					if (frame == 0) //Only report warning once
+						reportWarning("Angio requested for grayscale ultrasound");
+				}
+				else
+				{
+					angioFrame = vtkImageDataPtr::New();
+					angioFrame->DeepCopy(grayFrame);
+					angioJobs.push_back(std::make_pair(current, angioFrame));
+				}
 			}
-			else
+
+			for (unsigned j=0; j<angio.size(); ++j)
 			{
-				raw[j][i] = grayFrame;
+				raw[j][i] = angio[j] ? angioFrame : grayFrame;
 			}
 		}
 
+		// angio extraction only reads the frame pair through thread safe VTK calls: run in parallel
+		QtConcurrent::blockingMap(angioJobs, [this](std::pair<vtkImageDataPtr, vtkImageDataPtr>& job)
+		{
+			this->removeGrayscale(job.first, job.second);
+		});
+		angioJobs.clear();
+
 		if (mPurgeInput)
-			mImageContainer->purge(mReducedToFull[i]);
+		{
+			for (unsigned i=chunkStart; i<chunkStop; ++i)
+				mImageContainer->purge(mReducedToFull[first + i]);
+		}
 	}
 
-	if (mPurgeInput)
-		mImageContainer->purgeAll();
-
 	return raw;
 }
 
+double USFrameData::getEstimatedFrameMemoryUse(unsigned outputCount) const
+{
+	if (mImageContainer->empty())
+		return 0;
+	vtkImageDataPtr image = mImageContainer->get(0);
+	Eigen::Array3i rawDims(image->GetDimensions());
+	double rawSize = double(rawDims[0]) * rawDims[1] * image->GetNumberOfScalarComponents() * image->GetScalarSize();
+	Eigen::Array3i dims = this->getDimensions();
+	double processedSize = double(dims[0]) * dims[1];
+	return rawSize + outputCount * processedSize;
+}
+
 void USFrameData::purgeAll()
 {
 	mImageContainer->purgeAll();
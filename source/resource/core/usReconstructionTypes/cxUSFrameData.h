@@ -110,6 +110,15 @@ public:
 	  * of them should be angio or grayscale.
 	  */
 	std::vector<std::vector<vtkImageDataPtr> > initializeFrames(std::vector<bool> angio);
+	/** Same as initializeFrames(angio), but only for the frames [first, first+count).
+	  * Input frames are purged as soon as they are processed, thus a sweep can be
+	  * processed window by window with memory use proportional to count.
+	  */
+	std::vector<std::vector<vtkImageDataPtr> > initializeFrames(std::vector<bool> angio, unsigned first, unsigned count);
+	/** Estimated memory use in bytes of one raw input frame plus one processed
+	  * frame for each of outputCount outputs.
+	  */
+	double getEstimatedFrameMemoryUse(unsigned outputCount) const;
 
 	virtual USFrameDataPtr copy();
 	void purgeAll();
@@ -120,6 +129,7 @@ public:
 protected:
 	USFrameData();
 	vtkImageDataPtr useAngio(vtkImageDataPtr inData, vtkImageDataPtr grayFrame, int frameNum) const;/// Use only US angio data as input. Removes grayscale from the US data and converts the remaining color to grayscale
+	void removeGrayscale(const vtkImageDataPtr& inData, const vtkImageDataPtr& outData) const; ///< see cpp for thread safety
 
 	vtkImageDataPtr cropImageExtent(vtkImageDataPtr input, IntBoundingBox3D cropbox) const;
 	vtkImageDataPtr to8bitGrayscaleAndEffectuateCropping(vtkImageDataPtr input) const;
@@ -30,6 +30,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxUSReconstructInputDataAlgoritms.h"
 #include "cxCustomMetaImage.h"
 #include "cxErrorObserver.h"
+#include "cxFrameContainerFile.h"
 
 
 typedef vtkSmartPointer<vtkImageAppend> vtkImageAppendPtr;
@@ -38,7 +39,8 @@ namespace cx
 {
 
 UsReconstructionFileMaker::UsReconstructionFileMaker(QString sessionDescription) :
-    mSessionDescription(sessionDescription)
+    mSessionDescription(sessionDescription),
+	mUseFrameContainer(false)
 {
 }
 
@@ -353,9 +355,26 @@ void UsReconstructionFileMaker::writeUSImages(QString path, ImageDataContainerPt
 		customReader->setTransform(pos[i].mPos);
 		customReader->setModality("US");
 		customReader->setImageType(mSessionDescription);
+		customReader->write();
 	}
 }
 
+void UsReconstructionFileMaker::writeUSImagesToFrameContainer(QString path, ImageDataContainerPtr images, bool compression, std::vector<TimedPosition> pos)
+{
+	CX_ASSERT(images->size()==pos.size());
+	QString filename = QString("%1/%2.%3").arg(path).arg(mSessionDescription).arg(FrameContainerWriter::getSuffix());
+
+	FrameContainerWriter writer;
+	if (!writer.open(filename, compression))
+		return;
+	for (unsigned i=0; i<images->size(); ++i)
+		writer.append(images->get(i), pos[i].mTimeInfo, pos[i].mPos);
+	writer.close();
+
+	QFileInfo info(filename);
+	mReport << QString("%1, %2 bytes, %3 frames.").arg(info.fileName()).arg(info.size()).arg(images->size());
+}
+
 void UsReconstructionFileMaker::writeMask(QString path, QString session, vtkImageDataPtr mask)
 {
 	QString filename = QString("%1/%2.mask.mhd").arg(path).arg(session);
@@ -413,7 +432,9 @@ QString UsReconstructionFileMaker::writeToNewFolder(QString path, bool compressi
 	this->writeREADMEFile(path, session);
 
 	ImageDataContainerPtr imageData = mReconstructData.mUsRaw->getImageContainer();
-	if (imageData)
+	if (imageData && mUseFrameContainer)
+		this->writeUSImagesToFrameContainer(path, imageData, compression, mReconstructData.mFrames);
+	else if (imageData)
 		this->writeUSImages(path, imageData, compression, mReconstructData.mFrames);
 	else
 		mReport << "failed to find frame data, save failed.";
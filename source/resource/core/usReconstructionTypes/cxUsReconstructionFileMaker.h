@@ -61,6 +61,9 @@ public:
 	QString writeToNewFolder(QString path, bool compression);
 
 	QString getSessionName() const { return mSessionDescription; }
+	/** Write all frames to one \<session\>.cxframes file instead of one mhd file per frame.
+	 */
+	void setUseFrameContainer(bool on) { mUseFrameContainer = on; }
 
 
 	/**
@@ -94,6 +97,7 @@ private:
 	bool writeTrackerTimestamps(QString reconstructionFolder, QString session, std::vector<TimedPosition> ts);
 	void writeProbeConfiguration(QString reconstructionFolder, QString session, ProbeDefinition data, QString uid);
 	void writeUSImages(QString path, ImageDataContainerPtr images, bool compression, std::vector<TimedPosition> pos);
+	void writeUSImagesToFrameContainer(QString path, ImageDataContainerPtr images, bool compression, std::vector<TimedPosition> pos);
 	void writeMask(QString path, QString session, vtkImageDataPtr mask);
 	void writeREADMEFile(QString reconstructionFolder, QString session);
 	bool writeTimestamps(QString filename, std::vector<TimedPosition> ts, QString type, TimeStampType timeStampType = Modified);
@@ -106,6 +110,7 @@ private:
 	USReconstructInputData mReconstructData;
 	QString mSessionDescription;
 	QStringList mReport;
+	bool mUseFrameContainer;
 };
 
 typedef boost::shared_ptr<UsReconstructionFileMaker> UsReconstructionFileMakerPtr;
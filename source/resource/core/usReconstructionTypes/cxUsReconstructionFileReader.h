@@ -75,6 +75,13 @@ ProbeCalibration = <not used>
  * See http://www.itk.org/Wiki/MetaIO/Documentation for more.
  * Replaces ref us_acq_file_format_mhd .
  *
+ * \subsection us_acq_file_format_cxframes \<filebase\>.cxframes
+ *
+ * A single binary file containing all frames, each with its timestamps and
+ * rMu position, followed by a frame index. See FrameContainerWriter for the layout.
+ * Written instead of \ref us_acq_file_format_mhd_indexed if the frame container format
+ * is selected, and read in preference to it if present. The other files are written as before.
+ *
  * \subsection us_acq_file_format_file_xml ProbeCalibConfigs.xml (obsolete)
  *
  * This file contains the probe definition, and is copied from the
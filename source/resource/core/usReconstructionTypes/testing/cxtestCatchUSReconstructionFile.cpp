@@ -19,6 +19,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxDataLocations.h"
 #include "cxLogicManager.h"
 #include "cxFileManagerServiceProxy.h"
+#include "cxUtilHelpers.h"
+#include <QFileInfo>
 
 
 TEST_CASE_METHOD(cxtest::USReconstructionFileFixture, "USReconstructionFile: Create unique folders", "[unit][resource][usReconstructionTypes]")
@@ -79,3 +81,18 @@ TEST_CASE_METHOD(cxtest::USReconstructionFileFixture, "USReconstructionFile: Sav
 	this->assertCorrespondence(input, hasBeenRead);
 	cx::LogicManager::shutdown();
 }
+
+TEST_CASE_METHOD(cxtest::USReconstructionFileFixture, "USReconstructionFile: Save and load USReconstructInputData using frame container", "[integration][resource][usReconstructionTypes]")
+{
+	cx::LogicManager::initialize();
+	cx::FileManagerServicePtr filemanager = cx::FileManagerServiceProxy::create(cx::logicManager()->getPluginContext());
+	ReconstructionData input = this->createSampleReconstructData();
+
+	QString filename = this->write(input, true);
+	CHECK(QFileInfo(cx::changeExtension(filename, "cxframes")).exists());
+	CHECK(!QFileInfo(cx::changeExtension(filename, "")+"_0.mhd").exists());
+	cx::USReconstructInputData hasBeenRead = this->read(filename, filemanager);
+
+	this->assertCorrespondence(input, hasBeenRead);
+	cx::LogicManager::shutdown();
+}
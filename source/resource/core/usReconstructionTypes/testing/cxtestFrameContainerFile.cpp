@@ -0,0 +1,115 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <vtkImageData.h>
+#include "cxFrameContainerFile.h"
+#include "cxDataLocations.h"
+#include "cxVolumeHelpers.h"
+
+namespace cxtest
+{
+
+namespace
+{
+QString getTestFilename()
+{
+	QString path = cx::DataLocations::getTestDataPath() + "/temp/FrameContainerFile";
+	QDir().mkpath(path);
+	return path + "/test.cxframes";
+}
+
+vtkImageDataPtr createFrame(int index)
+{
+	vtkImageDataPtr frame = cx::generateVtkImageData(Eigen::Array3i(30, 20, 1), cx::Vector3D(0.5, 0.25, 1), 0);
+	unsigned char* ptr = static_cast<unsigned char*>(frame->GetScalarPointer());
+	for (int i=0; i<30*20; ++i)
+		ptr[i] = (i + index) % 256;
+	return frame;
+}
+
+void writeFrames(QString filename, bool compressed, int count)
+{
+	cx::FrameContainerWriter writer;
+	REQUIRE(writer.open(filename, compressed));
+	for (int i=0; i<count; ++i)
+		REQUIRE(writer.append(createFrame(i), cx::TimeInfo(1000+10*i), cx::createTransformTranslate(cx::Vector3D(i, 0, 0))));
+	REQUIRE(writer.close());
+}
+
+void checkFrames(QString filename, int count)
+{
+	cx::MappedFrameContainer container(filename);
+	REQUIRE(container.isValid());
+	REQUIRE(container.size()==count);
+	for (int i=0; i<count; ++i)
+	{
+		vtkImageDataPtr expected = createFrame(i);
+		vtkImageDataPtr frame = container.get(i);
+		REQUIRE(frame);
+		CHECK((Eigen::Array3i(frame->GetDimensions())==Eigen::Array3i(expected->GetDimensions())).all());
+		CHECK(cx::similar(cx::Vector3D(frame->GetSpacing()), cx::Vector3D(expected->GetSpacing())));
+		unsigned char* a = static_cast<unsigned char*>(frame->GetScalarPointer());
+		unsigned char* b = static_cast<unsigned char*>(expected->GetScalarPointer());
+		CHECK(std::equal(a, a+30*20, b));
+		CHECK(cx::similar(container.getTimestamp(i).getAcquisitionTime(), 1000+10*i));
+		CHECK(cx::similar(container.getTransform(i), cx::createTransformTranslate(cx::Vector3D(i, 0, 0))));
+	}
+}
+} // namespace
+
+TEST_CASE("FrameContainerFile: Write and read uncompressed frames", "[unit][resource][usReconstructionTypes]")
+{
+	QString filename = getTestFilename();
+	writeFrames(filename, false, 5);
+	checkFrames(filename, 5);
+	QFile::remove(filename);
+}
+
+TEST_CASE("FrameContainerFile: Write and read compressed frames", "[unit][resource][usReconstructionTypes]")
+{
+	QString filename = getTestFilename();
+	writeFrames(filename, true, 5);
+	checkFrames(filename, 5);
+	QFile::remove(filename);
+}
+
+TEST_CASE("FrameContainerFile: Recover frames from file without index", "[unit][resource][usReconstructionTypes]")
+{
+	QString filename = getTestFilename();
+	writeFrames(filename, false, 4);
+	// cut the index and part of the last frame, as after a crash during writing
+	QFile file(filename);
+	REQUIRE(file.open(QIODevice::ReadWrite));
+	qint64 fullSize = file.size();
+	file.resize(fullSize - 200);
+	file.close();
+
+	checkFrames(filename, 3);
+	QFile::remove(filename);
+}
+
+TEST_CASE("FrameContainerFile: Delete file on release", "[unit][resource][usReconstructionTypes]")
+{
+	QString filename = getTestFilename();
+	writeFrames(filename, false, 1);
+	{
+		cx::MappedFrameContainer container(filename);
+		container.setDeleteFileOnRelease(true);
+		CHECK(container.size()==1);
+	}
+	CHECK(!QFile::exists(filename));
+}
+
+} // namespace cxtest
@@ -0,0 +1,91 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <vtkImageData.h>
+#include "cxFrameRingBuffer.h"
+#include "cxVolumeHelpers.h"
+
+namespace cxtest
+{
+
+namespace
+{
+vtkImageDataPtr createFrame(unsigned char value)
+{
+	return cx::generateVtkImageData(Eigen::Array3i(8, 4, 1), cx::Vector3D(1, 1, 1), value);
+}
+
+unsigned char getValue(cx::FrameRingBuffer::Frame* frame)
+{
+	return *static_cast<unsigned char*>(frame->mImage->GetScalarPointer());
+}
+} // namespace
+
+TEST_CASE("FrameRingBuffer: Frames are returned in order until the ring is full", "[unit][resource][usReconstructionTypes]")
+{
+	cx::FrameRingBuffer ring;
+	ring.setMaxCapacity(4);
+
+	CHECK(ring.empty());
+	CHECK(!ring.front());
+
+	for (int i=0; i<4; ++i)
+		CHECK(ring.push(createFrame(10+i), cx::TimeInfo(i), i));
+	CHECK(!ring.push(createFrame(100), cx::TimeInfo(4), 4)); // full
+	CHECK(ring.getCapacity()==5);
+
+	for (int i=0; i<4; ++i)
+	{
+		cx::FrameRingBuffer::Frame* frame = ring.front();
+		REQUIRE(frame);
+		CHECK(frame->mIndex==i);
+		CHECK(getValue(frame)==10+i);
+		ring.pop();
+	}
+	CHECK(ring.empty());
+}
+
+TEST_CASE("FrameRingBuffer: Slots are reused without allocation", "[unit][resource][usReconstructionTypes]")
+{
+	cx::FrameRingBuffer ring;
+	ring.setMaxCapacity(2);
+
+	REQUIRE(ring.push(createFrame(1), cx::TimeInfo(0), 0));
+	cx::FrameRingBuffer::Frame* frame = ring.front();
+	vtkImageData* slotImage = frame->mImage.GetPointer();
+	void* slotData = frame->mImage->GetScalarPointer();
+	ring.pop();
+
+	// wrap around the ring, back to the first slot
+	REQUIRE(ring.getCapacity()==3);
+	for (int i=1; i<3; ++i)
+	{
+		REQUIRE(ring.push(createFrame(i+1), cx::TimeInfo(i), i));
+		ring.pop();
+	}
+	REQUIRE(ring.push(createFrame(42), cx::TimeInfo(3), 3));
+	frame = ring.front();
+	CHECK(frame->mImage.GetPointer()==slotImage);
+	CHECK(frame->mImage->GetScalarPointer()==slotData);
+	CHECK(getValue(frame)==42);
+}
+
+TEST_CASE("FrameRingBuffer: Capacity is limited by memory", "[unit][resource][usReconstructionTypes]")
+{
+	cx::FrameRingBuffer ring;
+	ring.setMemoryLimit(8*4*10); // room for 10 frames
+	REQUIRE(ring.push(createFrame(1), cx::TimeInfo(0), 0));
+	CHECK(ring.getCapacity()==11);
+}
+
+} // namespace cxtest
@@ -0,0 +1,90 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <vtkImageData.h>
+#include "cxUSFrameData.h"
+#include "cxVolumeHelpers.h"
+
+namespace cxtest
+{
+
+namespace
+{
+/** Create color frames that are gray except for one red pixel at (0,0).
+ */
+std::vector<vtkImageDataPtr> createColorFrames(int count)
+{
+	std::vector<vtkImageDataPtr> retval;
+	for (int i=0; i<count; ++i)
+	{
+		vtkImageDataPtr frame = cx::generateVtkImageData(Eigen::Array3i(10,10,1), cx::Vector3D(1,1,1), 100, 3);
+		unsigned char* ptr = static_cast<unsigned char*>(frame->GetScalarPointer());
+		ptr[0] = 200;
+		ptr[1] = 0;
+		ptr[2] = 0;
+		retval.push_back(frame);
+	}
+	return retval;
+}
+
+unsigned char getValue(vtkImageDataPtr image, int x, int y)
+{
+	return *static_cast<unsigned char*>(image->GetScalarPointer(x, y, 0));
+}
+} // namespace
+
+TEST_CASE("USFrameData: Angio and B-mode frames are created in one pass", "[unit][resource][usReconstructionTypes]")
+{
+	int frameCount = 37;
+	cx::USFrameDataPtr data = cx::USFrameData::create("test", createColorFrames(frameCount));
+	data->setPurgeInputDataAfterInitialize(false);
+
+	std::vector<bool> angio;
+	angio.push_back(false);
+	angio.push_back(true);
+	angio.push_back(true);
+	std::vector<std::vector<vtkImageDataPtr> > frames = data->initializeFrames(angio);
+
+	REQUIRE(frames.size() == 3);
+	for (int i=0; i<frameCount; ++i)
+	{
+		// B-mode keeps the gray pixels
+		CHECK(getValue(frames[0][i], 5, 5) > 0);
+		CHECK(getValue(frames[0][i], 0, 0) > 0);
+		// angio keeps the color pixels only
+		CHECK(getValue(frames[1][i], 5, 5) == 0);
+		CHECK(getValue(frames[1][i], 0, 0) > 0);
+		// outputs of the same type share frames
+		CHECK(frames[1][i].GetPointer() == frames[2][i].GetPointer());
+	}
+}
+
+TEST_CASE("USFrameData: Windowed frame initialization equals full initialization", "[unit][resource][usReconstructionTypes]")
+{
+	int frameCount = 20;
+	cx::USFrameDataPtr data = cx::USFrameData::create("test", createColorFrames(frameCount));
+	data->setPurgeInputDataAfterInitialize(false);
+
+	std::vector<bool> angio(1, true);
+	std::vector<std::vector<vtkImageDataPtr> > all = data->initializeFrames(angio);
+	std::vector<std::vector<vtkImageDataPtr> > window = data->initializeFrames(angio, 15, 10);
+
+	REQUIRE(window[0].size() == 5);
+	for (unsigned i=0; i<window[0].size(); ++i)
+	{
+		CHECK(getValue(window[0][i], 0, 0) == getValue(all[0][15+i], 0, 0));
+		CHECK(getValue(window[0][i], 5, 5) == getValue(all[0][15+i], 5, 5));
+	}
+}
+
+} // namespace cxtest
@@ -54,7 +54,7 @@ protected:
 
 	cx::USReconstructInputData createUSReconstructData(ReconstructionData input);
 
-	QString write(ReconstructionData input);
+	QString write(ReconstructionData input, bool useFrameContainer = false);
 	cx::USReconstructInputData read(QString filename, cx::FileManagerServicePtr filemanagerservice);
 	void assertCorrespondence(ReconstructionData input, cx::USReconstructInputData output);
 };
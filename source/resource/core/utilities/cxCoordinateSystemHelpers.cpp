@@ -11,6 +11,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include "cxCoordinateSystemHelpers.h"
 
+#include <QHash>
 #include "cxDefinitionStrings.h"
 
 namespace cx
@@ -44,6 +45,11 @@ bool operator==(const CoordinateSystem& lhs, const CoordinateSystem& rhs)
 	return ( lhs.mId==rhs.mId )&&( lhs.mRefObject==rhs.mRefObject );
 }
 
+uint qHash(const CoordinateSystem& key, uint seed)
+{
+	return qHash(key.mRefObject, seed) ^ uint(key.mId);
+}
+
 // --------------------------------------------------------
 
 
@@ -43,6 +43,7 @@ struct cxResource_EXPORT CoordinateSystem
 
 };
 cxResource_EXPORT bool operator==(const CoordinateSystem& lhs, const CoordinateSystem& rhs);
+cxResource_EXPORT uint qHash(const CoordinateSystem& key, uint seed = 0); ///< enables use as key in QHash
 typedef CoordinateSystem Space;
 
 
@@ -11,8 +11,15 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxCustomMetaImage.h"
 
 #include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QSysInfo>
 #include <QTextStream>
 #include <QStringList>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkDataArray.h>
+#include <vtkCallbackCommand.h>
 #include "cxLogger.h"
 
 #include "cxTypeConversions.h"
@@ -21,33 +28,47 @@ namespace cx
 {
 
 CustomMetaImage::CustomMetaImage(QString filename) :
-    mFilename(filename)
-{}
-
-QString CustomMetaImage::readKey(QString key)
+    mFilename(filename),
+    mModified(false),
+    mEmbeddedData(false)
 {
 	QFile file(mFilename);
+	if (!file.open(QIODevice::ReadOnly))
+		return;
+
+	QTextStream stream(&file);
+	while (!stream.atEnd())
+	{
+		QString line = stream.readLine();
+		mLines << line;
+		// the voxel data of .mha files follow the header
+		if (line.startsWith("ElementDataFile", Qt::CaseInsensitive) && line.contains("LOCAL"))
+		{
+			mEmbeddedData = true;
+			return;
+		}
+	}
+
+	// keep the final newline when writing
+	char last = 0;
+	if (file.size() && file.seek(file.size()-1) && file.getChar(&last) && last=='\n')
+		mLines << "";
+}
 
-	QString line;
-	if (file.open(QIODevice::ReadOnly))
+QString CustomMetaImage::readKey(QString key)
+{
+	for (int i=0; i<mLines.size(); ++i)
 	{
-		QTextStream t(&file);
-		while (!t.atEnd())
+		const QString& line = mLines[i];
+		if (line.startsWith(key, Qt::CaseInsensitive))
 		{
-			line.clear();
-			line = t.readLine();
-			// do something with the line
-			if (line.startsWith(key, Qt::CaseInsensitive))
+			QStringList list = line.split("=", QString::SkipEmptyParts);
+			if (list.size() >= 2)
 			{
-				QStringList list = line.split("=", QString::SkipEmptyParts);
-				if (list.size() >= 2)
-				{
-					list = list.mid(1);
-					return list.join("=");
-				}
+				list = list.mid(1);
+				return list.join("=");
 			}
 		}
-		file.close();
 	}
 
 	return "";
@@ -99,21 +120,31 @@ void CustomMetaImage::append(QStringList* data, QString key, QString value)
 
 void CustomMetaImage::setKey(QString key, QString value)
 {
-	QFile file(mFilename);
+	this->remove(&mLines, QStringList()<<key);
+	this->append(&mLines, key, value);
+	mModified = true;
+}
 
-	if (!file.open(QIODevice::ReadWrite))
+bool CustomMetaImage::write()
+{
+	if (!mModified)
+		return true;
+	if (mEmbeddedData)
 	{
-	  reportError("Failed to open file " + mFilename + ".");
-	  return;
+	  reportError("Cannot change header of file with embedded voxel data: " + mFilename);
+	  return false;
 	}
 
-	QStringList data = QTextStream(&file).readAll().split("\n");
-
-	this->remove(&data, QStringList()<<key);
-	this->append(&data, key, value);
+	QFile file(mFilename);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+	  reportError("Failed to open file " + mFilename + ".");
+	  return false;
+	}
 
-	file.resize(0);
-	file.write(data.join("\n").toLatin1());
+	file.write(mLines.join("\n").toLatin1());
+	mModified = false;
+	return true;
 }
 
 void CustomMetaImage::setModality(QString value)
@@ -142,37 +173,27 @@ Transform3D CustomMetaImage::readTransform()
   Vector3D e_y(0, 1, 0);
   Vector3D e_z(0, 0, 1);
 
-  QFile file(mFilename);
-
-  QString line;
-  if (file.open(QIODevice::ReadOnly))
+  for (int i=0; i<mLines.size(); ++i)
   {
-    QTextStream t(&file);
-    while (!t.atEnd())
+    const QString& line = mLines[i];
+    if (line.startsWith("Position", Qt::CaseInsensitive) || line.startsWith("Offset", Qt::CaseInsensitive))
     {
-      line.clear();
-      line = t.readLine();
-      // do something with the line
-      if (line.startsWith("Position", Qt::CaseInsensitive) || line.startsWith("Offset", Qt::CaseInsensitive))
-      {
-        QStringList list = line.split(" ", QString::SkipEmptyParts);
-        if (list.size()>=5)
-          p_r = Vector3D(list[2].toDouble(), list[3].toDouble(), list[4].toDouble());
-      }
-      else if (line.startsWith("TransformMatrix", Qt::CaseInsensitive) || line.startsWith("Orientation",
-          Qt::CaseInsensitive))
+      QStringList list = line.split(" ", QString::SkipEmptyParts);
+      if (list.size()>=5)
+        p_r = Vector3D(list[2].toDouble(), list[3].toDouble(), list[4].toDouble());
+    }
+    else if (line.startsWith("TransformMatrix", Qt::CaseInsensitive) || line.startsWith("Orientation",
+        Qt::CaseInsensitive))
+    {
+      QStringList list = line.split(" ", QString::SkipEmptyParts);
+
+      if (list.size()>=8)
       {
-        QStringList list = line.split(" ", QString::SkipEmptyParts);
-
-        if (list.size()>=8)
-        {
-          e_x = Vector3D(list[2].toDouble(), list[3].toDouble(), list[4].toDouble());
-          e_y = Vector3D(list[5].toDouble(), list[6].toDouble(), list[7].toDouble());
-          e_z = cross(e_x, e_y);
-        }
+        e_x = Vector3D(list[2].toDouble(), list[3].toDouble(), list[4].toDouble());
+        e_y = Vector3D(list[5].toDouble(), list[6].toDouble(), list[7].toDouble());
+        e_z = cross(e_x, e_y);
       }
     }
-    file.close();
   }
 
   Transform3D rMd = Transform3D::Identity();
@@ -195,15 +216,7 @@ Transform3D CustomMetaImage::readTransform()
 
 void CustomMetaImage::setTransform(const Transform3D M)
 {
-  QFile file(mFilename);
-
-  if (!file.open(QIODevice::ReadWrite))
-  {
-    reportWarning("Could not save transform because: Failed to open file " + mFilename);
-    return;
-  }
-
-  QStringList data = QTextStream(&file).readAll().split("\n");
+  QStringList& data = mLines;
 
   this->remove(&data, QStringList()<<"TransformMatrix"<<"Offset"<<"Position"<<"Orientation");
 
@@ -218,9 +231,112 @@ void CustomMetaImage::setTransform(const Transform3D M)
   for (int r=0; r<dim; ++r)
     posList << " " << M(r,3);
   this->append(&data, "Offset", qstring_cast(posList.str()));
+  mModified = true;
+}
+
+namespace
+{
+int getVtkScalarType(QString elementType)
+{
+	if (elementType=="MET_UCHAR")
+		return VTK_UNSIGNED_CHAR;
+	if (elementType=="MET_SHORT")
+		return VTK_SHORT;
+	if (elementType=="MET_USHORT")
+		return VTK_UNSIGNED_SHORT;
+	if (elementType=="MET_INT")
+		return VTK_INT;
+	if (elementType=="MET_UINT")
+		return VTK_UNSIGNED_INT;
+	if (elementType=="MET_FLOAT")
+		return VTK_FLOAT;
+	if (elementType=="MET_DOUBLE")
+		return VTK_DOUBLE;
+	return -1;
+}
+
+void unmapFileCallback(vtkObject*, unsigned long, void* clientData, void*)
+{
+	delete static_cast<QFile*>(clientData);
+}
+}
+
+/** Memory map the raw file of an uncompressed, single file image
+ *  directly into a vtkImageData, without copying. The mapping is
+ *  private: changes to the voxels are not written to file. The origin
+ *  is zero, as in the image readers.
+ *
+ *  The file must not be overwritten while the image is in use.
+ *  Return NULL for other kinds of files, use vtkMetaImageReader for those.
+ */
+vtkImageDataPtr CustomMetaImage::mapVoxelData()
+{
+	QString dataFile = this->readKey("ElementDataFile").trimmed();
+	if (dataFile.isEmpty() || dataFile=="LOCAL" || dataFile.startsWith("LIST") || dataFile.contains(" "))
+		return vtkImageDataPtr();
+	if (this->readKey("CompressedData").trimmed().compare("True", Qt::CaseInsensitive)==0)
+		return vtkImageDataPtr();
+
+	int scalarType = getVtkScalarType(this->readKey("ElementType").trimmed());
+	QStringList dimensions = this->readKey("DimSize").split(" ", QString::SkipEmptyParts);
+	QStringList spacing = this->readKey("ElementSpacing").split(" ", QString::SkipEmptyParts);
+	if (scalarType<0 || dimensions.size()<2 || dimensions.size()>3)
+		return vtkImageDataPtr();
+
+	int scalarSize = vtkDataArray::GetDataTypeSize(scalarType);
+	bool msb = this->readKey("ElementByteOrderMSB").trimmed().compare("True", Qt::CaseInsensitive)==0
+			|| this->readKey("BinaryDataByteOrderMSB").trimmed().compare("True", Qt::CaseInsensitive)==0;
+	if (scalarSize>1 && msb != (QSysInfo::ByteOrder==QSysInfo::BigEndian))
+		return vtkImageDataPtr();
+
+	int dim[3] = {1, 1, 1};
+	double space[3] = {1, 1, 1};
+	for (int i=0; i<3; ++i)
+	{
+		if (i < dimensions.size())
+			dim[i] = dimensions[i].toInt();
+		if (i < spacing.size())
+			space[i] = spacing[i].toDouble();
+	}
+	QString channelsText = this->readKey("ElementNumberOfChannels").trimmed();
+	int channels = channelsText.isEmpty() ? 1 : channelsText.toInt();
+	if (dim[0]<1 || dim[1]<1 || dim[2]<1 || channels<1)
+		return vtkImageDataPtr();
+
+	vtkIdType values = vtkIdType(dim[0])*dim[1]*dim[2]*channels;
+	qint64 size = qint64(values)*scalarSize;
+
+	QFile* file = new QFile(QFileInfo(mFilename).absoluteDir().absoluteFilePath(dataFile));
+	QString headerSizeText = this->readKey("HeaderSize").trimmed();
+	qint64 offset = headerSizeText.isEmpty() ? 0 : headerSizeText.toLongLong();
+	uchar* data = NULL;
+	if (file->open(QIODevice::ReadOnly))
+	{
+		if (offset<0) // -1: data are at the end of the file
+			offset = file->size() - size;
+		if (offset>=0 && offset%scalarSize==0 && file->size()>=offset+size)
+			data = file->map(offset, size, QFileDevice::MapPrivateOption);
+	}
+	if (!data)
+	{
+		delete file;
+		return vtkImageDataPtr();
+	}
 
-  file.resize(0);
-  file.write(data.join("\n").toLatin1());
+	vtkSmartPointer<vtkDataArray> array = vtkSmartPointer<vtkDataArray>::Take(vtkDataArray::CreateDataArray(scalarType));
+	array->SetNumberOfComponents(channels);
+	array->SetVoidArray(data, values, 1);
+	// the file is unmapped when the array is deleted
+	vtkSmartPointer<vtkCallbackCommand> unmap = vtkSmartPointer<vtkCallbackCommand>::New();
+	unmap->SetCallback(unmapFileCallback);
+	unmap->SetClientData(file);
+	array->AddObserver(vtkCommand::DeleteEvent, unmap);
+
+	vtkImageDataPtr retval = vtkImageDataPtr::New();
+	retval->SetExtent(0, dim[0]-1, 0, dim[1]-1, 0, dim[2]-1);
+	retval->SetSpacing(space);
+	retval->GetPointData()->SetScalars(array);
+	return retval;
 }
 
 }
@@ -14,7 +14,9 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxResourceExport.h"
 
 #include <QString>
+#include <QStringList>
 #include "cxTransform3D.h"
+#include "vtkForwardDeclarations.h"
 
 namespace cx
 {
@@ -26,6 +28,10 @@ typedef boost::shared_ptr<class CustomMetaImage> CustomMetaImagePtr;
  * This is meant as a supplement to vtkMetaImageReader/Writer,
  * extending that interface.
  *
+ * The header is read once on construction, and all reads use the
+ * parsed header. Changes made by the set methods are kept in memory
+ * until write() is called.
+ *
  * \ingroup cx_resource_core_utilities
  */
 class cxResource_EXPORT CustomMetaImage
@@ -45,8 +51,15 @@ public:
   QString readKey(QString key);
   void setKey(QString key, QString value);
 
+  bool write(); ///< write the header to file, if changed
+
+  vtkImageDataPtr mapVoxelData();
+
 private:
   QString mFilename;
+  QStringList mLines;
+  bool mModified;
+  bool mEmbeddedData;
 
   void remove(QStringList* data, QStringList keys);
   void append(QStringList* data, QString key, QString value);
@@ -18,6 +18,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxTypeConversions.h"
 #include "cxUtilHelpers.h"
 #include "cxBoundingBox3D.h"
+#include "cxCustomMetaImage.h"
 
 typedef vtkSmartPointer<class vtkImageImport> vtkImageImportPtr;
 
@@ -38,6 +39,9 @@ CachedImageData::~CachedImageData()
 
 vtkImageDataPtr CachedImageData::getImage(FileManagerServicePtr filemanager)
 {
+	// frames are read only, thus the raw data can be mapped directly
+	if (!mImageData && QFileInfo(mFilename).suffix().compare("mhd", Qt::CaseInsensitive)==0)
+		mImageData = CustomMetaImage::create(mFilename)->mapVoxelData();
 	if (!mImageData)
 	{
 		//mImageData = MetaImageReader().loadVtkImageData(mFilename);
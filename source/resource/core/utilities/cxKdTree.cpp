@@ -0,0 +1,177 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxKdTree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace cx
+{
+
+namespace
+{
+class CompareAlongAxis
+{
+public:
+	CompareAlongAxis(const Eigen::Matrix3Xd& positions, int axis) : mPositions(positions), mAxis(axis) {}
+	bool operator()(int a, int b) const
+	{
+		return mPositions(mAxis, a) < mPositions(mAxis, b);
+	}
+private:
+	const Eigen::Matrix3Xd& mPositions;
+	int mAxis;
+};
+} // namespace
+
+KdTree::KdTree(const Eigen::MatrixXd& positions) :
+	mPositions(3, positions.cols()),
+	mRemoved(positions.cols(), false),
+	mCount((int)positions.cols())
+{
+	if (mCount>0)
+		mPositions = positions.topRows(3);
+	mOrder.resize(mCount);
+	for (int i=0; i<mCount; ++i)
+		mOrder[i] = i;
+	mNodeOf.resize(mCount);
+	mAxis.resize(mCount);
+	mSubtreeCount.resize(mCount);
+
+	this->build(0, mCount);
+}
+
+/** Split along the axis with the largest extent, at the median.
+ */
+void KdTree::build(int begin, int end)
+{
+	if (begin>=end)
+		return;
+	int mid = (begin+end)/2;
+
+	Eigen::Vector3d minimum = mPositions.col(mOrder[begin]);
+	Eigen::Vector3d maximum = minimum;
+	for (int i=begin+1; i<end; ++i)
+	{
+		minimum = minimum.cwiseMin(mPositions.col(mOrder[i]));
+		maximum = maximum.cwiseMax(mPositions.col(mOrder[i]));
+	}
+	Eigen::Vector3d::Index axis;
+	(maximum-minimum).maxCoeff(&axis);
+
+	std::nth_element(mOrder.begin()+begin, mOrder.begin()+mid, mOrder.begin()+end, CompareAlongAxis(mPositions, (int)axis));
+	mAxis[mid] = (unsigned char)axis;
+	mSubtreeCount[mid] = end-begin;
+	mNodeOf[mOrder[mid]] = mid;
+
+	this->build(begin, mid);
+	this->build(mid+1, end);
+}
+
+std::pair<int, double> KdTree::findNearest(const Eigen::Vector3d& p) const
+{
+	Nearest best;
+	best.mIndex = -1;
+	best.mDistance2 = std::numeric_limits<double>::infinity();
+	this->findNearest(0, (int)mOrder.size(), p, &best);
+	return std::make_pair(best.mIndex, std::sqrt(best.mDistance2));
+}
+
+void KdTree::findNearest(int begin, int end, const Eigen::Vector3d& p, Nearest* best) const
+{
+	if (begin>=end)
+		return;
+	int mid = (begin+end)/2;
+	if (mSubtreeCount[mid]==0)
+		return;
+
+	int index = mOrder[mid];
+	if (!mRemoved[index])
+	{
+		double d2 = (mPositions.col(index)-p).squaredNorm();
+		if (d2 < best->mDistance2 || (d2==best->mDistance2 && index<best->mIndex))
+		{
+			best->mDistance2 = d2;
+			best->mIndex = index;
+		}
+	}
+
+	int axis = mAxis[mid];
+	double diff = p[axis] - mPositions(axis, index);
+	if (diff < 0)
+	{
+		this->findNearest(begin, mid, p, best);
+		if (diff*diff <= best->mDistance2)
+			this->findNearest(mid+1, end, p, best);
+	}
+	else
+	{
+		this->findNearest(mid+1, end, p, best);
+		if (diff*diff <= best->mDistance2)
+			this->findNearest(begin, mid, p, best);
+	}
+}
+
+std::vector<int> KdTree::findWithinRadius(const Eigen::Vector3d& p, double radius) const
+{
+	std::vector<int> retval;
+	this->findWithinRadius(0, (int)mOrder.size(), p, radius*radius, &retval);
+	std::sort(retval.begin(), retval.end());
+	return retval;
+}
+
+void KdTree::findWithinRadius(int begin, int end, const Eigen::Vector3d& p, double radius2, std::vector<int>* retval) const
+{
+	if (begin>=end)
+		return;
+	int mid = (begin+end)/2;
+	if (mSubtreeCount[mid]==0)
+		return;
+
+	int index = mOrder[mid];
+	if (!mRemoved[index] && (mPositions.col(index)-p).squaredNorm() <= radius2)
+		retval->push_back(index);
+
+	int axis = mAxis[mid];
+	double diff = p[axis] - mPositions(axis, index);
+	if (diff <= 0 || diff*diff <= radius2)
+		this->findWithinRadius(begin, mid, p, radius2, retval);
+	if (diff >= 0 || diff*diff <= radius2)
+		this->findWithinRadius(mid+1, end, p, radius2, retval);
+}
+
+void KdTree::remove(int index)
+{
+	if (mRemoved[index])
+		return;
+	mRemoved[index] = true;
+	--mCount;
+
+	// update counts on the path from the root to the node
+	int node = mNodeOf[index];
+	int begin = 0;
+	int end = (int)mOrder.size();
+	while (begin<end)
+	{
+		int mid = (begin+end)/2;
+		--mSubtreeCount[mid];
+		if (node==mid)
+			break;
+		if (node<mid)
+			end = mid;
+		else
+			begin = mid+1;
+	}
+}
+
+} // namespace cx
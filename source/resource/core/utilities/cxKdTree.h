@@ -0,0 +1,81 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXKDTREE_H_
+#define CXKDTREE_H_
+
+#include "cxResourceExport.h"
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <Eigen/Core>
+
+namespace cx
+{
+
+/**\brief Spatial index over a fixed set of 3D points.
+ *
+ * Balanced kd-tree, stored implicitly in an array. Build is O(n log n),
+ * nearest neighbour queries are O(log n) on typical data.
+ *
+ * Points are identified by their column index in the input matrix.
+ * Points can be removed from the index, e.g. when consuming points one
+ * by one. Removed points are skipped by all queries, and subtrees
+ * without remaining points are not visited.
+ *
+ * If several points have the same distance to the query, the one with
+ * the lowest index is returned, as with a linear search.
+ *
+ * \ingroup cx_resource_core_utilities
+ * \date 2026-10-18
+ */
+class cxResource_EXPORT KdTree
+{
+public:
+	explicit KdTree(const Eigen::MatrixXd& positions); ///< 3xN matrix, one point per column
+
+	int size() const { return mCount; } ///< number of points not removed
+	bool empty() const { return mCount==0; }
+	const Eigen::Matrix3Xd& getPositions() const { return mPositions; }
+
+	/** Return index of the point closest to p, and its distance.
+	 *  Index is -1 if the tree is empty.
+	 */
+	std::pair<int, double> findNearest(const Eigen::Vector3d& p) const;
+	std::vector<int> findWithinRadius(const Eigen::Vector3d& p, double radius) const; ///< sorted indices of all points within radius of p
+	void remove(int index);
+	bool isRemoved(int index) const { return mRemoved[index]; }
+
+private:
+	struct Nearest
+	{
+		int mIndex;
+		double mDistance2;
+	};
+	void build(int begin, int end);
+	void findNearest(int begin, int end, const Eigen::Vector3d& p, Nearest* best) const;
+	void findWithinRadius(int begin, int end, const Eigen::Vector3d& p, double radius2, std::vector<int>* retval) const;
+
+	Eigen::Matrix3Xd mPositions;
+	// Node for range [begin,end) is the point at mid=(begin+end)/2 in mOrder,
+	// left subtree is [begin,mid), right subtree [mid+1,end).
+	std::vector<int> mOrder; ///< point index for each node
+	std::vector<int> mNodeOf; ///< node for each point index
+	std::vector<unsigned char> mAxis; ///< split axis for each node
+	std::vector<int> mSubtreeCount; ///< points not removed in the subtree of each node
+	std::vector<bool> mRemoved;
+	int mCount;
+};
+typedef boost::shared_ptr<KdTree> KdTreePtr;
+
+} // namespace cx
+
+#endif /* CXKDTREE_H_ */
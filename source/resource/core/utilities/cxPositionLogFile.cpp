@@ -0,0 +1,374 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxPositionLogFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <QDataStream>
+#include <QFileInfo>
+#include <QtEndian>
+#include <Eigen/Geometry>
+#include "cxPositionStorageFile.h"
+#include "cxVector3D.h"
+#include "cxLogger.h"
+
+namespace cx
+{
+
+namespace
+{
+const char gFileMagic[] = "CXPOSLOG";
+const char gChunkMagic[] = "PCHK";
+const quint32 gVersion = 1;
+const qint64 gFileHeaderSize = 16;
+const qint64 gChunkHeaderSize = 32;
+const qint64 gSampleSize = 8+7*4;
+const quint32 gMaxUidSize = 1024;
+const unsigned gMaxChunkSize = 1024;
+
+float readFloat(const uchar* data)
+{
+	quint32 value = qFromLittleEndian<quint32>(data);
+	float retval;
+	std::memcpy(&retval, &value, sizeof(retval));
+	return retval;
+}
+
+double readDouble(const uchar* data)
+{
+	quint64 value = qFromLittleEndian<quint64>(data);
+	double retval;
+	std::memcpy(&retval, &value, sizeof(retval));
+	return retval;
+}
+}
+
+PositionLogReader::PositionLogReader(QString filename) :
+	mFile(filename),
+	mData(NULL),
+	mSize(0),
+	mValidSize(0)
+{
+	if (!mFile.open(QIODevice::ReadOnly))
+	{
+		reportError("Cannot open "+mFile.fileName());
+		return;
+	}
+
+	mSize = mFile.size();
+	if (mSize >= gFileHeaderSize)
+		mData = mFile.map(0, mSize);
+	if (!mData || std::memcmp(mData, gFileMagic, 8)!=0)
+	{
+		reportError("Not a position log file: "+mFile.fileName());
+		if (mData)
+			mFile.unmap(mData);
+		mData = NULL;
+		return;
+	}
+
+	this->scanChunks();
+	this->buildIndex();
+}
+
+PositionLogReader::~PositionLogReader()
+{
+	if (mData)
+		mFile.unmap(mData);
+	mFile.close();
+}
+
+void PositionLogReader::scanChunks()
+{
+	qint64 offset = gFileHeaderSize;
+	mValidSize = offset;
+
+	while (offset + gChunkHeaderSize <= mSize)
+	{
+		const uchar* header = mData + offset;
+		if (std::memcmp(header, gChunkMagic, 4)!=0)
+			break;
+		quint32 uidSize = qFromLittleEndian<quint32>(header+4);
+		if (uidSize > gMaxUidSize)
+			break;
+
+		Chunk chunk;
+		chunk.mCount = qFromLittleEndian<quint32>(header+8);
+		chunk.mStartTime = readDouble(header+16);
+		chunk.mStopTime = readDouble(header+24);
+		chunk.mMaxStopTime = chunk.mStopTime;
+		chunk.mDataOffset = offset + gChunkHeaderSize + (uidSize+3)/4*4;
+		qint64 end = chunk.mDataOffset + qint64(chunk.mCount)*gSampleSize;
+		if (end > mSize)
+			break;
+
+		QString uid = QString::fromUtf8(reinterpret_cast<const char*>(header+gChunkHeaderSize), uidSize);
+		mIndex[uid].push_back(chunk);
+		offset = end;
+		mValidSize = end;
+	}
+
+	if (mValidSize < mSize)
+		reportWarning(QString("Position log %1 ends with %2 bytes of incomplete data, ignored.")
+					  .arg(mFile.fileName())
+					  .arg(mSize-mValidSize));
+}
+
+bool PositionLogReader::startsBefore(const Chunk& a, const Chunk& b)
+{
+	return a.mStartTime < b.mStartTime;
+}
+
+bool PositionLogReader::endsBefore(const Chunk& chunk, double time)
+{
+	return chunk.mMaxStopTime < time;
+}
+
+/** Sort the chunks of each tool by start time, and compute the running
+ *  max stop time used for the binary search in getSessionHistory().
+ *  Chunks normally arrive sorted, but overlapping chunks are allowed.
+ */
+void PositionLogReader::buildIndex()
+{
+	for (std::map<QString, ChunkVector>::iterator iter=mIndex.begin(); iter!=mIndex.end(); ++iter)
+	{
+		ChunkVector& chunks = iter->second;
+		std::stable_sort(chunks.begin(), chunks.end(), startsBefore);
+		for (unsigned i=1; i<chunks.size(); ++i)
+			chunks[i].mMaxStopTime = std::max(chunks[i].mStopTime, chunks[i-1].mMaxStopTime);
+	}
+}
+
+QStringList PositionLogReader::getToolUids() const
+{
+	QStringList retval;
+	for (std::map<QString, ChunkVector>::const_iterator iter=mIndex.begin(); iter!=mIndex.end(); ++iter)
+		retval << iter->first;
+	return retval;
+}
+
+unsigned PositionLogReader::getNumberOfPositions(QString toolUid) const
+{
+	std::map<QString, ChunkVector>::const_iterator iter = mIndex.find(toolUid);
+	if (iter==mIndex.end())
+		return 0;
+	unsigned retval = 0;
+	for (unsigned i=0; i<iter->second.size(); ++i)
+		retval += iter->second[i].mCount;
+	return retval;
+}
+
+PositionLogMap PositionLogReader::getSessionHistory(QString toolUid, double startTime, double stopTime) const
+{
+	PositionLogMap retval;
+	std::map<QString, ChunkVector>::const_iterator iter = mIndex.find(toolUid);
+	if (iter==mIndex.end())
+		return retval;
+
+	const ChunkVector& chunks = iter->second;
+	ChunkVector::const_iterator chunk = std::lower_bound(chunks.begin(), chunks.end(), startTime, endsBefore);
+	for (; chunk!=chunks.end() && chunk->mStartTime<=stopTime; ++chunk)
+	{
+		if (chunk->mStopTime >= startTime)
+			this->readChunk(*chunk, startTime, stopTime, &retval);
+	}
+	return retval;
+}
+
+std::map<QString, PositionLogMap> PositionLogReader::getSessionHistory(double startTime, double stopTime) const
+{
+	std::map<QString, PositionLogMap> retval;
+	for (std::map<QString, ChunkVector>::const_iterator iter=mIndex.begin(); iter!=mIndex.end(); ++iter)
+	{
+		PositionLogMap positions = this->getSessionHistory(iter->first, startTime, stopTime);
+		if (!positions.empty())
+			retval[iter->first].swap(positions);
+	}
+	return retval;
+}
+
+PositionLogMap PositionLogReader::getPositionHistory(QString toolUid) const
+{
+	return this->getSessionHistory(toolUid, -std::numeric_limits<double>::max(), std::numeric_limits<double>::max());
+}
+
+void PositionLogReader::readChunk(const Chunk& chunk, double startTime, double stopTime, PositionLogMap* retval) const
+{
+	const uchar* data = mData + chunk.mDataOffset;
+	for (quint32 i=0; i<chunk.mCount; ++i)
+	{
+		const uchar* sample = data + i*gSampleSize;
+		double timestamp = readDouble(sample);
+		if (timestamp<startTime || timestamp>stopTime)
+			continue;
+
+		Eigen::Quaterniond rotation(readFloat(sample+8), readFloat(sample+12), readFloat(sample+16), readFloat(sample+20));
+		rotation.normalize();
+		Transform3D matrix = Transform3D::Identity();
+		matrix.linear() = rotation.toRotationMatrix();
+		matrix.translation() = Vector3D(readFloat(sample+24), readFloat(sample+28), readFloat(sample+32));
+		retval->insert(retval->end(), std::make_pair(timestamp, matrix));
+	}
+}
+
+//---------------------------------------------------------
+//---------------------------------------------------------
+//---------------------------------------------------------
+
+PositionLogWriter::PositionLogWriter(QString filename) : mFile(filename)
+{
+	qint64 validSize = 0;
+	if (mFile.exists() && mFile.size()>0)
+	{
+		PositionLogReader reader(filename);
+		if (!reader.isValid())
+			return;
+		validSize = reader.getValidSize();
+	}
+
+	if (!mFile.open(QIODevice::ReadWrite))
+	{
+		reportError("Cannot open "+mFile.fileName());
+		return;
+	}
+
+	if (validSize==0)
+	{
+		QByteArray header;
+		QDataStream stream(&header, QIODevice::WriteOnly);
+		stream.setByteOrder(QDataStream::LittleEndian);
+		stream.writeRawData(gFileMagic, 8);
+		stream << gVersion << quint32(0);
+		mFile.resize(0);
+		mFile.write(header);
+	}
+	else
+	{
+		// remove incomplete data from an interrupted write
+		if (mFile.size() > validSize)
+			mFile.resize(validSize);
+		mFile.seek(validSize);
+	}
+}
+
+PositionLogWriter::~PositionLogWriter()
+{
+	mFile.close();
+}
+
+void PositionLogWriter::write(QString toolUid, const PositionLogMap& positions)
+{
+	this->write(toolUid, positions.begin(), positions.end());
+}
+
+void PositionLogWriter::write(QString toolUid, PositionLogMap::const_iterator begin, PositionLogMap::const_iterator end)
+{
+	if (!mFile.isOpen())
+		return;
+
+	QByteArray uid = toolUid.toUtf8();
+	while (begin!=end)
+	{
+		PositionLogMap::const_iterator chunkEnd = begin;
+		unsigned count = 0;
+		while (chunkEnd!=end && count<gMaxChunkSize)
+		{
+			++chunkEnd;
+			++count;
+		}
+		this->writeChunk(uid, begin, chunkEnd, count);
+		begin = chunkEnd;
+	}
+}
+
+void PositionLogWriter::writeChunk(const QByteArray& uid, PositionLogMap::const_iterator begin, PositionLogMap::const_iterator end, unsigned count)
+{
+	PositionLogMap::const_iterator last = end;
+	--last;
+
+	QByteArray buffer;
+	buffer.reserve(gChunkHeaderSize + uid.size() + 3 + count*gSampleSize);
+	QDataStream stream(&buffer, QIODevice::WriteOnly);
+	stream.setByteOrder(QDataStream::LittleEndian);
+	stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+	stream.writeRawData(gChunkMagic, 4);
+	stream << quint32(uid.size()) << quint32(count) << quint32(0);
+	stream << begin->first << last->first;
+	stream.writeRawData(uid.constData(), uid.size());
+	for (int i=uid.size(); i%4; ++i)
+		stream << quint8(0);
+
+	for (PositionLogMap::const_iterator iter=begin; iter!=end; ++iter)
+	{
+		Eigen::Quaterniond rotation(Eigen::Matrix3d(iter->second.linear()));
+		Vector3D translation = iter->second.translation();
+		stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+		stream << iter->first;
+		stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+		stream << float(rotation.w()) << float(rotation.x()) << float(rotation.y()) << float(rotation.z());
+		stream << float(translation[0]) << float(translation[1]) << float(translation[2]);
+	}
+
+	if (mFile.write(buffer)!=buffer.size())
+		reportError("Failed to write positions to "+mFile.fileName());
+}
+
+//---------------------------------------------------------
+//---------------------------------------------------------
+//---------------------------------------------------------
+
+bool convertPositionStorageToPositionLog(QString legacyFilename, QString logFilename)
+{
+	if (!QFileInfo(legacyFilename).exists())
+		return false;
+
+	PositionStorageReader reader(legacyFilename);
+	PositionLogWriter writer(logFilename);
+	if (!writer.isValid())
+		return false;
+
+	// collect positions per tool, and write each tool in chunks as they fill up
+	std::map<QString, PositionLogMap> pending;
+	Transform3D matrix = Transform3D::Identity();
+	double timestamp;
+	QString toolUid;
+	unsigned count = 0;
+
+	while (!reader.atEnd())
+	{
+		if (!reader.read(&matrix, &timestamp, &toolUid))
+			break;
+		if (toolUid.isEmpty())
+			continue;
+
+		PositionLogMap& positions = pending[toolUid];
+		positions[timestamp] = matrix;
+		++count;
+		if (positions.size() >= gMaxChunkSize)
+		{
+			writer.write(toolUid, positions);
+			positions.clear();
+		}
+	}
+
+	for (std::map<QString, PositionLogMap>::iterator iter=pending.begin(); iter!=pending.end(); ++iter)
+		writer.write(iter->first, iter->second);
+
+	report(QString("Converted %1 tool positions from %2 to %3")
+		   .arg(count)
+		   .arg(QFileInfo(legacyFilename).fileName())
+		   .arg(QFileInfo(logFilename).fileName()));
+	return true;
+}
+
+} // namespace cx
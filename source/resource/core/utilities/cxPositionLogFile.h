@@ -0,0 +1,131 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXPOSITIONLOGFILE_H_
+#define CXPOSITIONLOGFILE_H_
+
+#include "cxResourceExport.h"
+
+#include <map>
+#include <vector>
+#include <QString>
+#include <QStringList>
+#include <QFile>
+#include <boost/shared_ptr.hpp>
+
+#include "cxTransform3D.h"
+
+namespace cx
+{
+
+typedef std::map<double, Transform3D> PositionLogMap; ///< same as TimedTransformMap
+
+/**\brief Reader for the chunked tool position log (.cxposlog).
+ *
+ * The file is memory mapped, and only the chunk headers are read on
+ * construction. They form a per-tool time index, thus a time range
+ * query only decodes the chunks overlapping the range.
+ *
+ * Binary file format description, all numbers little endian:
+   \verbatim
+  Header (16 bytes):
+    "CXPOSLOG" <version uint32> <reserved uint32>
+
+  Chunks, each holding positions from one tool in ascending time:
+    "PCHK" <uid size uint32> <count uint32> <reserved uint32>
+    <start time double> <stop time double>
+    <tool uid, utf8, zero padded to a multiple of 4 bytes>
+    count * <time double><qw><qx><qy><qz><x><y><z>   (7 floats)
+
+  Time is milliseconds since epoch, stored exactly so that positions
+  read back match the timestamps of the tool history. The rotation is
+  stored as a unit quaternion.
+   \endverbatim
+ *
+ * A truncated last chunk, e.g. after a crash during writing, is ignored.
+ *
+ * \sa PositionLogWriter
+ * \ingroup cx_resource_core_utilities
+ * \date 2026-10-18
+ */
+class cxResource_EXPORT PositionLogReader
+{
+public:
+	explicit PositionLogReader(QString filename);
+	~PositionLogReader();
+	bool isValid() const { return mData!=NULL; }
+	QStringList getToolUids() const;
+	unsigned getNumberOfPositions(QString toolUid) const;
+	PositionLogMap getSessionHistory(QString toolUid, double startTime, double stopTime) const;
+	std::map<QString, PositionLogMap> getSessionHistory(double startTime, double stopTime) const;
+	PositionLogMap getPositionHistory(QString toolUid) const; ///< all positions for the tool
+	qint64 getValidSize() const { return mValidSize; } ///< size of the file up to the last complete chunk
+
+	static QString getSuffix() { return "cxposlog"; }
+
+private:
+	struct Chunk
+	{
+		qint64 mDataOffset;
+		quint32 mCount;
+		double mStartTime;
+		double mStopTime;
+		double mMaxStopTime; ///< max stop time of this and all earlier chunks for the tool
+	};
+	typedef std::vector<Chunk> ChunkVector;
+	static bool startsBefore(const Chunk& a, const Chunk& b);
+	static bool endsBefore(const Chunk& chunk, double time);
+	void scanChunks();
+	void buildIndex();
+	void readChunk(const Chunk& chunk, double startTime, double stopTime, PositionLogMap* retval) const;
+
+	QFile mFile;
+	uchar* mData;
+	qint64 mSize;
+	qint64 mValidSize;
+	std::map<QString, ChunkVector> mIndex;
+};
+typedef boost::shared_ptr<PositionLogReader> PositionLogReaderPtr;
+
+/**\brief Writer for the chunked tool position log.
+ *
+ * Positions are appended to the file, split into chunks of limited
+ * size. An existing file is continued, after removing
+ * any incomplete chunk at the end.
+ *
+ * For a description of the file format, see PositionLogReader.
+ *
+ * \sa PositionLogReader
+ * \ingroup cx_resource_core_utilities
+ * \date 2026-10-18
+ */
+class cxResource_EXPORT PositionLogWriter
+{
+public:
+	explicit PositionLogWriter(QString filename);
+	~PositionLogWriter();
+	bool isValid() const { return mFile.isOpen(); }
+	void write(QString toolUid, PositionLogMap::const_iterator begin, PositionLogMap::const_iterator end);
+	void write(QString toolUid, const PositionLogMap& positions);
+
+private:
+	void writeChunk(const QByteArray& uid, PositionLogMap::const_iterator begin, PositionLogMap::const_iterator end, unsigned count);
+	QFile mFile;
+};
+
+/** Convert a legacy position file (.snwpos, see PositionStorageReader)
+ *  to the position log format. Return true on success.
+ */
+cxResource_EXPORT bool convertPositionStorageToPositionLog(QString legacyFilename, QString logFilename);
+
+} // namespace cx
+
+#endif /*CXPOSITIONLOGFILE_H_*/
@@ -10,6 +10,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 =========================================================================*/
 #include "cxSpaceProviderImpl.h"
 
+#include <QElapsedTimer>
 #include "cxPatientModelService.h"
 #include "cxTrackingService.h"
 #include "cxData.h"
@@ -31,6 +32,29 @@ SpaceProviderImpl::SpaceProviderImpl(TrackingServicePtr trackingService, Patient
 //	connect(mTrackingService.get(), SIGNAL(stateChanged()), this, SIGNAL(spaceAddedOrRemoved()));
 	connect(mTrackingService.get(), &TrackingService::stateChanged, this, &SpaceProvider::spaceAddedOrRemoved);
 	connect(mDataManager.get(), &PatientModelService::dataAddedOrRemoved, this, &SpaceProvider::spaceAddedOrRemoved);
+
+	connect(mTrackingService.get(), &TrackingService::stateChanged, this, &SpaceProviderImpl::clearCache);
+	connect(mDataManager.get(), &PatientModelService::dataAddedOrRemoved, this, &SpaceProviderImpl::clearCache);
+	connect(mDataManager.get(), &PatientModelService::patientChanged, this, &SpaceProviderImpl::clearCache);
+}
+
+SpaceProviderImpl::CacheStatistics SpaceProviderImpl::getCacheStatistics() const
+{
+	QMutexLocker lock(&mCacheMutex);
+	return mStatistics;
+}
+
+void SpaceProviderImpl::resetCacheStatistics()
+{
+	QMutexLocker lock(&mCacheMutex);
+	mStatistics = CacheStatistics();
+}
+
+void SpaceProviderImpl::clearCache()
+{
+	QMutexLocker lock(&mCacheMutex);
+	mStatistics.invalidations += mCache.size();
+	mCache.clear();
 }
 
 SpaceListenerPtr SpaceProviderImpl::createListener()
@@ -126,9 +150,61 @@ Transform3D SpaceProviderImpl::getActiveToolTipTransform(CoordinateSystem to, bo
 	return retval;
 }
 
+bool SpaceProviderImpl::isCacheable(const CoordinateSystem& space) const
+{
+	if (space.mRefObject == "active")
+		return false;
+	return (space.mId != csSENSOR) && (space.mId != csCOUNT);
+}
+
+/** Return a cached transform if the rMfrom and rMto it was computed from
+ *  are unchanged, otherwise recompute and replace it.
+ */
 Transform3D SpaceProviderImpl::get_toMfrom(CoordinateSystem from, CoordinateSystem to)
 {
-	Transform3D to_M_from = get_rMfrom(to).inv() * get_rMfrom(from);
+	if (!this->isCacheable(from) || !this->isCacheable(to))
+		return this->compute_toMfrom(from, to);
+
+	CachedTransform current;
+	current.rMfrom = this->get_rMfrom(from);
+	current.rMto = this->get_rMfrom(to);
+
+	CachedTransformKey key(from, to);
+	{
+		QMutexLocker lock(&mCacheMutex);
+		QHash<CachedTransformKey, CachedTransform>::const_iterator iter = mCache.constFind(key);
+		if (iter != mCache.constEnd())
+		{
+			if ((iter->rMfrom.matrix() == current.rMfrom.matrix()) && (iter->rMto.matrix() == current.rMto.matrix()))
+			{
+				++mStatistics.hits;
+				return iter->toMfrom;
+			}
+			++mStatistics.invalidations;
+		}
+	}
+
+	current.toMfrom = this->compute_toMfrom(current.rMfrom, current.rMto);
+
+	QMutexLocker lock(&mCacheMutex);
+	mCache.insert(key, current);
+	return current.toMfrom;
+}
+
+Transform3D SpaceProviderImpl::compute_toMfrom(CoordinateSystem from, CoordinateSystem to)
+{
+	return this->compute_toMfrom(get_rMfrom(from), get_rMfrom(to));
+}
+
+Transform3D SpaceProviderImpl::compute_toMfrom(const Transform3D& rMfrom, const Transform3D& rMto)
+{
+	QElapsedTimer timer;
+	timer.start();
+	Transform3D to_M_from = rMto.inv() * rMfrom;
+
+	QMutexLocker lock(&mCacheMutex);
+	++mStatistics.misses;
+	mStatistics.recomputeTime += timer.nsecsElapsed()/1.0E6;
 	return to_M_from;
 }
 
@@ -13,14 +13,25 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include "cxResourceExport.h"
 
+#include <QHash>
+#include <QPair>
+#include <QMutex>
 #include "cxSpaceProvider.h"
 #include "cxForwardDeclarations.h"
+#include "cxTransform3D.h"
 
 namespace cx
 {
 
 /** Provides information about all the coordinate systems in the application.
  *
+ * Transforms returned by get_toMfrom() are cached per (from,to) pair,
+ * together with the rMfrom and rMto they were computed from. An entry is
+ * returned only if these are unchanged at lookup, thus the cache is valid
+ * also for listeners notified of a change before the cache would have been.
+ * The cache is cleared when spaces are added or removed. Sensor spaces are
+ * not cached, as tools do not signal calibration changes, and neither are
+ * the "active" aliases, as they are resolved on each call.
  *
  * \ingroup cx_resource_core_utilities
  * \date 2014-02-21
@@ -28,7 +39,20 @@ namespace cx
  */
 class cxResource_EXPORT SpaceProviderImpl : public SpaceProvider
 {
+	Q_OBJECT
 public:
+	/** Counters describing the efficiency of the transform cache.
+	 */
+	struct CacheStatistics
+	{
+		CacheStatistics() : hits(0), misses(0), invalidations(0), recomputeTime(0) {}
+		unsigned hits;
+		unsigned misses; ///< number of recomputed transforms
+		unsigned invalidations; ///< number of outdated or removed transforms
+		double recomputeTime; ///< total time spent recomputing, ms
+		double getHitRate() const { return (hits+misses) ? double(hits)/(hits+misses) : 0; }
+	};
+
 	SpaceProviderImpl(TrackingServicePtr trackingService, PatientModelServicePtr dataManager);
 	virtual ~SpaceProviderImpl() {}
 
@@ -49,7 +73,22 @@ public:
 	virtual CoordinateSystem getR(); ///<data references coordinate system
 	virtual CoordinateSystem convertToSpecific(CoordinateSystem space);
 
+	CacheStatistics getCacheStatistics() const;
+	void resetCacheStatistics();
+	void clearCache();
+
 private:
+	typedef QPair<CoordinateSystem, CoordinateSystem> CachedTransformKey;
+	struct CachedTransform
+	{
+		Transform3D rMfrom; ///< version stamp for from
+		Transform3D rMto; ///< version stamp for to
+		Transform3D toMfrom;
+	};
+	bool isCacheable(const CoordinateSystem& space) const;
+	Transform3D compute_toMfrom(CoordinateSystem from, CoordinateSystem to);
+	Transform3D compute_toMfrom(const Transform3D& rMfrom, const Transform3D& rMto);
+
 	Transform3D get_rMfrom(CoordinateSystem from); ///< ref_M_from
 
 	Transform3D get_rMr(); ///< ref_M_ref
@@ -64,6 +103,10 @@ private:
 
 	TrackingServicePtr mTrackingService;
 	PatientModelServicePtr mDataManager;
+
+	QHash<CachedTransformKey, CachedTransform> mCache; ///< to_M_from for (from,to)
+	CacheStatistics mStatistics;
+	mutable QMutex mCacheMutex;
 };
 
 } // namespace cx
@@ -18,7 +18,6 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <vtkImageResample.h>
 #include <vtkImageClip.h>
 #include <vtkImageShiftScale.h>
-#include <vtkImageAccumulate.h>
 #include <vtkImageLuminance.h>
 #include <vtkImageExtractComponents.h>
 #include <vtkImageAppendComponents.h>
@@ -303,11 +302,13 @@ void printDisplayFriendlyInfo(std::map<std::string, std::string> map)
 
 int calculateNumVoxelsWithMaxValue(ImagePtr image)
 {
-	return static_cast<int*>(image->getHistogram()->GetOutput()->GetScalarPointer(image->getRange(), 0, 0))[0];
+	ImageStatisticsPtr statistics = image->getStatistics();
+	return statistics->getCount(statistics->getMax());
 }
 int calculateNumVoxelsWithMinValue(ImagePtr image)
 {
-	return static_cast<int*>(image->getHistogram()->GetOutput()->GetScalarPointer(0,0,0))[0];
+	ImageStatisticsPtr statistics = image->getStatistics();
+	return statistics->getCount(statistics->getMin());
 }
 
 DoubleBoundingBox3D findEnclosingBoundingBox(std::vector<DataPtr> data, Transform3D qMr)
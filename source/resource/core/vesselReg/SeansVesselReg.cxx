@@ -4,8 +4,13 @@
 #include <iostream>
 #include <time.h>
 #include <fstream>
+#include <algorithm>
 
 #include <QFileInfo>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QThread>
+#include <QtConcurrentMap>
 
 #include "cxImage.h"
 #include "cxTypeConversions.h"
@@ -25,7 +30,6 @@
 #include "vtkImageData.h"
 #include "vtkGeneralTransform.h"
 #include "vtkMath.h"
-#include "vtkSortDataArray.h"
 #include "vtkMaskPoints.h"
 #include "vtkPointData.h"
 #include "vtkLandmarkTransform.h"
@@ -49,6 +53,7 @@ SeansVesselReg::SeansVesselReg()// : mInvertedTransform(false)
 	mt_maximumNumberOfIterations = 100;
 	mt_verbose = false;
 	mt_maximumDurationSeconds = 1E6; // Random high number
+	mt_parallel = true;
 	margin = 40;
 }
 
@@ -116,7 +121,13 @@ bool SeansVesselReg::execute()
 	printOutResults(m_logPath + "/Vessel_Based_Registration_", context->mConcatenation);
 
 	if (mt_verbose)
+	{
 		std::cout << QString("\n\nV2V Execution time: %1s").arg(start.secsTo(QTime::currentTime())) << endl;
+		std::vector<IterationTiming> timings = context->mTimings;
+		for (unsigned i=0; i<timings.size(); ++i)
+			std::cout << QString("iteration\t%1\tclosest points: %2ms\tselection: %3ms\tregistration: %4ms")
+						 .arg(i).arg(timings[i].mClosestPoints).arg(timings[i].mSelection).arg(timings[i].mRegistration) << std::endl;
+	}
 
 	mLastRun = context;
 //	mLinearTransformResult = this->getLinearTransform(context->mConcatenation);
@@ -159,16 +170,56 @@ SeansVesselReg::ContextPtr SeansVesselReg::linearRefineAllLTS(ContextPtr seed)
 	lts.push_back(100);
 
 	std::vector<ContextPtr> paths;
-
-	// iterate along all paths
 	for (unsigned i=0; i<lts.size(); ++i)
 	{
 		ContextPtr current = this->splitContext(seed);
 		paths.push_back(current);
 		current->mLtsRatio = lts[i];
-		this->linearRefine(current);
-		if (mt_verbose)
-			std::cout << QString("LTS=%1, metric=%2").arg(current->mLtsRatio).arg(current->mMetric) << std::endl;
+	}
+
+	// iterate along all paths
+	if (mt_parallel)
+	{
+		// Each path runs in its own thread, using a locator that no
+		// other thread uses at the same time. Reuse the seed locators,
+		// create more if all are taken.
+		QMutex mutex;
+		std::vector<vtkCellLocatorPtr> available = seed->mTargetPointLocators;
+		QtConcurrent::blockingMap(paths, [this, seed, &mutex, &available](ContextPtr& current)
+		{
+			vtkCellLocatorPtr locator;
+			{
+				QMutexLocker sentry(&mutex);
+				if (available.empty())
+				{
+					locator = createLocator(seed->mTargetPoints);
+				}
+				else
+				{
+					locator = available.back();
+					available.pop_back();
+				}
+			}
+
+			std::vector<vtkCellLocatorPtr> locators = current->mTargetPointLocators;
+			current->mTargetPointLocators.assign(1, locator);
+			this->linearRefine(current);
+			current->mTargetPointLocators = locators;
+
+			QMutexLocker sentry(&mutex);
+			available.push_back(locator);
+		});
+	}
+	else
+	{
+		for (unsigned i=0; i<paths.size(); ++i)
+			this->linearRefine(paths[i]);
+	}
+
+	if (mt_verbose)
+	{
+		for (unsigned i=0; i<paths.size(); ++i)
+			std::cout << QString("LTS=%1, metric=%2").arg(paths[i]->mLtsRatio).arg(paths[i]->mMetric) << std::endl;
 	}
 
 	// search for best path
@@ -222,7 +273,7 @@ SeansVesselReg::ContextPtr SeansVesselReg::splitContext(ContextPtr context)
 	retval->mInvertedTransform = context->mInvertedTransform;
 
 	// constant data: shallow copy
-	retval->mTargetPointLocator = context->mTargetPointLocator;
+	retval->mTargetPointLocators = context->mTargetPointLocators;
 	retval->mTargetPoints = context->mTargetPoints;
 
 	// will be modified: deep copy
@@ -285,12 +336,11 @@ SeansVesselReg::ContextPtr SeansVesselReg::createContext(DataPtr source, DataPtr
 	}
 
 
-	// Create locator for target points
+	// Create locators for target points, one for each thread
 	context->mTargetPoints = targetPolyData;
-	context->mTargetPointLocator = vtkCellLocatorPtr::New();
-	context->mTargetPointLocator->SetDataSet(targetPolyData);
-	context->mTargetPointLocator->SetNumberOfCellsPerBucket(1);
-	context->mTargetPointLocator->BuildLocator();
+	int numberOfLocators = mt_parallel ? std::max(QThread::idealThreadCount(), 1) : 1;
+	for (int i=0; i<numberOfLocators; ++i)
+		context->mTargetPointLocators.push_back(createLocator(targetPolyData));
 
 	//Since we are going to play with the data, we have to make a copy
 	context->mSourcePoints = vtkPointsPtr::New();
@@ -323,49 +373,111 @@ void SeansVesselReg::computeDistances(ContextPtr context)
 	int nb_points = ((int) (numPoints * context->mLtsRatio) / 100);
 //	std::cout << QString("onestep %1/%2").arg(nb_points).arg(numPoints) << std::endl;
 
+	IterationTiming timing;
+	QElapsedTimer timer;
+	timer.start();
+
 	// - closestPoint is used so that the internal state of LandmarkTransform remains
 	//   correct whenever the iteration process is stopped (hence its source
 	//   and landmark points might be used in a vtkThinPlateSplineTransform).
-	vtkPointsPtr closestPoint = vtkPointsPtr::New();
-	closestPoint->SetNumberOfPoints(numPoints);
+	std::vector<double> closestPoints(3*numPoints);
+	std::vector<double> residuals(numPoints);
+
+	//Find closest points to all source points.
+	//Split the points into one range for each locator, and search the ranges in parallel.
+	int numRanges = std::max(1, std::min((int)context->mTargetPointLocators.size(), numPoints));
+	std::vector<int> ranges(numRanges);
+	std::vector<char> valid(numRanges, true);
+	for (int i = 0; i < numRanges; ++i)
+		ranges[i] = i;
+	auto findClosestPointsInRange = [&](int& range)
+	{
+		int begin = (long long)numPoints * range / numRanges;
+		int end = (long long)numPoints * (range+1) / numRanges;
+		valid[range] = this->findClosestPoints(context->mTargetPointLocators[range], context->mSourcePoints,
+											   begin, end, closestPoints.data(), residuals.data());
+	};
+	if (numRanges > 1)
+		QtConcurrent::blockingMap(ranges, findClosestPointsInRange);
+	else
+		findClosestPointsInRange(ranges[0]);
 
-	// Fill points with the closest points to each vertex in input
-	vtkFloatArrayPtr residuals = vtkFloatArrayPtr::New();
-	residuals->SetNumberOfValues(numPoints);
+	timing.mClosestPoints = timer.nsecsElapsed() / 1.0E6;
+	timer.restart();
+
+	if (std::find(valid.begin(), valid.end(), false) != valid.end())
+	{
+		std::cout << "nan found during findClosestPoint!" << std::endl;
+		context->mMetric = 1E6;
+		return;
+	}
 
-	vtkIdListPtr IdList = vtkIdListPtr::New();
-	IdList->SetNumberOfIds(numPoints);
 	double total_distance = 0;
-	double distanceSquared = 0;
-	//Find closest points to all source points
 	for (int i = 0; i < numPoints; ++i)
+		total_distance += sqrt(residuals[i]);
+
+	// quality of the current iteration
+	context->mMetric = total_distance / numPoints;
+
+	// Only the nb_points closest points are used: A partial selection is sufficient.
+	std::vector<vtkIdType> IdList(numPoints);
+	for (int i = 0; i < numPoints; ++i)
+		IdList[i] = i;
+	std::nth_element(IdList.begin(), IdList.begin() + nb_points, IdList.end(), [&residuals](vtkIdType a, vtkIdType b)
+	{
+		return residuals[a] < residuals[b];
+	});
+
+	vtkPointsPtr closestPoint = vtkPointsPtr::New();
+	closestPoint->SetNumberOfPoints(numPoints);
+	for (int i = 0; i < numPoints; ++i)
+		closestPoint->SetPoint(i, &closestPoints[3*i]);
+
+	context->mSortedSourcePoints = this->createSortedPoints(IdList, context->mSourcePoints, nb_points);
+	context->mSortedTargetPoints = this->createSortedPoints(IdList, closestPoint, nb_points);
+
+	timing.mSelection = timer.nsecsElapsed() / 1.0E6;
+	context->mTimings.push_back(timing);
+}
+
+/**Find the closest target point for the source points in [begin, end),
+ * store in closestPoints (3 values per point) and residuals (squared distance).
+ * Return false if a nan is found.
+ *
+ * The locator is not thread safe, and must not be used by other threads at the same time.
+ */
+bool SeansVesselReg::findClosestPoints(vtkCellLocatorPtr locator, vtkPointsPtr sourcePoints, int begin, int end,
+									   double* closestPoints, double* residuals)
+{
+	for (int i = begin; i < end; ++i)
 	{
 		//Check the distance to neighbouring points (neighbours should be matched to nearby points)
 		vtkIdType cell_id;
 		int sub_id;
-		double outPoint[3];
-		context->mTargetPointLocator->FindClosestPoint(context->mSourcePoints->GetPoint(i), outPoint, cell_id, sub_id, distanceSquared);
-		closestPoint->SetPoint(i, outPoint);
+		double distanceSquared = 0;
+		double sourcePoint[3];
+		sourcePoints->GetPoint(i, sourcePoint);
+		locator->FindClosestPoint(sourcePoint, &closestPoints[3*i], cell_id, sub_id, distanceSquared);
 		if ((boost::math::isnan)(distanceSquared))
-		{
-			std::cout << "nan found during findClosestPoint!" << std::endl;
-			{
-				context->mMetric = 1E6;
-				return;
-			}
-		}
-		residuals->InsertValue(i, distanceSquared);
-		IdList->InsertId(i, i);
-		total_distance += sqrt(distanceSquared);
+			return false;
+		residuals[i] = distanceSquared;
 	}
+	return true;
+}
 
-	// quality of the current iteration
-	context->mMetric = total_distance / numPoints;
-
-	vtkSortDataArrayPtr sort = vtkSortDataArrayPtr::New();
-	sort->Sort(residuals, IdList);
-	context->mSortedSourcePoints = this->createSortedPoints(IdList, context->mSourcePoints, nb_points);
-	context->mSortedTargetPoints = this->createSortedPoints(IdList, closestPoint, nb_points);
+/**Create a locator for the target points. The locator uses its own copy of
+ * the target, thus locators can be used in different threads.
+ */
+vtkCellLocatorPtr SeansVesselReg::createLocator(vtkPolyDataPtr target)
+{
+	vtkPolyDataPtr copy = vtkPolyDataPtr::New();
+	copy->DeepCopy(target);
+
+	vtkCellLocatorPtr locator = vtkCellLocatorPtr::New();
+	locator->SetDataSet(copy);
+	locator->SetNumberOfCellsPerBucket(1);
+	locator->BuildLocator();
+	return locator;
 }
 
 /**\brief Register the source points to the target point in a single ste.
@@ -387,6 +499,9 @@ void SeansVesselReg::performOneRegistration(ContextPtr context, bool linear)
 	if (!context->mSortedSourcePoints || !context->mSortedTargetPoints)
 		return;
 
+	QElapsedTimer timer;
+	timer.start();
+
 	if (linear)
 	{
 		context->mTransform = linearRegistration(context->mSortedSourcePoints, context->mSortedTargetPoints);
@@ -407,6 +522,9 @@ void SeansVesselReg::performOneRegistration(ContextPtr context, bool linear)
 	// add transform from this iteration to the total
 	context->mConcatenation->Concatenate(context->mTransform);
 
+	if (!context->mTimings.empty())
+		context->mTimings.back().mRegistration = timer.nsecsElapsed() / 1.0E6;
+
 	this->computeDistances(context);
 }
 
@@ -414,7 +532,7 @@ void SeansVesselReg::performOneRegistration(ContextPtr context, bool linear)
  * based on the numPoint first of unsortedPoints.
  *
  */
-vtkPointsPtr SeansVesselReg::createSortedPoints(vtkIdListPtr sortedIDList, vtkPointsPtr unsortedPoints, int numPoints)
+vtkPointsPtr SeansVesselReg::createSortedPoints(const std::vector<vtkIdType>& sortedIDList, vtkPointsPtr unsortedPoints, int numPoints)
 {
 	vtkPointsPtr retval = vtkPointsPtr::New();
 	retval->SetNumberOfPoints(numPoints);
@@ -423,7 +541,7 @@ vtkPointsPtr SeansVesselReg::createSortedPoints(vtkIdListPtr sortedIDList, vtkPo
 
 	for (int i = 0; i < numPoints; ++i)
 	{
-		vtkIdType index = sortedIDList->GetId(i);
+		vtkIdType index = sortedIDList[i];
 		unsortedPoints->GetPoint(index, temp_point); // source points to use in tps
 		retval->SetPoint(i, temp_point);
 	}
@@ -684,6 +802,15 @@ double SeansVesselReg::getResultLtsRatio(ContextPtr context)
 	return context->mLtsRatio;
 }
 
+std::vector<SeansVesselReg::IterationTiming> SeansVesselReg::getIterationTimings(ContextPtr context)
+{
+	if (!context)
+		context = mLastRun;
+	if (!context)
+		return std::vector<IterationTiming>();
+	return context->mTimings;
+}
+
 /**Convert the linear transform part of contatenation to a Transform3D
  */
 Transform3D SeansVesselReg::getLinearTransform(vtkGeneralTransformPtr concatenation)
@@ -7,6 +7,7 @@
 #include "vtkForwardDeclarations.h"
 #include "cxTransform3D.h"
 #include "vtkSmartPointer.h"
+#include <vector>
 
 namespace cx
 {
@@ -17,6 +18,9 @@ namespace cx
  *
  * Basic usage: Run execute(), then get result with getLinearTransform()
  *
+ * If mt_parallel is set, the closest point searches are split across threads,
+ * each with its own locator, and the LTS ratios in the auto LTS search are
+ * evaluated concurrently.
  *
  * \ingroup cx_resource_core_utilities
  * \date Feb 4, 2011
@@ -30,12 +34,22 @@ namespace cx
 class cxResource_EXPORT SeansVesselReg
 {
 public:
+	/**Time spent in one iteration, in ms.
+	 */
+	struct IterationTiming
+	{
+		IterationTiming() : mClosestPoints(0), mSelection(0), mRegistration(0) {}
+		double mClosestPoints; ///< finding the closest target point for each source point
+		double mSelection; ///< selecting the LTS subset of the points
+		double mRegistration; ///< computing and applying the transform
+	};
+
 	/**Helper for storing all running data
 	 * related to the v2v algorithm in one place.
 	 */
 	struct cxResource_EXPORT Context
 	{
-		vtkCellLocatorPtr mTargetPointLocator; ///< input: target data wrapped in a locator
+		std::vector<vtkCellLocatorPtr> mTargetPointLocators; ///< input: target data wrapped in locators, one for each thread used in computeDistances()
 		vtkPolyDataPtr mTargetPoints; ///< input: target data
 		vtkPointsPtr mSourcePoints; ///< input: current source data, modified according to last iteration
 
@@ -43,7 +57,7 @@ public:
 		vtkPolyDataPtr getFixedPoints(); ///< the fixed data (one of target or source, depending on inversion)
 		vtkPolyDataPtr getDifferenceLines(); ///< Lines connecting the moving and fixed data, according to LTS.
 
-		vtkPointsPtr mSortedSourcePoints; ///< source points sorted according to distance to target, #mSortedSourcePoints==#mSortedTargetPoints
+		vtkPointsPtr mSortedSourcePoints; ///< the LTS ratio of the source points closest to the target (unordered), #mSortedSourcePoints==#mSortedTargetPoints
 		vtkPointsPtr mSortedTargetPoints; ///< source points projected onto the target points (closest points) #mSortedSourcePoints==#mSortedTargetPoints
 
 		vtkGeneralTransformPtr mConcatenation; ///< output: concatenation of all transforms so far
@@ -51,6 +65,7 @@ public:
 		double mMetric; ///< output: mean least squares from BEFORE last iteration.
 
 		double mLtsRatio; ///< local copy of the lts ratio, can be changed for current iteration.
+		std::vector<IterationTiming> mTimings; ///< output: timing of each iteration
 
 		//---------------------------------------------------------------------------
 		//TODO non-linear needs to handle this!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
@@ -70,6 +85,7 @@ public:
 	Transform3D getLinearResult(ContextPtr context=ContextPtr());
 	double getResultMetric(ContextPtr context=ContextPtr());
 	double getResultLtsRatio(ContextPtr context=ContextPtr());
+	std::vector<IterationTiming> getIterationTimings(ContextPtr context=ContextPtr());
 	Transform3D getNonLinearTransform();
 	void checkQuality(Transform3D linearTransform);
 //	ImagePtr loadMinc(char* source_file);
@@ -93,6 +109,7 @@ public:
 	int mt_maximumNumberOfIterations;
 	bool mt_verbose;
 	double mt_maximumDurationSeconds;
+	bool mt_parallel; ///< use several threads for closest point search and auto LTS
 	double margin;
 	QString m_logPath;
 
@@ -121,7 +138,9 @@ protected:
 	vtkAbstractTransformPtr nonLinearRegistration(vtkPointsPtr sortedSourcePoints, vtkPointsPtr sortedTargetPoints);
 	vtkPolyDataPtr convertToPolyData(DataPtr data, QString id);
 	vtkPointsPtr transformPoints(vtkPointsPtr input, vtkAbstractTransformPtr transform);
-	vtkPointsPtr createSortedPoints(vtkIdListPtr sortedIDList, vtkPointsPtr unsortedPoints, int numPoints);
+	vtkPointsPtr createSortedPoints(const std::vector<vtkIdType>& sortedIDList, vtkPointsPtr unsortedPoints, int numPoints);
+	static vtkCellLocatorPtr createLocator(vtkPolyDataPtr target);
+	bool findClosestPoints(vtkCellLocatorPtr locator, vtkPointsPtr sourcePoints, int begin, int end, double* closestPoints, double* residuals);
 	vtkPolyDataPtr crop(vtkPolyDataPtr input, vtkPolyDataPtr fixed, double margin);
 	ContextPtr linearRefineAllLTS(ContextPtr context);
 	void linearRefine(ContextPtr context);
@@ -11,13 +11,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include "cxContourFilter.h"
 
-#include <vtkImageShrink3D.h>
-#include <vtkMarchingCubes.h>
-#include <vtkWindowedSincPolyDataFilter.h>
-#include <vtkTriangleFilter.h>
-#include <vtkDecimatePro.h>
-#include <vtkPolyDataNormals.h>
 #include <vtkImageData.h>
+#include <vtkPolyData.h>
 
 
 #include "cxRegistrationTransform.h"
@@ -31,6 +26,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxPatientModelService.h"
 #include "cxViewService.h"
 #include "cxVisServices.h"
+#include "cxSurfaceExtractor.h"
+#include "cxLogger.h"
 
 namespace cx
 {
@@ -56,7 +53,7 @@ QString ContourFilter::getHelp() const
 	        "<h3>Surfacing.</h3>"
 	        "<p><i>Find the surface of a binary volume using marching cubes.</i></p>"
 	        "<p>- Optional factor 2 reduction</p>"
-	        "<p>- Marching Cubes contouring</p>"
+	        "<p>- Marching Cubes contouring, using all cores</p>"
 	        "<p>- Optional Windowed Sinc smoothing</p>"
 	        "<p>- Decimation of triangles</p>"
            "</html>";
@@ -255,70 +252,18 @@ vtkPolyDataPtr ContourFilter::execute(vtkImageDataPtr input,
 	if (!input)
 		return vtkPolyDataPtr();
 
-	//Shrink input volume
-	vtkImageShrink3DPtr shrinker = vtkImageShrink3DPtr::New();
-	if(reduceResolution)
-	{
-//		std::cout << "smooth" << std::endl;
-		shrinker->SetInputData(input);
-		shrinker->SetShrinkFactors(2,2,2);
-		shrinker->Update();
-	}
-
-	// Find countour
-	vtkMarchingCubesPtr convert = vtkMarchingCubesPtr::New();
-	if(reduceResolution)
-		convert->SetInputConnection(shrinker->GetOutputPort());
-	else
-		convert->SetInputData(input);
-
-	convert->SetValue(0, threshold);
-	convert->Update();
-
-	vtkPolyDataPtr cubesPolyData = convert->GetOutput();
-//	vtkPolyDataPtr cubesPolyData = vtkPolyDataPtr::New();
-//	cubesPolyData = convert->GetOutput();
-//	std::cout << "convert->GetOutput(); " << cubesPolyData.GetPointer() << std::endl;
-
-	// Smooth surface model
-	vtkWindowedSincPolyDataFilterPtr smoother = vtkWindowedSincPolyDataFilterPtr::New();
-	if(smoothing)
-	{
-		smoother->SetInputData(cubesPolyData);
-        smoother->SetNumberOfIterations(numberOfIterations);// Higher number = more smoothing  -  default 15
-		smoother->SetBoundarySmoothing(false);
-		smoother->SetFeatureEdgeSmoothing(false);
-		smoother->SetNormalizeCoordinates(true);
-		smoother->SetFeatureAngle(120);
-        smoother->SetPassBand(passBand);//Lower number = more smoothing  -  default 0.3
-		smoother->Update();
-		cubesPolyData = smoother->GetOutput();
-	}
-
-	//Create a surface of triangles
-
-	//Decimate surface model (remove a percentage of the polygons)
-	vtkTriangleFilterPtr trifilt = vtkTriangleFilterPtr::New();
-	vtkDecimateProPtr deci = vtkDecimateProPtr::New();
-	vtkPolyDataNormalsPtr normals = vtkPolyDataNormalsPtr::New();
-	if (decimation > 0.000001)
-	{
-		trifilt->SetInputData(cubesPolyData);
-		trifilt->Update();
-		deci->SetInputConnection(trifilt->GetOutputPort());
-		deci->SetTargetReduction(decimation);
-		deci->SetPreserveTopology(preserveTopology);
-		//    deci->PreserveTopologyOn();
-		deci->Update();
-		cubesPolyData = deci->GetOutput();
-	}
-
-	normals->SetInputData(cubesPolyData);
-	normals->Update();
-
-	cubesPolyData->DeepCopy(normals->GetOutput());
-
-	return cubesPolyData;
+	SurfaceExtractor extractor;
+	extractor.setThreshold(threshold);
+	extractor.setReduceResolution(reduceResolution);
+	extractor.setSmoothing(smoothing, numberOfIterations, passBand);
+	extractor.setDecimation(decimation, preserveTopology);
+	vtkPolyDataPtr retval = extractor.execute(input);
+
+	if (retval)
+		report(QString("Created contour with %1 triangles: %2")
+			   .arg(retval->GetNumberOfPolys())
+			   .arg(extractor.getTimingsAsString()));
+	return retval;
 }
 
 bool ContourFilter::postProcess()
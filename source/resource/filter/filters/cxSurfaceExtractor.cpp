@@ -0,0 +1,665 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#include "cxSurfaceExtractor.h"
+
+#include <cmath>
+#include <algorithm>
+#include <QTime>
+#include <QThread>
+#include <QStringList>
+#include <QtConcurrentMap>
+#include <vtkImageData.h>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkFloatArray.h>
+#include <vtkPointData.h>
+#include <vtkWindowedSincPolyDataFilter.h>
+#include <vtkDecimatePro.h>
+
+#include "cxImagePyramid.h"
+#include "cxVector3D.h"
+
+typedef vtkSmartPointer<class vtkIdTypeArray> vtkIdTypeArrayPtr;
+
+namespace cx
+{
+
+namespace
+{
+/** Marching cubes triangles for all 256 cases of inside corners.
+ *
+ * Corner i of a cell is at (i&1, (i>>1)&1, (i>>2)&1). Edge e runs
+ * along axis a=e/4, from the corner with coordinate 0 along a, and
+ * coordinates u=e&1 and v=(e>>1)&1 along the axes (a+1)%3 and (a+2)%3.
+ *
+ * The table is generated: On each face, the crossed edges are paired,
+ * keeping inside corners on diagonals apart. This is decided by the
+ * face alone, thus neighbouring cells agree and the surface is closed.
+ * The pairs form loops, which are oriented with the inside behind them
+ * and split into triangle fans.
+ */
+class CellCases
+{
+public:
+	static const CellCases& get()
+	{
+		static CellCases cases;
+		return cases;
+	}
+	const std::vector<int>& getTriangles(int mask) const { return mTriangles[mask]; } ///< local edges, three per triangle
+
+	static Eigen::Array3i getCorner(int corner) { return Eigen::Array3i(corner&1, (corner>>1)&1, (corner>>2)&1); }
+	static Eigen::Array3i getEdgeStart(int edge)
+	{
+		int a = edge/4;
+		Eigen::Array3i retval(0, 0, 0);
+		retval[(a+1)%3] = edge&1;
+		retval[(a+2)%3] = (edge>>1)&1;
+		return retval;
+	}
+
+private:
+	CellCases()
+	{
+		for (int mask=0; mask<256; ++mask)
+			this->generate(mask);
+	}
+
+	static int getCornerIndex(const Eigen::Array3i& p) { return p[0] + 2*p[1] + 4*p[2]; }
+	static int getEdge(const Eigen::Array3i& p, const Eigen::Array3i& q)
+	{
+		int a = (p[0]!=q[0]) ? 0 : ((p[1]!=q[1]) ? 1 : 2);
+		Eigen::Array3i start = p.min(q);
+		return 4*a + start[(a+1)%3] + 2*start[(a+2)%3];
+	}
+	static Vector3D getMidpoint(int edge)
+	{
+		Vector3D retval = CellCases::getEdgeStart(edge).cast<double>();
+		retval[edge/4] = 0.5;
+		return retval;
+	}
+
+	void generate(int mask)
+	{
+		std::vector<std::vector<int> > neighbours(12);
+		for (int a=0; a<3; ++a)
+		{
+			for (int side=0; side<2; ++side)
+			{
+				int cycle[4];
+				int uv[4][2] = { {0,0}, {1,0}, {1,1}, {0,1} };
+				for (int k=0; k<4; ++k)
+				{
+					Eigen::Array3i p;
+					p[a] = side;
+					p[(a+1)%3] = uv[k][0];
+					p[(a+2)%3] = uv[k][1];
+					cycle[k] = getCornerIndex(p);
+				}
+				this->pairFaceEdges(mask, cycle, &neighbours);
+			}
+		}
+
+		std::vector<bool> visited(12, false);
+		for (int start=0; start<12; ++start)
+		{
+			if (visited[start] || neighbours[start].empty())
+				continue;
+			std::vector<int> loop;
+			int previous = -1;
+			int current = start;
+			do
+			{
+				visited[current] = true;
+				loop.push_back(current);
+				int next = (neighbours[current][0]==previous) ? neighbours[current][1] : neighbours[current][0];
+				previous = current;
+				current = next;
+			} while (current!=start);
+			this->addLoop(mask, loop);
+		}
+	}
+
+	/** Pair the crossed edges of a face given by its corners in cyclic order.
+	 */
+	void pairFaceEdges(int mask, const int* cycle, std::vector<std::vector<int> >* neighbours) const
+	{
+		int edges[4];
+		bool crossed[4];
+		int count = 0;
+		for (int k=0; k<4; ++k)
+		{
+			int p = cycle[k];
+			int q = cycle[(k+1)%4];
+			edges[k] = getEdge(getCorner(p), getCorner(q));
+			crossed[k] = ((mask>>p)&1) != ((mask>>q)&1);
+			count += crossed[k];
+		}
+
+		std::vector<std::pair<int,int> > pairs;
+		if (count==2)
+		{
+			int first = -1;
+			for (int k=0; k<4; ++k)
+			{
+				if (!crossed[k])
+					continue;
+				if (first<0)
+					first = edges[k];
+				else
+					pairs.push_back(std::make_pair(first, edges[k]));
+			}
+		}
+		else if (count==4)
+		{
+			// cut off each inside corner
+			for (int k=0; k<4; ++k)
+				if ((mask>>cycle[k])&1)
+					pairs.push_back(std::make_pair(edges[(k+3)%4], edges[k]));
+		}
+
+		for (unsigned i=0; i<pairs.size(); ++i)
+		{
+			(*neighbours)[pairs[i].first].push_back(pairs[i].second);
+			(*neighbours)[pairs[i].second].push_back(pairs[i].first);
+		}
+	}
+
+	/** Orient the loop with the inside corners behind it, then add it as a triangle fan.
+	 */
+	void addLoop(int mask, std::vector<int> loop)
+	{
+		Vector3D area = Vector3D::Zero();
+		Vector3D outwards = Vector3D::Zero();
+		for (unsigned i=0; i<loop.size(); ++i)
+		{
+			area += getMidpoint(loop[i]).cross(getMidpoint(loop[(i+1)%loop.size()]));
+			Vector3D direction = Vector3D::Zero();
+			direction[loop[i]/4] = 1;
+			bool startInside = (mask>>getCornerIndex(getEdgeStart(loop[i])))&1;
+			outwards += startInside ? direction : Vector3D(-direction);
+		}
+		if (area.dot(outwards) < 0)
+			std::reverse(loop.begin(), loop.end());
+
+		for (unsigned i=1; i+1<loop.size(); ++i)
+		{
+			mTriangles[mask].push_back(loop[0]);
+			mTriangles[mask].push_back(loop[i]);
+			mTriangles[mask].push_back(loop[i+1]);
+		}
+	}
+
+	std::vector<int> mTriangles[256];
+};
+
+const vtkIdType NO_VERTEX = -1;
+const vtkIdType AT_EDGE_START = -2; ///< the vertex is the point vertex at the start of the edge
+const vtkIdType AT_EDGE_END = -3; ///< the vertex is the point vertex at the end of the edge
+
+/** Vertex ids for all points and edges starting in one z-plane.
+ */
+struct PlaneVertices
+{
+	std::vector<vtkIdType> mPointIds; ///< vertex on a grid point with value equal to the threshold
+	std::vector<vtkIdType> mEdgeIds; ///< vertex on the edge from each point along x, y and z
+};
+
+/** A range of z-planes, processed by one thread.
+ */
+struct Slab
+{
+	int mBegin;
+	int mEnd;
+	std::vector<vtkIdType> mTriangles;
+};
+
+template<class T> class MarchingCubes
+{
+public:
+	MarchingCubes(vtkImageDataPtr input, double threshold) : mThreshold(threshold)
+	{
+		int* dim = input->GetDimensions();
+		int* extent = input->GetExtent();
+		double* origin = input->GetOrigin();
+		double* spacing = input->GetSpacing();
+		for (int i=0; i<3; ++i)
+		{
+			mDim[i] = dim[i];
+			mSpacing[i] = spacing[i];
+			mOrigin[i] = origin[i] + extent[2*i]*spacing[i];
+		}
+		mData = static_cast<const T*>(input->GetScalarPointer());
+		mComponents = input->GetNumberOfScalarComponents();
+		mPlaneSize = vtkIdType(mDim[0])*mDim[1];
+	}
+
+	vtkPolyDataPtr execute()
+	{
+		vtkPolyDataPtr retval = vtkPolyDataPtr::New();
+		retval->SetPoints(vtkPointsPtr::New());
+		retval->SetPolys(vtkCellArrayPtr::New());
+		if (!mData || (mDim<2).any())
+			return retval;
+
+		CellCases::get();
+
+		// count vertices in each plane, giving the id of the first vertex in each plane
+		std::vector<vtkIdType> first(mDim[2]+1, 0);
+		std::vector<int> planes(mDim[2]);
+		for (int z=0; z<mDim[2]; ++z)
+			planes[z] = z;
+		QtConcurrent::blockingMap(planes, [&](int& z)
+		{
+			first[z+1] = this->addPlaneVertices(z, 0, NULL, NULL);
+		});
+		for (int z=0; z<mDim[2]; ++z)
+			first[z+1] += first[z];
+
+		vtkPointsPtr points = vtkPointsPtr::New();
+		points->SetDataTypeToFloat();
+		points->SetNumberOfPoints(first.back());
+		float* positions = static_cast<float*>(points->GetVoidPointer(0));
+
+		std::vector<Slab> slabs = this->createSlabs();
+		QtConcurrent::blockingMap(slabs, [&](Slab& slab)
+		{
+			PlaneVertices lower;
+			PlaneVertices upper;
+			this->addPlaneVertices(slab.mBegin, first[slab.mBegin], &lower, positions);
+			for (int z=slab.mBegin; z<slab.mEnd; ++z)
+			{
+				if (z+1 >= mDim[2])
+					break;
+				// vertices in the first plane of the next slab are added by that slab
+				this->addPlaneVertices(z+1, first[z+1], &upper, (z+1<slab.mEnd) ? positions : NULL);
+				this->addTriangles(z, lower, upper, &slab.mTriangles);
+				std::swap(lower, upper);
+			}
+		});
+
+		vtkIdType numberOfTriangles = 0;
+		for (unsigned i=0; i<slabs.size(); ++i)
+			numberOfTriangles += slabs[i].mTriangles.size()/3;
+		vtkIdTypeArrayPtr cells = vtkIdTypeArrayPtr::New();
+		cells->SetNumberOfValues(4*numberOfTriangles);
+		vtkIdType* cell = cells->GetPointer(0);
+		for (unsigned i=0; i<slabs.size(); ++i)
+		{
+			const std::vector<vtkIdType>& triangles = slabs[i].mTriangles;
+			for (unsigned j=0; j<triangles.size(); j+=3)
+			{
+				*cell++ = 3;
+				*cell++ = triangles[j];
+				*cell++ = triangles[j+1];
+				*cell++ = triangles[j+2];
+			}
+			std::vector<vtkIdType>().swap(slabs[i].mTriangles);
+		}
+
+		retval->GetPolys()->SetCells(numberOfTriangles, cells);
+		retval->SetPoints(points);
+		return retval;
+	}
+
+private:
+	std::vector<Slab> createSlabs() const
+	{
+		int count = std::max(QThread::idealThreadCount(), 1) * 4;
+		count = std::min(count, mDim[2]);
+		std::vector<Slab> retval(count);
+		for (int i=0; i<count; ++i)
+		{
+			retval[i].mBegin = mDim[2]*i/count;
+			retval[i].mEnd = mDim[2]*(i+1)/count;
+		}
+		return retval;
+	}
+
+	double getValue(const Eigen::Array3i& p) const
+	{
+		return mData[mComponents*(p[0] + vtkIdType(mDim[0])*p[1] + mPlaneSize*p[2])];
+	}
+
+	/** A point vertex is a grid point with value equal to the threshold, next to an outside point.
+	 */
+	bool isPointVertex(const Eigen::Array3i& p, double value) const
+	{
+		if (value!=mThreshold)
+			return false;
+		for (int a=0; a<3; ++a)
+		{
+			for (int step=-1; step<=1; step+=2)
+			{
+				Eigen::Array3i q = p;
+				q[a] += step;
+				if (q[a]>=0 && q[a]<mDim[a] && this->getValue(q)<mThreshold)
+					return true;
+			}
+		}
+		return false;
+	}
+
+	void setPosition(float* positions, vtkIdType id, const Eigen::Array3i& p, int axis, double t) const
+	{
+		float* position = positions + 3*id;
+		for (int i=0; i<3; ++i)
+			position[i] = mOrigin[i] + mSpacing[i]*p[i];
+		if (axis>=0)
+			position[axis] += mSpacing[axis]*t;
+	}
+
+	/** Give ids to the vertices starting in plane z, in raster order starting at firstId.
+	 *  Store the ids in plane and the positions in positions, if given.
+	 *  Return the number of vertices.
+	 */
+	vtkIdType addPlaneVertices(int z, vtkIdType firstId, PlaneVertices* plane, float* positions) const
+	{
+		vtkIdType id = firstId;
+		if (plane)
+		{
+			plane->mPointIds.assign(vtkIdType(mDim[0])*mDim[1], NO_VERTEX);
+			plane->mEdgeIds.assign(3*vtkIdType(mDim[0])*mDim[1], NO_VERTEX);
+		}
+
+		for (int y=0; y<mDim[1]; ++y)
+		{
+			for (int x=0; x<mDim[0]; ++x)
+			{
+				Eigen::Array3i p(x, y, z);
+				vtkIdType index = x + vtkIdType(mDim[0])*y;
+				double value = this->getValue(p);
+				bool inside = value >= mThreshold;
+
+				if (this->isPointVertex(p, value))
+				{
+					if (plane)
+						plane->mPointIds[index] = id;
+					if (positions)
+						this->setPosition(positions, id, p, -1, 0);
+					++id;
+				}
+
+				for (int a=0; a<3; ++a)
+				{
+					if (p[a]+1 >= mDim[a])
+						continue;
+					Eigen::Array3i q = p;
+					q[a] += 1;
+					double endValue = this->getValue(q);
+					if (inside == (endValue >= mThreshold))
+						continue;
+
+					vtkIdType edgeId;
+					if (inside && value==mThreshold)
+						edgeId = AT_EDGE_START;
+					else if (!inside && endValue==mThreshold)
+						edgeId = AT_EDGE_END;
+					else
+					{
+						edgeId = id++;
+						if (positions)
+							this->setPosition(positions, edgeId, p, a, (mThreshold-value)/(endValue-value));
+					}
+					if (plane)
+						plane->mEdgeIds[3*index+a] = edgeId;
+				}
+			}
+		}
+		return id - firstId;
+	}
+
+	vtkIdType getVertex(int x, int y, int edge, const PlaneVertices& lower, const PlaneVertices& upper) const
+	{
+		Eigen::Array3i start = CellCases::getEdgeStart(edge);
+		int a = edge/4;
+		const PlaneVertices& plane = start[2] ? upper : lower;
+		vtkIdType index = (x+start[0]) + vtkIdType(mDim[0])*(y+start[1]);
+		vtkIdType retval = plane.mEdgeIds[3*index+a];
+		if (retval==AT_EDGE_START)
+			return plane.mPointIds[index];
+		if (retval==AT_EDGE_END)
+		{
+			if (a==2)
+				return upper.mPointIds[index];
+			return plane.mPointIds[index + ((a==0) ? 1 : mDim[0])];
+		}
+		return retval;
+	}
+
+	void addTriangles(int z, const PlaneVertices& lower, const PlaneVertices& upper, std::vector<vtkIdType>* triangles) const
+	{
+		const CellCases& cases = CellCases::get();
+		for (int y=0; y+1<mDim[1]; ++y)
+		{
+			for (int x=0; x+1<mDim[0]; ++x)
+			{
+				int mask = 0;
+				for (int corner=0; corner<8; ++corner)
+				{
+					Eigen::Array3i p = Eigen::Array3i(x, y, z) + CellCases::getCorner(corner);
+					if (this->getValue(p) >= mThreshold)
+						mask |= 1<<corner;
+				}
+
+				const std::vector<int>& edges = cases.getTriangles(mask);
+				for (unsigned i=0; i<edges.size(); i+=3)
+				{
+					vtkIdType a = this->getVertex(x, y, edges[i], lower, upper);
+					vtkIdType b = this->getVertex(x, y, edges[i+1], lower, upper);
+					vtkIdType c = this->getVertex(x, y, edges[i+2], lower, upper);
+					if (a==b || b==c || c==a)
+						continue; // collapsed onto a point vertex
+					triangles->push_back(a);
+					triangles->push_back(b);
+					triangles->push_back(c);
+				}
+			}
+		}
+	}
+
+	const T* mData;
+	int mComponents;
+	double mThreshold;
+	Eigen::Array3i mDim;
+	vtkIdType mPlaneSize;
+	Vector3D mOrigin; ///< position of the first voxel
+	Vector3D mSpacing;
+};
+
+/** A range of points, processed by one thread.
+ */
+struct Chunk
+{
+	vtkIdType mBegin;
+	vtkIdType mEnd;
+};
+
+std::vector<Chunk> createChunks(vtkIdType size)
+{
+	vtkIdType count = std::max(QThread::idealThreadCount(), 1);
+	count = std::max<vtkIdType>(std::min<vtkIdType>(count, size/65536), 1);
+	std::vector<Chunk> retval(count);
+	for (vtkIdType i=0; i<count; ++i)
+	{
+		retval[i].mBegin = size*i/count;
+		retval[i].mEnd = size*(i+1)/count;
+	}
+	return retval;
+}
+} // namespace
+
+SurfaceExtractor::SurfaceExtractor() :
+	mThreshold(0),
+	mReduceResolution(false),
+	mSmoothing(true),
+	mNumberOfIterations(15),
+	mPassBand(0.3),
+	mDecimation(0.2),
+	mPreserveTopology(true)
+{
+}
+
+void SurfaceExtractor::setThreshold(double threshold)
+{
+	mThreshold = threshold;
+}
+
+void SurfaceExtractor::setReduceResolution(bool on)
+{
+	mReduceResolution = on;
+}
+
+void SurfaceExtractor::setSmoothing(bool on, int numberOfIterations, double passBand)
+{
+	mSmoothing = on;
+	mNumberOfIterations = numberOfIterations;
+	mPassBand = passBand;
+}
+
+void SurfaceExtractor::setDecimation(double targetReduction, bool preserveTopology)
+{
+	mDecimation = targetReduction;
+	mPreserveTopology = preserveTopology;
+}
+
+vtkPolyDataPtr SurfaceExtractor::execute(vtkImageDataPtr input)
+{
+	mTimings.clear();
+	if (!input)
+		return vtkPolyDataPtr();
+
+	QTime clock;
+	clock.start();
+
+	if (mReduceResolution)
+	{
+		input = ImagePyramid::decimate(input);
+		mTimings.push_back(std::make_pair(QString("reduce"), double(clock.restart())));
+	}
+
+	vtkPolyDataPtr surface = extractSurface(input, mThreshold);
+	input = NULL;
+	mTimings.push_back(std::make_pair(QString("extract"), double(clock.restart())));
+
+	if (mSmoothing)
+	{
+		surface = this->smooth(surface);
+		mTimings.push_back(std::make_pair(QString("smooth"), double(clock.restart())));
+	}
+
+	if (mDecimation > 0.000001)
+	{
+		surface = this->decimate(surface);
+		mTimings.push_back(std::make_pair(QString("decimate"), double(clock.restart())));
+	}
+
+	computeNormals(surface);
+	mTimings.push_back(std::make_pair(QString("normals"), double(clock.restart())));
+	return surface;
+}
+
+QString SurfaceExtractor::getTimingsAsString() const
+{
+	QStringList retval;
+	for (unsigned i=0; i<mTimings.size(); ++i)
+		retval << QString("%1 %2 ms").arg(mTimings[i].first).arg(mTimings[i].second);
+	return retval.join(", ");
+}
+
+vtkPolyDataPtr SurfaceExtractor::extractSurface(vtkImageDataPtr input, double threshold)
+{
+	if (!input || !input->GetScalarPointer())
+		return vtkPolyDataPtr();
+
+	switch (input->GetScalarType())
+	{
+		vtkTemplateMacro(return MarchingCubes<VTK_TT>(input, threshold).execute());
+	}
+	return vtkPolyDataPtr();
+}
+
+vtkPolyDataPtr SurfaceExtractor::smooth(vtkPolyDataPtr surface) const
+{
+	vtkWindowedSincPolyDataFilterPtr smoother = vtkWindowedSincPolyDataFilterPtr::New();
+	smoother->SetInputData(surface);
+	smoother->SetNumberOfIterations(mNumberOfIterations);// Higher number = more smoothing  -  default 15
+	smoother->SetBoundarySmoothing(false);
+	smoother->SetFeatureEdgeSmoothing(false);
+	smoother->SetNormalizeCoordinates(true);
+	smoother->SetFeatureAngle(120);
+	smoother->SetPassBand(mPassBand);//Lower number = more smoothing  -  default 0.3
+	smoother->Update();
+	return smoother->GetOutput();
+}
+
+/** The surface consists of triangles only, thus no triangle filter is needed.
+ */
+vtkPolyDataPtr SurfaceExtractor::decimate(vtkPolyDataPtr surface) const
+{
+	vtkDecimateProPtr deci = vtkDecimateProPtr::New();
+	deci->SetInputData(surface);
+	deci->SetTargetReduction(mDecimation);
+	deci->SetPreserveTopology(mPreserveTopology);
+	deci->Update();
+	return deci->GetOutput();
+}
+
+void SurfaceExtractor::computeNormals(vtkPolyDataPtr surface)
+{
+	if (!surface)
+		return;
+	vtkPoints* points = surface->GetPoints();
+	vtkIdType numberOfPoints = points ? points->GetNumberOfPoints() : 0;
+
+	vtkFloatArrayPtr normals = vtkFloatArrayPtr::New();
+	normals->SetName("Normals");
+	normals->SetNumberOfComponents(3);
+	normals->SetNumberOfTuples(numberOfPoints);
+	float* normal = normals->GetPointer(0);
+	std::fill(normal, normal+3*numberOfPoints, 0.0f);
+
+	// sum of the unnormalized triangle normals, i.e. area weighted
+	vtkCellArray* polys = surface->GetPolys();
+	vtkIdType count;
+	vtkIdType* ids;
+	for (polys->InitTraversal(); polys->GetNextCell(count, ids); )
+	{
+		if (count!=3)
+			continue;
+		Vector3D a(points->GetPoint(ids[0]));
+		Vector3D b(points->GetPoint(ids[1]));
+		Vector3D c(points->GetPoint(ids[2]));
+		Vector3D n = (b-a).cross(c-a);
+		for (int i=0; i<3; ++i)
+			for (int j=0; j<3; ++j)
+				normal[3*ids[i]+j] += n[j];
+	}
+
+	std::vector<Chunk> chunks = createChunks(numberOfPoints);
+	QtConcurrent::blockingMap(chunks, [&](Chunk& chunk)
+	{
+		for (vtkIdType i=chunk.mBegin; i<chunk.mEnd; ++i)
+		{
+			float* n = normal + 3*i;
+			float length = std::sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+			if (length > 0)
+				for (int j=0; j<3; ++j)
+					n[j] /= length;
+		}
+	});
+
+	surface->GetPointData()->SetNormals(normals);
+}
+
+} // namespace cx
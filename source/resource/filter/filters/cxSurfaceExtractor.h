@@ -0,0 +1,79 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+#ifndef CXSURFACEEXTRACTOR_H
+#define CXSURFACEEXTRACTOR_H
+
+#include "cxResourceFilterExport.h"
+
+#include <vector>
+#include <utility>
+#include <QString>
+#include "vtkForwardDeclarations.h"
+
+namespace cx
+{
+
+/** Iso-surface extraction from a volume, the engine behind ContourFilter.
+ *
+ * Stages, each optional except extraction:
+ *  - Reduce resolution by 2x box decimation, see ImagePyramid.
+ *  - Marching cubes, block parallel. Each vertex is created once, by
+ *    the block owning its edge, thus no merging of points is needed.
+ *    Vertices on grid points with value equal to the threshold are
+ *    shared by all edges ending there, as in binary segmentations.
+ *  - Windowed sinc smoothing.
+ *  - Decimation.
+ *  - Point normals, pointing out of the volume above the threshold.
+ *
+ * Each stage releases its input as soon as it is done, and no stage
+ * copies the surface, thus at most two surfaces are in memory at once.
+ * The time spent in each stage is available after execute().
+ *
+ * \ingroup cx_resource_filter
+ * \date 2026-10-18
+ */
+class cxResourceFilter_EXPORT SurfaceExtractor
+{
+public:
+	SurfaceExtractor();
+
+	void setThreshold(double threshold); ///< values from threshold and above are inside the surface
+	void setReduceResolution(bool on);
+	void setSmoothing(bool on, int numberOfIterations=15, double passBand=0.3);
+	void setDecimation(double targetReduction, bool preserveTopology=true); ///< remove this fraction [0,1) of the triangles
+
+	vtkPolyDataPtr execute(vtkImageDataPtr input);
+	std::vector<std::pair<QString, double> > getTimings() const { return mTimings; } ///< ms spent in each stage of the last execute()
+	QString getTimingsAsString() const;
+
+	/** Marching cubes on the first component of input, using all cores.
+	 *  The triangles are oriented with normals pointing out of the inside region.
+	 */
+	static vtkPolyDataPtr extractSurface(vtkImageDataPtr input, double threshold);
+	static void computeNormals(vtkPolyDataPtr surface); ///< area weighted point normals, following the triangle orientation
+
+private:
+	vtkPolyDataPtr smooth(vtkPolyDataPtr surface) const;
+	vtkPolyDataPtr decimate(vtkPolyDataPtr surface) const;
+
+	double mThreshold;
+	bool mReduceResolution;
+	bool mSmoothing;
+	int mNumberOfIterations;
+	double mPassBand;
+	double mDecimation;
+	bool mPreserveTopology;
+	std::vector<std::pair<QString, double> > mTimings;
+};
+
+} // namespace cx
+
+#endif // CXSURFACEEXTRACTOR_H
@@ -0,0 +1,209 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <map>
+#include <set>
+#include <cmath>
+#include <vtkImageData.h>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+#include <vtkPointData.h>
+#include <vtkDataArray.h>
+#include <vtkMarchingCubes.h>
+#include "cxSurfaceExtractor.h"
+#include "cxContourFilter.h"
+#include "cxVector3D.h"
+
+namespace cxtest
+{
+
+namespace
+{
+const cx::Vector3D center(15.3, 15.7, 15.1);
+
+vtkImageDataPtr createImage(int dim)
+{
+	vtkImageDataPtr retval = vtkImageDataPtr::New();
+	retval->SetExtent(0, dim-1, 0, dim-1, 0, dim-1);
+	retval->SetSpacing(1, 1, 1);
+	retval->AllocateScalars(VTK_FLOAT, 1);
+	return retval;
+}
+
+/** Distance to a sphere, positive inside.
+ */
+vtkImageDataPtr createSphere(double radius)
+{
+	vtkImageDataPtr retval = createImage(32);
+	float* voxels = static_cast<float*>(retval->GetScalarPointer());
+	for (int k=0; k<32; ++k)
+		for (int j=0; j<32; ++j)
+			for (int i=0; i<32; ++i)
+				*voxels++ = radius - (cx::Vector3D(i, j, k) - center).norm();
+	return retval;
+}
+
+/** Binary ball, 1 inside.
+ */
+vtkImageDataPtr createBinarySphere(double radius)
+{
+	vtkImageDataPtr retval = createSphere(radius);
+	float* voxels = static_cast<float*>(retval->GetScalarPointer());
+	for (vtkIdType i=0; i<retval->GetNumberOfPoints(); ++i)
+		voxels[i] = (voxels[i] >= 0) ? 1 : 0;
+	return retval;
+}
+
+/** Random values, with a border of zeros.
+ */
+vtkImageDataPtr createNoise()
+{
+	vtkImageDataPtr retval = createImage(20);
+	float* voxels = static_cast<float*>(retval->GetScalarPointer());
+	unsigned seed = 1;
+	for (int k=0; k<20; ++k)
+		for (int j=0; j<20; ++j)
+			for (int i=0; i<20; ++i)
+			{
+				seed = seed*1103515245 + 12345;
+				bool border = (i==0 || j==0 || k==0 || i==19 || j==19 || k==19);
+				*voxels++ = border ? 0 : ((seed>>16)%1000)/1000.0 + 0.0001;
+			}
+	return retval;
+}
+
+int countPointsFromVtkMarchingCubes(vtkImageDataPtr image, double threshold)
+{
+	vtkMarchingCubesPtr cubes = vtkMarchingCubesPtr::New();
+	cubes->SetInputData(image);
+	cubes->SetValue(0, threshold);
+	cubes->ComputeNormalsOff();
+	cubes->ComputeGradientsOff();
+	cubes->ComputeScalarsOff();
+	cubes->Update();
+	return cubes->GetOutput()->GetNumberOfPoints();
+}
+
+/** A closed, consistently oriented surface has each directed edge exactly
+ *  once, and the same edge in the opposite direction in a neighbour triangle.
+ */
+void checkClosedAndOriented(vtkPolyDataPtr surface)
+{
+	std::map<std::pair<vtkIdType,vtkIdType>, int> edges;
+	vtkCellArray* polys = surface->GetPolys();
+	vtkIdType count;
+	vtkIdType* ids;
+	for (polys->InitTraversal(); polys->GetNextCell(count, ids); )
+	{
+		REQUIRE(count==3);
+		for (int i=0; i<3; ++i)
+			++edges[std::make_pair(ids[i], ids[(i+1)%3])];
+	}
+
+	int failures = 0;
+	for (std::map<std::pair<vtkIdType,vtkIdType>, int>::iterator iter=edges.begin(); iter!=edges.end(); ++iter)
+	{
+		std::pair<vtkIdType,vtkIdType> reverse(iter->first.second, iter->first.first);
+		if (iter->second!=1 || !edges.count(reverse) || edges[reverse]!=1)
+			++failures;
+	}
+	CHECK(failures==0);
+}
+} // namespace
+
+TEST_CASE("SurfaceExtractor: Extract a closed sphere", "[unit][resource][filter]")
+{
+	vtkImageDataPtr image = createSphere(10);
+	vtkPolyDataPtr surface = cx::SurfaceExtractor::extractSurface(image, 0);
+	REQUIRE(surface);
+	REQUIRE(surface->GetNumberOfPolys() > 0);
+
+	checkClosedAndOriented(surface);
+	// each crossed edge gives one vertex, as when vtkMarchingCubes merges points
+	CHECK(surface->GetNumberOfPoints() == countPointsFromVtkMarchingCubes(image, 0));
+
+	cx::SurfaceExtractor::computeNormals(surface);
+	vtkDataArray* normals = surface->GetPointData()->GetNormals();
+	REQUIRE(normals);
+	int inwards = 0;
+	for (vtkIdType i=0; i<surface->GetNumberOfPoints(); ++i)
+	{
+		cx::Vector3D position(surface->GetPoint(i));
+		cx::Vector3D normal(normals->GetTuple3(i));
+		CHECK(fabs((position-center).norm() - 10) < 0.1);
+		if (normal.dot(position-center) <= 0)
+			++inwards;
+	}
+	CHECK(inwards == 0);
+}
+
+TEST_CASE("SurfaceExtractor: Surface is closed for all cell configurations", "[unit][resource][filter]")
+{
+	vtkPolyDataPtr surface = cx::SurfaceExtractor::extractSurface(createNoise(), 0.5);
+	REQUIRE(surface->GetNumberOfPolys() > 1000);
+	checkClosedAndOriented(surface);
+}
+
+TEST_CASE("SurfaceExtractor: Binary volumes share vertices on grid points", "[unit][resource][filter]")
+{
+	vtkImageDataPtr image = createBinarySphere(10);
+	vtkPolyDataPtr surface = cx::SurfaceExtractor::extractSurface(image, 1);
+	REQUIRE(surface->GetNumberOfPolys() > 0);
+
+	std::set<std::vector<double> > positions;
+	for (vtkIdType i=0; i<surface->GetNumberOfPoints(); ++i)
+	{
+		double* p = surface->GetPoint(i);
+		positions.insert(std::vector<double>(p, p+3));
+		CHECK(p[0] == Approx(floor(p[0]+0.5)));
+		CHECK(p[1] == Approx(floor(p[1]+0.5)));
+		CHECK(p[2] == Approx(floor(p[2]+0.5)));
+	}
+	CHECK(positions.size() == surface->GetNumberOfPoints());
+	CHECK(surface->GetNumberOfPoints() == countPointsFromVtkMarchingCubes(image, 1));
+
+	vtkCellArray* polys = surface->GetPolys();
+	vtkIdType count;
+	vtkIdType* ids;
+	int degenerate = 0;
+	for (polys->InitTraversal(); polys->GetNextCell(count, ids); )
+		if (ids[0]==ids[1] || ids[1]==ids[2] || ids[2]==ids[0])
+			++degenerate;
+	CHECK(degenerate == 0);
+}
+
+TEST_CASE("SurfaceExtractor: Run all stages from ContourFilter", "[unit][resource][filter]")
+{
+	vtkImageDataPtr image = createBinarySphere(10);
+
+	vtkPolyDataPtr full = cx::ContourFilter::execute(image, 1, false, true, true, 0);
+	vtkPolyDataPtr reduced = cx::ContourFilter::execute(image, 1, true, true, true, 0.5);
+	REQUIRE(full);
+	REQUIRE(reduced);
+	CHECK(full->GetPointData()->GetNormals());
+	CHECK(reduced->GetPointData()->GetNormals());
+	CHECK(reduced->GetNumberOfPolys() > 0);
+	CHECK(reduced->GetNumberOfPolys() < full->GetNumberOfPolys()/4);
+
+	cx::SurfaceExtractor extractor;
+	extractor.setThreshold(1);
+	extractor.setReduceResolution(true);
+	extractor.execute(image);
+	std::vector<std::pair<QString, double> > timings = extractor.getTimings();
+	REQUIRE(timings.size() == 5);
+	CHECK(timings.front().first == "reduce");
+	CHECK(timings.back().first == "normals");
+}
+
+} // namespace cxtest
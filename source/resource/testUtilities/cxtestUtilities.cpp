@@ -12,6 +12,8 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include "cxtestUtilities.h"
 
 #include "vtkImageData.h"
+#include "vtkPointData.h"
+#include "vtkDataArray.h"
 #include "cxImage.h"
 #include "cxVolumeHelpers.h"
 #include "cxTypeConversions.h"
@@ -85,6 +87,24 @@ std::vector<cx::ImagePtr> Utilities::create3DImages(unsigned int count, Eigen::A
 	return retval;
 }
 
+vtkImageDataPtr Utilities::create3DVtkImageDataWithPattern(int scalarType, Eigen::Array3i dim, double offset)
+{
+	vtkImageDataPtr retval = vtkImageDataPtr::New();
+	retval->SetExtent(0, dim[0]-1, 0, dim[1]-1, 0, dim[2]-1);
+	retval->SetSpacing(1, 1, 1);
+	retval->AllocateScalars(scalarType, 1);
+
+	vtkIdType count = retval->GetNumberOfPoints();
+	for (vtkIdType i=0; i<count; ++i)
+		retval->GetPointData()->GetScalars()->SetTuple1(i, getPatternValue(i) + offset);
+	return retval;
+}
+
+double Utilities::getPatternValue(long index)
+{
+	return (index*7) % 120;
+}
+
 unsigned int Utilities::getNumberOfVoxelsAboveThreshold(vtkImageDataPtr image, int threshold, int component)
 {
 	if (!image)
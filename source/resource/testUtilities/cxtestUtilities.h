@@ -60,6 +60,8 @@ public:
 	static cx::ImagePtr create3DImage(Eigen::Array3i dim = Eigen::Array3i(3,3,3), const unsigned int voxelValue = 100);
 	static cx::ImagePtr create3DImage(Eigen::Array3i dim, cx::Vector3D spacing, const unsigned int voxelValue);
 	static std::vector<cx::ImagePtr> create3DImages(unsigned int imageCount, Eigen::Array3i dim = Eigen::Array3i(3,3,3), const unsigned int voxelValue = 100);
+	static vtkImageDataPtr create3DVtkImageDataWithPattern(int scalarType, Eigen::Array3i dim, double offset = 0); ///< unit spacing, voxel i has value getPatternValue(i) + offset
+	static double getPatternValue(long index); ///< values in [0,120), with all integers represented
 
 	static unsigned int getNumberOfVoxelsAboveThreshold(vtkImageDataPtr image, int threshold, int component=0);
 	static unsigned int getNumberOfNonZeroVoxels(vtkImageDataPtr image);
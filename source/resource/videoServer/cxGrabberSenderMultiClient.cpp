@@ -0,0 +1,195 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+                 
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+                 
+CustusX is released under a BSD 3-Clause license.
+                 
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "cxGrabberSenderMultiClient.h"
+
+#include "cxIGTLinkConversion.h"
+#include "cxIGTLinkConversionImage.h"
+#include "cxLogger.h"
+
+namespace cx
+{
+
+GrabberSenderMultiClient::GrabberSenderMultiClient()
+{
+	mMaxBufferSize = 19200000; //800(width)*600(height)*4(bytes)*10(images)
+}
+
+void GrabberSenderMultiClient::addClient(QTcpSocket* socket)
+{
+	if (!socket || this->findClient(socket))
+		return;
+
+	ClientPtr client(new Client());
+	client->mSocket = socket;
+	client->mStatistics.name = QString("%1:%2").arg(socket->peerAddress().toString()).arg(socket->peerPort());
+	client->mTimer.start();
+	connect(socket, &QTcpSocket::bytesWritten, this, &GrabberSenderMultiClient::bytesWrittenSlot);
+	connect(socket, &QObject::destroyed, this, &GrabberSenderMultiClient::socketDestroyedSlot);
+	mClients.push_back(client);
+}
+
+void GrabberSenderMultiClient::removeClient(QTcpSocket* socket)
+{
+	ClientPtr client = this->findClient(socket);
+	if (!client)
+		return;
+
+	ClientStatistics statistics = this->getStatistics(client);
+	report(QString("Client %1: sent %2 packages (%3 MB/s), dropped %4.")
+		   .arg(statistics.name)
+		   .arg(statistics.packagesSent)
+		   .arg(statistics.getThroughput(), 0, 'f', 1)
+		   .arg(statistics.packagesDropped));
+
+	if (client->mSocket)
+	{
+		disconnect(client->mSocket.data(), &QTcpSocket::bytesWritten, this, &GrabberSenderMultiClient::bytesWrittenSlot);
+		disconnect(client->mSocket.data(), &QObject::destroyed, this, &GrabberSenderMultiClient::socketDestroyedSlot);
+	}
+	mClients.removeAll(client);
+}
+
+void GrabberSenderMultiClient::setMaxBufferSize(qint64 bytes)
+{
+	mMaxBufferSize = bytes;
+}
+
+int GrabberSenderMultiClient::getClientCount() const
+{
+	return mClients.size();
+}
+
+std::vector<GrabberSenderMultiClient::ClientStatistics> GrabberSenderMultiClient::getStatistics() const
+{
+	std::vector<ClientStatistics> retval;
+	for (int i=0; i<mClients.size(); ++i)
+		retval.push_back(this->getStatistics(mClients[i]));
+	return retval;
+}
+
+GrabberSenderMultiClient::ClientStatistics GrabberSenderMultiClient::getStatistics(ClientPtr client) const
+{
+	ClientStatistics retval = client->mStatistics;
+	retval.duration = client->mTimer.elapsed()/1000.0;
+	return retval;
+}
+
+bool GrabberSenderMultiClient::isReady() const
+{
+	return !mClients.empty();
+}
+
+void GrabberSenderMultiClient::send(PackagePtr package)
+{
+	if (!package || !this->isReady())
+		return;
+
+	QByteArray buffer = this->encode(package);
+	if (buffer.isEmpty())
+		return;
+
+	for (int i=0; i<mClients.size(); ++i)
+		this->enqueue(mClients[i], buffer);
+}
+
+/** Pack all messages in the package into one buffer,
+ *  thus the image and probe definition are sent or dropped together.
+ */
+QByteArray GrabberSenderMultiClient::encode(PackagePtr package) const
+{
+	QByteArray retval;
+
+	if (package->mImage)
+	{
+		IGTLinkConversionImage converter;
+		igtl::ImageMessage::Pointer msg = converter.encode(package->mImage, pcsLPS);
+		msg->Pack();
+		retval.append(reinterpret_cast<const char*>(msg->GetPackPointer()), int(msg->GetPackSize()));
+	}
+
+	if (package->mProbe)
+	{
+		IGTLinkConversion converter;
+		IGTLinkUSStatusMessage::Pointer msg = converter.encode(package->mProbe);
+		msg->Pack();
+		retval.append(reinterpret_cast<const char*>(msg->GetPackPointer()), int(msg->GetPackSize()));
+	}
+
+	return retval;
+}
+
+void GrabberSenderMultiClient::enqueue(ClientPtr client, const QByteArray& buffer)
+{
+	if (!client->mSocket)
+		return;
+
+	client->mQueue.push_back(buffer); // shallow copy, the data is shared between clients
+	client->mQueuedBytes += buffer.size();
+	this->flush(client);
+
+	// drop oldest until the newest package fits within the limit
+	while (client->mQueue.size() > 1 && client->mSocket->bytesToWrite() + client->mQueuedBytes > mMaxBufferSize)
+	{
+		client->mQueuedBytes -= client->mQueue.front().size();
+		client->mQueue.pop_front();
+		++client->mStatistics.packagesDropped;
+	}
+}
+
+/** Move queued packages to the socket as long as there is room in its buffer.
+ */
+void GrabberSenderMultiClient::flush(ClientPtr client)
+{
+	QTcpSocket* socket = client->mSocket;
+	if (!socket)
+		return;
+
+	while (!client->mQueue.empty())
+	{
+		const QByteArray& buffer = client->mQueue.front();
+		qint64 pending = socket->bytesToWrite();
+		if (pending > 0 && pending + buffer.size() > mMaxBufferSize)
+			break;
+
+		socket->write(buffer);
+		++client->mStatistics.packagesSent;
+		client->mStatistics.bytesSent += buffer.size();
+		client->mQueuedBytes -= buffer.size();
+		client->mQueue.pop_front();
+	}
+}
+
+void GrabberSenderMultiClient::bytesWrittenSlot()
+{
+	ClientPtr client = this->findClient(this->sender());
+	if (client)
+		this->flush(client);
+}
+
+/** The QPointer to the socket is cleared before destroyed() is emitted.
+ */
+void GrabberSenderMultiClient::socketDestroyedSlot()
+{
+	for (int i=mClients.size()-1; i>=0; --i)
+		if (!mClients[i]->mSocket)
+			mClients.removeAt(i);
+}
+
+GrabberSenderMultiClient::ClientPtr GrabberSenderMultiClient::findClient(QObject* socket) const
+{
+	for (int i=0; i<mClients.size(); ++i)
+		if (mClients[i]->mSocket.data() == socket)
+			return mClients[i];
+	return ClientPtr();
+}
+
+} /* namespace cx */
@@ -0,0 +1,107 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+                 
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+                 
+CustusX is released under a BSD 3-Clause license.
+                 
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#ifndef CXGRABBERSENDERMULTICLIENT_H_
+#define CXGRABBERSENDERMULTICLIENT_H_
+
+#include "cxGrabberExport.h"
+
+#include "cxSender.h"
+
+#include <QByteArray>
+#include <QList>
+#include <QPointer>
+#include <QElapsedTimer>
+#include <boost/shared_ptr.hpp>
+#include <qtcpsocket.h>
+
+namespace cx
+{
+
+/**
+* \file
+* \addtogroup cx_resource_videoserver
+* @{
+*/
+
+/** Send grabbed data to any number of TCP/IP clients.
+ *
+ * Each package is encoded and packed once into a shared QByteArray,
+ * which is written to all connected sockets.
+ *
+ * Each client has its own queue: When the socket buffer of a slow client
+ * is full, packages are queued, and the oldest queued packages are dropped
+ * when the queue exceeds the buffer limit. Thus a slow client will skip
+ * frames without affecting the other clients.
+ *
+ * \date Oct 18, 2026
+ */
+class cxGrabber_EXPORT GrabberSenderMultiClient : public Sender
+{
+	Q_OBJECT
+
+public:
+	struct ClientStatistics
+	{
+		ClientStatistics() : packagesSent(0), packagesDropped(0), bytesSent(0), duration(0) {}
+		QString name;
+		int packagesSent;
+		int packagesDropped;
+		qint64 bytesSent;
+		double duration; ///< time connected, s
+		double getThroughput() const { return duration>0 ? bytesSent/duration/1.0E6 : 0; } ///< MB/s
+	};
+
+	GrabberSenderMultiClient();
+	virtual ~GrabberSenderMultiClient() {}
+
+	void addClient(QTcpSocket* socket); ///< the client is removed when the socket is deleted, or by removeClient()
+	void removeClient(QTcpSocket* socket);
+	void setMaxBufferSize(qint64 bytes); ///< max bytes pending for each client, before old packages are dropped
+	int getClientCount() const;
+	std::vector<ClientStatistics> getStatistics() const;
+
+	virtual bool isReady() const; ///< true if any client is connected
+	virtual void send(PackagePtr package);
+
+private slots:
+	void bytesWrittenSlot();
+	void socketDestroyedSlot();
+
+private:
+	struct Client
+	{
+		Client() : mQueuedBytes(0) {}
+		QPointer<QTcpSocket> mSocket;
+		QList<QByteArray> mQueue; ///< packages waiting for room in the socket buffer
+		qint64 mQueuedBytes;
+		QElapsedTimer mTimer;
+		ClientStatistics mStatistics;
+	};
+	typedef boost::shared_ptr<Client> ClientPtr;
+
+	QByteArray encode(PackagePtr package) const;
+	void enqueue(ClientPtr client, const QByteArray& buffer);
+	void flush(ClientPtr client);
+	ClientPtr findClient(QObject* socket) const;
+	ClientStatistics getStatistics(ClientPtr client) const;
+
+	QList<ClientPtr> mClients;
+	qint64 mMaxBufferSize; ///< max bytes pending for each client
+};
+typedef boost::shared_ptr<GrabberSenderMultiClient> GrabberSenderMultiClientPtr;
+
+/**
+* @}
+*/
+
+} /* namespace cx */
+#endif /* CXGRABBERSENDERMULTICLIENT_H_ */
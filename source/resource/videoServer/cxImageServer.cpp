@@ -20,13 +20,14 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <QTcpSocket>
 #include "cxCommandlineImageStreamerFactory.h"
 //#include "cxSender.h"
-#include "cxGrabberSenderQTcpSocket.h"
+#include "cxGrabberSenderMultiClient.h"
 
 namespace cx
 {
 
 ImageServer::ImageServer(QObject* parent) :
-	QTcpServer(parent)
+	QTcpServer(parent),
+	mSender(new GrabberSenderMultiClient())
 {}
 
 bool ImageServer::initialize()
@@ -79,33 +80,31 @@ void ImageServer::incomingConnection(qintptr socketDescriptor)
 {
 	std::cout << "Server: Incoming connection..." << std::endl;
 
-	if (mSocket != 0)
-	{
-		reportError("The image server can only handle a single connection.");
-		return;
-	}
-
-	mSocket = new QTcpSocket();
-	connect(mSocket, SIGNAL(disconnected()), this, SLOT(socketDisconnectedSlot()));
-	mSocket->setSocketDescriptor(socketDescriptor);
-	QString clientName = mSocket->localAddress().toString();
+	QTcpSocket* socket = new QTcpSocket(this);
+	connect(socket, SIGNAL(disconnected()), this, SLOT(socketDisconnectedSlot()));
+	socket->setSocketDescriptor(socketDescriptor);
+	QString clientName = socket->peerAddress().toString();
 	report("Connected to "+clientName+". Session started.");
-	SenderPtr sender(new GrabberSenderQTcpSocket(mSocket));
 
-	mImageSender->startStreaming(sender);
+	bool first = (mSender->getClientCount()==0);
+	mSender->addClient(socket);
+	if (first)
+		mImageSender->startStreaming(mSender);
 }
 
 void ImageServer::socketDisconnectedSlot()
 {
-	if (mImageSender)
-		mImageSender->stopStreaming();
+	QTcpSocket* socket = dynamic_cast<QTcpSocket*>(this->sender());
+	if (!socket)
+		return;
 
-	if (mSocket)
-	{
-		QString clientName = mSocket->localAddress().toString();
-		report("Disconnected from "+clientName+". Session ended.");
-		mSocket->deleteLater();
-	}
+	QString clientName = socket->peerAddress().toString();
+	report("Disconnected from "+clientName+". Session ended.");
+	mSender->removeClient(socket);
+	socket->deleteLater();
+
+	if (mImageSender && mSender->getClientCount()==0)
+		mImageSender->stopStreaming();
 }
 
 void ImageServer::printHelpText()
@@ -22,10 +22,14 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 namespace cx
 {
 typedef boost::shared_ptr<class Streamer> StreamerPtr;
+typedef boost::shared_ptr<class GrabberSenderMultiClient> GrabberSenderMultiClientPtr;
 
 /**
  * \brief ImageServer
  *
+ * Streams images to any number of clients. Streaming starts when the
+ * first client connects, and stops when the last client disconnects.
+ *
  * \ingroup cx_resource_videoserver
  * \date Oct 30, 2010
  * \author Christian Askeland
@@ -48,7 +52,7 @@ private slots:
 	void socketDisconnectedSlot();
 private:
 	StreamerPtr mImageSender;
-	QPointer<QTcpSocket> mSocket;
+	GrabberSenderMultiClientPtr mSender;
 };
 
 } // namespace cx
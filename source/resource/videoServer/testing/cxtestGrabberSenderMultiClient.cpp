@@ -0,0 +1,211 @@
+/*=========================================================================
+This file is part of CustusX, an Image Guided Therapy Application.
+
+Copyright (c) SINTEF Department of Medical Technology.
+All rights reserved.
+
+CustusX is released under a BSD 3-Clause license.
+
+See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt) for details.
+=========================================================================*/
+
+#include "catch.hpp"
+
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QThread>
+#include <boost/function.hpp>
+#include "cxGrabberSenderMultiClient.h"
+#include "cxtestUtilities.h"
+
+namespace cxtest
+{
+
+namespace
+{
+/** Process events until condition is true, or timeout ms have passed.
+ */
+bool waitFor(boost::function<bool ()> condition, int timeout = 5000)
+{
+	QElapsedTimer timer;
+	timer.start();
+	while (!condition())
+	{
+		if (timer.elapsed() > timeout)
+			return false;
+		QCoreApplication::processEvents();
+		QThread::msleep(1);
+	}
+	return true;
+}
+
+cx::PackagePtr createPackage()
+{
+	cx::PackagePtr retval(new cx::Package());
+	retval->mImage = Utilities::create3DImage(Eigen::Array3i(300, 300, 1), 100);
+	return retval;
+}
+
+/** A sender with connections over localhost. The server side
+ *  socket of each connection is added to the sender.
+ */
+class SenderFixture
+{
+public:
+	struct Connection
+	{
+		QTcpSocket* server; ///< owned by the QTcpServer
+		boost::shared_ptr<QTcpSocket> client;
+	};
+
+	SenderFixture() :
+		mSender(new cx::GrabberSenderMultiClient())
+	{
+		REQUIRE(mServer.listen(QHostAddress::LocalHost));
+	}
+
+	/** Connect a client. Small socket buffers give a client that
+	 *  fills up after a few packages if it does not read.
+	 */
+	Connection connect(bool smallSocketBuffers = false)
+	{
+		Connection retval;
+		retval.client.reset(new QTcpSocket());
+		retval.client->connectToHost(QHostAddress::LocalHost, mServer.serverPort());
+		REQUIRE(mServer.waitForNewConnection(1000));
+		retval.server = mServer.nextPendingConnection();
+		REQUIRE(retval.server);
+		REQUIRE(retval.client->waitForConnected(1000));
+
+		if (smallSocketBuffers)
+		{
+			retval.server->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, 4096);
+			retval.client->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 4096);
+		}
+		mSender->addClient(retval.server);
+		return retval;
+	}
+
+	/** Size of one package from createPackage(), found by sending one to connection.
+	 */
+	qint64 sendFirstPackage()
+	{
+		mSender->send(createPackage());
+		std::vector<cx::GrabberSenderMultiClient::ClientStatistics> statistics = mSender->getStatistics();
+		REQUIRE(statistics.size() > 0);
+		REQUIRE(statistics.front().packagesSent == 1);
+		return statistics.front().bytesSent;
+	}
+
+	cx::GrabberSenderMultiClientPtr mSender;
+	QTcpServer mServer;
+};
+} // namespace
+
+TEST_CASE("GrabberSenderMultiClient: Queue is bounded by the max buffer size", "[unit][resource][videoServer]")
+{
+	SenderFixture fixture;
+	SenderFixture::Connection connection = fixture.connect();
+	CHECK(fixture.mSender->isReady());
+
+	// no events are processed, thus nothing leaves the socket buffer
+	qint64 size = fixture.sendFirstPackage();
+	qint64 maxBufferSize = size*7/2;
+	fixture.mSender->setMaxBufferSize(maxBufferSize);
+	for (int i=1; i<10; ++i)
+		fixture.mSender->send(createPackage());
+
+	// three packages fit in the socket buffer, the newest is queued, the rest dropped
+	cx::GrabberSenderMultiClient::ClientStatistics statistics = fixture.mSender->getStatistics().front();
+	CHECK(statistics.packagesSent == 3);
+	CHECK(statistics.packagesDropped == 6);
+	CHECK(connection.server->bytesToWrite() <= maxBufferSize);
+
+	// the queued package is sent when the buffer drains
+	qint64 received = 0;
+	REQUIRE(waitFor([&]()
+	{
+		received += connection.client->readAll().size();
+		return received == 4*size;
+	}));
+	statistics = fixture.mSender->getStatistics().front();
+	CHECK(statistics.packagesSent == 4);
+	CHECK(statistics.packagesDropped == 6);
+}
+
+TEST_CASE("GrabberSenderMultiClient: Slow client drops frames without affecting others", "[unit][resource][videoServer]")
+{
+	SenderFixture fixture;
+	SenderFixture::Connection fast = fixture.connect();
+	SenderFixture::Connection slow = fixture.connect(true);
+
+	qint64 size = fixture.sendFirstPackage();
+	fixture.mSender->setMaxBufferSize(size*5/2);
+
+	int count = 30;
+	qint64 received = 0;
+	for (int i=0; i<count; ++i)
+	{
+		if (i>0)
+			fixture.mSender->send(createPackage());
+		// fast reads everything, slow reads nothing
+		REQUIRE(waitFor([&]()
+		{
+			received += fast.client->readAll().size();
+			return received == (i+1)*size;
+		}));
+	}
+
+	std::vector<cx::GrabberSenderMultiClient::ClientStatistics> statistics = fixture.mSender->getStatistics();
+	REQUIRE(statistics.size() == 2);
+	CHECK(statistics[0].packagesSent == count);
+	CHECK(statistics[0].packagesDropped == 0);
+	CHECK(statistics[0].bytesSent == count*size);
+	CHECK(statistics[1].packagesDropped > 0);
+	CHECK(statistics[1].packagesSent < count);
+	CHECK(statistics[1].packagesSent + statistics[1].packagesDropped <= count);
+	CHECK(slow.server->bytesToWrite() <= size*5/2);
+}
+
+TEST_CASE("GrabberSenderMultiClient: Disconnected clients are removed", "[unit][resource][videoServer]")
+{
+	SenderFixture fixture;
+	SenderFixture::Connection first = fixture.connect();
+	SenderFixture::Connection second = fixture.connect();
+	SenderFixture::Connection third = fixture.connect();
+	REQUIRE(fixture.mSender->getClientCount() == 3);
+
+	// as in ImageServer: remove the client when its socket is disconnected
+	cx::GrabberSenderMultiClientPtr sender = fixture.mSender;
+	QTcpSocket* secondServer = second.server;
+	QObject::connect(secondServer, &QTcpSocket::disconnected, [sender, secondServer]()
+	{
+		sender->removeClient(secondServer);
+	});
+	second.client->disconnectFromHost();
+	REQUIRE(waitFor([&]() { return fixture.mSender->getClientCount() == 2; }));
+
+	qint64 size = fixture.sendFirstPackage();
+	qint64 received = 0;
+	REQUIRE(waitFor([&]()
+	{
+		received += first.client->readAll().size();
+		return received == size;
+	}));
+
+	// a deleted socket removes its client
+	delete third.server;
+	CHECK(fixture.mSender->getClientCount() == 1);
+	fixture.mSender->send(createPackage());
+	CHECK(fixture.mSender->getStatistics().front().packagesSent == 2);
+
+	fixture.mSender->removeClient(first.server);
+	CHECK(fixture.mSender->getClientCount() == 0);
+	CHECK(!fixture.mSender->isReady());
+	fixture.mSender->send(createPackage());
+	CHECK(fixture.mSender->getStatistics().empty());
+}
+
+} // namespace cxtest
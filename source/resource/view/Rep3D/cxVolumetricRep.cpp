@@ -46,8 +46,10 @@ VolumetricRep::VolumetricRep() :
 	VolumetricBaseRep(),
 	mVolume(vtkVolumePtr::New()),
 	mVolumeProperty(cx::VolumeProperty::create()),
-	mMaxVoxels(0)
+	mMaxVoxels(0),
+	mRenderingPreview(false)
 {
+	connect(&mResampleWatcher, &QFutureWatcher<void>::finished, this, &VolumetricRep::updateVtkImageDataSlot);
 	this->setUseVolumeTextureMapper();
 	mVolume->SetProperty(mVolumeProperty->getVolumeProperty());
 }
@@ -107,6 +109,7 @@ void VolumetricRep::setImage(ImagePtr image)
 		mVolumeProperty->setImage(ImagePtr());
 		disconnect(mImage.get(), &Image::vtkImageDataChanged, this, &VolumetricRep::vtkImageDataChangedSlot);
 		disconnect(mImage.get(), &Image::transformChanged, this, &VolumetricRep::transformChangedSlot);
+		disconnect(mImage.get(), &Image::transferFunctionsChanged, this, &VolumetricRep::transferFunctionsChangedSlot);
 		mMonitor.reset();
 		mMapper->SetInputData( (vtkImageData*)NULL );
 	}
@@ -117,6 +120,7 @@ void VolumetricRep::setImage(ImagePtr image)
 	{
 		connect(mImage.get(), &Image::vtkImageDataChanged, this, &VolumetricRep::vtkImageDataChangedSlot);
 		connect(mImage.get(), &Image::transformChanged, this, &VolumetricRep::transformChangedSlot);
+		connect(mImage.get(), &Image::transferFunctionsChanged, this, &VolumetricRep::transferFunctionsChangedSlot);
 		mVolumeProperty->setImage(mImage);
 		this->vtkImageDataChangedSlot();
 		mMonitor = ImageMapperMonitor::create(mVolume, mImage);
@@ -148,15 +152,50 @@ void VolumetricRep::transformChangedSlot()
 	mVolume->SetUserMatrix(mImage->get_rMd().getVtkMatrix());
 }
 
+/**Coarse first, refine later: If the pyramid levels needed for the volume
+ * are not built, show the best volume already available, and build the
+ * levels in the background. This slot is called again when they are ready.
+ */
 void VolumetricRep::updateVtkImageDataSlot()
 {
 	if (!mImage)
 		return;
 
-	vtkImageDataPtr volume = mImage->resample(this->mMaxVoxels);
+	mRenderingPreview = mImage->isThresholdPreview();
+	long maxVoxels = this->getMaxVoxels();
+
+	if (!mImage->isResampleReady(maxVoxels))
+	{
+		vtkImageDataPtr coarse = mImage->getCoarseResample(maxVoxels);
+		if (coarse)
+			mMapper->SetInputData(coarse);
+		mResampleWatcher.setFuture(mImage->requestResample(maxVoxels));
+		return;
+	}
+
+	vtkImageDataPtr volume = mImage->resample(maxVoxels);
 	mMapper->SetInputData(volume);
 }
 
+/**Threshold previews are changed interactively: render them with 1/8 of
+ * the normal number of voxels, and refine when the preview stops.
+ */
+long VolumetricRep::getMaxVoxels() const
+{
+	if (!mRenderingPreview)
+		return mMaxVoxels;
+	long voxels = mImage->getPyramid()->getNumberOfVoxels(0);
+	if (mMaxVoxels>0)
+		voxels = std::min(voxels, mMaxVoxels);
+	return std::max(voxels/8, 1L);
+}
+
+void VolumetricRep::transferFunctionsChangedSlot()
+{
+	if (mImage && mImage->isThresholdPreview()!=mRenderingPreview)
+		this->updateVtkImageDataSlot();
+}
+
 void VolumetricRep::setMaxVolumeSize(long maxVoxels)
 {
 	mMaxVoxels = maxVoxels;
@@ -15,6 +15,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 
 #include "cxResourceVisualizationExport.h"
 
+#include <QFutureWatcher>
 #include "cxRepImpl.h"
 
 #include "vtkForwardDeclarations.h"
@@ -91,6 +92,8 @@ protected:
 	vtkVolumeMapperPtr mMapper;
 	vtkVolumePtr mVolume;
 	long mMaxVoxels; ///< always resample volume below this size.
+	bool mRenderingPreview; ///< the rendered volume is a threshold preview
+	QFutureWatcher<void> mResampleWatcher; ///< pyramid levels being built for the volume
 
 	ImagePtr mImage;
 	cx::ImageMapperMonitorPtr mMonitor; ///< helper object for visualizing clipping/cropping
@@ -99,6 +102,9 @@ protected slots:
 	void transformChangedSlot();
 	void vtkImageDataChangedSlot();
 	void updateVtkImageDataSlot();
+	void transferFunctionsChangedSlot();
+private:
+	long getMaxVoxels() const;
 };
 //---------------------------------------------------------
 } // namespace cx
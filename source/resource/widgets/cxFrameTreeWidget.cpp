@@ -14,7 +14,7 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <QVBoxLayout>
 #include <QTreeWidget>
 #include <QTreeWidgetItem>
-#include "cxFrameForest.h"
+#include "cxFrameGraph.h"
 #include "cxData.h"
 #include "cxPatientModelService.h"
 
@@ -63,20 +63,19 @@ void FrameTreeWidget::rebuild()
 {
   mTreeWidget->clear();
 
-  FrameForest forest(mPatientService->getDatas());
-  QDomElement root = forest.getDocument().documentElement();
+  FrameGraph graph(mPatientService->getDatas());
 
-  this->fill(mTreeWidget->invisibleRootItem(), root);
+  this->fill(mTreeWidget->invisibleRootItem(), graph, graph.getRootFrames());
 
   mTreeWidget->expandToDepth(10);
   mTreeWidget->resizeColumnToContents(0);
 }
 
-void FrameTreeWidget::fill(QTreeWidgetItem* parent, QDomNode node)
+void FrameTreeWidget::fill(QTreeWidgetItem* parent, const FrameGraph& graph, QStringList frames)
 {
-  for (QDomNode child = node.firstChild(); !child.isNull(); child = child.nextSibling())
+  for (int i=0; i<frames.size(); ++i)
   {
-    QString frameName = child.toElement().tagName();
+    QString frameName = frames[i];
 
     // if frame refers to a data, use its name instead.
 	DataPtr data = mPatientService->getData(frameName);
@@ -84,7 +83,7 @@ void FrameTreeWidget::fill(QTreeWidgetItem* parent, QDomNode node)
       frameName = data->getName();
 
     QTreeWidgetItem* item = new QTreeWidgetItem(parent, QStringList() << frameName);
-    this->fill(item, child);
+    this->fill(item, graph, graph.getChildren(frames[i]));
   }
 }
 
@@ -19,18 +19,19 @@ See Lisence.txt (https://github.com/SINTEFMedtek/CustusX/blob/master/License.txt
 #include <map>
 #include <string>
 #include <QWidget>
+#include <QStringList>
 #include "cxForwardDeclarations.h"
 class QTreeWidget;
 class QTreeWidgetItem;
-class QDomNode;
 
 namespace cx
 {
+class FrameGraph;
 
 /**
  * \class FrameTreeWidget
  *
- *\brief Widget for displaying the FrameForest object
+ *\brief Widget for displaying the FrameGraph object
  * \ingroup cx_gui
  *
  *\date Sep 23, 2010
@@ -48,7 +49,7 @@ protected:
 private:
   PatientModelServicePtr mPatientService;
   QTreeWidget* mTreeWidget;
-  void fill(QTreeWidgetItem* parent, QDomNode node);
+  void fill(QTreeWidgetItem* parent, const FrameGraph& graph, QStringList frames);
   std::map<QString, DataPtr> mConnectedData;
 
 private slots: